@@ -17,6 +17,8 @@ zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "hashtx")
 zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "rawblock")
 zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "rawtx")
 zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "checkedblock")
+zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "hashticket")
+zmqSubSocket.setsockopt(zmq.SUBSCRIBE, "rawticket")
 zmqSubSocket.connect("tcp://127.0.0.1:%i" % port)
 
 try:
@@ -43,6 +45,12 @@ try:
         elif topic == "checkedblock":
             print '- CHECKED BLOCK ('+sequence+') -'
             print binascii.hexlify(body[:80])
+        elif topic == "hashticket" or topic == "rawticket":
+            ticketType, height, connected = struct.unpack('<BIB', body[32:38])
+            print '- '+('HASH' if topic == "hashticket" else 'RAW')+' TICKET ('+sequence+') -'
+            print binascii.hexlify(body[:32]), 'type', ticketType, 'height', height, 'connected' if connected else 'disconnected'
+            if topic == "rawticket":
+                print binascii.hexlify(body[38:])
 
 except KeyboardInterrupt:
     zmqContext.destroy()
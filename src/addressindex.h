@@ -60,8 +60,8 @@ struct CAddressUnspentValue {
 
     ADD_SERIALIZE_METHODS;
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
+    template <typename Stream>
+    inline void SerializationOp(Stream& s, const SERIALIZE_ACTION ser_action) {
         READWRITE(patoshis);
         READWRITE(*(CScriptBase*)(&script));
         READWRITE(blockHeight);
@@ -19,3 +19,8 @@ bool AMQPAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool AMQPAbstractNotifier::NotifyTicket(const ticket_notification_t &/*ticket*/)
+{
+    return true;
+}
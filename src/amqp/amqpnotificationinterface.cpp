@@ -49,6 +49,8 @@ AMQPNotificationInterface* AMQPNotificationInterface::CreateWithArguments(const
     factories["pubhashtx"] = AMQPAbstractNotifier::Create<AMQPPublishHashTransactionNotifier>;
     factories["pubrawblock"] = AMQPAbstractNotifier::Create<AMQPPublishRawBlockNotifier>;
     factories["pubrawtx"] = AMQPAbstractNotifier::Create<AMQPPublishRawTransactionNotifier>;
+    factories["pubhashticket"] = AMQPAbstractNotifier::Create<AMQPPublishHashTicketNotifier>;
+    factories["pubrawticket"] = AMQPAbstractNotifier::Create<AMQPPublishRawTicketNotifier>;
 
     for (std::map<std::string, AMQPNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i) {
         std::map<std::string, std::string>::const_iterator j = args.find("-amqp" + i->first);
@@ -134,3 +136,16 @@ void AMQPNotificationInterface::SyncTransaction(const CTransaction &tx, const CB
         }
     }
 }
+
+void AMQPNotificationInterface::TicketNotification(const ticket_notification_t &ticket)
+{
+    for (std::list<AMQPAbstractNotifier*>::iterator i = notifiers.begin(); i != notifiers.end(); ) {
+        AMQPAbstractNotifier *notifier = *i;
+        if (notifier->NotifyTicket(ticket)) {
+            i++;
+        } else {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
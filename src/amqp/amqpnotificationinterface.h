@@ -26,6 +26,7 @@ protected:
     // CValidationInterface
     void SyncTransaction(const CTransaction &tx, const CBlock *pblock);
     void UpdatedBlockTip(const CBlockIndex *pindex);
+    void TicketNotification(const ticket_notification_t &ticket);
 
 private:
     AMQPNotificationInterface();
@@ -17,6 +17,8 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_HASHTICKET = "hashticket";
+static const char *MSG_RAWTICKET  = "rawticket";
 
 // Invoke this method from a new thread to run the proton container event loop.
 void AMQPAbstractPublishNotifier::SpawnProtonContainer()
@@ -152,17 +154,17 @@ bool AMQPPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint("amqp", "amqp: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
     {
+        // cs_main is held only to read the block, serialization is done without it
         LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex)) {
+        if(!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
             LogPrint("amqp", "amqp: Can't read block from disk");
             return false;
         }
-
-        ss << block;
     }
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
 
     return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
 }
@@ -175,3 +177,17 @@ bool AMQPPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool AMQPPublishHashTicketNotifier::NotifyTicket(const ticket_notification_t &ticket)
+{
+    LogPrint("amqp", "amqp: Publish hashticket %s (%s)\n", ticket.txid.GetHex(), ticket.bConnected ? "connected" : "disconnected");
+    const auto vData = GetTicketNotificationMessage(ticket, false);
+    return SendMessage(MSG_HASHTICKET, vData.data(), vData.size());
+}
+
+bool AMQPPublishRawTicketNotifier::NotifyTicket(const ticket_notification_t &ticket)
+{
+    LogPrint("amqp", "amqp: Publish rawticket %s (%s)\n", ticket.txid.GetHex(), ticket.bConnected ? "connected" : "disconnected");
+    const auto vData = GetTicketNotificationMessage(ticket, true);
+    return SendMessage(MSG_RAWTICKET, vData.data(), vData.size());
+}
@@ -53,4 +53,16 @@ public:
     bool NotifyTransaction(const CTransaction &transaction);
 };
 
+class AMQPPublishHashTicketNotifier : public AMQPAbstractPublishNotifier
+{
+public:
+    bool NotifyTicket(const ticket_notification_t &ticket);
+};
+
+class AMQPPublishRawTicketNotifier : public AMQPAbstractPublishNotifier
+{
+public:
+    bool NotifyTicket(const ticket_notification_t &ticket);
+};
+
 #endif // ZCASH_AMQP_AMQPPUBLISHNOTIFIER_H
@@ -94,6 +94,7 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_ACTIVATES_UPGRADE  =   128, //! block activates a network upgrade
+    BLOCK_POW_VALID          =   256, //! Equihash solution of the block header was verified
 };
 
 //! Short-hand for the highest consensus validity we implement.
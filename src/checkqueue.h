@@ -8,6 +8,8 @@
 #include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <type_traits>
+#include <utility>
 
 #include <sync.h>
 #include <svc_thread.h>
@@ -54,14 +56,23 @@ public:
         return Loop(true);
     }
 
-    //! Add a batch of checks to the queue
-    void Add(std::vector<T>& vChecks)
+    /**
+     * Add a batch of checks to the queue.
+     * Checks of type U are swapped into the queue if U is T,
+     * otherwise they are moved into the T objects constructed from U.
+     */
+    template <typename U>
+    void Add(std::vector<U>& vChecks)
     {
         std::unique_lock<std::mutex> lock(mtx);
-        for (T& check : vChecks)
+        for (U& check : vChecks)
         {
-            m_queue.emplace_back();
-            check.swap(m_queue.back());
+            if constexpr (std::is_same_v<T, U>)
+            {
+                m_queue.emplace_back();
+                check.swap(m_queue.back());
+            } else
+                m_queue.emplace_back(std::move(check));
         }
         m_nTodo += vChecks.size();
         if (vChecks.size() == 1)
@@ -239,7 +250,8 @@ public:
             m_pQueueManager->Worker();
     }
 
-    void Add(std::vector<T>& vChecks)
+    template <typename U>
+    void Add(std::vector<U>& vChecks)
     {
         if (!m_pQueueManager)
             return;
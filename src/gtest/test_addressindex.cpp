@@ -0,0 +1,245 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <consensus/consensus.h>
+#include <consensus/upgrades.h>
+#include <consensus/validation.h>
+#include <init.h>
+#include <key_io.h>
+#include <main.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <rpc/server.h>
+#include <univalue.h>
+#include <wallet/wallet.h>
+#include <pastel_gtest_main.h>
+
+using namespace std;
+using namespace testing;
+
+extern UniValue CallRPC(string args);
+
+#ifdef ENABLE_MINING
+/**
+ * Insight explorer address, spent and timestamp indexes test.
+ * Indexes are enabled only for the duration of each test.
+ */
+class TestAddressIndex : public Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        gl_pPastelTestEnv->InitializeRegTest();
+        gl_pPastelTestEnv->generate_coins(101);
+    }
+
+    static void TearDownTestSuite()
+    {
+        gl_pPastelTestEnv->FinalizeRegTest();
+    }
+
+    void SetUp() override
+    {
+        m_bSavedExperimentalMode = fExperimentalMode;
+        m_bSavedInsightExplorer = fInsightExplorer;
+        fExperimentalMode = true;
+        SetInsightIndexes(true);
+    }
+
+    void TearDown() override
+    {
+        fExperimentalMode = m_bSavedExperimentalMode;
+        SetInsightIndexes(m_bSavedInsightExplorer);
+    }
+
+    static void SetInsightIndexes(const bool bEnable)
+    {
+        fInsightExplorer = bEnable;
+        fAddressIndex = bEnable;
+        fSpentIndex = bEnable;
+        fTimestampIndex = bEnable;
+    }
+
+    // create transaction that spends the first output of txFrom to the new wallet key
+    CTransaction CreateSpend(const CTransaction& txFrom, const CKeyID& keyID, const CAmount nFee)
+    {
+        const auto& consensusParams = Params().GetConsensus();
+        const int nHeight = chainActive.Height() + 1;
+        CMutableTransaction mtx = CreateNewContextualCMutableTransaction(consensusParams, nHeight);
+        mtx.vin.emplace_back(COutPoint(txFrom.GetHash(), 0));
+        mtx.vout.emplace_back(txFrom.vout[0].nValue - nFee, GetScriptForDestination(keyID));
+        EXPECT_TRUE(SignSignature(*pwalletMain, txFrom, mtx, 0, to_integral_type(SIGHASH::ALL), CurrentEpochBranchId(nHeight, consensusParams)));
+        return mtx;
+    }
+
+    using address_index_t = vector<pair<CAddressIndexKey, CAmount>>;
+    using address_unspent_t = vector<pair<CAddressUnspentKey, CAddressUnspentValue>>;
+
+    static address_index_t ReadAddressIndex(const CKeyID& keyID)
+    {
+        address_index_t v;
+        EXPECT_TRUE(GetAddressIndex(keyID, CScript::ScriptType::P2PKH, v));
+        return v;
+    }
+
+    static address_unspent_t ReadAddressUnspent(const CKeyID& keyID)
+    {
+        address_unspent_t v;
+        EXPECT_TRUE(GetAddressUnspent(keyID, CScript::ScriptType::P2PKH, v));
+        return v;
+    }
+
+    static bool IsUnspentIndexed(const address_unspent_t& v, const uint256& txid, const size_t n)
+    {
+        return find_if(v.cbegin(), v.cend(), [&](const auto& p) { return p.first.txhash == txid && p.first.index == n; }) != v.cend();
+    }
+
+    static bool IsTimestampIndexed(const CBlockIndex* pindex)
+    {
+        v_uint256 vHashes;
+        EXPECT_TRUE(GetTimestampIndex(pindex->nTime + 1, pindex->nTime, vHashes));
+        return find(vHashes.cbegin(), vHashes.cend(), pindex->GetBlockHash()) != vHashes.cend();
+    }
+
+protected:
+    bool m_bSavedExperimentalMode = false;
+    bool m_bSavedInsightExplorer = false;
+};
+
+// ConnectBlock writes address, unspent, spent and timestamp indexes,
+// DisconnectBlock reverts them, address RPCs read them
+TEST_F(TestAddressIndex, connect_disconnect_roundtrip)
+{
+    const auto& chainparams = Params();
+    const auto& consensusParams = chainparams.GetConsensus();
+    constexpr CAmount nFee = 1000;
+    KeyIO keyIO(chainparams);
+
+    // spend the coinbase that matures in the next block
+    CTransaction txCoinbase;
+    CKeyID keyCoinbase;
+    const CKeyID keyDest = pwalletMain->GenerateNewKey().GetID();
+    const string sDestAddress = keyIO.EncodeDestination(keyDest);
+    CTransaction tx;
+    {
+        LOCK(cs_main);
+        const int nCoinbaseHeight = chainActive.Height() + 1 - COINBASE_MATURITY;
+        ASSERT_GT(nCoinbaseHeight, 0);
+        CBlock block;
+        ASSERT_TRUE(ReadBlockFromDisk(block, chainActive[nCoinbaseHeight], consensusParams));
+        txCoinbase = block.vtx[0];
+        CTxDestination dest;
+        ASSERT_TRUE(ExtractDestination(txCoinbase.vout[0].scriptPubKey, dest));
+        ASSERT_TRUE(IsKeyDestination(dest));
+        keyCoinbase = get<CKeyID>(dest);
+        ASSERT_TRUE(pcoinsTip->HaveCoins(txCoinbase.GetHash()));
+
+        tx = CreateSpend(txCoinbase, keyDest, nFee);
+        CValidationState state;
+        ASSERT_TRUE(AcceptToMemoryPool(chainparams, mempool, state, tx, false, nullptr)) << state.GetRejectReason();
+    }
+    const CAmount nValue = tx.vout[0].nValue;
+
+    // mempool only: unconfirmed balance, no confirmed utxos
+    UniValue ret = CallRPC("getaddressbalance " + sDestAddress);
+    EXPECT_EQ(find_value(ret, "balance").get_int64(), 0);
+    EXPECT_EQ(find_value(ret, "received").get_int64(), 0);
+    EXPECT_EQ(find_value(ret, "unconfirmed").get_int64(), nValue);
+    ret = CallRPC("getaddressutxos " + sDestAddress);
+    EXPECT_TRUE(ret.empty());
+
+    gl_pPastelTestEnv->generate_coins(1);
+
+    LOCK(cs_main);
+    CBlockIndex* pindex = chainActive.Tip();
+    CBlock block;
+    ASSERT_TRUE(ReadBlockFromDisk(block, pindex, consensusParams));
+    ASSERT_EQ(block.vtx.size(), 2u);
+    ASSERT_EQ(block.vtx[1].GetHash(), tx.GetHash());
+
+    // indexes written by the block connection
+    const auto vAddressIndex = ReadAddressIndex(keyDest);
+    ASSERT_EQ(vAddressIndex.size(), 1u);
+    EXPECT_EQ(vAddressIndex[0].first.txhash, tx.GetHash());
+    EXPECT_EQ(vAddressIndex[0].first.blockHeight, pindex->nHeight);
+    EXPECT_FALSE(vAddressIndex[0].first.spending);
+    EXPECT_EQ(vAddressIndex[0].second, nValue);
+    const auto vUnspent = ReadAddressUnspent(keyDest);
+    ASSERT_EQ(vUnspent.size(), 1u);
+    EXPECT_TRUE(IsUnspentIndexed(vUnspent, tx.GetHash(), 0));
+    EXPECT_EQ(vUnspent[0].second.blockHeight, pindex->nHeight);
+    EXPECT_EQ(vUnspent[0].second.patoshis, nValue);
+    CSpentIndexKey spentKey(txCoinbase.GetHash(), 0);
+    CSpentIndexValue spentValue;
+    ASSERT_TRUE(GetSpentIndex(spentKey, spentValue));
+    EXPECT_EQ(spentValue.txid, tx.GetHash());
+    EXPECT_EQ(spentValue.blockHeight, pindex->nHeight);
+    EXPECT_EQ(spentValue.patoshis, txCoinbase.vout[0].nValue);
+    EXPECT_EQ(spentValue.addressHash, uint160(keyCoinbase));
+    EXPECT_TRUE(IsTimestampIndexed(pindex));
+
+    // address RPCs
+    ret = CallRPC("getaddressbalance " + sDestAddress);
+    EXPECT_EQ(find_value(ret, "balance").get_int64(), nValue);
+    EXPECT_EQ(find_value(ret, "received").get_int64(), nValue);
+    EXPECT_EQ(find_value(ret, "unconfirmed").get_int64(), 0);
+    ret = CallRPC("getaddressutxos {\"addresses\":[\"" + sDestAddress + "\"]}");
+    ASSERT_EQ(ret.size(), 1u);
+    EXPECT_EQ(find_value(ret[0], "address").get_str(), sDestAddress);
+    EXPECT_EQ(find_value(ret[0], "txid").get_str(), tx.GetHash().GetHex());
+    EXPECT_EQ(find_value(ret[0], "outputIndex").get_int(), 0);
+    EXPECT_EQ(find_value(ret[0], "patoshis").get_int64(), nValue);
+    EXPECT_EQ(find_value(ret[0], "height").get_int(), pindex->nHeight);
+
+    // disconnect the block in a memory-only view: indexes are reverted,
+    // spent coinbase output is restored to the unspent index with its original height
+    CCoinsViewCache view(pcoinsTip);
+    CValidationState state;
+    ASSERT_TRUE(DisconnectBlock(block, state, chainparams, pindex, view));
+    EXPECT_TRUE(ReadAddressIndex(keyDest).empty());
+    EXPECT_TRUE(ReadAddressUnspent(keyDest).empty());
+    EXPECT_FALSE(GetSpentIndex(spentKey, spentValue));
+    const auto vCoinbaseUnspent = ReadAddressUnspent(keyCoinbase);
+    const auto itCoinbase = find_if(vCoinbaseUnspent.cbegin(), vCoinbaseUnspent.cend(),
+        [&](const auto& p) { return p.first.txhash == txCoinbase.GetHash() && p.first.index == 0; });
+    ASSERT_NE(itCoinbase, vCoinbaseUnspent.cend());
+    EXPECT_EQ(itCoinbase->second.blockHeight, pindex->nHeight - COINBASE_MATURITY);
+    ret = CallRPC("getaddressutxos " + sDestAddress);
+    EXPECT_TRUE(ret.empty());
+
+    // reconnect without index updates (VerifyDB mode): indexes are not written
+    {
+        CCoinsViewCache viewVerify(&view);
+        ASSERT_TRUE(ConnectBlock(block, state, chainparams, pindex, viewVerify, false, false));
+        EXPECT_TRUE(ReadAddressIndex(keyDest).empty());
+        EXPECT_TRUE(ReadAddressUnspent(keyDest).empty());
+        EXPECT_FALSE(GetSpentIndex(spentKey, spentValue));
+    }
+
+    // reconnect the block: indexes are the same as before the disconnect
+    ASSERT_TRUE(ConnectBlock(block, state, chainparams, pindex, view));
+    const auto vAddressIndex2 = ReadAddressIndex(keyDest);
+    ASSERT_EQ(vAddressIndex2.size(), 1u);
+    EXPECT_EQ(vAddressIndex2[0].first.txhash, tx.GetHash());
+    EXPECT_EQ(vAddressIndex2[0].second, nValue);
+    const auto vUnspent2 = ReadAddressUnspent(keyDest);
+    ASSERT_EQ(vUnspent2.size(), 1u);
+    EXPECT_TRUE(IsUnspentIndexed(vUnspent2, tx.GetHash(), 0));
+    EXPECT_EQ(vUnspent2[0].second.blockHeight, pindex->nHeight);
+    EXPECT_FALSE(IsUnspentIndexed(ReadAddressUnspent(keyCoinbase), txCoinbase.GetHash(), 0));
+    ASSERT_TRUE(GetSpentIndex(spentKey, spentValue));
+    EXPECT_EQ(spentValue.txid, tx.GetHash());
+    EXPECT_TRUE(IsTimestampIndexed(pindex));
+    ret = CallRPC("getaddressbalance " + sDestAddress);
+    EXPECT_EQ(find_value(ret, "balance").get_int64(), nValue);
+
+    // VerifyDB level 4 disconnects and reconnects the tip blocks, indexes must stay intact
+    EXPECT_TRUE(CVerifyDB().VerifyDB(chainparams, pcoinsTip, 4, 2));
+    EXPECT_EQ(ReadAddressIndex(keyDest).size(), 1u);
+    EXPECT_TRUE(IsUnspentIndexed(ReadAddressUnspent(keyDest), tx.GetHash(), 0));
+    EXPECT_TRUE(GetSpentIndex(spentKey, spentValue));
+    EXPECT_TRUE(IsTimestampIndexed(pindex));
+}
+#endif // ENABLE_MINING
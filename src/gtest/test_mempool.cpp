@@ -17,6 +17,11 @@
 #include "util.h"
 #include "pastel_gtest_main.h"
 #include "test_mempool_entryhelper.h"
+#include "script/sign.h"
+#ifdef ENABLE_WALLET
+#include "init.h"
+#include "wallet/wallet.h"
+#endif
 
 using namespace testing;
 using namespace std;
@@ -389,6 +394,288 @@ TEST_F(TestMemPool, Indexing)
     EXPECT_TRUE(it == pool.mapTx.get<1>().end());
 }
 
+// Test ancestor state and ancestor fee rate index (child pays for parent)
+TEST_F(TestMemPool, AncestorFeeRate)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+
+    // low-fee parent with high-fee child
+    CMutableTransaction txParent;
+    txParent.vout.resize(1);
+    txParent.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txParent.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(txParent.GetHash(), entry.Fee(0LL).FromTx(txParent));
+
+    CMutableTransaction txChild;
+    txChild.vin.resize(1);
+    txChild.vin[0].scriptSig = CScript() << OP_11;
+    txChild.vin[0].prevout.hash = txParent.GetHash();
+    txChild.vin[0].prevout.n = 0;
+    txChild.vout.resize(1);
+    txChild.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txChild.vout[0].nValue = 9 * COIN;
+    pool.addUnchecked(txChild.GetHash(), entry.Fee(50000LL).FromTx(txChild));
+
+    // unrelated transaction with medium fee
+    CMutableTransaction tx;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx.vout[0].nValue = 5 * COIN;
+    pool.addUnchecked(tx.GetHash(), entry.Fee(10000LL).FromTx(tx));
+
+    const size_t nParentSize = ::GetSerializeSize(txParent, SER_NETWORK, PROTOCOL_VERSION);
+    const size_t nChildSize = ::GetSerializeSize(txChild, SER_NETWORK, PROTOCOL_VERSION);
+    {
+        LOCK(pool.cs);
+        const auto it = pool.mapTx.find(txChild.GetHash());
+        ASSERT_NE(it, pool.mapTx.end());
+        EXPECT_EQ(it->GetCountWithAncestors(), 2u);
+        EXPECT_EQ(it->GetSizeWithAncestors(), nParentSize + nChildSize);
+        EXPECT_EQ(it->GetModFeesWithAncestors(), 50000LL);
+
+        set<uint256> setAncestors;
+        pool.CalculateMemPoolAncestors(txChild, setAncestors);
+        EXPECT_EQ(setAncestors.size(), 1u);
+        EXPECT_EQ(setAncestors.count(txParent.GetHash()), 1u);
+
+        set<uint256> setDescendants;
+        pool.CalculateDescendants(txParent.GetHash(), setDescendants);
+        EXPECT_EQ(setDescendants.size(), 1u);
+        EXPECT_EQ(setDescendants.count(txChild.GetHash()), 1u);
+    }
+
+    // ancestor fee rate index: child package first, then tx, parent is the last
+    auto it = pool.mapTx.get<2>().begin();
+    EXPECT_EQ(it++->GetTx().GetHash(), txChild.GetHash());
+    EXPECT_EQ(it++->GetTx().GetHash(), tx.GetHash());
+    EXPECT_EQ(it++->GetTx().GetHash(), txParent.GetHash());
+    EXPECT_TRUE(it == pool.mapTx.get<2>().end());
+
+    // fee delta of the parent is included in the child ancestor fees
+    pool.PrioritiseTransaction(txParent.GetHash(), txParent.GetHash().ToString(), 0.0, 5000LL);
+    {
+        LOCK(pool.cs);
+        const auto itChild = pool.mapTx.find(txChild.GetHash());
+        ASSERT_NE(itChild, pool.mapTx.end());
+        EXPECT_EQ(itChild->GetModFeesWithAncestors(), 55000LL);
+    }
+
+    // parent is mined - child has no in-mempool ancestors anymore
+    list<CTransaction> removed;
+    pool.remove(txParent, false, &removed);
+    EXPECT_EQ(removed.size(), 1u);
+    {
+        LOCK(pool.cs);
+        const auto itChild = pool.mapTx.find(txChild.GetHash());
+        ASSERT_NE(itChild, pool.mapTx.end());
+        EXPECT_EQ(itChild->GetCountWithAncestors(), 1u);
+        EXPECT_EQ(itChild->GetSizeWithAncestors(), nChildSize);
+        EXPECT_EQ(itChild->GetModFeesWithAncestors(), 50000LL);
+    }
+}
+
+// compare ancestor state of all mempool entries with the full recalculation
+static void CheckAncestorState(CTxMemPool& pool)
+{
+    LOCK(pool.cs);
+    for (auto it = pool.mapTx.cbegin(); it != pool.mapTx.cend(); ++it)
+    {
+        set<uint256> setAncestors;
+        pool.CalculateMemPoolAncestors(it->GetTx(), setAncestors);
+        uint64_t nSize = it->GetTxSize();
+        CAmount nModFees = it->GetModifiedFee();
+        for (const auto& txid : setAncestors)
+        {
+            const auto itAncestor = pool.mapTx.find(txid);
+            ASSERT_NE(itAncestor, pool.mapTx.cend());
+            nSize += itAncestor->GetTxSize();
+            nModFees += itAncestor->GetModifiedFee();
+        }
+        EXPECT_EQ(it->GetCountWithAncestors(), setAncestors.size() + 1) << it->GetTx().GetHash().ToString();
+        EXPECT_EQ(it->GetSizeWithAncestors(), nSize) << it->GetTx().GetHash().ToString();
+        EXPECT_EQ(it->GetModFeesWithAncestors(), nModFees) << it->GetTx().GetHash().ToString();
+    }
+}
+
+// Test incremental update of the descendants ancestor state on transaction add and removal
+TEST_F(TestMemPool, AncestorStateIncremental)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+
+    // A -> B -> C -> D, C also spends A directly (diamond)
+    CMutableTransaction txA;
+    txA.vout.resize(2);
+    for (auto& out : txA.vout)
+    {
+        out.scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        out.nValue = 10 * COIN;
+    }
+    const auto CreateChild = [](const vector<COutPoint>& vPrevOut) -> CMutableTransaction
+    {
+        CMutableTransaction mtx;
+        for (const auto& prevout : vPrevOut)
+        {
+            mtx.vin.emplace_back(prevout);
+            mtx.vin.back().scriptSig = CScript() << OP_11;
+        }
+        mtx.vout.resize(1);
+        mtx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        mtx.vout[0].nValue = COIN;
+        return mtx;
+    };
+    const CTransaction txB = CreateChild({ COutPoint(txA.GetHash(), 0) });
+    const CTransaction txC = CreateChild({ COutPoint(txB.GetHash(), 0), COutPoint(txA.GetHash(), 1) });
+    const CTransaction txD = CreateChild({ COutPoint(txC.GetHash(), 0) });
+
+    // block disconnect re-adds transactions with descendants already in the mempool
+    pool.addUnchecked(txC.GetHash(), entry.Fee(3000LL).FromTx(txC));
+    pool.addUnchecked(txD.GetHash(), entry.Fee(4000LL).FromTx(txD));
+    pool.addUnchecked(txB.GetHash(), entry.Fee(2000LL).FromTx(txB));
+    CheckAncestorState(pool);
+    pool.addUnchecked(txA.GetHash(), entry.Fee(1000LL).FromTx(txA));
+    CheckAncestorState(pool);
+    {
+        LOCK(pool.cs);
+        const auto it = pool.mapTx.find(txD.GetHash());
+        ASSERT_NE(it, pool.mapTx.end());
+        EXPECT_EQ(it->GetCountWithAncestors(), 4u);
+        EXPECT_EQ(it->GetModFeesWithAncestors(), 10000LL);
+    }
+
+    // fee delta of the root is propagated to all descendants
+    pool.PrioritiseTransaction(txA.GetHash(), txA.GetHash().ToString(), 0.0, 500LL);
+    CheckAncestorState(pool);
+
+    // root is mined
+    list<CTransaction> removed;
+    pool.remove(txA, false, &removed);
+    EXPECT_EQ(removed.size(), 1u);
+    CheckAncestorState(pool);
+
+    // root is re-added after the block disconnect
+    pool.addUnchecked(txA.GetHash(), entry.Fee(1000LL).FromTx(txA));
+    CheckAncestorState(pool);
+
+    // transaction with in-mempool parent is removed and re-added
+    removed.clear();
+    pool.remove(txB, false, &removed);
+    EXPECT_EQ(removed.size(), 1u);
+    CheckAncestorState(pool);
+    pool.addUnchecked(txB.GetHash(), entry.Fee(2000LL).FromTx(txB));
+    CheckAncestorState(pool);
+}
+
+// Test CTxMemPool::TrimToSize and rolling minimum fee
+TEST_F(TestMemPool, TrimToSize)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    entry.hadNoDependencies = true;
+
+    CMutableTransaction tx1;
+    tx1.vout.resize(1);
+    tx1.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx1.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx1.GetHash(), entry.Fee(10000LL).FromTx(tx1));
+
+    CMutableTransaction tx2;
+    tx2.vout.resize(1);
+    tx2.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx2.vout[0].nValue = 2 * COIN;
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(20000LL).FromTx(tx2));
+
+    // lowest fee rate with high fee child
+    CMutableTransaction tx3;
+    tx3.vout.resize(1);
+    tx3.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx3.vout[0].nValue = 5 * COIN;
+    pool.addUnchecked(tx3.GetHash(), entry.Fee(0LL).FromTx(tx3));
+
+    CMutableTransaction txChild;
+    txChild.vin.resize(1);
+    txChild.vin[0].scriptSig = CScript() << OP_11;
+    txChild.vin[0].prevout.hash = tx3.GetHash();
+    txChild.vin[0].prevout.n = 0;
+    txChild.vout.resize(1);
+    txChild.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txChild.vout[0].nValue = 4 * COIN;
+    pool.addUnchecked(txChild.GetHash(), entry.Fee(30000LL).FromTx(txChild));
+    EXPECT_EQ(pool.size(), 4u);
+    EXPECT_EQ(pool.GetMinFee(1).GetFeePerK(), 0);
+
+    // nothing to trim
+    EXPECT_EQ(pool.TrimToSize(pool.DynamicMemoryUsage()), 0u);
+    EXPECT_EQ(pool.size(), 4u);
+
+    // lowest fee rate transaction is evicted together with its child
+    EXPECT_EQ(pool.TrimToSize(pool.DynamicMemoryUsage() - 1), 2u);
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_FALSE(pool.exists(tx3.GetHash()));
+    EXPECT_FALSE(pool.exists(txChild.GetHash()));
+    EXPECT_TRUE(pool.exists(tx1.GetHash()));
+    EXPECT_TRUE(pool.exists(tx2.GetHash()));
+    // rolling minimum fee is raised above the fee rate of the evicted transaction
+    EXPECT_EQ(pool.GetMinFee(1).GetFeePerK(), ::minRelayTxFee.GetFeePerK());
+
+    // next eviction - tx1
+    EXPECT_EQ(pool.TrimToSize(pool.DynamicMemoryUsage() - 1), 1u);
+    EXPECT_TRUE(pool.exists(tx2.GetHash()));
+    EXPECT_GT(pool.GetMinFee(1).GetFeePerK(), ::minRelayTxFee.GetFeePerK());
+
+    pool.TrimToSize(0);
+    EXPECT_EQ(pool.size(), 0u);
+}
+
+// Rolling minimum fee decays gradually starting from the block connection
+TEST_F(TestMemPool, RollingFeeDecay)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    entry.hadNoDependencies = true;
+    const int64_t nStartTime = GetTime();
+    SetMockTime(nStartTime);
+
+    CMutableTransaction tx1;
+    tx1.vout.resize(1);
+    tx1.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx1.vout[0].nValue = 10 * COIN;
+    pool.addUnchecked(tx1.GetHash(), entry.Fee(10000LL).FromTx(tx1));
+
+    CMutableTransaction tx2;
+    tx2.vout.resize(1);
+    tx2.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx2.vout[0].nValue = 2 * COIN;
+    pool.addUnchecked(tx2.GetHash(), entry.Fee(100000LL).FromTx(tx2));
+
+    // evict tx1 - rolling minimum fee is bumped
+    EXPECT_EQ(pool.TrimToSize(pool.DynamicMemoryUsage() - 1), 1u);
+    EXPECT_FALSE(pool.exists(tx1.GetHash()));
+    const size_t nTxSize = ::GetSerializeSize(CTransaction(tx1), SER_NETWORK, PROTOCOL_VERSION);
+    const CAmount nRollingFee = CFeeRate(10000LL, nTxSize).GetFeePerK() + ::minRelayTxFee.GetFeePerK();
+    ASSERT_GT(nRollingFee / 2, ::minRelayTxFee.GetFeePerK());
+    // mempool usage is above the limit - default halflife is used
+    constexpr size_t nSizeLimit = 1;
+    EXPECT_EQ(pool.GetMinFee(nSizeLimit).GetFeePerK(), nRollingFee);
+
+    // block is connected - rolling fee starts to decay from now on and is not dropped
+    list<CTransaction> conflicts;
+    pool.removeForBlock({}, 1, conflicts, true);
+    EXPECT_EQ(pool.GetMinFee(nSizeLimit).GetFeePerK(), nRollingFee);
+    SetMockTime(nStartTime + 5);
+    EXPECT_EQ(pool.GetMinFee(nSizeLimit).GetFeePerK(), nRollingFee);
+
+    // halved after one halflife
+    SetMockTime(nStartTime + ROLLING_FEE_HALFLIFE);
+    EXPECT_NEAR(static_cast<double>(pool.GetMinFee(nSizeLimit).GetFeePerK()), nRollingFee / 2.0, 1.0);
+
+    // dropped when decayed below the half of the min relay fee
+    SetMockTime(nStartTime + ROLLING_FEE_HALFLIFE * 30);
+    EXPECT_EQ(pool.GetMinFee(nSizeLimit).GetFeePerK(), 0);
+    SetMockTime(0);
+}
+
 TEST_F(TestMemPool, RemoveWithoutBranchId)
 {
     CTxMemPool pool(CFeeRate(0));
@@ -487,4 +774,82 @@ TEST_F(TestMemPool, lookup)
     EXPECT_TRUE(pool.lookup(txid, txOut, &nBlockHeight));
     EXPECT_NE(nBlockHeight, numeric_limits<uint32_t>::max());
 }
+
+#ifdef ENABLE_WALLET
+// Test mempool.dat dump and load round trip: transactions with their entry times and prioritisation deltas
+TEST_F(TestMemPool, DumpLoadRoundTrip)
+{
+    const auto& chainparams = Params();
+    const auto& consensusParams = chainparams.GetConsensus();
+    const int64_t nStartTime = GetTime();
+    mempool.clear();
+
+    // two transactions spending mature coinbases and a child of the first one
+    vector<CTransaction> vTx;
+    const auto CreateSpend = [&](const CTransaction& txFrom, const int nHeight) -> CTransaction
+    {
+        CMutableTransaction mtx = CreateNewContextualCMutableTransaction(consensusParams, nHeight);
+        mtx.vin.emplace_back(COutPoint(txFrom.GetHash(), 0));
+        mtx.vout.emplace_back(txFrom.vout[0].nValue - CENT, txFrom.vout[0].scriptPubKey);
+        EXPECT_TRUE(SignSignature(*pwalletMain, txFrom, mtx, 0, to_integral_type(SIGHASH::ALL), CurrentEpochBranchId(nHeight, consensusParams)));
+        return mtx;
+    };
+    {
+        LOCK(cs_main);
+        const int nHeight = chainActive.Height() + 1;
+        for (int nCoinbaseHeight = 1; nCoinbaseHeight <= 2; ++nCoinbaseHeight)
+        {
+            CBlock block;
+            ASSERT_TRUE(ReadBlockFromDisk(block, chainActive[nCoinbaseHeight], consensusParams));
+            vTx.push_back(CreateSpend(block.vtx[0], nHeight));
+        }
+        vTx.push_back(CreateSpend(vTx[0], nHeight));
+        for (size_t i = 0; i < vTx.size(); ++i)
+        {
+            SetMockTime(nStartTime + 10 * i);
+            CValidationState state;
+            ASSERT_TRUE(AcceptToMemoryPool(chainparams, mempool, state, vTx[i], false, nullptr)) << state.GetRejectReason();
+        }
+    }
+    ASSERT_EQ(mempool.size(), vTx.size());
+    const uint256 txidNotInMempool = GetRandHash();
+    mempool.PrioritiseTransaction(vTx[1].GetHash(), vTx[1].GetHash().ToString(), 0, 5000);
+    mempool.PrioritiseTransaction(txidNotInMempool, txidNotInMempool.ToString(), 0.5, 700);
+
+    ASSERT_TRUE(DumpMempool());
+    mempool.clear();
+    mempool.ClearPrioritisation(vTx[1].GetHash());
+    mempool.ClearPrioritisation(txidNotInMempool);
+    EXPECT_EQ(mempool.size(), 0u);
+
+    // child is loaded after its parent, entry times are not reset to the load time
+    SetMockTime(nStartTime + 1000);
+    ASSERT_TRUE(LoadMempool(chainparams));
+    EXPECT_EQ(mempool.size(), vTx.size());
+    {
+        LOCK(mempool.cs);
+        for (size_t i = 0; i < vTx.size(); ++i)
+        {
+            const auto it = mempool.mapTx.find(vTx[i].GetHash());
+            ASSERT_NE(it, mempool.mapTx.end()) << "transaction " << i;
+            EXPECT_EQ(it->GetTime(), nStartTime + static_cast<int64_t>(10 * i));
+        }
+        const auto it = mempool.mapTx.find(vTx[1].GetHash());
+        EXPECT_EQ(it->GetModifiedFee(), it->GetFee() + 5000);
+        ASSERT_EQ(mempool.mapDeltas.count(txidNotInMempool), 1u);
+        EXPECT_EQ(mempool.mapDeltas[txidNotInMempool].first, 0.5);
+        EXPECT_EQ(mempool.mapDeltas[txidNotInMempool].second, 700);
+    }
+
+    // second load - all transactions are already there
+    ASSERT_TRUE(LoadMempool(chainparams));
+    EXPECT_EQ(mempool.size(), vTx.size());
+
+    mempool.clear();
+    mempool.ClearPrioritisation(vTx[1].GetHash());
+    mempool.ClearPrioritisation(txidNotInMempool);
+    fs::remove(GetDataDir() / "mempool.dat");
+    SetMockTime(0);
+}
+#endif // ENABLE_WALLET
 #endif // ENABLE_MINING
\ No newline at end of file
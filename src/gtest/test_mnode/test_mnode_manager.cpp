@@ -0,0 +1,110 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <arith_uint256.h>
+#include <mnode/mnode-controller.h>
+#include <mnode/mnode-manager.h>
+
+using namespace std;
+using namespace testing;
+
+constexpr int TEST_MN_PROTOCOL_VERSION = 170009;
+
+class TestMasternodeMan :
+    public CMasternodeMan,
+    public Test
+{
+public:
+    void SetUp() override
+    {
+        // MN ranks are calculated only when MN list is synced
+        auto& mnSync = masterNodeCtrl.masternodeSync;
+        mnSync.Reset();
+        while (!mnSync.IsMasternodeListSynced())
+            mnSync.SwitchToNextAsset();
+    }
+
+    void TearDown() override
+    {
+        Clear();
+        masterNodeCtrl.masternodeSync.Reset();
+    }
+
+    void AddTestMasternode(const uint32_t n, const int nProtocolVersion = TEST_MN_PROTOCOL_VERSION)
+    {
+        CMasternode mn;
+        mn.vin = CTxIn(COutPoint(ArithToUint256(arith_uint256(n)), 0));
+        mn.nProtocolVersion = nProtocolVersion;
+        // collateral block hash is set - MN score does not depend on the chain state
+        mn.nCollateralMinConfBlockHash = ArithToUint256(arith_uint256(1000 + n));
+        EXPECT_TRUE(Add(mn));
+    }
+};
+
+TEST_F(TestMasternodeMan, ranks_cache)
+{
+    for (uint32_t i = 1; i <= 5; ++i)
+        AddTestMasternode(i);
+    const uint256 blockHash1 = uint256S("1");
+    const uint256 blockHash2 = uint256S("2");
+
+    LOCK(cs);
+    const auto pRanks = GetMasternodeRanksCached(blockHash1, 0);
+    ASSERT_NE(pRanks, nullptr);
+    ASSERT_EQ(pRanks->vRanked.size(), 5u);
+    EXPECT_EQ(mapRanksCache.size(), 1u);
+
+    // ranks are ordered by MN score
+    score_pair_vec_t vScores;
+    ASSERT_TRUE(GetMasternodeScores(blockHash1, vScores));
+    ASSERT_EQ(vScores.size(), pRanks->vRanked.size());
+    for (size_t i = 0; i < vScores.size(); ++i)
+    {
+        const auto& outpoint = vScores[i].second->vin.prevout;
+        EXPECT_EQ(pRanks->vRanked[i], outpoint);
+        EXPECT_EQ(pRanks->mapRank.at(outpoint), static_cast<int>(i + 1));
+    }
+
+    // second call for the same block hash returns cached ranks
+    EXPECT_EQ(GetMasternodeRanksCached(blockHash1, 0), pRanks);
+    // ranks for another block hash are cached separately
+    ASSERT_NE(GetMasternodeRanksCached(blockHash2, 0), nullptr);
+    EXPECT_EQ(mapRanksCache.size(), 2u);
+}
+
+TEST_F(TestMasternodeMan, ranks_cache_invalidation)
+{
+    for (uint32_t i = 1; i <= 3; ++i)
+        AddTestMasternode(i);
+    const uint256 blockHash = uint256S("1");
+    {
+        LOCK(cs);
+        const auto pRanks = GetMasternodeRanksCached(blockHash, 0);
+        ASSERT_NE(pRanks, nullptr);
+        EXPECT_EQ(pRanks->vRanked.size(), 3u);
+    }
+
+    // new MN invalidates ranks cache
+    AddTestMasternode(4, TEST_MN_PROTOCOL_VERSION + 1);
+    {
+        LOCK(cs);
+        EXPECT_TRUE(mapRanksCache.empty());
+        const auto pRanks = GetMasternodeRanksCached(blockHash, 0);
+        ASSERT_NE(pRanks, nullptr);
+        EXPECT_EQ(pRanks->vRanked.size(), 4u);
+        // ranks are cached per min protocol version
+        const auto pRanksProto = GetMasternodeRanksCached(blockHash, TEST_MN_PROTOCOL_VERSION + 1);
+        ASSERT_NE(pRanksProto, nullptr);
+        ASSERT_EQ(pRanksProto->vRanked.size(), 1u);
+        EXPECT_EQ(pRanksProto->mapRank.at(COutPoint(ArithToUint256(arith_uint256(4)), 0)), 1);
+        EXPECT_EQ(mapRanksCache.size(), 2u);
+    }
+
+    // MN list cleared - no ranks
+    Clear();
+    LOCK(cs);
+    EXPECT_TRUE(mapRanksCache.empty());
+    EXPECT_EQ(GetMasternodeRanksCached(blockHash, 0), nullptr);
+}
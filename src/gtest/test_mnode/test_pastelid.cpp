@@ -83,3 +83,130 @@ TEST(PastelID, GetStoredPastelIDs)
             EXPECT_EQ(it3->second, it2->second);
     }
 }
+
+TEST(PastelID, SignatureCache)
+{
+    SelectParams(ChainNetwork::REGTEST);
+
+    gl_pPastelTestEnv->GenerateTempDataDir();
+    auto guard = sg::make_scope_guard([&]() noexcept 
+    {
+        CPastelID::ResetCaches();
+        gl_pPastelTestEnv->ClearTempDataDir();
+    });
+
+    const auto PASS = "passphrase";
+    const auto mapIDs = CPastelID::CreateNewPastelKeys(PASS);
+    ASSERT_FALSE(mapIDs.empty());
+    const string sPastelID = mapIDs.cbegin()->first;
+
+    // small cache to test eviction
+    constexpr size_t MAX_SIG_ENTRIES = 3;
+    CPastelID::ResetCaches(MAX_SIG_ENTRIES, 0);
+
+    const string sText = "text to sign";
+    const string sSignature = CPastelID::Sign(sText, sPastelID, PASS);
+    ASSERT_FALSE(sSignature.empty());
+
+    // first verification - cache miss, signature and public key are cached
+    EXPECT_TRUE(CPastelID::Verify(sText, sSignature, sPastelID));
+    auto stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nSigEntries, 1u);
+    EXPECT_EQ(stats.nSigHits, 0u);
+    EXPECT_EQ(stats.nPubKeyEntries, 1u);
+    EXPECT_EQ(stats.nPubKeyHits, 0u);
+
+    // second verification - signature cache hit
+    EXPECT_TRUE(CPastelID::Verify(sText, sSignature, sPastelID));
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nSigEntries, 1u);
+    EXPECT_EQ(stats.nSigHits, 1u);
+    EXPECT_EQ(stats.nPubKeyHits, 0u);
+
+    // bad signature is never cached - public key is reused
+    const string sBadText = sText + "!";
+    for (size_t i = 1; i <= 2; ++i)
+    {
+        EXPECT_FALSE(CPastelID::Verify(sBadText, sSignature, sPastelID));
+        stats = CPastelID::GetCacheStats();
+        EXPECT_EQ(stats.nSigEntries, 1u);
+        EXPECT_EQ(stats.nSigHits, 1u);
+        EXPECT_EQ(stats.nPubKeyEntries, 1u);
+        EXPECT_EQ(stats.nPubKeyHits, i);
+    }
+
+    // fill the cache above the limit - old entries are evicted
+    v_strings vTexts;
+    for (size_t i = 0; i < MAX_SIG_ENTRIES + 1; ++i)
+    {
+        vTexts.emplace_back(sText + " #" + to_string(i));
+        EXPECT_TRUE(CPastelID::Verify(vTexts.back(), CPastelID::Sign(vTexts.back(), sPastelID, PASS), sPastelID));
+    }
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nSigEntries, MAX_SIG_ENTRIES);
+    EXPECT_EQ(stats.nSigEvictions, 2u);
+
+    // all signatures are still verified correctly, either from cache or re-verified and re-cached
+    const auto prevStats = stats;
+    EXPECT_TRUE(CPastelID::Verify(sText, sSignature, sPastelID));
+    EXPECT_FALSE(CPastelID::Verify(sBadText, sSignature, sPastelID));
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nSigEntries, MAX_SIG_ENTRIES);
+    EXPECT_EQ((stats.nSigHits - prevStats.nSigHits) + (stats.nSigEvictions - prevStats.nSigEvictions), 1u);
+}
+
+TEST(PastelID, PubKeyCache)
+{
+    SelectParams(ChainNetwork::REGTEST);
+
+    gl_pPastelTestEnv->GenerateTempDataDir();
+    auto guard = sg::make_scope_guard([&]() noexcept 
+    {
+        CPastelID::ResetCaches();
+        gl_pPastelTestEnv->ClearTempDataDir();
+    });
+
+    const auto PASS = "passphrase";
+    constexpr size_t MAX_PUBKEY_ENTRIES = 2;
+    v_strings vPastelIDs;
+    for (size_t i = 0; i < MAX_PUBKEY_ENTRIES + 1; ++i)
+    {
+        const auto mapIDs = CPastelID::CreateNewPastelKeys(PASS);
+        ASSERT_FALSE(mapIDs.empty());
+        vPastelIDs.push_back(mapIDs.cbegin()->first);
+    }
+    CPastelID::ResetCaches(0, MAX_PUBKEY_ENTRIES);
+
+    const string sText = "text to sign";
+    // decoded public key is reused for the different signatures of the same Pastel ID
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const string sNextText = sText + to_string(i);
+        EXPECT_TRUE(CPastelID::Verify(sNextText, CPastelID::Sign(sNextText, vPastelIDs[0], PASS), vPastelIDs[0]));
+    }
+    auto stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nPubKeyEntries, 1u);
+    EXPECT_EQ(stats.nPubKeyHits, 1u);
+    EXPECT_EQ(stats.nPubKeyEvictions, 0u);
+
+    // signature of the other Pastel ID is not valid
+    EXPECT_FALSE(CPastelID::Verify(sText, CPastelID::Sign(sText, vPastelIDs[0], PASS), vPastelIDs[1]));
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nPubKeyEntries, 2u);
+    EXPECT_EQ(stats.nPubKeyEvictions, 0u);
+
+    // public key cache is full - one key is evicted
+    EXPECT_TRUE(CPastelID::Verify(sText, CPastelID::Sign(sText, vPastelIDs[2], PASS), vPastelIDs[2]));
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nPubKeyEntries, MAX_PUBKEY_ENTRIES);
+    EXPECT_EQ(stats.nPubKeyEvictions, 1u);
+
+    // all signatures are still verified correctly
+    for (const auto& sPastelID : vPastelIDs)
+    {
+        const string sNextText = sText + sPastelID;
+        EXPECT_TRUE(CPastelID::Verify(sNextText, CPastelID::Sign(sNextText, sPastelID, PASS), sPastelID));
+    }
+    stats = CPastelID::GetCacheStats();
+    EXPECT_EQ(stats.nPubKeyEntries, MAX_PUBKEY_ENTRIES);
+}
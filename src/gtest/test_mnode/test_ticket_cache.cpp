@@ -0,0 +1,105 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <arith_uint256.h>
+#include <mnode/ticket-cache.h>
+
+using namespace std;
+using namespace testing;
+
+class TestTicketCache : public Test
+{
+protected:
+    static CSerializeData CreateData(const size_t nSize)
+    {
+        return CSerializeData(nSize, 'x');
+    }
+};
+
+TEST_F(TestTicketCache, get_put)
+{
+    CTicketCache cache;
+    const uint256 txid = uint256S("1");
+    TicketID ticketId = TicketID::InvalidID;
+    uint32_t nHeight = 0;
+    CSerializeData vData;
+
+    EXPECT_FALSE(cache.Get(txid, ticketId, nHeight, vData));
+    cache.Put(txid, TicketID::NFT, 100, CreateData(10), cache.GetGeneration());
+    ASSERT_TRUE(cache.Get(txid, ticketId, nHeight, vData));
+    EXPECT_EQ(ticketId, TicketID::NFT);
+    EXPECT_EQ(nHeight, 100u);
+    EXPECT_EQ(vData.size(), 10u);
+
+    const auto stats = cache.GetStats();
+    EXPECT_EQ(stats.nHits, 1u);
+    EXPECT_EQ(stats.nMisses, 1u);
+    EXPECT_EQ(stats.nEntries, 1u);
+    EXPECT_GT(stats.nUsage, 10u);
+}
+
+TEST_F(TestTicketCache, lru_eviction)
+{
+    CTicketCache cache;
+    TicketID ticketId;
+    uint32_t nHeight;
+    CSerializeData vData;
+
+    const uint256 txid1 = uint256S("1");
+    const uint256 txid2 = uint256S("2");
+    const uint256 txid3 = uint256S("3");
+    cache.Put(txid1, TicketID::NFT, 1, CreateData(1000), cache.GetGeneration());
+    const size_t nEntryUsage = cache.GetStats().nUsage;
+    // room for two entries only
+    cache.SetMaxSize(nEntryUsage * 2);
+    cache.Put(txid2, TicketID::NFT, 2, CreateData(1000), cache.GetGeneration());
+    // txid1 becomes most recently used
+    EXPECT_TRUE(cache.Get(txid1, ticketId, nHeight, vData));
+    // txid2 should be evicted
+    cache.Put(txid3, TicketID::NFT, 3, CreateData(1000), cache.GetGeneration());
+    EXPECT_TRUE(cache.Get(txid1, ticketId, nHeight, vData));
+    EXPECT_FALSE(cache.Get(txid2, ticketId, nHeight, vData));
+    EXPECT_TRUE(cache.Get(txid3, ticketId, nHeight, vData));
+    EXPECT_EQ(cache.GetStats().nEvictions, 1u);
+    EXPECT_LE(cache.GetStats().nUsage, nEntryUsage * 2);
+}
+
+TEST_F(TestTicketCache, erase_above_height)
+{
+    CTicketCache cache;
+    TicketID ticketId;
+    uint32_t nHeight;
+    CSerializeData vData;
+
+    for (uint32_t i = 1; i <= 10; ++i)
+        cache.Put(ArithToUint256(arith_uint256(i)), TicketID::Activate, i, CreateData(10), cache.GetGeneration());
+    cache.EraseAboveHeight(5);
+    EXPECT_EQ(cache.GetStats().nEntries, 5u);
+    EXPECT_TRUE(cache.Get(ArithToUint256(arith_uint256(5)), ticketId, nHeight, vData));
+    EXPECT_FALSE(cache.Get(ArithToUint256(arith_uint256(6)), ticketId, nHeight, vData));
+    cache.Clear();
+    EXPECT_EQ(cache.GetStats().nEntries, 0u);
+    EXPECT_EQ(cache.GetStats().nUsage, 0u);
+}
+
+TEST_F(TestTicketCache, put_after_invalidation)
+{
+    CTicketCache cache;
+    TicketID ticketId;
+    uint32_t nHeight;
+    CSerializeData vData;
+
+    const uint256 txid = uint256S("1");
+    // ticket data was read before the block was disconnected
+    const uint64_t nGeneration = cache.GetGeneration();
+    cache.EraseAboveHeight(5);
+    cache.Put(txid, TicketID::NFT, 10, CreateData(10), nGeneration);
+    EXPECT_FALSE(cache.Get(txid, ticketId, nHeight, vData));
+    EXPECT_EQ(cache.GetStats().nEntries, 0u);
+
+    // data read after invalidation is cached
+    cache.Put(txid, TicketID::NFT, 5, CreateData(10), cache.GetGeneration());
+    EXPECT_TRUE(cache.Get(txid, ticketId, nHeight, vData));
+}
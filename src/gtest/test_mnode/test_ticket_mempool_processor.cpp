@@ -6,24 +6,12 @@
 #include <txmempool.h>
 #include <mnode/ticket-mempool-processor.h>
 #include <mnode/tickets/username-change.h>
+#include "test_mempool_entryhelper.h"
 #include "test_mnode/test_ticket_mempool.h"
 
 using namespace testing;
 using namespace std;
 
-class MockTxMemPool : public CTxMemPool
-{
-public:
-    MockTxMemPool(const CFeeRate& _minRelayFee) : 
-        CTxMemPool(_minRelayFee)
-    {}
-    
-    // Lookup for the transaction with the specific hash (txid).
-    MOCK_METHOD(bool, lookup, (const uint256& txid, CTransaction& tx, uint32_t* nBlockHeight), (const, override));
-    // Get a list of transactions by txids
-    MOCK_METHOD(void, batch_lookup, (const v_uint256& vTxid, std::vector<CMutableTransaction>& vTx, v_uints& vBlockHeight), (const, override));
-};
-
 class TestTktMemPoolProcessor : 
     public CPastelTicketMemPoolProcessor,
     public Test
@@ -36,42 +24,26 @@ public:
 
 TEST_F(TestTktMemPoolProcessor, ticket_search)
 {
-    MockTxMemPool txMemPool(CFeeRate(0));
+    CTxMemPool txMemPool(CFeeRate(0));
 
     auto pMemPoolTracker = make_shared<MockTicketTxMemPoolTracker>();
     ASSERT_NE(pMemPoolTracker, nullptr);
+    txMemPool.AddTxMemPoolTracker(pMemPoolTracker);
 
-    v_uint256 vTxid_username, vTxid_pastelid;
-    vector<CMutableTransaction> vTx;
-    v_uints vBlockHeight;
+    TestMemPoolEntryHelper entry;
+    entry.hadNoDependencies = true;
     for (uint32_t i = 0; i < 10; ++i) {
         CMutableTransaction tx = CreateTicketTransaction(TicketID::Username, [&](CPastelTicket& tkt) {
             auto& userNameTicket = dynamic_cast<CChangeUsernameTicket&>(tkt);
             userNameTicket.username = to_string(i);
             userNameTicket.pastelID = strprintf("Pastel-ID-%u", i);
         });
-        vTx.push_back(tx);
-        vBlockHeight.emplace_back(100 + i);
-        vTxid_username.emplace_back(tx.GetHash());
+        EXPECT_TRUE(txMemPool.addUnchecked(tx.GetHash(), entry.Height(100 + i).FromTx(tx)));
     }
-    pMemPoolTracker->Mock_AddTestData(TicketID::PastelID, 20, vTxid_pastelid);
-    pMemPoolTracker->Mock_AddTestTxids(TicketID::Username, vTxid_username);
+    EXPECT_EQ(pMemPoolTracker->Call_count(TicketID::Username), 10u);
 
-    Sequence s1;
     m_TicketID = TicketID::Username;
-    EXPECT_CALL(*pMemPoolTracker, getTicketTransactions(TicketID::Username, ::testing::_))
-        .WillOnce(DoAll(
-            SetArgReferee<1>(vTxid_username),
-            Return()));
-    EXPECT_CALL(txMemPool, batch_lookup)
-        .WillOnce(DoAll(
-                SetArgReferee<1>(vTx),
-                SetArgReferee<2>(vBlockHeight),
-                Return()
-            ));
-
     EXPECT_NO_THROW(Initialize(txMemPool, pMemPoolTracker));
-    EXPECT_EQ(m_vTicket.size(), 10u);
 
     // FindTicket
     auto pTkt = CPastelTicketProcessor::CreateTicket(TicketID::Username);
@@ -80,6 +52,7 @@ TEST_F(TestTktMemPoolProcessor, ticket_search)
     userNameTkt.username = "5";
     EXPECT_TRUE(FindTicket(userNameTkt));
     EXPECT_EQ(userNameTkt.pastelID, "Pastel-ID-5");
+    EXPECT_EQ(userNameTkt.GetBlock(), 105u);
     
     userNameTkt.Clear();
     userNameTkt.username = "not_existing";
@@ -102,5 +75,24 @@ TEST_F(TestTktMemPoolProcessor, ticket_search)
     userNameTkt.Clear();
     userNameTkt.pastelID = "not_existing";
     EXPECT_FALSE(FindTicketBySecondaryKey(userNameTkt));
+
+    // ListTickets
+    mempool_tickets_t vTickets;
+    EXPECT_TRUE(ListTickets(vTickets, "3"));
+    ASSERT_EQ(vTickets.size(), 1u);
+    EXPECT_EQ(vTickets[0]->KeyTwo(), "Pastel-ID-3");
+    vTickets.clear();
+    const string sKeyTwo = "Pastel-ID-4";
+    EXPECT_FALSE(ListTickets(vTickets, "3", &sKeyTwo));
+
+    // ticket is removed from the indexes with the transaction
+    const auto pTkt3 = pMemPoolTracker->findTicket(TicketID::Username, TICKET_KEY_TYPE::KEY_ONE, "3");
+    ASSERT_NE(pTkt3, nullptr);
+    CTransaction tx3;
+    ASSERT_TRUE(txMemPool.lookup(uint256S(pTkt3->GetTxId()), tx3));
+    txMemPool.remove(tx3);
+    EXPECT_FALSE(TicketExists("3"));
+    EXPECT_FALSE(TicketExistsBySecondaryKey("Pastel-ID-3"));
+    EXPECT_EQ(pMemPoolTracker->Call_count(TicketID::Username), 9u);
 }
 
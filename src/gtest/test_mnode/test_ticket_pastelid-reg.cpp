@@ -0,0 +1,103 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <main.h>
+#include <key.h>
+#include <uint256.h>
+#include <mnode/tickets/pastelid-reg.h>
+#include <mnode/mnode-controller.h>
+#include <pastel_gtest_main.h>
+
+using namespace std;
+using namespace testing;
+
+#ifdef ENABLE_MINING
+class TestPastelIDRegTicket : public Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        gl_pPastelTestEnv->InitializeRegTest();
+        gl_pPastelTestEnv->generate_coins(masterNodeCtrl.MinTicketConfirmations + 5);
+    }
+
+    static void TearDownTestSuite()
+    {
+        gl_pPastelTestEnv->FinalizeRegTest();
+    }
+
+protected:
+    static constexpr auto TEST_PASSPHRASE = "passphrase";
+    static constexpr auto TEST_ADDRESS = "tPj5BfCrLfLpuviSJrD3B1yyWp3XkgtFjb6";
+
+    // create Pastel ID registration ticket "stored" in the given block
+    static CPastelIDRegTicket CreateTicket(string&& sTxId, const uint32_t nBlock, const optional<CMNID_RegData> &mnRegData = nullopt)
+    {
+        const auto keys = CPastelID::CreateNewPastelKeys(TEST_PASSPHRASE);
+        EXPECT_FALSE(keys.empty());
+        string sPastelID = keys.empty() ? string() : keys.cbegin()->first;
+        auto ticket = CPastelIDRegTicket::Create(move(sPastelID), TEST_PASSPHRASE, TEST_ADDRESS, mnRegData);
+        ticket.SetTxId(move(sTxId));
+        ticket.SetBlock(nBlock);
+        return ticket;
+    }
+
+    static uint32_t GetChainHeight()
+    {
+        LOCK(cs_main);
+        return static_cast<uint32_t>(chainActive.Height());
+    }
+};
+
+// fully confirmed personal Pastel ID registration ticket: cache hit and miss on the different block height
+TEST_F(TestPastelIDRegTicket, validity_cache_confirmed)
+{
+    auto ticket = CreateTicket(uint256S("a1").GetHex(), 1);
+    ASSERT_GE(GetChainHeight() - 1, masterNodeCtrl.MinTicketConfirmations);
+    // cache miss - full validation, valid ticket is cached
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+
+    const auto vSignature = ticket.pslid_signature;
+    ticket.pslid_signature[0] ^= 0xFF;
+    // cache hit - signature is not verified again
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+    // pre-registration check never uses the cache
+    EXPECT_TRUE(ticket.IsValid(true, 0).IsNotValid());
+
+    // same txid, but different block height (reorg) - cache miss
+    ticket.SetBlock(2);
+    EXPECT_TRUE(ticket.IsValid(false, 0).IsNotValid());
+
+    // restore signature - ticket is valid and cached for the new height
+    ticket.pslid_signature = vSignature;
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+    ticket.pslid_signature[0] ^= 0xFF;
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+    ticket.SetBlock(1);
+    EXPECT_TRUE(ticket.IsValid(false, 0).IsNotValid());
+}
+
+// not confirmed ticket is never cached
+TEST_F(TestPastelIDRegTicket, validity_cache_not_confirmed)
+{
+    auto ticket = CreateTicket(uint256S("a2").GetHex(), GetChainHeight());
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+    ticket.pslid_signature[0] ^= 0xFF;
+    EXPECT_TRUE(ticket.IsValid(false, 0).IsNotValid());
+}
+
+// MN Pastel ID ticket is not cached if MN checks were skipped (MNs are not synced)
+TEST_F(TestPastelIDRegTicket, validity_cache_mnid_not_synced)
+{
+    ASSERT_FALSE(masterNodeCtrl.masternodeSync.IsSynced());
+    CMNID_RegData mnRegData(false);
+    mnRegData.outpoint = COutPoint(uint256S("b1"), 0);
+    mnRegData.mnPrivKey.MakeNewKey(true);
+    auto ticket = CreateTicket(uint256S("a3").GetHex(), 1, mnRegData);
+    EXPECT_FALSE(ticket.IsValid(false, 0).IsNotValid());
+    ticket.pslid_signature[0] ^= 0xFF;
+    EXPECT_TRUE(ticket.IsValid(false, 0).IsNotValid());
+}
+#endif // ENABLE_MINING
@@ -4,7 +4,9 @@
 #include <gtest/gtest.h>
 #include <json/json.hpp>
 
+#include <utilstrencodings.h>
 #include <mnode/ticket-processor.h>
+#include <mnode/tickets/nft-reg.h>
 #include <pastel_gtest_main.h>
 #include <test_mnode/mock_ticket.h>
 
@@ -120,3 +122,161 @@ INSTANTIATE_TEST_SUITE_P(ticket_processor, PTest_fuzzy_filter, Values(
     make_tuple(R"(-42)", "-43", false),
     make_tuple(R"(2.3)", "2.4", false)
 ));
+
+TEST(ticket_processor, height_index_key)
+{
+    const string sTxId1(64, 'f');
+    const string sTxId2(64, '0');
+    const auto sKey1 = CPastelTicketProcessor::RealHeightKey(99, sTxId1);
+    const auto sKey2 = CPastelTicketProcessor::RealHeightKey(100, sTxId2);
+    const auto sKey3 = CPastelTicketProcessor::RealHeightKey(1'000'000, sTxId2);
+    // all height index keys have the same length
+    EXPECT_EQ(sKey1.size(), sKey2.size());
+    EXPECT_EQ(sKey2.size(), sKey3.size());
+    // height index keys are ordered by height
+    EXPECT_LT(sKey1, sKey2);
+    EXPECT_LT(sKey2, sKey3);
+    EXPECT_EQ(sKey1.compare(0, 3, "@H@"), 0);
+}
+
+TEST(ticket_processor, mvkey_row)
+{
+    const string sTxId1(64, 'f');
+    const string sTxId2(64, '0');
+    const string sMVKey = "jXYqZNPj21RVnwxnEJ654wEdzi7GZTZ5LAdiotBmPrF7pDMkpX1JegDMQZX55WZLkvy9fxNpZcbBJdWFnMK2q";
+    const auto sRow1 = CPastelTicketProcessor::RealMVKeyRow(sMVKey, 99, sTxId1);
+    const auto sRow2 = CPastelTicketProcessor::RealMVKeyRow(sMVKey, 100, sTxId2);
+    // all rows for the same MV key have the same length and common prefix
+    EXPECT_EQ(sRow1.size(), sRow2.size());
+    const auto sPrefix = CPastelTicketProcessor::RealMVKey(sMVKey) + '\0';
+    EXPECT_EQ(sRow1.compare(0, sPrefix.size(), sPrefix), 0);
+    EXPECT_EQ(sRow2.compare(0, sPrefix.size(), sPrefix), 0);
+    // rows are ordered by height
+    EXPECT_LT(sRow1, sRow2);
+    EXPECT_EQ(sRow1.substr(sRow1.size() - sTxId1.size()), sTxId1);
+}
+
+TEST(ticket_processor, nft_search_attributes_fuzzy_filter)
+{
+    // trigram mask of the substring is a subset of the string mask
+    const string sValue = "case insensitive string subsearch";
+    const auto nMask = CNFTSearchAttributes::GetTrigramMask(sValue);
+    const auto nSubMask = CNFTSearchAttributes::GetTrigramMask("sensitive");
+    EXPECT_EQ(nMask & nSubMask, nSubMask);
+    EXPECT_EQ(CNFTSearchAttributes::GetTrigramMask("ab"), 0u);
+
+    CNFTSearchAttributes attrs;
+    nft_search_prop_t prop;
+    prop.nType = to_integral_type(NFT_SEARCH_PROP_TYPE::string);
+    prop.sValue = sValue;
+    prop.nTrigramMask = nMask;
+    attrs.mapProps.emplace("keywords", prop);
+    prop.nType = to_integral_type(NFT_SEARCH_PROP_TYPE::boolean);
+    prop.sValue = "1";
+    prop.nTrigramMask = 0;
+    attrs.mapProps.emplace("green", prop);
+    attrs.setNotIndexedProps.insert("series");
+
+    EXPECT_TRUE(attrs.PassFuzzyFilter("keywords", "Sea").value());
+    EXPECT_TRUE(attrs.PassFuzzyFilter("keywords", "SUBSEARCH").value());
+    EXPECT_FALSE(attrs.PassFuzzyFilter("keywords", "mystr").value());
+    EXPECT_TRUE(attrs.PassFuzzyFilter("green", "yes").value());
+    EXPECT_FALSE(attrs.PassFuzzyFilter("green", "no").value());
+    // unknown properties are skipped
+    EXPECT_TRUE(attrs.PassFuzzyFilter("creator_name", "any").value());
+    // not indexed properties should be checked using app ticket json
+    EXPECT_FALSE(attrs.PassFuzzyFilter("series", "any").has_value());
+}
+
+TEST(ticket_processor, nft_search_attributes_not_scalar_props)
+{
+    const json jApp = {
+        { "keywords", "sea, sky" },
+        { "tags", { "sea", "sky" } },
+        { "meta", { { "sea", 1 } } },
+        { "series", nullptr }
+    };
+    const json jNFT = { { "app_ticket", EncodeBase64(jApp.dump()) } };
+    const CNFTRegTicket ticket(EncodeBase64(jNFT.dump()));
+
+    CNFTSearchAttributes attrs;
+    string error;
+    ASSERT_TRUE(attrs.Parse(ticket, error)) << error;
+    EXPECT_EQ(attrs.mapProps.count("keywords"), 1u);
+    EXPECT_TRUE(attrs.PassFuzzyFilter("keywords", "sea").value());
+    // arrays, objects and nulls should be checked by searchthumbids using app ticket json
+    for (const auto& sPropName : { "tags", "meta", "series" })
+    {
+        EXPECT_EQ(attrs.setNotIndexedProps.count(sPropName), 1u) << sPropName;
+        EXPECT_FALSE(attrs.PassFuzzyFilter(sPropName, "sea").has_value()) << sPropName;
+        // json path rejects fuzzy filter on non-scalar values
+        EXPECT_FALSE(isValuePassFuzzyFilter(jApp[sPropName], "sea")) << sPropName;
+    }
+    // missing properties are still skipped
+    EXPECT_TRUE(attrs.PassFuzzyFilter("creator_name", "any").value());
+}
+
+TEST(ticket_processor, json_to_univalue)
+{
+    const json j = {
+        { "type", "username-change" },
+        { "height", 123 },
+        { "fee", 100'000'000'000ULL },
+        { "offset", -5 },
+        { "ratio", 0.25 },
+        { "active", true },
+        { "empty", nullptr },
+        { "list", { 1, "two", { { "three", 3 } } } }
+    };
+    const UniValue v = JSONToUniValue(j);
+    ASSERT_TRUE(v.isObject());
+    EXPECT_EQ(v["height"].get_int(), 123);
+    EXPECT_EQ(v["fee"].get_int64(), 100'000'000'000LL);
+    EXPECT_TRUE(v["empty"].isNull());
+    // same serialization as json::dump()
+    EXPECT_EQ(v.write(), j.dump());
+}
+
+TEST(ticket_processor, tickets_list_page)
+{
+    vector<CChangeUsernameTicket> vTickets;
+    for (size_t i = 0; i < 10; ++i)
+        vTickets.emplace_back("pastelid", "user" + to_string(i));
+
+    const auto WritePage = [&](const tickets_list_page_t& page, size_t &nAdded) -> json
+    {
+        CTicketsJSONArrayWriter writer(page);
+        nAdded = 0;
+        for (const auto& ticket : vTickets)
+        {
+            ++nAdded;
+            if (!writer.Add(ticket))
+                break;
+        }
+        return json::parse(writer.Finish().write());
+    };
+
+    size_t nAdded = 0;
+    // no limit - all tickets
+    json j = WritePage({}, nAdded);
+    ASSERT_TRUE(j.is_array());
+    EXPECT_EQ(j.size(), vTickets.size());
+    EXPECT_EQ(nAdded, vTickets.size());
+
+    // offset 3, limit 4 - tickets 3..6, enumeration stops after the last one
+    j = WritePage({ 3, 4 }, nAdded);
+    ASSERT_EQ(j.size(), 4u);
+    EXPECT_EQ(nAdded, 7u);
+    for (size_t i = 0; i < j.size(); ++i)
+        EXPECT_EQ(j[i]["ticket"]["username"], "user" + to_string(i + 3));
+
+    // offset beyond the end - empty array
+    j = WritePage({ 20, 4 }, nAdded);
+    EXPECT_TRUE(j.is_array());
+    EXPECT_TRUE(j.empty());
+
+    // limit exceeds the number of remaining tickets
+    j = WritePage({ 8, 5 }, nAdded);
+    ASSERT_EQ(j.size(), 2u);
+    EXPECT_EQ(j[1]["ticket"]["username"], "user9");
+}
@@ -5,9 +5,11 @@
 
 #include <gtest/gtest.h>
 
+#include "arith_uint256.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "pow.h"
+#include "primitives/block.h"
 #include "random.h"
 
 using namespace std;
@@ -198,3 +200,36 @@ TEST(PoW, GetBlockProofEquivalentTime_test)
         EXPECT_EQ(tdiff, p1->GetBlockTime() - p2->GetBlockTime());
     }
 }
+
+/* Test Equihash solutions check of the block headers batch with invalid solutions */
+TEST(PoW, check_equihash_solutions)
+{
+    SelectParams(ChainNetwork::REGTEST);
+    const auto& chainparams = Params();
+    const Consensus::Params& params = chainparams.GetConsensus();
+
+    const CBlockHeader validHeader = chainparams.GenesisBlock();
+    ASSERT_TRUE(CheckEquihashSolution(&validHeader, params));
+
+    CBlockHeader badNonceHeader = validHeader;
+    badNonceHeader.nNonce = ArithToUint256(UintToArith256(badNonceHeader.nNonce) + 1);
+    CBlockHeader badSolutionHeader = validHeader;
+    badSolutionHeader.nSolution[0] ^= 0xFF;
+
+    vector<CBlockHeader> vHeaders = { validHeader, badNonceHeader, validHeader, badSolutionHeader, badSolutionHeader };
+    v_uint8 vValid(vHeaders.size(), 0);
+    // last header is marked as already verified - it should be skipped
+    vValid.back() = 1;
+    CheckEquihashSolutions(vHeaders, params, vValid);
+    EXPECT_EQ(vValid, v_uint8({ 1, 0, 1, 0, 1 }));
+
+    // output vector is resized to the number of headers
+    vValid.clear();
+    CheckEquihashSolutions(vHeaders, params, vValid);
+    EXPECT_EQ(vValid, v_uint8({ 1, 0, 1, 0, 0 }));
+
+    // empty batch
+    vHeaders.clear();
+    CheckEquihashSolutions(vHeaders, params, vValid);
+    EXPECT_TRUE(vValid.empty());
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <key_io.h>
+#include <main.h>
+#include <transaction_builder.h>
+#include <sapling_check.h>
+#include <script_check.h>
+#include <zcash/Address.hpp>
+#include <pastel_gtest_utils.h>
+
+using namespace std;
+using namespace testing;
+
+static const string tSecretRegtest = "cND2ZvtabDbJ1gucx9GWH6XT9kgTAqfb6cotPt5Q5CyxVDhid2EN";
+
+class TestSaplingProofCheck : public Test
+{
+public:
+    static void SetUpTestSuite()
+    {
+        RegtestActivateSapling();
+    }
+
+    static void TearDownTestSuite()
+    {
+        RegtestDeactivateSapling();
+    }
+
+protected:
+    static constexpr int TEST_HEIGHT = 3;
+
+    // create valid transaction with one Sapling spend and two Sapling outputs
+    static CTransaction CreateSaplingTransaction()
+    {
+        const auto& consensusParams = Params().GetConsensus();
+        string sKeyError;
+        CBasicKeyStore keystore;
+        KeyIO keyIO(Params());
+        const CKey tsk = keyIO.DecodeSecret(tSecretRegtest, sKeyError);
+        EXPECT_TRUE(tsk.IsValid());
+        keystore.AddKey(tsk);
+        const auto scriptPubKey = GetScriptForDestination(tsk.GetPubKey().GetID());
+
+        const auto sk = libzcash::SaplingSpendingKey::random();
+        const auto expsk = sk.expanded_spending_key();
+        const auto fvk = sk.full_viewing_key();
+        const auto ivk = fvk.in_viewing_key();
+        const auto pk = sk.default_address();
+
+        // shielding transaction from transparent to Sapling
+        auto builder1 = TransactionBuilder(consensusParams, TEST_HEIGHT - 1, &keystore);
+        builder1.AddTransparentInput(COutPoint(), scriptPubKey, 50000);
+        builder1.AddSaplingOutput(fvk.ovk, pk, 40000, {});
+        const auto tx1 = builder1.Build().GetTxOrThrow();
+
+        // spend the note that was just created
+        auto maybe_pt = libzcash::SaplingNotePlaintext::decrypt(
+            tx1.vShieldedOutput[0].encCiphertext, ivk, tx1.vShieldedOutput[0].ephemeralKey, tx1.vShieldedOutput[0].cm);
+        EXPECT_TRUE(static_cast<bool>(maybe_pt));
+        auto maybe_note = maybe_pt.value().note(ivk);
+        EXPECT_TRUE(static_cast<bool>(maybe_note));
+        SaplingMerkleTree tree;
+        tree.append(tx1.vShieldedOutput[0].cm);
+
+        auto builder2 = TransactionBuilder(consensusParams, TEST_HEIGHT);
+        builder2.AddSaplingSpend(expsk, maybe_note.value(), tree.root(), tree.witness());
+        builder2.AddSaplingOutput(fvk.ovk, pk, 25000, {});
+        return builder2.Build().GetTxOrThrow();
+    }
+
+    /**
+     * Verify Sapling proofs inline (ContextualCheckTransaction) and via CSaplingProofCheck,
+     * check that both paths report the same result, reject reason and DoS level.
+     */
+    static void CheckSaplingProofs(const CTransaction& tx, const bool isMined, const string& sExpectedRejectReason, const int nExpectedDoS)
+    {
+        const auto fnNotIBD = [](const Consensus::Params&) { return false; };
+        const bool bExpectedValid = sExpectedRejectReason.empty();
+
+        // inline proof verification
+        CValidationState state;
+        EXPECT_EQ(ContextualCheckTransaction(tx, state, Params(), TEST_HEIGHT, isMined, fnNotIBD), bExpectedValid);
+        EXPECT_EQ(state.GetRejectReason(), sExpectedRejectReason);
+        int nDoS = 0;
+        EXPECT_EQ(state.IsInvalid(nDoS), !bExpectedValid);
+        EXPECT_EQ(nDoS, nExpectedDoS);
+
+        // deferred proof verification
+        CValidationState deferredState;
+        vector<CSaplingProofCheck> vChecks;
+        EXPECT_TRUE(ContextualCheckTransaction(tx, deferredState, Params(), TEST_HEIGHT, isMined, fnNotIBD, &vChecks));
+        ASSERT_EQ(vChecks.size(), 1u);
+        sapling_check_result_t result;
+        vChecks[0].SetResult(&result);
+        EXPECT_EQ(gl_ScriptCheckManager.RunChecks(vChecks), bExpectedValid);
+        EXPECT_EQ(result.bValid, bExpectedValid);
+        EXPECT_EQ(result.sRejectReason, state.GetRejectReason());
+        EXPECT_EQ(result.nDoS, nDoS);
+    }
+};
+
+TEST_F(TestSaplingProofCheck, reject_reasons)
+{
+    const auto tx = CreateSaplingTransaction();
+    ASSERT_EQ(tx.vShieldedSpend.size(), 1u);
+    ASSERT_FALSE(tx.vShieldedOutput.empty());
+
+    for (const bool isMined : { true, false })
+    {
+        SCOPED_TRACE(isMined ? "block" : "mempool");
+        const int nDoSRelaxing = isMined ? 100 : 10;
+
+        CheckSaplingProofs(tx, isMined, "", 0);
+
+        CMutableTransaction mtx(tx);
+        mtx.vShieldedSpend[0].zkproof[0] ^= 0xFF;
+        CheckSaplingProofs(mtx, isMined, "bad-txns-sapling-spend-description-invalid", nDoSRelaxing);
+
+        mtx = CMutableTransaction(tx);
+        mtx.vShieldedOutput[0].zkproof[0] ^= 0xFF;
+        // invalid output description is always rejected with the block DoS level
+        CheckSaplingProofs(mtx, isMined, "bad-txns-sapling-output-description-invalid", 100);
+
+        mtx = CMutableTransaction(tx);
+        mtx.bindingSig[0] ^= 0xFF;
+        CheckSaplingProofs(mtx, isMined, "bad-txns-sapling-binding-signature-invalid", nDoSRelaxing);
+    }
+}
+
+// checks of the several transactions - each check reports its own result
+TEST_F(TestSaplingProofCheck, batch)
+{
+    const auto tx = CreateSaplingTransaction();
+    CMutableTransaction mtx(tx);
+    mtx.bindingSig[0] ^= 0xFF;
+    const CTransaction txBad(mtx);
+
+    const auto fnNotIBD = [](const Consensus::Params&) { return false; };
+    vector<CSaplingProofCheck> vChecks;
+    CValidationState state;
+    EXPECT_TRUE(ContextualCheckTransaction(tx, state, Params(), TEST_HEIGHT, true, fnNotIBD, &vChecks));
+    EXPECT_TRUE(ContextualCheckTransaction(txBad, state, Params(), TEST_HEIGHT, true, fnNotIBD, &vChecks));
+    ASSERT_EQ(vChecks.size(), 2u);
+
+    vector<sapling_check_result_t> vResults(vChecks.size());
+    for (size_t i = 0; i < vChecks.size(); ++i)
+        vChecks[i].SetResult(&vResults[i]);
+    EXPECT_FALSE(gl_ScriptCheckManager.RunChecks(vChecks));
+    EXPECT_TRUE(vResults[0].bValid);
+    EXPECT_FALSE(vResults[1].bValid);
+    EXPECT_EQ(vResults[1].sRejectReason, "bad-txns-sapling-binding-signature-invalid");
+    EXPECT_EQ(vResults[1].nDoS, 100);
+}
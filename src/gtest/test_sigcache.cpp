@@ -0,0 +1,43 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <script/sigcache.h>
+#include <random.h>
+#include <util.h>
+
+using namespace std;
+using namespace testing;
+
+TEST(test_sigcache, batch_insert_bounded)
+{
+    mapArgs["-maxsigcachesize"] = "1";
+    InitSignatureCache();
+
+    const auto statsBefore = GetSignatureCacheStats();
+    EXPECT_GT(statsBefore.nMaxEntries, 0u);
+
+    // insert more entries than the cache can hold
+    const size_t nEntries = statsBefore.nMaxEntries * 2;
+    v_uint256 vEntries;
+    vEntries.reserve(nEntries);
+    for (size_t i = 0; i < nEntries; ++i)
+        vEntries.push_back(GetRandHash());
+    SignatureCacheInsertBatch(vEntries);
+
+    const auto stats = GetSignatureCacheStats();
+    EXPECT_EQ(stats.nInserts - statsBefore.nInserts, nEntries);
+    EXPECT_GT(stats.nEvictions, statsBefore.nEvictions);
+    EXPECT_LE(stats.nEntries, stats.nMaxEntries);
+
+    // disabled cache does not accept new entries
+    mapArgs["-maxsigcachesize"] = "0";
+    InitSignatureCache();
+    SignatureCacheInsertBatch(vEntries);
+    EXPECT_EQ(GetSignatureCacheStats().nInserts, stats.nInserts);
+
+    mapArgs.erase("-maxsigcachesize");
+    InitSignatureCache();
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2022 The Pastel developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <gtest/gtest.h>
+
+#include <socket_events.h>
+
+using namespace std;
+using namespace testing;
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+
+class TestSocketEvents : public Test
+{
+public:
+    void SetUp() override
+    {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, m_sockets), 0);
+    }
+
+    void TearDown() override
+    {
+        close(m_sockets[0]);
+        close(m_sockets[1]);
+    }
+
+protected:
+    int m_sockets[2] = { -1, -1 };
+};
+
+TEST_F(TestSocketEvents, recv_send)
+{
+    CSocketEventWaiter waiter;
+    const SOCKET hSocket = m_sockets[0];
+    EXPECT_TRUE(waiter.IsSupportedSocket(hSocket));
+
+    socket_events_t mapEvents;
+    string error;
+    ASSERT_TRUE(waiter.SetSocketEvents(hSocket, 1, SOCKET_EVENT_RECV));
+    EXPECT_EQ(waiter.GetSockets().size(), 1u);
+    // nothing to receive yet
+    ASSERT_TRUE(waiter.Wait(mapEvents, 0, error)) << error;
+    EXPECT_TRUE(mapEvents.empty());
+
+    ASSERT_EQ(write(m_sockets[1], "x", 1), 1);
+    ASSERT_TRUE(waiter.Wait(mapEvents, 100, error)) << error;
+    ASSERT_EQ(mapEvents.count(hSocket), 1u);
+    EXPECT_TRUE(mapEvents[hSocket] & SOCKET_EVENT_RECV);
+    EXPECT_FALSE(mapEvents[hSocket] & SOCKET_EVENT_SEND);
+
+    // level-triggered: data is still not read - event is reported again,
+    // registration is kept between the waits
+    ASSERT_TRUE(waiter.Wait(mapEvents, 0, error)) << error;
+    EXPECT_EQ(mapEvents.count(hSocket), 1u);
+
+    // requested events changed - socket is ready to send
+    ASSERT_TRUE(waiter.SetSocketEvents(hSocket, 1, SOCKET_EVENT_SEND));
+    ASSERT_TRUE(waiter.Wait(mapEvents, 100, error)) << error;
+    ASSERT_EQ(mapEvents.count(hSocket), 1u);
+    EXPECT_TRUE(mapEvents[hSocket] & SOCKET_EVENT_SEND);
+    EXPECT_FALSE(mapEvents[hSocket] & SOCKET_EVENT_RECV);
+
+    // socket is removed - no events
+    waiter.RemoveSocket(hSocket, 1);
+    EXPECT_TRUE(waiter.GetSockets().empty());
+    ASSERT_TRUE(waiter.Wait(mapEvents, 0, error)) << error;
+    EXPECT_TRUE(mapEvents.empty());
+}
+
+TEST_F(TestSocketEvents, owner_change)
+{
+    CSocketEventWaiter waiter;
+    const SOCKET hSocket = m_sockets[0];
+    socket_events_t mapEvents;
+    string error;
+
+    ASSERT_TRUE(waiter.SetSocketEvents(hSocket, 1, SOCKET_EVENT_RECV));
+    ASSERT_TRUE(waiter.Wait(mapEvents, 0, error)) << error;
+    EXPECT_TRUE(mapEvents.empty());
+
+    // the same socket handle is reused by another node - it should be re-registered
+    ASSERT_TRUE(waiter.SetSocketEvents(hSocket, 2, SOCKET_EVENT_RECV));
+    // removal by the previous owner is ignored
+    waiter.RemoveSocket(hSocket, 1);
+    ASSERT_EQ(write(m_sockets[1], "x", 1), 1);
+    ASSERT_TRUE(waiter.Wait(mapEvents, 100, error)) << error;
+    ASSERT_EQ(mapEvents.count(hSocket), 1u);
+    EXPECT_TRUE(mapEvents[hSocket] & SOCKET_EVENT_RECV);
+}
+
+TEST_F(TestSocketEvents, hangup)
+{
+    CSocketEventWaiter waiter;
+    const SOCKET hSocket = m_sockets[0];
+    socket_events_t mapEvents;
+    string error;
+
+    ASSERT_TRUE(waiter.SetSocketEvents(hSocket, 1, SOCKET_EVENT_RECV));
+    // peer closed the connection - socket is readable (recv returns 0)
+    close(m_sockets[1]);
+    m_sockets[1] = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_TRUE(waiter.Wait(mapEvents, 100, error)) << error;
+    ASSERT_EQ(mapEvents.count(hSocket), 1u);
+    EXPECT_TRUE(mapEvents[hSocket] & SOCKET_EVENT_RECV);
+}
+#endif // WIN32
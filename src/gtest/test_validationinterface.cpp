@@ -0,0 +1,143 @@
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <thread>
+#include <vector>
+#include <mutex>
+
+#include <gtest/gtest.h>
+
+#include <validationinterface.h>
+#include <primitives/transaction.h>
+#include <utilstrencodings.h>
+
+using namespace std;
+using namespace testing;
+
+class TestTxListener : public CValidationInterface
+{
+public:
+    vector<uint256> vTxIds;
+    vector<thread::id> vThreadIds;
+    mutex m_mutex;
+
+protected:
+    void SyncTransaction(const CTransaction &tx, const CBlock *pblock) override
+    {
+        unique_lock<mutex> lck(m_mutex);
+        vTxIds.push_back(tx.GetHash());
+        vThreadIds.push_back(this_thread::get_id());
+    }
+};
+
+static vector<uint256> SendTestTransactions(const size_t nCount)
+{
+    vector<uint256> vTxIds;
+    for (size_t i = 0; i < nCount; ++i)
+    {
+        CMutableTransaction mtx;
+        mtx.nLockTime = static_cast<uint32_t>(i);
+        const CTransaction tx(mtx);
+        vTxIds.push_back(tx.GetHash());
+        SyncWithWallets(tx, nullptr);
+    }
+    return vTxIds;
+}
+
+TEST(test_validationinterface, async_listener_ordered)
+{
+    TestTxListener listener;
+    StartValidationInterfaceQueue();
+    RegisterValidationInterface(&listener, true);
+
+    const auto vExpected = SendTestTransactions(200);
+    SyncWithValidationInterfaceQueue();
+    EXPECT_EQ(GetValidationInterfaceQueueSize(), 0u);
+    EXPECT_EQ(listener.vTxIds, vExpected);
+    for (const auto &id : listener.vThreadIds)
+        EXPECT_NE(id, this_thread::get_id());
+
+    UnregisterValidationInterface(&listener);
+    SendTestTransactions(10);
+    EXPECT_EQ(listener.vTxIds.size(), vExpected.size());
+    StopValidationInterfaceQueue();
+}
+
+TEST(test_validationinterface, async_listener_without_queue)
+{
+    // notifications are delivered synchronously when the queue thread is not running
+    TestTxListener listener;
+    RegisterValidationInterface(&listener, true);
+    const auto vExpected = SendTestTransactions(5);
+    EXPECT_EQ(listener.vTxIds, vExpected);
+    for (const auto &id : listener.vThreadIds)
+        EXPECT_EQ(id, this_thread::get_id());
+    UnregisterValidationInterface(&listener);
+}
+
+class TestTicketListener : public CValidationInterface
+{
+public:
+    vector<ticket_notification_t> vTickets;
+
+protected:
+    void TicketNotification(const ticket_notification_t &ticket) override
+    {
+        vTickets.push_back(ticket);
+    }
+};
+
+static ticket_notification_t CreateTestTicketNotification()
+{
+    ticket_notification_t ticket;
+    ticket.nTicketID = 3;
+    ticket.txid = uint256S("0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20");
+    ticket.nBlockHeight = 0x01020304;
+    ticket.bConnected = true;
+    ticket.vTicketData = { 0xde, 0xad, 0xbe, 0xef };
+    return ticket;
+}
+
+TEST(test_validationinterface, ticket_notification_message)
+{
+    auto ticket = CreateTestTicketNotification();
+
+    // hashticket: txid in hashtx byte order | ticket type | height (LE) | event
+    auto vMsg = GetTicketNotificationMessage(ticket, false);
+    ASSERT_EQ(vMsg.size(), TICKET_NOTIFICATION_HEADER_SIZE);
+    EXPECT_EQ(HexStr(vMsg.cbegin(), vMsg.cbegin() + 32), ticket.txid.GetHex());
+    EXPECT_EQ(vMsg[32], 3);
+    EXPECT_EQ(vMsg[33], 0x04);
+    EXPECT_EQ(vMsg[34], 0x03);
+    EXPECT_EQ(vMsg[35], 0x02);
+    EXPECT_EQ(vMsg[36], 0x01);
+    EXPECT_EQ(vMsg[37], 1);
+
+    // rawticket: the same header followed by the serialized ticket
+    ticket.bConnected = false;
+    vMsg = GetTicketNotificationMessage(ticket, true);
+    ASSERT_EQ(vMsg.size(), TICKET_NOTIFICATION_HEADER_SIZE + ticket.vTicketData.size());
+    EXPECT_EQ(vMsg[37], 0);
+    const vector<unsigned char> vHeader(vMsg.cbegin(), vMsg.cbegin() + TICKET_NOTIFICATION_HEADER_SIZE);
+    EXPECT_EQ(vHeader, GetTicketNotificationMessage(ticket, false));
+    const vector<unsigned char> vData(vMsg.cbegin() + TICKET_NOTIFICATION_HEADER_SIZE, vMsg.cend());
+    EXPECT_EQ(vData, ticket.vTicketData);
+}
+
+TEST(test_validationinterface, ticket_notification_async)
+{
+    // asynchronous listener gets a copy of the notification
+    TestTicketListener listener;
+    StartValidationInterfaceQueue();
+    RegisterValidationInterface(&listener, true);
+    {
+        const auto ticket = CreateTestTicketNotification();
+        GetMainSignals().TicketNotification(ticket);
+    }
+    SyncWithValidationInterfaceQueue();
+    ASSERT_EQ(listener.vTickets.size(), 1u);
+    const auto expected = CreateTestTicketNotification();
+    EXPECT_EQ(GetTicketNotificationMessage(listener.vTickets[0], true), GetTicketNotificationMessage(expected, true));
+    UnregisterValidationInterface(&listener);
+    StopValidationInterfaceQueue();
+}
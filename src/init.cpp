@@ -8,6 +8,7 @@
 #include "config/bitcoin-config.h"
 #endif
 
+#include <atomic>
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -43,6 +44,7 @@
 #include <metrics.h>
 #include <miner.h>
 #include <net.h>
+#include <pow.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
 #include <script/standard.h>
@@ -79,6 +81,8 @@ extern void ThreadSendAlert();
 CWallet* pwalletMain = nullptr;
 #endif
 bool fFeeEstimatesInitialized = false;
+// set when mempool.dat was loaded - mempool can be dumped to disk
+static atomic_bool fDumpMempoolLater(false);
 
 #if ENABLE_ZMQ
 static CZMQNotificationInterface* pzmqNotificationInterface = nullptr;
@@ -214,6 +218,9 @@ void Shutdown(CServiceThreadGroup& threadGroup, CScheduler &scheduler)
     scheduler.join_all();
     UnregisterNodeSignals(GetNodeSignals());
 
+    if (fDumpMempoolLater && GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL))
+        DumpMempool();
+
     if (fFeeEstimatesInitialized)
     {
         fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
@@ -287,6 +294,7 @@ void Shutdown(CServiceThreadGroup& threadGroup, CScheduler &scheduler)
     }
 #endif
     UnregisterAllValidationInterfaces();
+    StopValidationInterfaceQueue();
 #ifdef ENABLE_WALLET
     delete pwalletMain;
     pwalletMain = nullptr;
@@ -373,6 +381,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-exportdir=<dir>", _("Specify directory to be used when exporting data"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
+    strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
+    strUsage += HelpMessageOpt("-persistmempool", strprintf(_("Whether to save the mempool on shutdown and load on restart (default: %u)"), DEFAULT_PERSIST_MEMPOOL));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %zu)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
@@ -402,6 +412,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-listen", _("Accept connections from outside (default: 1 if no -proxy or -connect)"));
     strUsage += HelpMessageOpt("-listenonion", strprintf(_("Automatically create Tor hidden service (default: %d)"), DEFAULT_LISTEN_ONION));
     strUsage += HelpMessageOpt("-maxconnections=<n>", strprintf(_("Maintain at most <n> connections to peers (default: %u)"), DEFAULT_MAX_PEER_CONNECTIONS));
+    strUsage += HelpMessageOpt("-msghandlerthreads=<n>", strprintf(_("Number of threads to process peer messages, messages from one peer are always processed in order (1 to %d, default: %d)"),
+        MAX_MSGHANDLER_THREADS, DEFAULT_MSGHANDLER_THREADS));
     strUsage += HelpMessageOpt("-maxreceivebuffer=<n>", strprintf(_("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)"), 5000));
     strUsage += HelpMessageOpt("-maxsendbuffer=<n>", strprintf(_("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)"), 1000));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
@@ -452,6 +464,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubhashticket=<address>", _("Enable publish ticket hash, type and height in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawticket=<address>", _("Enable publish raw ticket in <address>"));
 #endif
 
 #if ENABLE_PROTON
@@ -460,6 +474,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-amqppubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-amqppubrawblock=<address>", _("Enable publish raw block in <address>"));
     strUsage += HelpMessageOpt("-amqppubrawtx=<address>", _("Enable publish raw transaction in <address>"));
+    strUsage += HelpMessageOpt("-amqppubhashticket=<address>", _("Enable publish ticket hash, type and height in <address>"));
+    strUsage += HelpMessageOpt("-amqppubrawticket=<address>", _("Enable publish raw ticket in <address>"));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -488,6 +504,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", 0));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxticketcachesize=<n>", strprintf("Limit size of decoded tickets cache to <n> MiB (default: %u)", DEFAULT_MAX_TICKET_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/kB) smaller than this are considered zero fee for relaying (default: %s)"),
@@ -693,6 +710,13 @@ void ThreadImport(std::vector<fs::path> vImportFiles)
         }
     }
 
+    // reload mempool saved on shutdown, transactions are re-accepted in batches
+    if (GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL))
+    {
+        LoadMempool(chainparams);
+        fDumpMempoolLater = !ShutdownRequested();
+    }
+
     if (GetBoolArg("-stopafterblockimport", false)) {
         LogPrintf("Stopping after block import\n");
         StartShutdown();
@@ -1004,6 +1028,7 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
 
     // -par=0 means autodetect, but nScriptCheckThreads==0 means no concurrency
     gl_ScriptCheckManager.SetThreadCount(GetArg("-par", DEFAULT_SCRIPTCHECK_THREADS));
+    InitSignatureCache();
 
     fServer = GetBoolArg("-server", false);
 
@@ -1219,10 +1244,17 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
     std::ostringstream strErrors;
 
     gl_ScriptCheckManager.create_workers(threadGroup);
+#ifdef ENABLE_WALLET
+    if (!fDisableWallet)
+        CreateSaplingDecryptWorkers(threadGroup);
+#endif
 
     // Start the lightweight task scheduler thread
     scheduler.add_workers(1);
 
+    // Start the thread that delivers notifications to asynchronous validation interface listeners
+    StartValidationInterfaceQueue();
+
     // Count uptime
     MarkStartTime();
 
@@ -1410,7 +1442,7 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
     pzmqNotificationInterface = CZMQNotificationInterface::CreateWithArguments(mapArgs);
 
     if (pzmqNotificationInterface) {
-        RegisterValidationInterface(pzmqNotificationInterface);
+        RegisterValidationInterface(pzmqNotificationInterface, true);
     }
 #endif
 
@@ -1425,7 +1457,7 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
             return InitError(_("AMQP support requires -experimentalfeatures."));
         }
 
-        RegisterValidationInterface(pAMQPNotificationInterface);
+        RegisterValidationInterface(pAMQPNotificationInterface, true);
     }
 #endif
 
@@ -1724,7 +1756,8 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
             uiInterface.InitMessage(_("Rescanning..."));
             LogPrintf("Rescanning last %i blocks (from block %i)...\n", chainActive.Height() - pindexRescan->nHeight, pindexRescan->nHeight);
             nStart = GetTimeMillis();
-            pwalletMain->ScanForWalletTransactions(pindexRescan, true);
+            if (pwalletMain->ScanForWalletTransactions(pindexRescan, true) < 0)
+                InitWarning(_("Warning: wallet rescan aborted, failed to read blocks from disk."));
             LogPrintf(" rescan      %15dms\n", GetTimeMillis() - nStart);
             pwalletMain->SetBestChain(chainActive.GetLocator());
             CWalletDB::IncrementUpdateCounter();
@@ -1865,6 +1898,14 @@ bool AppInit2(CServiceThreadGroup& threadGroup, CScheduler& scheduler)
                                    std::ref(cs_main), std::cref(pindexBestHeader), nPowTargetSpacing);
     scheduler.scheduleEvery(f, nPowTargetSpacing);
 
+    // periodically save mempool to disk
+    if (GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL))
+        scheduler.scheduleEvery([]()
+            {
+                if (fDumpMempoolLater)
+                    DumpMempool();
+            }, MEMPOOL_DUMP_INTERVAL_SECS);
+
 #ifdef ENABLE_MINING
     // Generate coins in the background
  #ifdef ENABLE_WALLET
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <deque>
 #include <sstream>
 #include <unistd.h>
 
@@ -52,6 +53,8 @@ using namespace std;
 
 #include "librustzcash.h"
 #include <script_check.h>
+#include <script/sigcache.h>
+#include <sapling_check.h>
 
 string STR_MSG_MAGIC("Zcash Signed Message:\n");
 
@@ -324,6 +327,12 @@ struct CNodeState
 
 /** Map maintaining per-node state. Requires cs_main. */
 unordered_map<NodeId, CNodeState> mapNodeState;
+/**
+ * Protects node misbehavior score (nMisbehavior, fShouldBan) - Misbehaving() is called by the
+ * message handlers without cs_main. Nodes are added to/removed from mapNodeState holding both
+ * cs_main and cs_mapNodeState. Never lock cs_main or any other lock while holding cs_mapNodeState.
+ */
+CCriticalSection cs_mapNodeState;
 
 // Requires cs_main.
 CNodeState *State(const NodeId nodeid)
@@ -352,7 +361,7 @@ int64_t GetBlockTimeout(int64_t nTime, int nValidatedQueuedBefore, const Consens
 
 void InitializeNode(NodeId nodeid, const CNode *pnode)
 {
-    LOCK(cs_main);
+    LOCK2(cs_main, cs_mapNodeState);
     CNodeState &state = mapNodeState.emplace(nodeid, CNodeState()).first->second;
     state.name = pnode->addrName;
     state.address = pnode->addr;
@@ -366,7 +375,12 @@ void FinalizeNode(NodeId nodeid)
     if (state->fSyncStarted)
         nSyncStarted--;
 
-    if (state->nMisbehavior == 0 && state->fCurrentlyConnected)
+    int nMisbehavior;
+    {
+        LOCK(cs_mapNodeState);
+        nMisbehavior = state->nMisbehavior;
+    }
+    if (nMisbehavior == 0 && state->fCurrentlyConnected)
         AddressCurrentlyConnected(state->address);
 
     state->BlocksInFlightCleanup(nodeid);
@@ -374,7 +388,10 @@ void FinalizeNode(NodeId nodeid)
         gl_pOrphanTxManager->EraseOrphansFor(nodeid);
     nPreferredDownload -= state->fPreferredDownload;
 
-    mapNodeState.erase(nodeid);
+    {
+        LOCK(cs_mapNodeState);
+        mapNodeState.erase(nodeid);
+    }
 }
 
 // Requires cs_main.
@@ -567,7 +584,10 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats)
     CNodeState *state = State(nodeid);
     if (!state)
         return false;
-    stats.nMisbehavior = state->nMisbehavior;
+    {
+        LOCK(cs_mapNodeState);
+        stats.nMisbehavior = state->nMisbehavior;
+    }
     stats.nSyncHeight = state->pindexBestKnownBlock ? state->pindexBestKnownBlock->nHeight : -1;
     stats.nCommonHeight = state->pindexLastCommonBlock ? state->pindexLastCommonBlock->nHeight : -1;
     for (const auto& queue : state->vBlocksInFlight)
@@ -878,7 +898,8 @@ bool ContextualCheckTransaction(
     const CChainParams& chainparams,
     const int nHeight,
     const bool isMined,
-    funcIsInitialBlockDownload_t isInitBlockDownload)
+    funcIsInitialBlockDownload_t isInitBlockDownload,
+    vector<CSaplingProofCheck> *pvSaplingChecks)
 {
     const auto& consensusParams = chainparams.GetConsensus();
     const bool overwinterActive = NetworkUpgradeActive(nHeight, consensusParams, Consensus::UpgradeIndex::UPGRADE_OVERWINTER);
@@ -1008,64 +1029,20 @@ bool ContextualCheckTransaction(
                 REJECT_INVALID, "error-computing-signature-hash");
         }
 
-        auto ctx = librustzcash_sapling_verification_ctx_init();
-        for (const auto &spend : tx.vShieldedSpend)
-        {
-            if (!librustzcash_sapling_check_spend(
-                ctx,
-                spend.cv.begin(),
-                spend.anchor.begin(),
-                spend.nullifier.begin(),
-                spend.rk.begin(),
-                spend.zkproof.data(),
-                spend.spendAuthSig.data(),
-                dataToBeSigned.begin()
-            ))
-            {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                return state.DoS(
-                    dosLevelPotentiallyRelaxing,
-                    error("ContextualCheckTransaction(): Sapling spend description invalid"),
-                    REJECT_INVALID, "bad-txns-sapling-spend-description-invalid");
-            }
-        }
-
-        for (const auto &output : tx.vShieldedOutput)
+        CSaplingProofCheck saplingCheck(tx, dataToBeSigned, DOS_LEVEL_BLOCK, dosLevelPotentiallyRelaxing);
+        if (pvSaplingChecks)
+            // proofs will be verified later by the caller (in parallel for all block transactions)
+            pvSaplingChecks->emplace_back(move(saplingCheck));
+        else
         {
-            if (!librustzcash_sapling_check_output(
-                ctx,
-                output.cv.begin(),
-                output.cm.begin(),
-                output.ephemeralKey.begin(),
-                output.zkproof.data()
-            ))
-            {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                // This should be a non-contextual check, but we check it here
-                // as we need to pass over the outputs anyway in order to then
-                // call librustzcash_sapling_final_check().
+            sapling_check_result_t result;
+            saplingCheck.SetResult(&result);
+            if (!saplingCheck())
                 return state.DoS(
-                    DOS_LEVEL_BLOCK,
-                    error("ContextualCheckTransaction(): Sapling output description invalid"),
-                    REJECT_INVALID, "bad-txns-sapling-output-description-invalid");
-            }
+                    result.nDoS,
+                    error("ContextualCheckTransaction(): %s", result.sError),
+                    REJECT_INVALID, result.sRejectReason);
         }
-
-        if (!librustzcash_sapling_final_check(
-            ctx,
-            tx.valueBalance,
-            tx.bindingSig.data(),
-            dataToBeSigned.begin()
-        ))
-        {
-            librustzcash_sapling_verification_ctx_free(ctx);
-            return state.DoS(
-                dosLevelPotentiallyRelaxing,
-                error("ContextualCheckTransaction(): Sapling binding signature invalid"),
-                REJECT_INVALID, "bad-txns-sapling-binding-signature-invalid");
-        }
-
-        librustzcash_sapling_verification_ctx_free(ctx);
     }
     
     // Check Pastel Ticket transactions
@@ -1272,7 +1249,7 @@ CAmount GetMinRelayFee(const CTransaction& tx, const size_t nBytes, bool fAllowF
 bool AcceptToMemoryPool(
         const CChainParams& chainparams,
         CTxMemPool& pool, CValidationState &state, const CTransaction &tx, bool fLimitFree,
-        bool* pfMissingInputs, bool fRejectAbsurdFee)
+        bool* pfMissingInputs, bool fRejectAbsurdFee, const int64_t nAcceptTime)
 {
     AssertLockHeld(cs_main);
     if (pfMissingInputs)
@@ -1434,7 +1411,7 @@ bool AcceptToMemoryPool(
         // it has passed ContextualCheckInputs and therefore this is correct.
         auto consensusBranchId = CurrentEpochBranchId(chainActive.Height() + 1, consensusParams);
 
-        CTxMemPoolEntry entry(tx, nFees, GetTime(), dPriority, chainActive.Height(), mempool.HasNoInputsOf(tx), fSpendsCoinbase, consensusBranchId);
+        CTxMemPoolEntry entry(tx, nFees, nAcceptTime ? nAcceptTime : GetTime(), dPriority, chainActive.Height(), mempool.HasNoInputsOf(tx), fSpendsCoinbase, consensusBranchId);
         const size_t nTxSize = entry.GetTxSize();
 
         // Accept a tx if it contains joinsplits and has at least the default fee specified by z_sendmany.
@@ -1474,6 +1451,16 @@ bool AcceptToMemoryPool(
             dFreeCount += nTxSize;
         }
 
+        // the mempool min fee is raised when transactions are evicted because of the mempool size limit
+        const size_t nMaxMempoolSize = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+        if (fLimitFree)
+        {
+            const CAmount mempoolRejectFee = pool.GetMinFee(nMaxMempoolSize).GetFee(nTxSize);
+            if (mempoolRejectFee > 0 && nFees < mempoolRejectFee)
+                return state.DoS(0, error("AcceptToMemoryPool [%s]: mempool min fee not met %" PRId64 " < %" PRId64, hash.ToString(), nFees, mempoolRejectFee),
+                                 REJECT_INSUFFICIENTFEE, "mempool min fee not met");
+        }
+
         if (fRejectAbsurdFee && nFees > ::minRelayTxFee.GetFee(nTxSize) * 10000) {
             string errmsg = strprintf("absurdly high fees %s, %" PRId64 " > %" PRId64,
                                       hash.ToString(),
@@ -1506,6 +1493,18 @@ bool AcceptToMemoryPool(
 
         // Store transaction in memory
         pool.addUnchecked(hash, entry, !fnIsInitialBlockDownload(consensusParams));
+
+        // insightexplorer: add address deltas and spent outputs to the mempool indexes
+        if (fAddressIndex)
+            pool.addAddressIndex(entry, view);
+        if (fSpentIndex)
+            pool.addSpentIndex(entry, view);
+
+        // trim mempool and check if tx was trimmed
+        pool.TrimToSize(nMaxMempoolSize);
+        if (!pool.exists(hash))
+            return state.DoS(0, error("AcceptToMemoryPool [%s]: mempool full", hash.ToString()),
+                             REJECT_INSUFFICIENTFEE, "mempool full");
     }
 
     SyncWithWallets(tx, nullptr);
@@ -1513,6 +1512,168 @@ bool AcceptToMemoryPool(
     return true;
 }
 
+static const char* MEMPOOL_FILENAME = "mempool.dat";
+static constexpr uint64_t MEMPOOL_DUMP_VERSION = 1;
+
+/**
+ * Dump mempool transactions with entry times and prioritisation deltas to mempool.dat.
+ * File is written to the temporary file first and then renamed.
+ * 
+ * \return true if mempool was successfully saved
+ */
+bool DumpMempool()
+{
+    const int64_t nStart = GetTimeMicros();
+
+    map<uint256, pair<double, CAmount>> mapDeltas;
+    vector<pair<CTransaction, int64_t>> vTx;
+    {
+        LOCK(mempool.cs);
+        for (const auto &[txid, delta] : mempool.mapDeltas)
+            mapDeltas.emplace(txid, delta);
+        // parents are saved before their children, otherwise children fail to load with missing inputs:
+        // transaction always has more in-mempool ancestors than any of its parents
+        vector<const CTxMemPoolEntry*> vEntries;
+        vEntries.reserve(mempool.mapTx.size());
+        for (const auto& entry : mempool.mapTx)
+            vEntries.push_back(&entry);
+        stable_sort(vEntries.begin(), vEntries.end(), [](const CTxMemPoolEntry* a, const CTxMemPoolEntry* b)
+            {
+                return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+            });
+        vTx.reserve(vEntries.size());
+        for (const auto pEntry : vEntries)
+            vTx.emplace_back(pEntry->GetTx(), pEntry->GetTime());
+    }
+
+    const int64_t nMid = GetTimeMicros();
+    try
+    {
+        const fs::path pathTmp = GetDataDir() / (string(MEMPOOL_FILENAME) + ".new");
+        FILE* fp = nullptr;
+#if defined(_MSC_VER) && (_MSC_VER >= 1400)
+        const errno_t err = fopen_s(&fp, pathTmp.string().c_str(), "wb");
+#else
+        fp = fopen(pathTmp.string().c_str(), "wb");
+#endif
+        if (!fp)
+            return false;
+        CAutoFile file(fp, SER_DISK, CLIENT_VERSION);
+
+        file << MEMPOOL_DUMP_VERSION;
+        file << static_cast<uint64_t>(vTx.size());
+        for (const auto& [tx, nTime] : vTx)
+        {
+            file << tx;
+            file << nTime;
+            double dPriorityDelta = 0;
+            CAmount nFeeDelta = 0;
+            const auto it = mapDeltas.find(tx.GetHash());
+            if (it != mapDeltas.cend())
+            {
+                dPriorityDelta = it->second.first;
+                nFeeDelta = it->second.second;
+                mapDeltas.erase(it);
+            }
+            file << dPriorityDelta;
+            file << nFeeDelta;
+        }
+        // prioritisation deltas for transactions that are not in the mempool
+        file << mapDeltas;
+        FileCommit(file.Get());
+        file.fclose();
+        if (!RenameOver(pathTmp, GetDataDir() / MEMPOOL_FILENAME))
+            throw runtime_error("Rename failed");
+        const int64_t nLast = GetTimeMicros();
+        LogPrintf("Dumped mempool: %zu txs, %gs to copy, %gs to dump\n", vTx.size(), (nMid - nStart) * 0.000001, (nLast - nMid) * 0.000001);
+    } catch (const exception& e) {
+        LogPrintf("Failed to dump mempool: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Load mempool.dat and re-accept transactions via AcceptToMemoryPool.
+ * Transactions are processed in batches of MEMPOOL_LOAD_BATCH_SIZE,
+ * cs_main is released between batches so the node stays responsive.
+ * 
+ * \param chainparams - chain parameters
+ * \return true if mempool.dat was successfully loaded
+ */
+bool LoadMempool(const CChainParams& chainparams)
+{
+    const fs::path pathMempool = GetDataDir() / MEMPOOL_FILENAME;
+    FILE* fp = nullptr;
+#if defined(_MSC_VER) && (_MSC_VER >= 1400)
+    const errno_t err = fopen_s(&fp, pathMempool.string().c_str(), "rb");
+#else
+    fp = fopen(pathMempool.string().c_str(), "rb");
+#endif
+    CAutoFile file(fp, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull())
+    {
+        LogPrintf("Failed to open mempool file from disk. Continuing anyway.\n");
+        return false;
+    }
+
+    size_t nCount = 0, nFailed = 0, nAlreadyThere = 0;
+    try
+    {
+        uint64_t nVersion = 0;
+        file >> nVersion;
+        if (nVersion != MEMPOOL_DUMP_VERSION)
+            return false;
+        uint64_t nTxCount = 0;
+        file >> nTxCount;
+
+        while (nTxCount > 0)
+        {
+            if (ShutdownRequested())
+                return false;
+            const size_t nBatchSize = static_cast<size_t>(min<uint64_t>(nTxCount, MEMPOOL_LOAD_BATCH_SIZE));
+            nTxCount -= nBatchSize;
+
+            LOCK(cs_main);
+            for (size_t i = 0; i < nBatchSize; ++i)
+            {
+                CTransaction tx;
+                int64_t nTime = 0;
+                double dPriorityDelta = 0;
+                CAmount nFeeDelta = 0;
+                file >> tx;
+                file >> nTime;
+                file >> dPriorityDelta;
+                file >> nFeeDelta;
+
+                const uint256& txid = tx.GetHash();
+                if (dPriorityDelta != 0 || nFeeDelta != 0)
+                    mempool.PrioritiseTransaction(txid, txid.ToString(), dPriorityDelta, nFeeDelta);
+                if (mempool.exists(txid))
+                {
+                    ++nAlreadyThere;
+                    continue;
+                }
+                CValidationState state;
+                if (AcceptToMemoryPool(chainparams, mempool, state, tx, false, nullptr, false, nTime))
+                    ++nCount;
+                else
+                    ++nFailed;
+            }
+        }
+        map<uint256, pair<double, CAmount>> mapDeltas;
+        file >> mapDeltas;
+        for (const auto &[txid, delta] : mapDeltas)
+            mempool.PrioritiseTransaction(txid, txid.ToString(), delta.first, delta.second);
+    } catch (const exception& e) {
+        LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+
+    LogPrintf("Imported mempool transactions from disk: %zu successes, %zu failed, %zu already there\n", nCount, nFailed, nAlreadyThere);
+    return true;
+}
+
 /**
  * Search for transaction by txid (transaction hash) and return in txOut.
  * If transaction was found inside a block, its hash (txid) is placed in hashBlock.
@@ -1850,6 +2011,8 @@ void Misbehaving(NodeId pnode, int howmuch)
     if (howmuch == 0)
         return;
 
+    // can be called without cs_main
+    LOCK(cs_mapNodeState);
     CNodeState *state = State(pnode);
     if (!state)
         return;
@@ -2044,6 +2207,8 @@ bool ContextualCheckInputs(
         // still computed and checked, and any change will be caught at the next checkpoint.
         if (fScriptChecks)
         {
+            // signature cache entries of the inline checks are inserted once all inputs are valid
+            v_uint256 vSigCacheEntries;
             unsigned int i = 0;
             for (const auto& txIn : tx.vin)
             {
@@ -2053,6 +2218,8 @@ bool ContextualCheckInputs(
 
                 // Verify signature
                 CScriptCheck check(*coins, tx, i, flags, cacheStore, consensusBranchId, &txdata);
+                if (!pvChecks)
+                    check.SetSigCacheEntries(&vSigCacheEntries);
                 if (pvChecks) {
                     pvChecks->push_back(CScriptCheck());
                     check.swap(pvChecks->back());
@@ -2080,6 +2247,8 @@ bool ContextualCheckInputs(
                 }
                 ++i;
             }
+            if (!vSigCacheEntries.empty())
+                SignatureCacheInsertBatch(vSigCacheEntries);
         }
     }
 
@@ -2195,6 +2364,140 @@ static bool ApplyTxInUndo(const CTxInUndo& undo, CCoinsViewCache& view, const CO
     return fClean;
 }
 
+// insightexplorer: address, address unspent and spent index updates for one block
+typedef struct _insight_index_updates_t
+{
+    vector<pair<CAddressIndexKey, CAmount>> vAddressIndex;
+    vector<pair<CAddressUnspentKey, CAddressUnspentValue>> vAddressUnspentIndex;
+    vector<pair<CSpentIndexKey, CSpentIndexValue>> vSpentIndex;
+} insight_index_updates_t;
+
+/**
+ * Collect insight explorer index updates for the transaction connected in the block.
+ * Must be called before the transaction inputs are spent in the view.
+ * 
+ * \param tx - transaction
+ * \param nTxIndex - index of the transaction in the block
+ * \param nHeight - block height
+ * \param view - coins view with the transaction inputs
+ * \param updates - index updates
+ */
+static void ConnectInsightIndexes(const CTransaction& tx, const uint32_t nTxIndex, const int nHeight,
+    const CCoinsViewCache& view, insight_index_updates_t& updates)
+{
+    const uint256& txid = tx.GetHash();
+    if (!tx.IsCoinBase())
+    {
+        for (uint32_t j = 0; j < tx.vin.size(); ++j)
+        {
+            const auto& input = tx.vin[j];
+            const CTxOut& prevout = view.GetOutputFor(input);
+            const auto type = prevout.scriptPubKey.GetScriptType();
+            const uint160 addressHash = type == CScript::ScriptType::UNKNOWN ? uint160() : prevout.scriptPubKey.AddressHash();
+            if (fAddressIndex && type != CScript::ScriptType::UNKNOWN)
+            {
+                const auto nType = to_integral_type(type);
+                // record spending activity
+                updates.vAddressIndex.emplace_back(CAddressIndexKey(nType, addressHash, nHeight, nTxIndex, txid, j, true), -prevout.nValue);
+                // remove address from unspent index
+                updates.vAddressUnspentIndex.emplace_back(CAddressUnspentKey(nType, addressHash, input.prevout.hash, input.prevout.n), CAddressUnspentValue());
+            }
+            if (fSpentIndex)
+                updates.vSpentIndex.emplace_back(CSpentIndexKey(input.prevout.hash, input.prevout.n),
+                    CSpentIndexValue(txid, j, nHeight, prevout.nValue, type, addressHash));
+        }
+    }
+    if (!fAddressIndex)
+        return;
+    for (uint32_t k = 0; k < tx.vout.size(); ++k)
+    {
+        const auto& out = tx.vout[k];
+        const auto type = out.scriptPubKey.GetScriptType();
+        if (type == CScript::ScriptType::UNKNOWN)
+            continue;
+        const auto nType = to_integral_type(type);
+        const uint160 addressHash = out.scriptPubKey.AddressHash();
+        // record receiving activity
+        updates.vAddressIndex.emplace_back(CAddressIndexKey(nType, addressHash, nHeight, nTxIndex, txid, k, false), out.nValue);
+        // record unspent output
+        updates.vAddressUnspentIndex.emplace_back(CAddressUnspentKey(nType, addressHash, txid, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight));
+    }
+}
+
+/**
+ * Collect insight explorer index updates for the transaction disconnected from the block.
+ * Must be called after the transaction inputs are restored in the view.
+ * 
+ * \param tx - transaction
+ * \param nTxIndex - index of the transaction in the block
+ * \param nHeight - block height
+ * \param pTxUndo - transaction undo data (nullptr for coinbase)
+ * \param view - coins view with the restored transaction inputs
+ * \param updates - index updates: address index entries to erase, unspent and spent index updates
+ */
+static void DisconnectInsightIndexes(const CTransaction& tx, const uint32_t nTxIndex, const int nHeight,
+    const CTxUndo* pTxUndo, const CCoinsViewCache& view, insight_index_updates_t& updates)
+{
+    const uint256& txid = tx.GetHash();
+    if (fAddressIndex)
+    {
+        for (uint32_t k = 0; k < tx.vout.size(); ++k)
+        {
+            const auto& out = tx.vout[k];
+            const auto type = out.scriptPubKey.GetScriptType();
+            if (type == CScript::ScriptType::UNKNOWN)
+                continue;
+            const auto nType = to_integral_type(type);
+            const uint160 addressHash = out.scriptPubKey.AddressHash();
+            updates.vAddressIndex.emplace_back(CAddressIndexKey(nType, addressHash, nHeight, nTxIndex, txid, k, false), out.nValue);
+            // undo unspent index
+            updates.vAddressUnspentIndex.emplace_back(CAddressUnspentKey(nType, addressHash, txid, k), CAddressUnspentValue());
+        }
+    }
+    if (!pTxUndo)
+        return;
+    for (uint32_t j = 0; j < tx.vin.size(); ++j)
+    {
+        const auto& input = tx.vin[j];
+        const CTxOut& prevout = pTxUndo->vprevout[j].txout;
+        if (fSpentIndex)
+            updates.vSpentIndex.emplace_back(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue());
+        const auto type = prevout.scriptPubKey.GetScriptType();
+        if (!fAddressIndex || type == CScript::ScriptType::UNKNOWN)
+            continue;
+        const auto nType = to_integral_type(type);
+        const uint160 addressHash = prevout.scriptPubKey.AddressHash();
+        updates.vAddressIndex.emplace_back(CAddressIndexKey(nType, addressHash, nHeight, nTxIndex, txid, j, true), -prevout.nValue);
+        // restore unspent index, height of the restored output is available in the view
+        const CCoins* coins = view.AccessCoins(input.prevout.hash);
+        const int nPrevHeight = coins ? coins->nHeight : pTxUndo->vprevout[j].nHeight;
+        updates.vAddressUnspentIndex.emplace_back(CAddressUnspentKey(nType, addressHash, input.prevout.hash, input.prevout.n),
+            CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, nPrevHeight));
+    }
+}
+
+/**
+ * Write insight explorer index updates to the block tree DB.
+ * 
+ * \param state - validation state
+ * \param updates - index updates
+ * \param bConnect - true if block was connected, false if disconnected
+ * \return false if failed to write the indexes
+ */
+static bool WriteInsightIndexes(CValidationState& state, const insight_index_updates_t& updates, const bool bConnect)
+{
+    if (fAddressIndex)
+    {
+        if (bConnect ? !pblocktree->WriteAddressIndex(updates.vAddressIndex) : !pblocktree->EraseAddressIndex(updates.vAddressIndex))
+            return AbortNode(state, "Failed to write address index");
+        if (!pblocktree->UpdateAddressUnspentIndex(updates.vAddressUnspentIndex))
+            return AbortNode(state, "Failed to write address unspent index");
+    }
+    if (fSpentIndex && !pblocktree->UpdateSpentIndex(updates.vSpentIndex))
+        return AbortNode(state, "Failed to write transaction spent index");
+    return true;
+}
+
 bool DisconnectBlock(
     const CBlock& block, 
     CValidationState& state, 
@@ -2220,6 +2523,10 @@ bool DisconnectBlock(
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
         return error("DisconnectBlock(): block and undo data inconsistent");
 
+    // insightexplorer indexes are not updated by the block verification (pfClean is set)
+    const bool bUpdateInsightIndexes = !pfClean && (fAddressIndex || fSpentIndex);
+    insight_index_updates_t insightUpdates;
+
     // undo transactions in reverse order
     if (!block.vtx.empty())
     {
@@ -2251,7 +2558,11 @@ bool DisconnectBlock(
             view.SetNullifiers(tx, false);
 
             if (i == 0)
+            {
+                if (bUpdateInsightIndexes)
+                    DisconnectInsightIndexes(tx, 0, pindex->nHeight, nullptr, view, insightUpdates);
                 break; // break on coinbase
+            }
             // restore inputs, not coinbases
             const CTxUndo& txundo = blockUndo.vtxundo[i - 1];
             if (txundo.vprevout.size() != tx.vin.size())
@@ -2263,9 +2574,14 @@ bool DisconnectBlock(
                 if (!ApplyTxInUndo(undo, view, out))
                     fClean = false;
             }
+            if (bUpdateInsightIndexes)
+                DisconnectInsightIndexes(tx, static_cast<uint32_t>(i), pindex->nHeight, &txundo, view, insightUpdates);
         }
     }
 
+    if (bUpdateInsightIndexes && !WriteInsightIndexes(state, insightUpdates, false))
+        return false;
+
     // set the old best Sprout anchor back
     view.PopAnchor(blockUndo.old_sprout_tree_root, SPROUT);
 
@@ -2391,7 +2707,8 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 
-bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindex, CCoinsViewCache& view, bool fJustCheck)
+bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindex, CCoinsViewCache& view,
+    bool fJustCheck, const bool fUpdateInsightIndexes)
 {
     AssertLockHeld(cs_main);
 
@@ -2449,6 +2766,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainPara
     CBlockUndo blockundo;
 
     auto scriptCheckControl = gl_ScriptCheckManager.create_master(fExpensiveChecks);
+    // signature cache entries collected by the parallel script checks (one slot per check),
+    // inserted into the cache in one batch after all checks passed
+    deque<v_uint256> vSigCacheEntries;
 
     int64_t nTimeStart = GetTimeMicros();
     CAmount nFees = 0;
@@ -2483,6 +2803,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainPara
     // Grab the consensus branch ID for the block's height
     auto consensusBranchId = CurrentEpochBranchId(pindex->nHeight, consensusParams);
 
+    // insightexplorer indexes
+    const bool bUpdateInsightIndexes = !fJustCheck && fUpdateInsightIndexes && (fAddressIndex || fSpentIndex);
+    insight_index_updates_t insightUpdates;
+
     vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
     for (size_t i = 0; i < block.vtx.size(); i++)
@@ -2525,9 +2849,17 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainPara
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             if (!ContextualCheckInputs(tx, state, view, fExpensiveChecks, flags, fCacheResults, txdata[i], consensusParams, consensusBranchId, gl_ScriptCheckManager.GetThreadCount() ? &vChecks : nullptr))
                 return false;
+            if (fCacheResults)
+            {
+                for (auto& check : vChecks)
+                    check.SetSigCacheEntries(&vSigCacheEntries.emplace_back());
+            }
             scriptCheckControl->Add(vChecks);
         }
 
+        if (bUpdateInsightIndexes)
+            ConnectInsightIndexes(tx, static_cast<uint32_t>(i), pindex->nHeight, view, insightUpdates);
+
         CTxUndo undoDummy;
         if (i > 0)
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2576,6 +2908,13 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainPara
    
     if (!scriptCheckControl->Wait())
         return state.DoS(100, false);
+    if (!vSigCacheEntries.empty())
+    {
+        v_uint256 vEntries;
+        for (auto& vCheckEntries : vSigCacheEntries)
+            vEntries.insert(vEntries.end(), vCheckEntries.cbegin(), vCheckEntries.cend());
+        SignatureCacheInsertBatch(vEntries);
+    }
     const int64_t nTime2 = GetTimeMicros(); nTimeVerify += nTime2 - nTimeStart;
     LogPrint("bench", "    - Verify %zu txins: %.2fms (%.3fms/txin) [%.2fs]\n", 
         nInputs ? nInputs - 1 : 0, 
@@ -2623,6 +2962,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, const CChainPara
     if (fTxIndex && !pblocktree->WriteTxIndex(vPos))
         return AbortNode(state, "Failed to write transaction index");
 
+    if (bUpdateInsightIndexes && !WriteInsightIndexes(state, insightUpdates, true))
+        return false;
+    if (fTimestampIndex && fUpdateInsightIndexes && !pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
+        return AbortNode(state, "Failed to write timestamp index");
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -3518,11 +3862,22 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
     return true;
 }
 
+/**
+ * Context-independent block header checks.
+ * 
+ * \param block - block header to check
+ * \param state - validation state
+ * \param chainparams - chain parameters
+ * \param fCheckPOW - check Equihash solution and proof of work
+ * \param bEquihashVerified - true if Equihash solution was already verified by the caller
+ * \return true if the block header is valid
+ */
 bool CheckBlockHeader(
     const CBlockHeader& block,
     CValidationState& state,
     const CChainParams& chainparams,
-    bool fCheckPOW)
+    bool fCheckPOW,
+    const bool bEquihashVerified)
 {
     // Check block version
     if (block.nVersion < MIN_BLOCK_VERSION)
@@ -3534,7 +3889,7 @@ bool CheckBlockHeader(
     if (chainparams.IsRegTest())
     {
         // Check Equihash solution is valid
-        if (fCheckPOW && !CheckEquihashSolution(&block, consensusParams))
+        if (fCheckPOW && !bEquihashVerified && !CheckEquihashSolution(&block, consensusParams))
             return state.DoS(100, error("CheckBlockHeader(): Equihash solution invalid"),
                              REJECT_INVALID, "invalid-solution");
     }
@@ -3544,8 +3899,9 @@ bool CheckBlockHeader(
         if (it != mapBlockIndex.cend() && it->second->nHeight > TOP_INGEST_BLOCK) { //if new block is TOP_INGEST_BLOCK+1, no more skips
     //<-INGEST!!!
          
-            // Check Equihash solution is valid
-            if (fCheckPOW && !CheckEquihashSolution(&block, consensusParams))
+            // Check Equihash solution is valid (skipped if it was already verified for this header)
+            const bool bPowVerified = bEquihashVerified || (it->second->nStatus & BLOCK_POW_VALID);
+            if (fCheckPOW && !bPowVerified && !CheckEquihashSolution(&block, consensusParams))
                 return state.DoS(100, error("CheckBlockHeader(): Equihash solution invalid"),
                                  REJECT_INVALID, "invalid-solution");
     
@@ -3694,13 +4050,15 @@ bool ContextualCheckBlock(
     const int nHeight = !pindexPrev ? 0 : pindexPrev->nHeight + 1;
     const auto& consensusParams = chainparams.GetConsensus();
 
+    // Sapling proofs of all block transactions are verified after the loop in parallel
+    vector<CSaplingProofCheck> vSaplingChecks;
     // Check that all transactions are finalized
     for (const auto& tx : block.vtx)
     {
 
         // Check transaction contextually against consensus rules at block height
         // isMined flag is true
-        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true))
+        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true, fnIsInitialBlockDownload, &vSaplingChecks))
             return false; // Failure reason has been set in validation state object
 
         int nLockTimeFlags = 0;
@@ -3709,6 +4067,24 @@ bool ContextualCheckBlock(
             return state.DoS(10, error("%s: contains a non-final transaction", __func__), REJECT_INVALID, "bad-txns-nonfinal");
     }
 
+    if (!vSaplingChecks.empty())
+    {
+        vector<sapling_check_result_t> vSaplingResults(vSaplingChecks.size());
+        for (size_t i = 0; i < vSaplingChecks.size(); ++i)
+            vSaplingChecks[i].SetResult(&vSaplingResults[i]);
+        // failed check always reports the error in its result
+        gl_ScriptCheckManager.RunChecks(vSaplingChecks);
+        for (const auto& result : vSaplingResults)
+        {
+            if (result.bValid)
+                continue;
+            return state.DoS(
+                result.nDoS,
+                error("ContextualCheckTransaction(): %s", result.sError),
+                REJECT_INVALID, result.sRejectReason);
+        }
+    }
+
     // Enforce BIP 34 rule that the coinbase starts with serialized block height.
     // In Zcash this has been enforced since launch, except that the genesis
     // block didn't include the height in the coinbase (see Zcash protocol spec
@@ -3725,11 +4101,27 @@ bool ContextualCheckBlock(
     return true;
 }
 
+/**
+ * Mark the block index entry as having verified Equihash solution.
+ * 
+ * \param pindex - block index entry
+ * \param bEquihashVerified - true if Equihash solution of the block header was verified
+ */
+static void SetBlockPowValid(CBlockIndex* pindex, const bool bEquihashVerified)
+{
+    AssertLockHeld(cs_main);
+    if (!pindex || !bEquihashVerified || (pindex->nStatus & BLOCK_POW_VALID))
+        return;
+    pindex->nStatus |= BLOCK_POW_VALID;
+    setDirtyBlockIndex.insert(pindex);
+}
+
 bool AcceptBlockHeader(
     const CBlockHeader& block,
     CValidationState& state,
     const CChainParams& chainparams,
-    CBlockIndex** ppindex)
+    CBlockIndex** ppindex,
+    const bool bEquihashVerified)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3744,13 +4136,14 @@ bool AcceptBlockHeader(
             *ppindex = pindex;
         if (pindex->nStatus & BLOCK_FAILED_MASK)
             return state.Invalid(error("%s: block is marked invalid", __func__), 0, "duplicate");
+        SetBlockPowValid(pindex, bEquihashVerified);
         // if previous block has failed contextual validation - add it to unlinked block map as well
         if (gl_BlockCache.check_prev_block(pindex))
             LogPrint("net", "block %s (height=%d) added to cached unlinked map\n", hash.ToString(), pindex->nHeight);
         return true;
     }
 
-    if (!CheckBlockHeader(block, state, chainparams))
+    if (!CheckBlockHeader(block, state, chainparams, true, bEquihashVerified))
         return false;
 
     // Get prev block index
@@ -3771,6 +4164,7 @@ bool AcceptBlockHeader(
 
     if (!pindex)
         pindex = AddToBlockIndex(block, consensusParams);
+    SetBlockPowValid(pindex, bEquihashVerified);
 
     if (ppindex)
         *ppindex = pindex;
@@ -3885,6 +4279,9 @@ bool ProcessNewBlock(
     const bool fForceProcessing, 
     CDiskBlockPos *dbp)
 {
+    // don't let asynchronous validation interface listeners fall too far behind
+    LimitValidationInterfaceQueue();
+
     // Preliminary checks
     auto verifier = libzcash::ProofVerifier::Disabled();
     const bool bChecked = CheckBlock(*pblock, state, chainparams, verifier);
@@ -4228,9 +4625,10 @@ static bool LoadBlockIndexDB(const CChainParams& chainparams)
 
     // Check whether block explorer features are enabled
     pblocktree->ReadFlag("insightexplorer", fInsightExplorer);
-    LogPrintf("%s: insight explorer %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
+    LogPrintf("%s: insight explorer %s\n", __func__, fInsightExplorer ? "enabled" : "disabled");
     fAddressIndex = fInsightExplorer;
     fSpentIndex = fInsightExplorer;
+    fTimestampIndex = fInsightExplorer;
 
     // Fill in-memory data
     for (const auto &[hash, pindex] : mapBlockIndex)
@@ -4346,7 +4744,8 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             CBlock block;
             if (!ReadBlockFromDisk(block, pindex, consensusParams))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            if (!ConnectBlock(block, state, chainparams, pindex, coins))
+            // insightexplorer indexes were not touched by the disconnect above, no need to rewrite them
+            if (!ConnectBlock(block, state, chainparams, pindex, coins, false, false))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         }
     }
@@ -4533,7 +4932,10 @@ void UnloadBlockIndex()
     nPreferredDownload = 0;
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
-    mapNodeState.clear();
+    {
+        LOCK(cs_mapNodeState);
+        mapNodeState.clear();
+    }
     recentRejects.reset();
 
     for (auto& entry : mapBlockIndex)
@@ -5099,7 +5501,12 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                             // however we MUST always provide at least what the remote peer needs
                             for (const auto& [idx, hash] : merkleBlock.vMatchedTxn)
                             {
-                                if (!pfrom->setInventoryKnown.count(CInv(MSG_TX, hash)))
+                                bool bKnown;
+                                {
+                                    LOCK(pfrom->cs_inventory);
+                                    bKnown = pfrom->setInventoryKnown.count(CInv(MSG_TX, hash)) > 0;
+                                }
+                                if (!bKnown)
                                     pfrom->PushMessage("tx", block.vtx[idx]);
                             }
                         }
@@ -5631,7 +6038,10 @@ static bool ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
             CValidationState state;
 
             pfrom->setAskFor.erase(inv.hash);
-            mapAlreadyAskedFor.erase(inv);
+            {
+                LOCK(cs_mapAlreadyAskedFor);
+                mapAlreadyAskedFor.erase(inv);
+            }
 
             if (!AlreadyHave(inv) && AcceptToMemoryPool(chainparams, mempool, state, tx, true, &fMissingInputs))
             {
@@ -5721,18 +6131,34 @@ static bool ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
         if (nCount == 0)
             return true;
 
+        // verify Equihash solutions of the whole batch in parallel without holding cs_main,
+        // headers already indexed with verified solution are skipped,
+        // invalid solutions are rejected (or skipped for ingest blocks) by AcceptBlockHeader
+        v_uint8 vEquihashValid(headers.size(), 0);
+        {
+            LOCK(cs_main);
+            for (size_t i = 0; i < headers.size(); ++i)
+            {
+                const auto it = mapBlockIndex.find(headers[i].GetHash());
+                if ((it != mapBlockIndex.cend()) && (it->second->nStatus & BLOCK_POW_VALID))
+                    vEquihashValid[i] = 1;
+            }
+        }
+        CheckEquihashSolutions(headers, consensusParams, vEquihashValid);
+
         CBlockIndex *pindexLast = nullptr;
         {
             LOCK(cs_main);
-            for (const auto& header : headers)
+            for (size_t i = 0; i < headers.size(); ++i)
             {
+                const auto& header = headers[i];
                 CValidationState state;
                 if (pindexLast && header.hashPrevBlock != pindexLast->GetBlockHash())
                 {
                     Misbehaving(pfrom->GetId(), 20);
                     return error("non-continuous headers sequence");
                 }
-                if (!AcceptBlockHeader(header, state, chainparams, & pindexLast))
+                if (!AcceptBlockHeader(header, state, chainparams, &pindexLast, vEquihashValid[i] != 0))
                 {
                     int nDoS = 0;
                     if (state.IsInvalid(nDoS))
@@ -5822,7 +6248,10 @@ static bool ProcessMessage(const CChainParams& chainparams, CNode* pfrom, string
         }
         pfrom->fSentAddr = true;
 
-        pfrom->vAddrToSend.clear();
+        {
+            LOCK(pfrom->cs_vAddr);
+            pfrom->vAddrToSend.clear();
+        }
         vector<CAddress> vAddr = addrman.GetAddr();
         for (const auto &addr : vAddr)
             pfrom->PushAddress(addr);
@@ -6251,7 +6680,10 @@ bool SendMessages(const CChainParams& chainparams, CNode* pto, bool fSendTrickle
             {
                 // Periodically clear addrKnown to allow refresh broadcasts
                 if (nLastRebroadcast)
+                {
+                    LOCK(pnode->cs_vAddr);
                     pnode->addrKnown.reset();
+                }
 
                 // Rebroadcast our address
                 AdvertizeLocal(pnode);
@@ -6265,25 +6697,27 @@ bool SendMessages(const CChainParams& chainparams, CNode* pto, bool fSendTrickle
         //
         if (fSendTrickle)
         {
-            vector<CAddress> vAddr;
-            vAddr.reserve(pto->vAddrToSend.size());
-            for (const auto& addr : pto->vAddrToSend)
+            vector<CAddress> vAddrToSend;
             {
-                if (!pto->addrKnown.contains(addr.GetKey()))
+                LOCK(pto->cs_vAddr);
+                vAddrToSend.reserve(pto->vAddrToSend.size());
+                for (const auto& addr : pto->vAddrToSend)
                 {
-                    pto->addrKnown.insert(addr.GetKey());
-                    vAddr.push_back(addr);
-                    // receiver rejects addr messages with a size larger than 1000
-                    if (vAddr.size() >= 1000)
+                    if (!pto->addrKnown.contains(addr.GetKey()))
                     {
-                        pto->PushMessage("addr", vAddr);
-                        vAddr.clear();
+                        pto->addrKnown.insert(addr.GetKey());
+                        vAddrToSend.push_back(addr);
                     }
                 }
+                pto->vAddrToSend.clear();
             }
-            pto->vAddrToSend.clear();
-            if (!vAddr.empty())
+            // receiver rejects addr messages with a size larger than 1000
+            vector<CAddress> vAddr;
+            for (size_t i = 0; i < vAddrToSend.size(); i += 1000)
+            {
+                vAddr.assign(vAddrToSend.begin() + i, vAddrToSend.begin() + min(i + 1000, vAddrToSend.size()));
                 pto->PushMessage("addr", vAddr);
+            }
         }
 
         const NodeId nodeId = pto->GetId();
@@ -6296,7 +6730,13 @@ bool SendMessages(const CChainParams& chainparams, CNode* pto, bool fSendTrickle
         }
         assert(pNodeState);
         CNodeState &state = *pNodeState;
-        if (state.fShouldBan)
+        bool fShouldBan;
+        {
+            LOCK(cs_mapNodeState);
+            fShouldBan = state.fShouldBan;
+            state.fShouldBan = false;
+        }
+        if (fShouldBan)
         {
             if (pto->fWhitelisted)
                 LogPrintf("Warning: not punishing whitelisted peer %s!\n", pto->addr.ToString());
@@ -6307,7 +6747,6 @@ bool SendMessages(const CChainParams& chainparams, CNode* pto, bool fSendTrickle
                 else
                     CNode::Ban(pto->addr);
             }
-            state.fShouldBan = false;
         }
 
         for (const auto& reject : state.rejects)
@@ -6547,3 +6986,32 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
         return true;
     return pblocktree->ReadSpentIndex(key, value);
 }
+
+bool GetAddressIndex(const uint160& addressHash, const CScript::ScriptType type,
+    vector<pair<CAddressIndexKey, CAmount>> &vAddressIndex, const int nStartHeight, const int nEndHeight)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+    if (!pblocktree->ReadAddressIndex(addressHash, type, vAddressIndex, nStartHeight, nEndHeight))
+        return error("unable to get txids for address");
+    return true;
+}
+
+bool GetAddressUnspent(const uint160& addressHash, const CScript::ScriptType type,
+    vector<pair<CAddressUnspentKey, CAddressUnspentValue>> &vUnspentOutputs)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, vUnspentOutputs))
+        return error("unable to get txids for address");
+    return true;
+}
+
+bool GetTimestampIndex(const unsigned int nHigh, const unsigned int nLow, v_uint256 &vHashes)
+{
+    if (!fTimestampIndex)
+        return error("timestamp index not enabled");
+    if (!pblocktree->ReadTimestampIndex(nHigh, nLow, vHashes))
+        return error("unable to get hashes for timestamps");
+    return true;
+}
@@ -31,11 +31,14 @@
 #include <script/sigcache.h>
 #include <script/standard.h>
 #include <spentindex.h>
+#include <addressindex.h>
+#include <timestampindex.h>
 #include <sync.h>
 #include <tinyformat.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <script_check.h>
+#include <sapling_check.h>
 
 class CBlockIndex;
 class CBlockTreeDB;
@@ -64,6 +67,14 @@ static constexpr unsigned int MAX_P2SH_SIGOPS = 15;
 static constexpr unsigned int MAX_STANDARD_TX_SIGOPS = MAX_BLOCK_SIGOPS/5;
 /** Default for -minrelaytxfee, minimum relay fee for transactions */
 static constexpr unsigned int DEFAULT_MIN_RELAY_TX_FEE = 100;
+/** Default for -maxmempool, maximum megabytes of mempool memory usage */
+static constexpr unsigned int DEFAULT_MAX_MEMPOOL_SIZE = 300;
+/** Default for -persistmempool */
+static constexpr bool DEFAULT_PERSIST_MEMPOOL = true;
+/** Interval in seconds between periodic mempool dumps */
+static constexpr int64_t MEMPOOL_DUMP_INTERVAL_SECS = 15 * 60;
+/** Number of transactions re-accepted under one cs_main lock when loading mempool.dat */
+static constexpr size_t MEMPOOL_LOAD_BATCH_SIZE = 100;
 /** Default for -txexpirydelta, in number of blocks */
 static constexpr unsigned int DEFAULT_TX_EXPIRY_DELTA = 20;
 /** The number of blocks within expiry height when a tx is considered to be expiring soon */
@@ -124,6 +135,9 @@ extern bool fAddressIndex;
 // Maintain a full spent index, used to query the spending txid and input index for an outpoint
 extern bool fSpentIndex;
 
+// Maintain a timestamp index, used to query for blocks by time range
+extern bool fTimestampIndex;
+
 extern std::string STR_MSG_MAGIC;
 extern unsigned int expiryDelta;
 extern CScript COINBASE_FLAGS;
@@ -187,6 +201,7 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals);
  * Process an incoming block. This only returns after the best known valid
  * block is made active. Note that it does not, however, guarantee that the
  * specific block passed to it has been checked for validity!
+ * Should not be called with cs_main held - it may wait for the validation interface queue backlog.
  *
  * @param[out]  state   This may be set to an Error state if any error occurred processing it, including during 
  *                      validation/connection/etc of otherwise unrelated blocks during reorganisation; 
@@ -292,7 +307,13 @@ bool AcceptToMemoryPool(
      CTxMemPool& pool, CValidationState &state,
      const CTransaction &tx,
      bool fLimitFree,
-     bool* pfMissingInputs, bool fRejectAbsurdFee=false);
+     bool* pfMissingInputs, bool fRejectAbsurdFee=false,
+     const int64_t nAcceptTime = 0);
+
+/** Dump the mempool to disk (mempool.dat). */
+bool DumpMempool();
+/** Load the mempool from disk and re-accept transactions in batches. */
+bool LoadMempool(const CChainParams& chainparams);
 
 
 struct CNodeStateStats {
@@ -384,7 +405,8 @@ bool ContextualCheckTransaction(
     const CChainParams& chainparams,
     const int nHeight,
     const bool isMined,
-    funcIsInitialBlockDownload_t isInitBlockDownload = fnIsInitialBlockDownload);
+    funcIsInitialBlockDownload_t isInitBlockDownload = fnIsInitialBlockDownload,
+    std::vector<CSaplingProofCheck> *pvSaplingChecks = nullptr);
 
 /** Apply the effects of this transaction on the UTXO set represented by view */
 void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight);
@@ -439,6 +461,12 @@ bool IsExpiringSoonTx(const CTransaction &tx, int nNextBlockHeight);
 bool CheckFinalTx(const CTransaction &tx, int flags = -1);
 
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
+bool GetAddressIndex(const uint160& addressHash, const CScript::ScriptType type,
+                     std::vector<std::pair<CAddressIndexKey, CAmount>> &vAddressIndex,
+                     const int nStartHeight = 0, const int nEndHeight = 0);
+bool GetAddressUnspent(const uint160& addressHash, const CScript::ScriptType type,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> &vUnspentOutputs);
+bool GetTimestampIndex(const unsigned int nHigh, const unsigned int nLow, v_uint256 &vHashes);
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
@@ -460,21 +488,25 @@ bool DisconnectBlock(
     CCoinsViewCache& coins,
     bool* pfClean = nullptr);
 
-/** Apply the effects of this block (with given index) on the UTXO set represented by coins */
+/** Apply the effects of this block (with given index) on the UTXO set represented by coins.
+ *  If fUpdateInsightIndexes is false, insight explorer address, spent and timestamp indexes are not written
+ *  (used by VerifyDB to reconnect blocks that are already indexed). */
 bool ConnectBlock(
     const CBlock& block,
     CValidationState& state,
     const CChainParams& chainparams,
     CBlockIndex* pindex,
     CCoinsViewCache& coins,
-    bool fJustCheck = false);
+    bool fJustCheck = false,
+    const bool fUpdateInsightIndexes = true);
 
 /** Context-independent validity checks */
 bool CheckBlockHeader(
     const CBlockHeader& block,
     CValidationState& state,
     const CChainParams& chainparams,
-    bool fCheckPOW = true);
+    bool fCheckPOW = true,
+    const bool bEquihashVerified = false);
 bool CheckBlock(
     const CBlock& block,
     CValidationState& state,
@@ -521,7 +553,8 @@ bool AcceptBlockHeader(
     const CBlockHeader& block, 
     CValidationState& state, 
     const CChainParams& chainparams,
-    CBlockIndex** ppindex = nullptr);
+    CBlockIndex** ppindex = nullptr,
+    const bool bEquihashVerified = false);
 
 
 
@@ -4,6 +4,9 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 #include <tuple>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
 #ifdef ENABLE_MINING
 #include <functional>
 #endif
@@ -48,55 +51,384 @@ using namespace std;
 // BitcoinMiner
 //
 
-//
-// Unconfirmed transactions in the memory pool often depend on other
-// transactions in the memory pool. When we select transactions from the
-// pool, we select by highest priority or fee rate, so we might consider
-// transactions that depend on transactions that aren't yet in the block.
-// The COrphan class keeps track of these 'temporary orphans' while
-// CreateBlock is figuring out which transactions to include.
-//
-class COrphan
+uint64_t nLastBlockTx = 0;
+uint64_t nLastBlockSize = 0;
+
+// max number of consecutive packages that did not fit into the almost full block
+constexpr int MAX_CONSECUTIVE_PACKAGE_FAILURES = 1000;
+
+/**
+ * Selects memory pool transactions for the new block template.
+ * 
+ * High-priority transactions are added first (up to -blockprioritysize),
+ * the rest of the block is filled in a single pass over the mempool ancestor fee rate index:
+ * each transaction is added together with all its in-mempool ancestors (child-pays-for-parent).
+ * Ancestor state of the transactions with some ancestors already in the block is
+ * tracked in the "modified" set.
+ * Should be used with cs_main and mempool.cs locked.
+ */
+class CBlockTemplateAssembler
 {
 public:
-    const CTransaction* ptx;
-    set<uint256> setDependsOn;
-    CFeeRate feeRate;
-    double dPriority;
-
-    COrphan(const CTransaction* ptxIn) : ptx(ptxIn), feeRate(0), dPriority(0)
+    CBlockTemplateAssembler(CBlockTemplate &blockTemplate, CCoinsViewCache &view, SaplingMerkleTree &saplingTree,
+        const Consensus::Params& consensusParams, const uint32_t nConsensusBranchId,
+        const int nHeight, const int64_t nLockTimeCutoff) :
+        m_blockTemplate(blockTemplate),
+        m_view(view),
+        m_saplingTree(saplingTree),
+        m_consensusParams(consensusParams),
+        m_nConsensusBranchId(nConsensusBranchId),
+        m_nHeight(nHeight),
+        m_nLockTimeCutoff(nLockTimeCutoff)
     {
+        m_fPrintPriority = GetBoolArg("-printpriority", false);
     }
+
+    void AddPriorityTxs(const unsigned int nBlockPrioritySize);
+    void AddPackageTxs(const unsigned int nBlockMaxSize, const unsigned int nBlockMinSize);
+
+    uint64_t GetBlockSize() const noexcept { return m_nBlockSize; }
+    uint64_t GetBlockTxCount() const noexcept { return m_nBlockTx; }
+    CAmount GetFees() const noexcept { return m_nFees; }
+
+protected:
+    using txiter = CTxMemPool::txiter;
+
+    // ancestor state of the package excluding ancestors already added to the block
+    typedef struct _package_score_t
+    {
+        uint64_t nSize;
+        CAmount nModFees;
+        uint256 txid;
+
+        // higher ancestor fee rate first
+        bool operator<(const _package_score_t& other) const noexcept
+        {
+            const double f1 = static_cast<double>(nModFees) * other.nSize;
+            const double f2 = static_cast<double>(other.nModFees) * nSize;
+            if (f1 == f2)
+                return txid < other.txid;
+            return f1 > f2;
+        }
+    } package_score_t;
+
+    bool IsInBlock(const uint256& txid) const noexcept { return m_setInBlock.count(txid) > 0; }
+    bool TestPackage(const vector<txiter>& vPackage, CCoinsViewCache& viewPackage, vector<unsigned int>& vSigOps) const;
+    void AddToBlock(txiter it, const unsigned int nTxSigOps);
+    void UpdateModifiedDescendants(txiter it);
+    void RemoveModified(const uint256& txid);
+
+    CBlockTemplate &m_blockTemplate;
+    CCoinsViewCache &m_view;
+    SaplingMerkleTree &m_saplingTree;
+    const Consensus::Params& m_consensusParams;
+    const uint32_t m_nConsensusBranchId;
+    const int m_nHeight;
+    const int64_t m_nLockTimeCutoff;
+    bool m_fPrintPriority;
+
+    uint64_t m_nBlockSize = 1000;
+    uint64_t m_nBlockTx = 0;
+    unsigned int m_nBlockSigOps = 100;
+    CAmount m_nFees = 0;
+
+    set<uint256> m_setInBlock;
+    // transactions with some ancestors in the block
+    unordered_map<uint256, package_score_t> m_mapModified;
+    set<package_score_t> m_setModified;
 };
 
-uint64_t nLastBlockTx = 0;
-uint64_t nLastBlockSize = 0;
+/**
+ * Check that the package can be added to the block.
+ * Transactions should be ordered so that parents come before children.
+ * 
+ * \param vPackage - package transactions
+ * \param viewPackage - coins view to apply the package transactions to
+ * \param vSigOps - returns sigops for each package transaction
+ * \return true if all package transactions are final, have valid inputs (mandatory script flags)
+ *         and the block sigop limit is not exceeded
+ */
+bool CBlockTemplateAssembler::TestPackage(const vector<txiter>& vPackage, CCoinsViewCache& viewPackage, vector<unsigned int>& vSigOps) const
+{
+    unsigned int nPackageSigOps = 0;
+    vSigOps.clear();
+    vSigOps.reserve(vPackage.size());
+    for (const auto& it : vPackage)
+    {
+        const auto& tx = it->GetTx();
+        if (tx.IsCoinBase() || !IsFinalTx(tx, m_nHeight, m_nLockTimeCutoff) || IsExpiredTx(tx, m_nHeight))
+            return false;
+        if (!viewPackage.HaveInputs(tx))
+            return false;
+        const unsigned int nTxSigOps = GetLegacySigOpCount(tx) + GetP2SHSigOpCount(tx, viewPackage);
+        nPackageSigOps += nTxSigOps;
+        if (m_nBlockSigOps + nPackageSigOps >= MAX_BLOCK_SIGOPS)
+            return false;
+        // Note that flags: we don't want to set mempool/IsStandard()
+        // policy here, but we still have to ensure that the block we
+        // create only contains transactions that are valid in new blocks.
+        CValidationState state;
+        PrecomputedTransactionData txdata(tx);
+        if (!ContextualCheckInputs(tx, state, viewPackage, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true, txdata, m_consensusParams, m_nConsensusBranchId))
+            return false;
+        UpdateCoins(tx, viewPackage, m_nHeight);
+        vSigOps.push_back(nTxSigOps);
+    }
+    return true;
+}
 
-// We want to sort transactions by priority and fee rate, so:
-typedef std::tuple<double, CFeeRate, const CTransaction*> TxPriority;
-class TxPriorityCompare
+void CBlockTemplateAssembler::AddToBlock(txiter it, const unsigned int nTxSigOps)
 {
-    bool byFee;
+    const auto& tx = it->GetTx();
+    for (const auto &outDescription : tx.vShieldedOutput)
+        m_saplingTree.append(outDescription.cm);
+
+    m_blockTemplate.block.vtx.push_back(tx);
+    m_blockTemplate.vTxFees.push_back(it->GetFee());
+    m_blockTemplate.vTxSigOps.push_back(nTxSigOps);
+    m_nBlockSize += it->GetTxSize();
+    ++m_nBlockTx;
+    m_nBlockSigOps += nTxSigOps;
+    m_nFees += it->GetFee();
+    m_setInBlock.insert(tx.GetHash());
+    RemoveModified(tx.GetHash());
+
+    if (m_fPrintPriority)
+    {
+        LogPrintf("fee %s ancestor fee %s txid %s\n",
+            it->GetFeeRate().ToString(), CFeeRate(it->GetModFeesWithAncestors(), it->GetSizeWithAncestors()).ToString(),
+            tx.GetHash().ToString());
+    }
+}
 
-public:
-    TxPriorityCompare(bool _byFee) : byFee(_byFee) { }
+void CBlockTemplateAssembler::RemoveModified(const uint256& txid)
+{
+    const auto it = m_mapModified.find(txid);
+    if (it == m_mapModified.end())
+        return;
+    m_setModified.erase(it->second);
+    m_mapModified.erase(it);
+}
 
-    bool operator()(const TxPriority& a, const TxPriority& b)
+/**
+ * Transaction was added to the block - exclude it from the ancestor state of its descendants.
+ * 
+ * \param it - transaction added to the block
+ */
+void CBlockTemplateAssembler::UpdateModifiedDescendants(txiter it)
+{
+    set<uint256> setDescendants;
+    mempool.CalculateDescendants(it->GetTx().GetHash(), setDescendants);
+    for (const auto& txid : setDescendants)
     {
-        if (byFee)
+        if (IsInBlock(txid))
+            continue;
+        auto itModified = m_mapModified.find(txid);
+        if (itModified == m_mapModified.end())
         {
-            if (std::get<1>(a) == std::get<1>(b))
-                return std::get<0>(a) < std::get<0>(b);
-            return std::get<1>(a) < std::get<1>(b);
+            const auto itDescendant = mempool.mapTx.find(txid);
+            if (itDescendant == mempool.mapTx.end())
+                continue;
+            package_score_t score = { itDescendant->GetSizeWithAncestors(), itDescendant->GetModFeesWithAncestors(), txid };
+            itModified = m_mapModified.emplace(txid, score).first;
+        } else
+            m_setModified.erase(itModified->second);
+        itModified->second.nSize -= it->GetTxSize();
+        itModified->second.nModFees -= it->GetModifiedFee();
+        m_setModified.insert(itModified->second);
+    }
+}
+
+/**
+ * Add high-priority transactions to the block (regardless of their fees)
+ * until the block reaches nBlockPrioritySize.
+ * Transactions with in-mempool parents wait until all parents are added.
+ * 
+ * \param nBlockPrioritySize - max size of the block part dedicated to high-priority transactions
+ */
+void CBlockTemplateAssembler::AddPriorityTxs(const unsigned int nBlockPrioritySize)
+{
+    if (!nBlockPrioritySize)
+        return;
+    using tx_priority_t = pair<double, txiter>;
+    const auto comparer = [](const tx_priority_t& a, const tx_priority_t& b) noexcept
+    {
+        if (a.first == b.first)
+            return a.second->GetFeeRate() < b.second->GetFeeRate();
+        return a.first < b.first;
+    };
+    vector<tx_priority_t> vecPriority;
+    vecPriority.reserve(mempool.mapTx.size());
+    // transactions waiting for their in-mempool parents
+    unordered_map<uint256, double> mapWaitPriority;
+    for (auto mi = mempool.mapTx.cbegin(); mi != mempool.mapTx.cend(); ++mi)
+    {
+        double dPriority = mi->GetPriority(m_nHeight);
+        CAmount nDummy = 0;
+        mempool.ApplyDeltas(mi->GetTx().GetHash(), dPriority, nDummy);
+        vecPriority.emplace_back(dPriority, mi);
+    }
+    make_heap(vecPriority.begin(), vecPriority.end(), comparer);
+
+    vector<unsigned int> vSigOps;
+    while (!vecPriority.empty())
+    {
+        const auto [dPriority, it] = vecPriority.front();
+        pop_heap(vecPriority.begin(), vecPriority.end(), comparer);
+        vecPriority.pop_back();
+
+        const auto& tx = it->GetTx();
+        const uint256& hash = tx.GetHash();
+        if (IsInBlock(hash))
+            continue;
+        if ((m_nBlockSize + it->GetTxSize() >= nBlockPrioritySize) || !AllowFree(dPriority))
+            break;
+
+        // all in-mempool parents should be already in the block
+        bool bWaitForParents = false;
+        for (const auto& txin : tx.vin)
+        {
+            if (mempool.exists_nolock(txin.prevout.hash) && !IsInBlock(txin.prevout.hash))
+            {
+                bWaitForParents = true;
+                break;
+            }
+        }
+        if (bWaitForParents)
+        {
+            mapWaitPriority.emplace(hash, dPriority);
+            continue;
         }
-        else
+
+        CCoinsViewCache viewPackage(&m_view);
+        if (!TestPackage({it}, viewPackage, vSigOps))
+            continue;
+        viewPackage.Flush();
+        AddToBlock(it, vSigOps[0]);
+        UpdateModifiedDescendants(it);
+
+        // children waiting for this transaction can be processed again
+        for (auto itNext = mempool.mapNextTx.lower_bound(COutPoint(hash, 0)); 
+             (itNext != mempool.mapNextTx.cend()) && (itNext->first.hash == hash); ++itNext)
         {
-            if (std::get<0>(a) == std::get<0>(b))
-                return std::get<1>(a) < std::get<1>(b);
-            return std::get<0>(a) < std::get<0>(b);
+            const auto itWait = mapWaitPriority.find(itNext->second.ptx->GetHash());
+            if (itWait == mapWaitPriority.end())
+                continue;
+            const auto itChild = mempool.mapTx.find(itWait->first);
+            if (itChild != mempool.mapTx.cend())
+            {
+                vecPriority.emplace_back(itWait->second, itChild);
+                push_heap(vecPriority.begin(), vecPriority.end(), comparer);
+            }
+            mapWaitPriority.erase(itWait);
         }
     }
-};
+}
+
+/**
+ * Fill the block with the transaction packages in the ancestor fee rate order.
+ * 
+ * \param nBlockMaxSize - max block size
+ * \param nBlockMinSize - min block size, the block is filled with low-fee transactions until this size
+ */
+void CBlockTemplateAssembler::AddPackageTxs(const unsigned int nBlockMaxSize, const unsigned int nBlockMinSize)
+{
+    const auto& ancestorIndex = mempool.mapTx.get<2>();
+    auto mi = ancestorIndex.begin();
+    // transactions which packages failed the checks
+    set<uint256> setFailed;
+    int nConsecutiveFailed = 0;
+    vector<unsigned int> vSigOps;
+
+    while ((mi != ancestorIndex.end()) || !m_setModified.empty())
+    {
+        if (mi != ancestorIndex.end())
+        {
+            const uint256& hash = mi->GetTx().GetHash();
+            // modified entries are processed from the modified set
+            if (IsInBlock(hash) || setFailed.count(hash) || m_mapModified.count(hash))
+            {
+                ++mi;
+                continue;
+            }
+        }
+
+        // select the best package from the mempool index and the modified set
+        txiter it;
+        uint64_t nPackageSize;
+        CAmount nPackageFees;
+        bool bUsingModified = false;
+        if (mi == ancestorIndex.end())
+            bUsingModified = true;
+        else if (!m_setModified.empty())
+        {
+            const package_score_t score = { mi->GetSizeWithAncestors(), mi->GetModFeesWithAncestors(), mi->GetTx().GetHash() };
+            bUsingModified = *m_setModified.begin() < score;
+        }
+        if (bUsingModified)
+        {
+            const auto& score = *m_setModified.begin();
+            it = mempool.mapTx.find(score.txid);
+            nPackageSize = score.nSize;
+            nPackageFees = score.nModFees;
+            const uint256 txid = score.txid;
+            RemoveModified(txid);
+            if (it == mempool.mapTx.end())
+                continue;
+        } else {
+            it = mempool.mapTx.project<0>(mi);
+            nPackageSize = mi->GetSizeWithAncestors();
+            nPackageFees = mi->GetModFeesWithAncestors();
+            ++mi;
+        }
+        const uint256 hash = it->GetTx().GetHash();
+
+        // everything else in the mempool has lower ancestor fee rate
+        if ((nPackageFees < ::minRelayTxFee.GetFee(nPackageSize)) && (m_nBlockSize >= nBlockMinSize))
+            break;
+
+        if (m_nBlockSize + nPackageSize >= nBlockMaxSize)
+        {
+            setFailed.insert(hash);
+            if ((++nConsecutiveFailed > MAX_CONSECUTIVE_PACKAGE_FAILURES) && (m_nBlockSize > nBlockMaxSize - 4000))
+                break; // block is almost full
+            continue;
+        }
+
+        // package: in-mempool ancestors that are not in the block yet and the transaction itself
+        set<uint256> setAncestors;
+        mempool.CalculateMemPoolAncestors(it->GetTx(), setAncestors);
+        vector<txiter> vPackage;
+        vPackage.reserve(setAncestors.size() + 1);
+        for (const auto& ancestorTxid : setAncestors)
+        {
+            if (IsInBlock(ancestorTxid))
+                continue;
+            const auto itAncestor = mempool.mapTx.find(ancestorTxid);
+            if (itAncestor != mempool.mapTx.end())
+                vPackage.push_back(itAncestor);
+        }
+        vPackage.push_back(it);
+        // parents have less ancestors than their children
+        sort(vPackage.begin(), vPackage.end(), [](const txiter& a, const txiter& b) noexcept
+        {
+            return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+        });
+
+        CCoinsViewCache viewPackage(&m_view);
+        if (!TestPackage(vPackage, viewPackage, vSigOps))
+        {
+            setFailed.insert(hash);
+            continue;
+        }
+        nConsecutiveFailed = 0;
+        viewPackage.Flush();
+        for (size_t i = 0; i < vPackage.size(); ++i)
+            AddToBlock(vPackage[i], vSigOps[i]);
+        for (const auto& itPackage : vPackage)
+            UpdateModifiedDescendants(itPackage);
+    }
+}
 
 void UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
 {
@@ -147,7 +479,8 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& s
         LOCK2(cs_main, mempool.cs);
         CBlockIndex* pindexPrev = chainActive.Tip();
         const int nHeight = pindexPrev->nHeight + 1;
-        uint32_t consensusBranchId = CurrentEpochBranchId(nHeight, chainparams.GetConsensus());
+        const auto &consensusParams = chainparams.GetConsensus();
+        const uint32_t consensusBranchId = CurrentEpochBranchId(nHeight, consensusParams);
         pblock->nTime = GetAdjustedTime();
         const int64_t nMedianTimePast = pindexPrev->GetMedianTimePast();
         CCoinsViewCache view(pcoinsTip);
@@ -155,194 +488,17 @@ CBlockTemplate* CreateNewBlock(const CChainParams& chainparams, const CScript& s
         SaplingMerkleTree sapling_tree;
         assert(view.GetSaplingAnchorAt(view.GetBestAnchor(SAPLING), sapling_tree));
 
-        // Priority order to process transactions
-        list<COrphan> vOrphan; // list memory doesn't move
-        unordered_map<uint256, vector<COrphan*> > mapDependers;
-        bool fPrintPriority = GetBoolArg("-printpriority", false);
-
-        // This vector will be sorted into a priority queue:
-        vector<TxPriority> vecPriority;
-        vecPriority.reserve(mempool.mapTx.size());
-        for (auto mi = mempool.mapTx.cbegin(); mi != mempool.mapTx.cend(); ++mi)
-        {
-            const CTransaction& tx = mi->GetTx();
-
-            int64_t nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
-                                    ? nMedianTimePast
-                                    : pblock->GetBlockTime();
-
-            if (tx.IsCoinBase() || !IsFinalTx(tx, nHeight, nLockTimeCutoff) || IsExpiredTx(tx, nHeight))
-                continue;
-
-            COrphan* porphan = nullptr;
-            double dPriority = 0;
-            CAmount nTotalIn = 0;
-            bool fMissingInputs = false;
-            for (const auto& txin : tx.vin)
-            {
-                // Read prev transaction
-                if (!view.HaveCoins(txin.prevout.hash))
-                {
-                    // This should never happen; all transactions in the memory
-                    // pool should connect to either transactions in the chain
-                    // or other transactions in the memory pool.
-                    if (!mempool.mapTx.count(txin.prevout.hash))
-                    {
-                        LogPrintf("ERROR: mempool transaction missing input\n");
-                        if (fDebug)
-                            assert("mempool transaction missing input" == 0);
-                        fMissingInputs = true;
-                        if (porphan)
-                            vOrphan.pop_back();
-                        break;
-                    }
-
-                    // Has to wait for dependencies
-                    if (!porphan)
-                    {
-                        // Use list for automatic deletion
-                        vOrphan.push_back(COrphan(&tx));
-                        porphan = &vOrphan.back();
-                    }
-                    mapDependers[txin.prevout.hash].push_back(porphan);
-                    porphan->setDependsOn.insert(txin.prevout.hash);
-                    nTotalIn += mempool.mapTx.find(txin.prevout.hash)->GetTx().vout[txin.prevout.n].nValue;
-                    continue;
-                }
-                const CCoins* coins = view.AccessCoins(txin.prevout.hash);
-                assert(coins);
-
-                CAmount nValueIn = coins->vout[txin.prevout.n].nValue;
-                nTotalIn += nValueIn;
-
-                int nConf = nHeight - coins->nHeight;
-
-                dPriority += (double)nValueIn * nConf;
-            }
-            nTotalIn += tx.GetShieldedValueIn();
-
-            if (fMissingInputs)
-                continue;
-
-            // Priority is sum(valuein * age) / modified_txsize
-            const size_t nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
-            dPriority = tx.ComputePriority(dPriority, nTxSize);
-
-            uint256 hash = tx.GetHash();
-            mempool.ApplyDeltas(hash, dPriority, nTotalIn);
-
-            CFeeRate feeRate(nTotalIn-tx.GetValueOut(), nTxSize);
-
-            if (porphan)
-            {
-                porphan->dPriority = dPriority;
-                porphan->feeRate = feeRate;
-            }
-            else
-                vecPriority.emplace_back(dPriority, feeRate, &(mi->GetTx()));
-        }
+        const int64_t nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+                                ? nMedianTimePast
+                                : pblock->GetBlockTime();
 
         // Collect transactions into block
-        uint64_t nBlockSize = 1000;
-        uint64_t nBlockTx = 0;
-        int nBlockSigOps = 100;
-        bool fSortedByFee = (nBlockPrioritySize <= 0);
-
-        TxPriorityCompare comparer(fSortedByFee);
-        std::make_heap(vecPriority.begin(), vecPriority.end(), comparer);
-
-        const auto &consensusParams = chainparams.GetConsensus();
-        while (!vecPriority.empty())
-        {
-            // Take highest priority transaction off the priority queue:
-            double dPriority = std::get<0>(vecPriority.front());
-            CFeeRate feeRate = std::get<1>(vecPriority.front());
-            const CTransaction& tx = *(std::get<2>(vecPriority.front()));
-
-            std::pop_heap(vecPriority.begin(), vecPriority.end(), comparer);
-            vecPriority.pop_back();
-
-            // Size limits
-            const size_t nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
-            if (nBlockSize + nTxSize >= nBlockMaxSize)
-                continue;
-
-            // Legacy limits on sigOps:
-            unsigned int nTxSigOps = GetLegacySigOpCount(tx);
-            if (nBlockSigOps + nTxSigOps >= MAX_BLOCK_SIGOPS)
-                continue;
-
-            // Skip free transactions if we're past the minimum block size:
-            const uint256& hash = tx.GetHash();
-            double dPriorityDelta = 0;
-            CAmount nFeeDelta = 0;
-            mempool.ApplyDeltas(hash, dPriorityDelta, nFeeDelta);
-            if (fSortedByFee && (dPriorityDelta <= 0) && (nFeeDelta <= 0) && (feeRate < ::minRelayTxFee) && (nBlockSize + nTxSize >= nBlockMinSize))
-                continue;
-
-            // Prioritise by fee once past the priority size or we run out of high-priority
-            // transactions:
-            if (!fSortedByFee &&
-                ((nBlockSize + nTxSize >= nBlockPrioritySize) || !AllowFree(dPriority)))
-            {
-                fSortedByFee = true;
-                comparer = TxPriorityCompare(fSortedByFee);
-                std::make_heap(vecPriority.begin(), vecPriority.end(), comparer);
-            }
-
-            if (!view.HaveInputs(tx))
-                continue;
-
-            CAmount nTxFees = view.GetValueIn(tx)-tx.GetValueOut();
-
-            nTxSigOps += GetP2SHSigOpCount(tx, view);
-            if (nBlockSigOps + nTxSigOps >= MAX_BLOCK_SIGOPS)
-                continue;
-
-            // Note that flags: we don't want to set mempool/IsStandard()
-            // policy here, but we still have to ensure that the block we
-            // create only contains transactions that are valid in new blocks.
-            CValidationState state;
-            PrecomputedTransactionData txdata(tx);
-            if (!ContextualCheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true, txdata, consensusParams, consensusBranchId))
-                continue;
-
-            UpdateCoins(tx, view, nHeight);
-
-            for (const auto &outDescription : tx.vShieldedOutput)
-                sapling_tree.append(outDescription.cm);
-
-            // Added
-            pblock->vtx.push_back(tx);
-            pblocktemplate->vTxFees.push_back(nTxFees);
-            pblocktemplate->vTxSigOps.push_back(nTxSigOps);
-            nBlockSize += nTxSize;
-            ++nBlockTx;
-            nBlockSigOps += nTxSigOps;
-            nFees += nTxFees;
-
-            if (fPrintPriority)
-            {
-                LogPrintf("priority %.1f fee %s txid %s\n",
-                    dPriority, feeRate.ToString(), tx.GetHash().ToString());
-            }
-
-            // Add transactions that depend on this one to the priority queue
-            if (mapDependers.count(hash))
-            {
-                for (auto porphan : mapDependers[hash])
-                {
-                    if (porphan->setDependsOn.empty())
-                        continue;
-                    porphan->setDependsOn.erase(hash);
-                    if (porphan->setDependsOn.empty())
-                    {
-                        vecPriority.emplace_back(porphan->dPriority, porphan->feeRate, porphan->ptx);
-                        std::push_heap(vecPriority.begin(), vecPriority.end(), comparer);
-                    }
-                }
-            }
-        }
+        CBlockTemplateAssembler assembler(*pblocktemplate, view, sapling_tree, consensusParams, consensusBranchId, nHeight, nLockTimeCutoff);
+        assembler.AddPriorityTxs(nBlockPrioritySize);
+        assembler.AddPackageTxs(nBlockMaxSize, nBlockMinSize);
+        const uint64_t nBlockSize = assembler.GetBlockSize();
+        const uint64_t nBlockTx = assembler.GetBlockTxCount();
+        nFees = assembler.GetFees();
 
         nLastBlockTx = nBlockTx;
         nLastBlockSize = nBlockSize;
@@ -68,6 +68,7 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogFnPrint("masternode", "Adding new Masternode: addr=%s, %zu now", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.vin.prevout] = mn;
+    InvalidateRanksCache();
     return true;
 }
 
@@ -154,6 +155,7 @@ void CMasternodeMan::CheckAndRemove(bool bCheckAndRemove)
 
                 // and finally remove it from the list
                 mapMasternodes.erase(it++);
+                InvalidateRanksCache();
             } else {
                 const bool fAsk = (nAskForMnbRecovery > 0) &&
                             masterNodeCtrl.masternodeSync.IsSynced() &&
@@ -312,6 +314,7 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    InvalidateRanksCache();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -631,6 +634,52 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     return !vecMasternodeScoresRet.empty();
 }
 
+/**
+ * Get masternode ranks for the given block hash.
+ * Ranks are calculated once per (block hash, min protocol version) and cached
+ * until the masternode list is changed.
+ * cs should be locked by the caller.
+ * 
+ * \param nBlockHash - block hash to calculate MN scores for
+ * \param nMinProtocol - min MN protocol version
+ * \return pointer to the cached MN ranks or nullptr if ranks can't be calculated
+ */
+const CMasternodeMan::mn_ranks_t* CMasternodeMan::GetMasternodeRanksCached(const uint256& nBlockHash, const int nMinProtocol)
+{
+    AssertLockHeld(cs);
+    const auto key = make_pair(nBlockHash, nMinProtocol);
+    const auto it = mapRanksCache.find(key);
+    if (it != mapRanksCache.cend())
+        return &it->second;
+
+    score_pair_vec_t vecMasternodeScores;
+    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+        return nullptr;
+
+    mn_ranks_t ranks;
+    ranks.vRanked.reserve(vecMasternodeScores.size());
+    ranks.mapRank.reserve(vecMasternodeScores.size());
+    bool bCanCache = true;
+    int nRank = 0;
+    for (const auto& [score, pmn] : vecMasternodeScores)
+    {
+        ranks.vRanked.push_back(pmn->vin.prevout);
+        ranks.mapRank.emplace(pmn->vin.prevout, ++nRank);
+        // MN score will change when collateral block hash is set
+        if (pmn->nCollateralMinConfBlockHash.IsNull())
+            bCanCache = false;
+    }
+    if (!bCanCache)
+    {
+        // keep the ranks only until the next call
+        mnRanksNotCached = move(ranks);
+        return &mnRanksNotCached;
+    }
+    if (mapRanksCache.size() >= MAX_MN_RANKS_CACHE_SIZE)
+        mapRanksCache.clear();
+    return &mapRanksCache.emplace(key, move(ranks)).first->second;
+}
+
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -648,22 +697,15 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const auto pRanks = GetMasternodeRanksCached(nBlockHash, nMinProtocol);
+    if (!pRanks)
         return false;
 
-    int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores)
-    {
-        nRank++;
-        if (scorePair.second->vin.prevout == outpoint)
-        {
-            nRankRet = nRank;
-            return true;
-        }
-    }
-
-    return false;
+    const auto it = pRanks->mapRank.find(outpoint);
+    if (it == pRanks->mapRank.cend())
+        return false;
+    nRankRet = it->second;
+    return true;
 }
 
 bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight, int nMinProtocol)
@@ -683,15 +725,18 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const auto pRanks = GetMasternodeRanksCached(nBlockHash, nMinProtocol);
+    if (!pRanks)
         return false;
 
+    vecMasternodeRanksRet.reserve(pRanks->vRanked.size());
     int nRank = 0;
-    for (auto& scorePair : vecMasternodeScores)
+    for (const auto& outpoint : pRanks->vRanked)
     {
-        nRank++;
-        vecMasternodeRanksRet.emplace_back(nRank, *scorePair.second);
+        ++nRank;
+        const auto it = mapMasternodes.find(outpoint);
+        if (it != mapMasternodes.cend())
+            vecMasternodeRanksRet.emplace_back(nRank, it->second);
     }
 
     return true;
@@ -776,12 +821,19 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, string& strCommand, CDataStrea
 
         LogFnPrint("masternode", "MNPING -- Masternode ping, masternode=%s", mnp.vin.prevout.ToStringShort());
 
+        {
+            // most of the pings are relayed by several peers - skip already seen ones without taking cs_main
+            LOCK(cs);
+            if (mapSeenMasternodePing.count(nHash))
+                return; //seen
+        }
+
         // Need LOCK2 here to ensure consistent locking order because the CheckAndUpdate call below locks cs_main
         LOCK2(cs_main, cs);
 
-        if(mapSeenMasternodePing.count(nHash))
+        // ping could be processed by another message handler thread in the meantime
+        if (!mapSeenMasternodePing.emplace(nHash, mnp).second)
             return; //seen
-        mapSeenMasternodePing.emplace(nHash, mnp);
 
         LogFnPrint("masternode", "MNPING -- Masternode ping, masternode=%s new", mnp.vin.prevout.ToStringShort());
 
@@ -879,9 +931,6 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, string& strCommand, CDataStrea
 
     } else if (strCommand == NetMsgType::MNVERIFY) { // Masternode Verify
 
-        // Need LOCK2 here to ensure consistent locking order because the all functions below call GetBlockHash which locks cs_main
-        LOCK2(cs_main, cs);
-
         CMasternodeVerification mnv;
         vRecv >> mnv;
 
@@ -890,6 +939,9 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, string& strCommand, CDataStrea
         if (!masterNodeCtrl.masternodeSync.IsMasternodeListSynced())
             return;
 
+        // Need LOCK2 here to ensure consistent locking order because the all functions below call GetBlockHash which locks cs_main
+        LOCK2(cs_main, cs);
+
         if(mnv.vchSig1.empty()) {
             // CASE 1: someone asked me to verify myself /IP we are using/
             SendVerifyReply(pfrom, mnv);
@@ -1390,7 +1442,12 @@ void CMasternodeMan::UpdateMasternodeList(CMasternodeBroadcast mnb)
             masterNodeCtrl.masternodeSync.BumpAssetLastTime("CMasternodeMan::UpdateMasternodeList - new");
     } else {
         CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-        if(pmn->UpdateFromNewBroadcast(mnb))
+        const int nOldProtocolVersion = pmn->nProtocolVersion;
+        const bool bUpdated = pmn->UpdateFromNewBroadcast(mnb);
+        // ranks are filtered by MN protocol version
+        if (pmn->nProtocolVersion != nOldProtocolVersion)
+            InvalidateRanksCache();
+        if (bUpdated)
         {
             masterNodeCtrl.masternodeSync.BumpAssetLastTime("CMasternodeMan::UpdateMasternodeList - seen");
             mapSeenMasternodeBroadcast.erase(mnbOld.GetHash());
@@ -1462,7 +1519,12 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         if (pmn)
         {
             auto mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if (!mnb.Update(pmn, nDos))
+            const int nOldProtocolVersion = pmn->nProtocolVersion;
+            const bool bUpdated = mnb.Update(pmn, nDos);
+            // ranks are filtered by MN protocol version
+            if (pmn->nProtocolVersion != nOldProtocolVersion)
+                InvalidateRanksCache();
+            if (!bUpdated)
             {
                 LogFnPrint("masternode", "Update() failed, masternode=%s", mnb.vin.prevout.ToStringShort());
                 return false;
@@ -1611,23 +1673,39 @@ void CMasternodeMan::UpdatedBlockTip(const CBlockIndex *pindex)
 
 vector<CMasternode> CMasternodeMan::CalculateTopMNsForBlock(int nBlockHeight)
 {
-    rank_pair_vec_t vMasternodeRanks;
-    if (!GetMasternodeRanks(vMasternodeRanks, nBlockHeight) ||
-        vMasternodeRanks.size() < masterNodeCtrl.nMasternodeTopMNsNumberMin)
-    {
-        LogFnPrintf("ERROR: Failed to find Top MasterNodes");
-        return vector<CMasternode>{};
-    }
-    
     vector<CMasternode> topMNs;
-    for (auto mn : vMasternodeRanks)
+    do
     {
-        if (mn.second.IsValidForPayment())
-            topMNs.push_back(mn.second);
-        if (topMNs.size() == masterNodeCtrl.nMasternodeTopMNsNumber)
+        if (!masterNodeCtrl.masternodeSync.IsMasternodeListSynced())
             break;
-    }
 
+        uint256 nBlockHash;
+        if (!GetBlockHash(nBlockHash, nBlockHeight))
+        {
+            LogFnPrintf("ERROR: GetBlockHash() failed at nBlockHeight %d", nBlockHeight);
+            break;
+        }
+
+        LOCK(cs);
+        const auto pRanks = GetMasternodeRanksCached(nBlockHash, 0);
+        if (!pRanks || pRanks->vRanked.size() < masterNodeCtrl.nMasternodeTopMNsNumberMin)
+            break;
+
+        // walk MNs in rank order, copy only top MNs valid for payment
+        topMNs.reserve(masterNodeCtrl.nMasternodeTopMNsNumber);
+        for (const auto& outpoint : pRanks->vRanked)
+        {
+            const auto it = mapMasternodes.find(outpoint);
+            if (it == mapMasternodes.cend() || !it->second.IsValidForPayment())
+                continue;
+            topMNs.push_back(it->second);
+            if (topMNs.size() == masterNodeCtrl.nMasternodeTopMNsNumber)
+                break;
+        }
+        return topMNs;
+    } while (false);
+
+    LogFnPrintf("ERROR: Failed to find Top MasterNodes");
     return topMNs;
 }
 
@@ -10,6 +10,7 @@
 #include <list>
 #include <set>
 #include <atomic>
+#include <unordered_map>
 
 #include <net.h>
 #include <sync.h>
@@ -18,6 +19,15 @@
 
 using namespace std;
 
+// hasher for the unordered containers with COutPoint key
+struct COutPointHasher
+{
+    size_t operator()(const COutPoint& outpoint) const noexcept
+    {
+        return static_cast<size_t>(outpoint.hash.GetCheapHash() ^ outpoint.n);
+    }
+};
+
 class CMasternodeMan
 {
 public:
@@ -26,7 +36,17 @@ public:
     typedef std::pair<int, CMasternode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
 
-private:
+    // max number of block hashes to keep masternode ranks for
+    static constexpr size_t MAX_MN_RANKS_CACHE_SIZE = 64;
+
+    // masternode ranks calculated for the block hash
+    typedef struct _mn_ranks_t
+    {
+        std::vector<COutPoint> vRanked; // MN outpoints ordered by rank (by score descending)
+        std::unordered_map<COutPoint, int, COutPointHasher> mapRank; // MN outpoint -> rank (1-based)
+    } mn_ranks_t;
+
+protected:
     static const std::string SERIALIZATION_VERSION_STRING;
 
     static constexpr int DSEG_UPDATE_SECONDS        = 3 * 60 * 60;
@@ -68,6 +88,11 @@ private:
     std::list< std::pair<CService, uint256> > listScheduledMnbRequestConnections;
     
     std::map<int, std::vector<CMasternode>> mapHistoricalTopMNs;
+    // cache of the masternode ranks: (block hash, min protocol version) -> ranks
+    // cleared when masternode list is changed
+    std::map<std::pair<uint256, int>, mn_ranks_t> mapRanksCache;
+    // ranks that can't be cached yet (some MN collateral block hashes are not set)
+    mn_ranks_t mnRanksNotCached;
     
     int64_t nLastWatchdogVoteTime;
 
@@ -76,6 +101,10 @@ private:
     CMasternode* Find(const COutPoint& outpoint);
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    // get cached masternode ranks for the block hash, calculates ranks if not cached yet
+    const mn_ranks_t* GetMasternodeRanksCached(const uint256& nBlockHash, const int nMinProtocol);
+    // invalidate masternode ranks cache, should be called when MN list or MN protocol version is changed
+    void InvalidateRanksCache() noexcept { mapRanksCache.clear(); }
 
 public:
     // Keep track of all broadcasts I've seen
@@ -116,6 +145,8 @@ public:
         
         if(bRead && (strVersion != SERIALIZATION_VERSION_STRING))
             Clear();
+        if (bRead)
+            InvalidateRanksCache();
     }
 
     CMasternodeMan();
@@ -26,10 +26,19 @@ void CACNotificationInterface::NotifyHeaderTip(const CBlockIndex *pindexNew, boo
     masterNodeCtrl.masternodeSync.NotifyHeaderTip(pindexNew, fInitialDownload);
 }
 
+void CACNotificationInterface::ChainTip(const CBlockIndex *pindex, const CBlock *pblock, SaplingMerkleTree saplingTree, bool added)
+{
+    if (added)
+    {
+        if (pblock)
+            masterNodeCtrl.masternodeTickets.ConnectedBlock(pindex, *pblock);
+    } else
+        masterNodeCtrl.masternodeTickets.DisconnectedBlock(pindex, pblock);
+}
+
 void CACNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, bool fInitialDownload)
 {
     masterNodeCtrl.masternodeSync.UpdatedBlockTip(pindexNew, fInitialDownload);
-	masterNodeCtrl.masternodeTickets.UpdatedBlockTip(pindexNew, fInitialDownload);
 	
 	if (fInitialDownload)
 		return;
@@ -16,9 +16,9 @@ UniValue tickets_list(const UniValue& params)
     RPC_CMD_PARSER2(LIST, params, id, nft, nft__collection, nft__collection__act, act, 
         sell, offer, buy, accept, trade, transfer,
         down, royalty, username, ethereumaddress, action, action__act);
-    if ((params.size() < 2 || params.size() > 4) || !LIST.IsCmdSupported())
+    if ((params.size() < 2 || params.size() > 7) || !LIST.IsCmdSupported())
         throw JSONRPCError(RPC_INVALID_PARAMETER,
-R"(tickets list "type" ("filter") ("minheight")
+R"(tickets list "type" ("filter") ("minheight") ("limit") ("offset")
 List all tickets of the specific type registered in the system
 
 Available types:
@@ -87,10 +87,19 @@ action-act - List action activation tickets. Without filter parameter lists ALL
 
 Arguments:
 1. minheight	 - (optional) minimum height for returned tickets (only tickets registered after this height will be returned).
+2. limit	 - (optional) maximum number of tickets to return, 0 - no limit. Default: 0.
+3. offset	 - (optional) number of matching tickets to skip, tickets are ordered by block height. Default: 0.
+               For offer, accept and transfer tickets limit and offset follow the optional <pastelID> and minheight parameters.
 
 Example: List ALL Pastel ID tickets:
 )" + HelpExampleCli("tickets list id", "") +
 R"(
+Example: List second page of 100 active NFT tickets:
+)" + HelpExampleCli("tickets list nft active 0 100 100", "") +
+R"(
+Example: List first 10 available Offer tickets of the Pastel ID registered after block 1000:
+)" + HelpExampleCli("tickets list offer available jXYqZNPj21RVnwxnEJ654wEdzi7GZTZ5LAdiotBmPrF7pDMkpX1JegDMQZX55WZLkvy9fxNpZcbBJuE8QYUqBF 1000 10 0", "") +
+R"(
 As json rpc
 )" + HelpExampleRpc("tickets", R"("list", "id")"));
 
@@ -111,60 +120,83 @@ As json rpc
     if (params.size() > 3 && !bSpecialParsingLogic)
         minheight = get_number(params[3]);
 
+    // parse optional limit & offset parameters starting at position nLimitParam
+    tickets_list_page_t page;
+    const auto parsePageParams = [&](const size_t nLimitParam)
+    {
+        if (params.size() > nLimitParam)
+        {
+            const auto nLimit = get_long_number(params[nLimitParam]);
+            if (nLimit < 0)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit parameter, should be a non-negative number");
+            page.nLimit = static_cast<size_t>(nLimit);
+        }
+        if (params.size() > nLimitParam + 1)
+        {
+            const auto nOffset = get_long_number(params[nLimitParam + 1]);
+            if (nOffset < 0)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid offset parameter, should be a non-negative number");
+            page.nOffset = static_cast<size_t>(nOffset);
+        }
+    };
+    if (!bSpecialParsingLogic)
+        parsePageParams(4);
+
     UniValue obj(UniValue::VARR);
     switch (LIST.cmd())
     {
     case RPC_CMD_LIST::id: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CPastelIDRegTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CPastelIDRegTicket>(minheight, page);
         else if (filter == "mn")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 1));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 1, nullptr, page);
         else if (filter == "personal")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 2));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 2, nullptr, page);
         else if (filter == "mine") {
             const auto mapIDs = CPastelID::GetStoredPastelIDs(true);
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 3, &mapIDs));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterPastelIDTickets(minheight, 3, &mapIDs, page);
         }
     } break;
 
     case RPC_CMD_LIST::nft: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CNFTRegTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CNFTRegTicket>(minheight, page);
         else if (filter == "active")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 1));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 1, page);
         else if (filter == "inactive")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 2));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 2, page);
         else if ((filter == "transferred") || (filter == "sold"))
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 3));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterNFTTickets(minheight, 3, page);
     } break;
 
     case RPC_CMD_LIST::act: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CNFTActivateTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CNFTActivateTicket>(minheight, page);
         else if (filter == "available")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterActTickets(minheight, 1));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterActTickets(minheight, 1, page);
         else if ((filter == "transferred") || (filter == "sold"))
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterActTickets(minheight, 2));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterActTickets(minheight, 2, page);
     } break;
 
     case RPC_CMD_LIST::nft__collection: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CNFTCollectionRegTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CNFTCollectionRegTicket>(minheight, page);
         else if (filter == "active")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterNFTCollectionTickets(1));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterNFTCollectionTickets(minheight, 1, page);
         else if (filter == "inactive")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterNFTCollectionTickets(2));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterNFTCollectionTickets(minheight, 2, page);
     } break;
 
     case RPC_CMD_LIST::nft__collection__act: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CNFTCollectionActivateTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CNFTCollectionActivateTicket>(minheight, page);
     } break;
 
     case RPC_CMD_LIST::sell:
     case RPC_CMD_LIST::offer:
     {
         string pastelID;
+        size_t nLimitParam = 4;
 
         if (params.size() > 2 && 
             params[2].get_str() != "all" && 
@@ -178,6 +210,7 @@ As json rpc
                 minheight = get_number(params[2]); // This means min_height is input.
             else
                 pastelID = params[2].get_str();    // This means pastel ID is input
+            nLimitParam = 3;
         } else if (params.size() > 2) {
             filter = params[2].get_str();
             if (params.size() > 3)
@@ -185,30 +218,35 @@ As json rpc
                 if (params[3].get_str().find_first_not_of("0123456789") == string::npos)
                     minheight = get_number(params[3]); // This means min_height is input.
                 else
+                {
                     pastelID = params[3].get_str(); // This means pastelID is input
-            }
-            if (params.size() > 4)
-            {
-                pastelID = params[3].get_str();
-                minheight = get_number(params[4]);
+                    // minheight follows pastelID
+                    if (params.size() > 4)
+                    {
+                        minheight = get_number(params[4]);
+                        ++nLimitParam;
+                    }
+                }
             }
         }
+        parsePageParams(nLimitParam);
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 0, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 0, pastelID, page);
         else if (filter == "available")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 1, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 1, pastelID, page);
         else if (filter == "unavailable")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 2, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 2, pastelID, page);
         else if (filter == "expired")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 3, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 3, pastelID, page);
         else if ((filter == "transferred") || (filter == "sold"))
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 4, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterOfferTickets(minheight, 4, pastelID, page);
     } break;
 
     case RPC_CMD_LIST::buy:
     case RPC_CMD_LIST::accept:
     {
         string pastelID;
+        size_t nLimitParam = 4;
 
         if (params.size() > 2 && 
             params[2].get_str() != "all" && 
@@ -220,32 +258,39 @@ As json rpc
                 minheight = get_number(params[2]); // This means min_height is input.
             else
                 pastelID = params[2].get_str(); // This means pastelID is input
+            nLimitParam = 3;
         } else if (params.size() > 2) {
             filter = params[2].get_str();
-            if (params.size() > 3) {
+            if (params.size() > 3)
+            {
                 if (params[3].get_str().find_first_not_of("0123456789") == string::npos)
                     minheight = get_number(params[3]); // This means min_height is input.
                 else
+                {
                     pastelID = params[3].get_str(); // This means pastelID is input
-            }
-            if (params.size() > 4)
-            {
-                pastelID = params[3].get_str();
-                minheight = get_number(params[4]);
+                    // minheight follows pastelID
+                    if (params.size() > 4)
+                    {
+                        minheight = get_number(params[4]);
+                        ++nLimitParam;
+                    }
+                }
             }
         }
+        parsePageParams(nLimitParam);
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 0, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 0, pastelID, page);
         else if (filter == "expired")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 1, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 1, pastelID, page);
         else if ((filter == "transferred") || (filter == "sold"))
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 2, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterAcceptTickets(minheight, 2, pastelID, page);
     } break;
 
     case RPC_CMD_LIST::trade:
     case RPC_CMD_LIST::transfer:
     {
         string pastelID;
+        size_t nLimitParam = 4;
 
         if (params.size() > 2 && 
             params[2].get_str() != "all" && 
@@ -257,6 +302,7 @@ As json rpc
                 minheight = get_number(params[2]); // This means min_height is input.
             else
                 pastelID = params[2].get_str(); // This means pastelID is input
+            nLimitParam = 3;
         } else if (params.size() > 2) {
             filter = params[2].get_str();
             if (params.size() > 3)
@@ -264,50 +310,55 @@ As json rpc
                 if (params[3].get_str().find_first_not_of("0123456789") == string::npos)
                     minheight = get_number(params[3]); // This means min_height is input.
                 else
+                {
                     pastelID = params[3].get_str(); // This means pastelID is input
-            }
-            if (params.size() > 4) {
-                pastelID = params[3].get_str();
-                minheight = get_number(params[4]);
+                    // minheight follows pastelID
+                    if (params.size() > 4)
+                    {
+                        minheight = get_number(params[4]);
+                        ++nLimitParam;
+                    }
+                }
             }
         }
+        parsePageParams(nLimitParam);
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 0, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 0, pastelID, page);
         else if (filter == "available")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 1, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 1, pastelID, page);
         else if ((filter == "transferred") || (filter == "sold"))
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 2, pastelID));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterTransferTickets(minheight, 2, pastelID, page);
     } break;
 
     case RPC_CMD_LIST::royalty: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CNFTRoyaltyTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CNFTRoyaltyTicket>(minheight, page);
     } break;
 
     case RPC_CMD_LIST::username: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CChangeUsernameTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CChangeUsernameTicket>(minheight, page);
     } break;
 
     case RPC_CMD_LIST::ethereumaddress: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CChangeEthereumAddressTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CChangeEthereumAddressTicket>(minheight, page);
     } break;
 
     case RPC_CMD_LIST::action: {
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CActionRegTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CActionRegTicket>(minheight, page);
         else if (filter == "active")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 1));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 1, page);
         else if (filter == "inactive")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 2));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 2, page);
         else if (filter == "transferred")
-            obj.read(masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 3));
+            obj = masterNodeCtrl.masternodeTickets.ListFilterActionTickets(minheight, 3, page);
     } break;
 
     case RPC_CMD_LIST::action__act:
         if (filter == "all")
-            obj.read(masterNodeCtrl.masternodeTickets.ListTickets<CActionActivateTicket>(minheight));
+            obj = masterNodeCtrl.masternodeTickets.ListTickets<CActionActivateTicket>(minheight, page);
         break;
 
     default:
@@ -0,0 +1,145 @@
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <mnode/ticket-cache.h>
+#include <memusage.h>
+
+using namespace std;
+
+CTicketCache::CTicketCache() noexcept :
+    m_nUsage(0),
+    m_nMaxSize(DEFAULT_MAX_TICKET_CACHE_SIZE << 20),
+    m_nHits(0),
+    m_nMisses(0),
+    m_nEvictions(0),
+    m_nGeneration(0)
+{}
+
+/**
+ * Approximate memory usage of the cache entry: list node, map node and ticket data.
+ */
+size_t CTicketCache::EntryUsage(const ticket_cache_entry_t& entry) noexcept
+{
+    return memusage::MallocUsage(sizeof(ticket_cache_entry_t) + 2 * sizeof(void*)) +
+           memusage::MallocUsage(sizeof(pair<const uint256, lru_list_t::iterator>) + sizeof(void*)) +
+           memusage::MallocUsage(entry.vData.capacity());
+}
+
+void CTicketCache::erase(lru_list_t::iterator it)
+{
+    m_nUsage -= EntryUsage(*it);
+    m_mapTicket.erase(it->txid);
+    m_lruList.erase(it);
+}
+
+/**
+ * Set max memory usage of the cache, evict least recently used entries if needed.
+ * 
+ * \param nMaxSize - max memory usage in bytes, 0 - disable cache
+ */
+void CTicketCache::SetMaxSize(const size_t nMaxSize)
+{
+    LOCK(cs_ticketCache);
+    m_nMaxSize = nMaxSize;
+    while (!m_lruList.empty() && m_nUsage > m_nMaxSize)
+    {
+        erase(prev(m_lruList.end()));
+        ++m_nEvictions;
+    }
+}
+
+/**
+ * Get cached ticket data by txid.
+ * 
+ * \param txid - ticket transaction id
+ * \param ticketId - returns ticket type
+ * \param nHeight - returns ticket block height
+ * \param vData - returns copy of the uncompressed ticket data
+ * \return true if ticket was found in the cache
+ */
+bool CTicketCache::Get(const uint256& txid, TicketID& ticketId, uint32_t& nHeight, CSerializeData& vData)
+{
+    LOCK(cs_ticketCache);
+    const auto it = m_mapTicket.find(txid);
+    if (it == m_mapTicket.cend())
+    {
+        ++m_nMisses;
+        return false;
+    }
+    // move to the front of LRU list
+    m_lruList.splice(m_lruList.begin(), m_lruList, it->second);
+    const auto& entry = *it->second;
+    ticketId = entry.ticketId;
+    nHeight = entry.nHeight;
+    vData = entry.vData;
+    ++m_nHits;
+    return true;
+}
+
+uint64_t CTicketCache::GetGeneration() const noexcept
+{
+    return m_nGeneration.load();
+}
+
+/**
+ * Add ticket data to the cache.
+ * Evicts least recently used entries if cache memory usage exceeds the limit.
+ * Ticket data read before the last cache invalidation is not added - it can be
+ * from the block that was disconnected after the data was read.
+ * 
+ * \param nGeneration - cache generation captured before ticket data was read
+ */
+void CTicketCache::Put(const uint256& txid, const TicketID ticketId, const uint32_t nHeight, CSerializeData&& vData,
+    const uint64_t nGeneration)
+{
+    LOCK(cs_ticketCache);
+    if (!m_nMaxSize || (nGeneration != m_nGeneration))
+        return;
+    const auto it = m_mapTicket.find(txid);
+    if (it != m_mapTicket.cend())
+        erase(it->second);
+    m_lruList.push_front({txid, ticketId, nHeight, move(vData)});
+    m_mapTicket.emplace(txid, m_lruList.begin());
+    m_nUsage += EntryUsage(m_lruList.front());
+    while (m_nUsage > m_nMaxSize && !m_lruList.empty())
+    {
+        erase(prev(m_lruList.end()));
+        ++m_nEvictions;
+    }
+}
+
+/**
+ * Remove all cached tickets registered above the given height.
+ * Called when blocks are disconnected from the active chain.
+ * 
+ * \param nHeight - fork height
+ */
+void CTicketCache::EraseAboveHeight(const uint32_t nHeight)
+{
+    LOCK(cs_ticketCache);
+    ++m_nGeneration;
+    for (auto it = m_lruList.begin(); it != m_lruList.end();)
+    {
+        if (it->nHeight > nHeight)
+        {
+            auto itErase = it++;
+            erase(itErase);
+        } else
+            ++it;
+    }
+}
+
+void CTicketCache::Clear()
+{
+    LOCK(cs_ticketCache);
+    ++m_nGeneration;
+    m_mapTicket.clear();
+    m_lruList.clear();
+    m_nUsage = 0;
+}
+
+CTicketCache::ticket_cache_stats_t CTicketCache::GetStats() const
+{
+    LOCK(cs_ticketCache);
+    return { m_nHits, m_nMisses, m_nEvictions, m_lruList.size(), m_nUsage, m_nMaxSize };
+}
@@ -0,0 +1,79 @@
+#pragma once
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+#include <uint256.h>
+#include <streams.h>
+#include <sync.h>
+#include <mnode/tickets/ticket-types.h>
+
+// default max size of the decoded tickets cache in MiB
+constexpr size_t DEFAULT_MAX_TICKET_CACHE_SIZE = 32;
+
+/**
+ * Bounded LRU cache of the decoded (uncompressed) ticket data keyed by ticket txid.
+ * Caches only tickets from the active chain (with known block height).
+ * Used by CPastelTicketProcessor::GetTicket to skip txindex lookup, block file read,
+ * P2FMS parsing and zstd decompression for the tickets requested over and over again.
+ */
+class CTicketCache
+{
+public:
+    typedef struct _ticket_cache_stats_t
+    {
+        uint64_t nHits;
+        uint64_t nMisses;
+        uint64_t nEvictions;
+        size_t nEntries;
+        size_t nUsage;
+        size_t nMaxSize;
+    } ticket_cache_stats_t;
+
+    CTicketCache() noexcept;
+
+    // set max memory usage of the cache in bytes
+    void SetMaxSize(const size_t nMaxSize);
+    // get ticket data by txid, moves the entry to the front of the LRU list
+    bool Get(const uint256& txid, TicketID& ticketId, uint32_t& nHeight, CSerializeData& vData);
+    // get current cache generation, should be captured before reading ticket data to Put
+    uint64_t GetGeneration() const noexcept;
+    // add ticket data to the cache, ignored if the cache was invalidated after nGeneration was captured
+    void Put(const uint256& txid, const TicketID ticketId, const uint32_t nHeight, CSerializeData&& vData,
+        const uint64_t nGeneration);
+    // remove tickets registered above the given height (used on chain reorg)
+    void EraseAboveHeight(const uint32_t nHeight);
+    void Clear();
+
+    ticket_cache_stats_t GetStats() const;
+
+protected:
+    typedef struct _ticket_cache_entry_t
+    {
+        uint256 txid;
+        TicketID ticketId;
+        uint32_t nHeight;
+        CSerializeData vData; // uncompressed ticket data
+    } ticket_cache_entry_t;
+
+    using lru_list_t = std::list<ticket_cache_entry_t>;
+
+    mutable CCriticalSection cs_ticketCache;
+    // LRU list, most recently used entries are at the front
+    lru_list_t m_lruList;
+    // txid -> LRU list entry
+    std::unordered_map<uint256, lru_list_t::iterator> m_mapTicket;
+    size_t m_nUsage;
+    size_t m_nMaxSize;
+    uint64_t m_nHits;
+    uint64_t m_nMisses;
+    uint64_t m_nEvictions;
+    // incremented on each invalidation (EraseAboveHeight, Clear)
+    std::atomic_uint64_t m_nGeneration;
+
+    static size_t EntryUsage(const ticket_cache_entry_t& entry) noexcept;
+    void erase(lru_list_t::iterator it);
+};
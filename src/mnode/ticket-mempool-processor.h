@@ -5,7 +5,12 @@
 
 #include <txmempool.h>
 #include <mnode/ticket-processor.h>
+#include <mnode/ticket-txmempool.h>
 
+/**
+ * Search for Pastel tickets of one type in the local memory pool.
+ * Uses parsed ticket key indexes maintained by CTicketTxMemPoolTracker.
+ */
 class CPastelTicketMemPoolProcessor
 {
 public:
@@ -23,54 +28,47 @@ public:
     template <typename _TicketType>
     bool FindTicket(_TicketType& ticket) const noexcept
     {
-        const auto sKey = ticket.KeyOne();
-        bool bRet = false;
-        for (const auto& tkt : m_vTicket)
-        {
-            if (sKey == tkt->KeyOne())
-            {
-                ticket = *dynamic_cast<_TicketType*>(tkt.get());
-                bRet = true;
-                break;
-            }
-        }
-        return bRet;
+        return FindTicketByKey(TICKET_KEY_TYPE::KEY_ONE, ticket.KeyOne(), ticket);
     }
 
     /**
      * Find Pastel ticket by secondary key.
-     * Uses ticket.KeyOne() as a search key.
+     * Uses ticket.KeyTwo() as a search key.
      * 
      * \param ticket - returns ticket if found
-     * \return - true if ticket was found by primary key
+     * \return - true if ticket was found by secondary key
      */
     template <typename _TicketType>
     bool FindTicketBySecondaryKey(_TicketType& ticket) const noexcept
     {
         if (!ticket.HasKeyTwo())
             return false;
-        const std::string sKeyTwo = ticket.KeyTwo();
-        bool bRet = false;
-        for (const auto& tkt : m_vTicket)
-        {
-            if (sKeyTwo == tkt->KeyTwo())
-            {
-                ticket = *dynamic_cast<_TicketType*>(tkt.get());
-                bRet = true;
-                break;
-            }
-        }
-        return bRet;
+        return FindTicketByKey(TICKET_KEY_TYPE::KEY_TWO, ticket.KeyTwo(), ticket);
     }
     // check if ticket exists by primary key
     bool TicketExists(const std::string& sKeyOne) const noexcept;
     // check if ticket exists by secondary key
     bool TicketExistsBySecondaryKey(const std::string& sKeyTwo) const noexcept;
     // list tickets by primary key (and optional secondary key)
-    bool ListTickets(PastelTickets_t& vTicket, const std::string& sKeyOne, const std::string *psKeyTwo = nullptr) const noexcept;
+    bool ListTickets(mempool_tickets_t& vTicket, const std::string& sKeyOne, const std::string *psKeyTwo = nullptr) const noexcept;
 
 protected: 
     TicketID m_TicketID; 
-    // tickets in mempool with m_TicketID
-    PastelTickets_t m_vTicket;
+    // mempool tracker with parsed ticket indexes
+    std::shared_ptr<CTicketTxMemPoolTracker> m_pTracker;
+
+    template <typename _TicketType>
+    bool FindTicketByKey(const TICKET_KEY_TYPE keyType, const std::string& sKey, _TicketType& ticket) const noexcept
+    {
+        if (!m_pTracker)
+            return false;
+        const auto pTicket = m_pTracker->findTicket(m_TicketID, keyType, sKey);
+        if (!pTicket)
+            return false;
+        const auto pFoundTicket = dynamic_cast<const _TicketType*>(pTicket.get());
+        if (!pFoundTicket)
+            return false;
+        ticket = *pFoundTicket;
+        return true;
+    }
 };
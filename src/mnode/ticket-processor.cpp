@@ -20,11 +20,75 @@
 #include <mnode/mnode-controller.h>
 #include <mnode/ticket-processor.h>
 #include <mnode/ticket-txmempool.h>
+#include <script_check.h>
+#include <validationinterface.h>
 
 using json = nlohmann::json;
 using namespace std;
 
 static shared_ptr<ITxMemPoolTracker> TicketTxMemPoolTracker;
+// LRU cache of the decoded tickets by txid
+static CTicketCache TicketCache;
+
+// prefix of the block height index keys in ticket DB
+constexpr auto TICKET_HEIGHT_INDEX_PREFIX = "@H@";
+// marker key - block height index was built for the ticket DB
+constexpr auto TICKET_HEIGHT_INDEX_MARKER = "@V@heightidx";
+// max number of records to write in one batch while building ticket DB indexes (height, MV key)
+constexpr size_t TICKET_INDEX_BUILD_BATCH_SIZE = 10'000;
+// marker key - MV keys are stored as separate "@M@<mvkey>\0<height><txid>" rows
+constexpr auto TICKET_MVKEY_INDEX_MARKER = "@V@mvkeyidx";
+
+/**
+ * Closure to parse one ticket transaction of the connected block.
+ * Extracts P2FMS data, uncompresses and deserializes the ticket.
+ * Stores references to the block transaction and to the result ticket.
+ */
+class CTicketParseCheck
+{
+public:
+    CTicketParseCheck() = default;
+    CTicketParseCheck(const CTransaction* ptx, unique_ptr<CPastelTicket>* pTicket) :
+        m_ptx(ptx),
+        m_pTicket(pTicket)
+    {}
+
+    // not a ticket or invalid ticket does not fail the whole batch
+    bool operator()()
+    {
+        if (!m_ptx || !m_pTicket)
+            return true;
+        CCompressedDataStream data_stream(SER_NETWORK, DATASTREAM_VERSION);
+        TicketID ticket_id;
+        string error;
+        const CMutableTransaction mtx(*m_ptx);
+        if (!CPastelTicketProcessor::preParseTicket(mtx, data_stream, ticket_id, error, false))
+            return true;
+        try
+        {
+            auto ticket = CPastelTicketProcessor::CreateTicket(ticket_id);
+            if (!ticket)
+                error = strprintf("unknown ticket type %hhu", to_integral_type<TicketID>(ticket_id));
+            else
+            {
+                data_stream >> *ticket;
+                *m_pTicket = move(ticket);
+                return true;
+            }
+        } catch (const exception& ex) {
+            error = strprintf("Failed to parse and unpack ticket - %s", ex.what());
+        } catch (...) {
+            error = "Failed to parse and unpack ticket - Unknown exception";
+        }
+        LogPrintf("ERROR: invalid ticket ['%s', txid=%s]. %s\n", 
+            GetTicketDescription(ticket_id), m_ptx->GetHash().GetHex(), error);
+        return true;
+    }
+
+private:
+    const CTransaction* m_ptx = nullptr;
+    unique_ptr<CPastelTicket>* m_pTicket = nullptr;
+};
 
 /**
  * Get height of the active blockchain + 1.
@@ -49,10 +113,158 @@ void CPastelTicketProcessor::InitTicketDB()
     nTotalCache = max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbCache
     const uint64_t nTicketDBCache = nTotalCache / 8 / uint8_t(TicketID::COUNT);
+    TicketCache.SetMaxSize(static_cast<size_t>(max<int64_t>(GetArg("-maxticketcachesize", DEFAULT_MAX_TICKET_CACHE_SIZE), 0)) << 20);
 
     // create DB for each ticket type
     for (uint8_t id = to_integral_type<TicketID>(TicketID::PastelID); id != to_integral_type<TicketID>(TicketID::COUNT); ++id)
-        dbs.emplace(static_cast<TicketID>(id), make_unique<CDBWrapper>(ticketsDir / TICKET_INFO[id].szDBSubFolder, nTicketDBCache, false, fReindex));
+    {
+        const auto ticketId = static_cast<TicketID>(id);
+        auto itDB = dbs.emplace(ticketId, make_unique<CDBWrapper>(ticketsDir / TICKET_INFO[id].szDBSubFolder, nTicketDBCache, false, fReindex)).first;
+        // block height index is maintained by UpdateDB, build it once for the ticket DBs created by older versions
+        if (!itDB->second->Exists(string(TICKET_HEIGHT_INDEX_MARKER)))
+            BuildHeightIndex(ticketId);
+        if (!itDB->second->Exists(string(TICKET_MVKEY_INDEX_MARKER)))
+            BuildMVKeyIndex(ticketId);
+    }
+}
+
+/**
+ * Get block height index key for the ticket.
+ * Height is zero-padded and txid has fixed length, so all index keys have the same size
+ * and are ordered by height in the ticket DB.
+ * 
+ * \param nHeight - ticket block height
+ * \param txid - ticket transaction id
+ * \return height index key "@H@<height><txid>"
+ */
+string CPastelTicketProcessor::RealHeightKey(const uint32_t nHeight, const string& txid) noexcept
+{
+    return strprintf("%s%010u%s", TICKET_HEIGHT_INDEX_PREFIX, nHeight, txid);
+}
+
+/**
+ * Get MV key row for the ticket.
+ * Txid has fixed length and height is zero-padded, so all rows for the given MV key
+ * have the same size and are stored contiguously in the ticket DB ordered by height.
+ * 
+ * \param key - MV key
+ * \param nHeight - ticket block height
+ * \param txid - ticket transaction id
+ * \return MV key row "@M@<key>\0<height><txid>"
+ */
+string CPastelTicketProcessor::RealMVKeyRow(const string& key, const uint32_t nHeight, const string& txid) noexcept
+{
+    string sRow = RealMVKey(key);
+    sRow += '\0';
+    sRow += strprintf("%010u", nHeight);
+    sRow += txid;
+    return sRow;
+}
+
+/**
+ * Build block height index for the existing ticket DB.
+ * 
+ * \param id - ticket type
+ */
+void CPastelTicketProcessor::BuildHeightIndex(const TicketID id)
+{
+    const auto itDB = dbs.find(id);
+    if (itDB == dbs.cend())
+        return;
+    auto &db = *itDB->second;
+    const bool bEmptyDB = db.IsEmpty();
+    if (!bEmptyDB)
+        LogFnPrintf("Building block height index for '%s' tickets...", GetTicketDescription(id));
+    size_t nIndexed = 0;
+    if (!bEmptyDB)
+    {
+        CDBBatch batch(db);
+        size_t nBatchSize = 0;
+        unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        pcursor->SeekToFirst();
+        string sKey;
+        for (; pcursor->Valid(); pcursor->Next())
+        {
+            sKey.clear();
+            if (!pcursor->GetKey(sKey) || sKey.empty() || sKey.front() == '@')
+                continue;
+            auto ticket = CreateTicket(id);
+            if (!ticket || !pcursor->GetValue(*ticket))
+                continue;
+            batch.Write(RealHeightKey(ticket->GetBlock(), ticket->GetTxId()), sKey);
+            ++nIndexed;
+            if (++nBatchSize >= TICKET_INDEX_BUILD_BATCH_SIZE)
+            {
+                db.WriteBatch(batch);
+                batch.Clear();
+                nBatchSize = 0;
+            }
+        }
+        db.WriteBatch(batch);
+    }
+    db.Write(string(TICKET_HEIGHT_INDEX_MARKER), true, true);
+    if (!bEmptyDB)
+        LogFnPrintf("Block height index for '%s' tickets created (%zu tickets)", GetTicketDescription(id), nIndexed);
+}
+
+/**
+ * Convert MV keys of the existing ticket DB.
+ * Older versions stored MV keys as "@M@<mvkey>" -> vector of primary keys,
+ * these records are replaced with one "@M@<mvkey>\0<height><txid>" -> primary key row per ticket.
+ * 
+ * \param id - ticket type
+ */
+void CPastelTicketProcessor::BuildMVKeyIndex(const TicketID id)
+{
+    const auto itDB = dbs.find(id);
+    if (itDB == dbs.cend())
+        return;
+    auto &db = *itDB->second;
+    const bool bEmptyDB = db.IsEmpty();
+    if (!bEmptyDB)
+        LogFnPrintf("Converting MV keys for '%s' tickets...", GetTicketDescription(id));
+    size_t nConverted = 0;
+    if (!bEmptyDB)
+    {
+        const string sMVKeyPrefix = RealMVKey("");
+        CDBBatch batch(db);
+        size_t nBatchSize = 0;
+        // iterator uses implicit DB snapshot, batch writes are not visible to it
+        unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        pcursor->SeekToFirst();
+        string sKey;
+        for (; pcursor->Valid(); pcursor->Next())
+        {
+            sKey.clear();
+            if (!pcursor->GetKey(sKey) || sKey.empty())
+                continue;
+            if (sKey.front() == '@')
+            {
+                // erase old-style MV key record (MV key rows have '\0' separator)
+                if ((sKey.compare(0, sMVKeyPrefix.size(), sMVKeyPrefix) == 0) && (sKey.find('\0') == string::npos))
+                {
+                    batch.Erase(sKey);
+                    ++nBatchSize;
+                }
+                continue;
+            }
+            auto ticket = CreateTicket(id);
+            if (!ticket || !pcursor->GetValue(*ticket))
+                continue;
+            UpdateDB_MVK(batch, *ticket);
+            ++nConverted;
+            if (++nBatchSize >= TICKET_INDEX_BUILD_BATCH_SIZE)
+            {
+                db.WriteBatch(batch);
+                batch.Clear();
+                nBatchSize = 0;
+            }
+        }
+        db.WriteBatch(batch);
+    }
+    db.Write(string(TICKET_MVKEY_INDEX_MARKER), true, true);
+    if (!bEmptyDB)
+        LogFnPrintf("MV keys for '%s' tickets converted (%zu tickets)", GetTicketDescription(id), nConverted);
 }
 
 /**
@@ -127,38 +339,161 @@ unique_ptr<CPastelTicket> CPastelTicketProcessor::CreateTicket(const TicketID ti
     return ticket;
 }
 
-void CPastelTicketProcessor::UpdatedBlockTip(const CBlockIndex* cBlockIndex, bool fInitialDownload)
+/**
+ * Parse tickets of the block.
+ * Tickets are parsed in parallel on the shared validation check queue.
+ * 
+ * \param block - block to parse tickets of
+ * \param vTickets - returns parsed tickets, indexed by the block transaction index (nullptr for non-ticket txs)
+ */
+static void ParseBlockTickets(const CBlock& block, vector<unique_ptr<CPastelTicket>> &vTickets)
+{
+    vTickets.clear();
+    vTickets.resize(block.vtx.size());
+    vector<CTicketParseCheck> vChecks;
+    vChecks.reserve(block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i)
+    {
+        if (block.vtx[i].IsCoinBase())
+            continue;
+        vChecks.emplace_back(&block.vtx[i], &vTickets[i]);
+    }
+    gl_ScriptCheckManager.RunChecks(vChecks);
+}
+
+/**
+ * Send ticket notifications to the validation interface listeners (ZMQ, AMQP).
+ * 
+ * \param block - block with the tickets
+ * \param vTickets - parsed block tickets, indexed by the block transaction index
+ * \param nHeight - block height
+ * \param bConnected - true if block was connected, false - disconnected
+ */
+static void NotifyBlockTickets(const CBlock& block, const vector<unique_ptr<CPastelTicket>> &vTickets, 
+    const uint32_t nHeight, const bool bConnected)
 {
-    if (!cBlockIndex)
+    auto &signals = GetMainSignals();
+    if (signals.TicketNotification.empty())
         return;
-
-    CBlock block;
-    if (!ReadBlockFromDisk(block, cBlockIndex, Params().GetConsensus()))
+    for (size_t i = 0; i < vTickets.size(); ++i)
     {
-        LogFnPrintf("ERROR: Can't read block from disk");
-        return;
+        const auto& ticket = vTickets[i];
+        if (!ticket)
+            continue;
+        ticket_notification_t notification;
+        notification.nTicketID = to_integral_type<TicketID>(ticket->ID());
+        notification.txid = block.vtx[i].GetHash();
+        notification.nBlockHeight = nHeight;
+        notification.bConnected = bConnected;
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << *ticket;
+        notification.vTicketData.assign(ss.begin(), ss.end());
+        signals.TicketNotification(notification);
     }
+}
 
-    for (const auto& tx : block.vtx)
+/**
+ * Block was connected to the active chain.
+ * Uses connected block directly (no need to re-read it from disk).
+ * Tickets are parsed in parallel by the ticket parse workers, 
+ * then added to the ticket DBs in the block order - one DB batch per ticket type.
+ * 
+ * \param pindex - connected block index
+ * \param block - connected block
+ */
+void CPastelTicketProcessor::ConnectedBlock(const CBlockIndex* pindex, const CBlock& block)
+{
+    if (!pindex)
+        return;
+    const auto nHeight = static_cast<uint32_t>(pindex->nHeight);
+    vector<unique_ptr<CPastelTicket>> vTickets;
+    ParseBlockTickets(block, vTickets);
+    // coalesce DB writes: one batch per ticket DB
+    map<TicketID, CDBBatch> mapBatches;
+    // tickets written to the batches, not yet visible in the DBs
+    map<TicketID, pending_tickets_t> mapPending;
+    for (size_t i = 0; i < vTickets.size(); ++i)
     {
-        CMutableTransaction mtx(tx);
-        ParseTicketAndUpdateDB(mtx, cBlockIndex->nHeight);
+        auto& ticket = vTickets[i];
+        if (!ticket)
+            continue;
+        const auto itDB = dbs.find(ticket->ID());
+        if (itDB == dbs.cend())
+        {
+            ticket.reset();
+            continue;
+        }
+        ticket->SetTxId(block.vtx[i].GetHash().GetHex());
+        ticket->SetBlock(nHeight);
+        LogPrintf("ConnectedBlock -- Processing ticket ['%s', txid=%s, nBlockHeight=%u]\n", 
+            GetTicketDescription(ticket->ID()), ticket->GetTxId(), nHeight);
+        auto itBatch = mapBatches.try_emplace(ticket->ID(), *itDB->second).first;
+        UpdateDBBatch(itBatch->second, *ticket, &mapPending[ticket->ID()]);
     }
+    for (auto& [id, batch] : mapBatches)
+        dbs[id]->WriteBatch(batch, true);
+    NotifyBlockTickets(block, vTickets, nHeight, true);
 }
 
-void CPastelTicketProcessor::UpdateDB_MVK(const CPastelTicket& ticket, const string& mvKey)
+/**
+ * Block was disconnected from the active chain.
+ * Tickets from the disconnected block are removed from the decoded tickets cache
+ * and the listeners are notified about the disconnected tickets.
+ * 
+ * \param pindex - disconnected block index
+ * \param pblock - disconnected block
+ */
+void CPastelTicketProcessor::DisconnectedBlock(const CBlockIndex* pindex, const CBlock* pblock)
 {
-    v_strings mainKeys;
-    const auto realMVKey = RealMVKey(mvKey);
-    auto itDB = dbs.find(ticket.ID());
-    if (itDB == dbs.end())
+    if (!pindex)
         return;
-    itDB->second->Read(realMVKey, mainKeys);
-    if (find(mainKeys.cbegin(), mainKeys.cend(), ticket.KeyOne()) == mainKeys.cend())
+    const auto nHeight = static_cast<uint32_t>(pindex->nHeight);
+    TicketCache.EraseAboveHeight(nHeight > 0 ? nHeight - 1 : 0);
+    if (!pblock || GetMainSignals().TicketNotification.empty())
+        return;
+    vector<unique_ptr<CPastelTicket>> vTickets;
+    ParseBlockTickets(*pblock, vTickets);
+    for (size_t i = 0; i < vTickets.size(); ++i)
     {
-        mainKeys.emplace_back(ticket.KeyOne());
-        itDB->second->Write(realMVKey, mainKeys, true);
+        auto& ticket = vTickets[i];
+        if (!ticket)
+            continue;
+        // only tickets stored in the ticket DBs on block connect are reported
+        if (dbs.find(ticket->ID()) == dbs.cend())
+        {
+            ticket.reset();
+            continue;
+        }
+        ticket->SetTxId(pblock->vtx[i].GetHash().GetHex());
+        ticket->SetBlock(nHeight);
     }
+    NotifyBlockTickets(*pblock, vTickets, nHeight, false);
+}
+
+/**
+ * Add (or erase) MV key rows of the ticket to the DB batch.
+ * 
+ * \param batch - DB batch to add MV key rows to
+ * \param ticket - ticket to process MV keys for
+ * \param bErase - if true - erase ticket's MV key rows
+ */
+void CPastelTicketProcessor::UpdateDB_MVK(CDBBatch& batch, const CPastelTicket& ticket, const bool bErase) const
+{
+    const auto sKeyOne = ticket.KeyOne();
+    const auto fnUpdateRow = [&](const string& mvKey)
+    {
+        const auto sRow = RealMVKeyRow(mvKey, ticket.GetBlock(), ticket.GetTxId());
+        if (bErase)
+            batch.Erase(sRow);
+        else
+            batch.Write(sRow, sKeyOne);
+    };
+    if (ticket.HasMVKeyOne())
+        fnUpdateRow(ticket.MVKeyOne());
+    if (ticket.HasMVKeyTwo())
+        fnUpdateRow(ticket.MVKeyTwo());
+    if (ticket.HasMVKeyThree())
+        fnUpdateRow(ticket.MVKeyThree());
 }
 
 bool CPastelTicketProcessor::UpdateDB(CPastelTicket &ticket, string& txid, const unsigned int nBlockHeight)
@@ -170,24 +505,71 @@ bool CPastelTicketProcessor::UpdateDB(CPastelTicket &ticket, string& txid, const
     auto itDB = dbs.find(ticket.ID());
     if (itDB == dbs.end())
         return false;
-    itDB->second->Write(ticket.KeyOne(), ticket, true);
-    if (ticket.HasKeyTwo())
-    {
-        auto realKeyTwo = RealKeyTwo(ticket.KeyTwo());
-        itDB->second->Write(realKeyTwo, ticket.KeyOne(), true);
-    }
+    CDBBatch batch(*itDB->second);
+    UpdateDBBatch(batch, ticket);
+    itDB->second->WriteBatch(batch, true);
 
-    if (ticket.HasMVKeyOne())
-        UpdateDB_MVK(ticket, ticket.MVKeyOne());
-    if (ticket.HasMVKeyTwo())
-        UpdateDB_MVK(ticket, ticket.MVKeyTwo());
-    if (ticket.HasMVKeyThree())
-        UpdateDB_MVK(ticket, ticket.MVKeyThree());
-        
     //LogFnPrintf("tickets", "Ticket added into DB with key %s (txid - %s)", ticket.KeyOne(), ticket.ticketTnx);
     return true;
 }
 
+/**
+ * Add ticket records to the DB batch: ticket itself, height index, secondary key and MV keys.
+ * Removes stale records if the ticket was stored before with different txid or height.
+ * 
+ * \param batch - DB batch for the ticket's DB
+ * \param ticket - ticket to add (txid and block height should be set)
+ * \param pPending - tickets already written to the batch (primary key -> ticket),
+ *      checked before the DB - batch writes are not visible in the DB until the batch is written.
+ *      The ticket is added to this map, it should stay alive until the batch is written.
+ */
+void CPastelTicketProcessor::UpdateDBBatch(CDBBatch& batch, const CPastelTicket& ticket, pending_tickets_t* pPending) const
+{
+    const auto itDB = dbs.find(ticket.ID());
+    if (itDB == dbs.cend())
+        return;
+    const auto sKeyOne = ticket.KeyOne();
+    // remove stale height index record if the ticket was stored before with different txid or height
+    const CPastelTicket* pExistingTicket = nullptr;
+    unique_ptr<CPastelTicket> dbTicket;
+    if (pPending)
+    {
+        const auto it = pPending->find(sKeyOne);
+        if (it != pPending->cend())
+            pExistingTicket = it->second;
+    }
+    if (!pExistingTicket)
+    {
+        dbTicket = CreateTicket(ticket.ID());
+        if (dbTicket && itDB->second->Read(sKeyOne, *dbTicket))
+            pExistingTicket = dbTicket.get();
+    }
+    if (pExistingTicket &&
+        (!pExistingTicket->IsBlock(ticket.GetBlock()) || !pExistingTicket->IsTxId(ticket.GetTxId())))
+    {
+        batch.Erase(RealHeightKey(pExistingTicket->GetBlock(), pExistingTicket->GetTxId()));
+        UpdateDB_MVK(batch, *pExistingTicket, true);
+    }
+    if (pPending)
+        (*pPending)[sKeyOne] = &ticket;
+    batch.Write(sKeyOne, ticket);
+    batch.Write(RealHeightKey(ticket.GetBlock(), ticket.GetTxId()), sKeyOne);
+    if (ticket.HasKeyTwo())
+        batch.Write(RealKeyTwo(ticket.KeyTwo()), sKeyOne);
+    if (ticket.ID() == TicketID::NFT)
+    {
+        // pre-parse NFT ticket attributes used by NFT search
+        const auto pNFTTicket = dynamic_cast<const CNFTRegTicket*>(&ticket);
+        CNFTSearchAttributes attrs;
+        string error;
+        if (pNFTTicket && attrs.Parse(*pNFTTicket, error))
+            batch.Write(RealNFTAttrKey(ticket.GetTxId()), attrs);
+        else
+            LogFnPrintf("WARNING: failed to parse NFT ticket search attributes (%s). %s", ticket.GetTxId(), error);
+    }
+    UpdateDB_MVK(batch, ticket);
+}
+
 /**
  * Reads P2FMS (Pay-to-Fake-Multisig) transaction into CDataStream object.
  * Parses the first byte from the stream - it defines ticket id.
@@ -541,45 +923,6 @@ ticket_validation_t CPastelTicketProcessor::ValidateIfTicketTransaction(const ui
     return tv;
 }
 
-bool CPastelTicketProcessor::ParseTicketAndUpdateDB(CMutableTransaction& tx, const unsigned int nBlockHeight)
-{
-    string error_ret;
-    CCompressedDataStream data_stream(SER_NETWORK, DATASTREAM_VERSION);
-    TicketID ticket_id;
-
-    if (!preParseTicket(tx, data_stream, ticket_id, error_ret))
-        return false;
-
-    try {
-        string txid = tx.GetHash().GetHex();
-
-        LogPrintf("ParseTicketAndUpdateDB -- Processing ticket ['%s', txid=%s, nBlockHeight=%u]\n", 
-            GetTicketDescription(ticket_id), txid, nBlockHeight);
-
-        auto ticket = CreateTicket(ticket_id);
-        if (!ticket)
-            error_ret = strprintf("unknown ticket type %hhu", to_integral_type<TicketID>(ticket_id));
-        else
-        {
-            data_stream >> *ticket;
-            return UpdateDB(*ticket, txid, nBlockHeight);
-        }
-    }
-    catch (const exception& ex)
-    {
-        error_ret = strprintf("Failed to parse and unpack ticket - %s", ex.what());
-    }
-    catch (...)
-    {
-        error_ret = "Failed to parse and unpack ticket - Unknown exception";
-    }
-
-    LogPrintf("ParseTicketAndUpdateDB -- Invalid ticket ['%s', txid=%s, nBlockHeight=%u]. ERROR: %s\n", 
-        GetTicketDescription(ticket_id), tx.GetHash().GetHex(), nBlockHeight, error_ret);
-
-    return false;
-}
-
 string CPastelTicketProcessor::GetTicketJSON(const uint256 &txid)
 {
     auto ticket = GetTicket(txid);
@@ -600,10 +943,39 @@ string CPastelTicketProcessor::GetTicketJSON(const uint256 &txid)
  */
 unique_ptr<CPastelTicket> CPastelTicketProcessor::GetTicket(const uint256 &txid)
 {
-    CTransaction tx;
-    uint256 hashBlock;
+    TicketID ticket_id;
     // undefined ticket height = -1
     uint32_t nTicketHeight = numeric_limits<uint32_t>::max();
+    // decoded ticket data
+    CSerializeData vTicketData;
+
+    // try to get decoded ticket data from the cache first
+    if (TicketCache.Get(txid, ticket_id, nTicketHeight, vTicketData))
+    {
+        try
+        {
+            auto ticket = CreateTicket(ticket_id);
+            if (ticket)
+            {
+                CDataStream data_stream(vTicketData, SER_NETWORK, DATASTREAM_VERSION);
+                data_stream >> *ticket;
+                ticket->SetTxId(txid.GetHex());
+                ticket->SetBlock(nTicketHeight);
+                return ticket;
+            }
+        }
+        catch (const exception& ex)
+        {
+            LogFnPrintf("Failed to unpack cached ticket [txid=%s]. %s", txid.GetHex(), ex.what());
+        }
+        nTicketHeight = numeric_limits<uint32_t>::max();
+    }
+
+    // capture cache generation before reading the ticket transaction,
+    // the ticket is not cached if its block is disconnected in the meantime
+    const uint64_t nCacheGeneration = TicketCache.GetGeneration();
+    CTransaction tx;
+    uint256 hashBlock;
 
     // get ticket transaction by txid, also may return ticket height
     if (!GetTransaction(txid, tx, Params().GetConsensus(), hashBlock, true, &nTicketHeight))
@@ -611,7 +983,6 @@ unique_ptr<CPastelTicket> CPastelTicketProcessor::GetTicket(const uint256 &txid)
 
     CMutableTransaction mtx(tx);
 
-    TicketID ticket_id;
     string error_ret;
     CCompressedDataStream data_stream(SER_NETWORK, DATASTREAM_VERSION);
 
@@ -625,12 +996,22 @@ unique_ptr<CPastelTicket> CPastelTicketProcessor::GetTicket(const uint256 &txid)
     string ticketBlockTxIdStr = tx.GetHash().GetHex();
     try
     {
-        if (nTicketHeight == numeric_limits<uint32_t>::max())
+        // cache only tickets from the blocks in the active chain
+        bool bCacheTicket = false;
+        if (!hashBlock.IsNull())
         {
-            // if ticket block height is still not defined - lookup it up in mapBlockIndex by hash
-            if (mapBlockIndex.count(hashBlock) != 0)
-                nTicketHeight = mapBlockIndex[hashBlock]->nHeight;
+            LOCK(cs_main);
+            const auto it = mapBlockIndex.find(hashBlock);
+            if (it != mapBlockIndex.cend() && it->second)
+            {
+                // if ticket block height is still not defined - lookup it up in mapBlockIndex by hash
+                if (nTicketHeight == numeric_limits<uint32_t>::max())
+                    nTicketHeight = it->second->nHeight;
+                bCacheTicket = chainActive.Contains(it->second);
+            }
         }
+        if (bCacheTicket)
+            vTicketData.assign(data_stream.begin(), data_stream.end());
 
         // create Pastel ticket by id
         ticket = CreateTicket(ticket_id);
@@ -640,6 +1021,8 @@ unique_ptr<CPastelTicket> CPastelTicketProcessor::GetTicket(const uint256 &txid)
             data_stream >> *ticket;
             ticket->SetTxId(move(ticketBlockTxIdStr));
             ticket->SetBlock(nTicketHeight);
+            if (bCacheTicket)
+                TicketCache.Put(txid, ticket_id, nTicketHeight, move(vTicketData), nCacheGeneration);
         }
         else
             error_ret = strprintf("unknown ticket_id %hhu", to_integral_type<TicketID>(ticket_id));
@@ -751,23 +1134,11 @@ template <class _TicketType>
 vector<_TicketType> CPastelTicketProcessor::FindTicketsByMVKey(const string& mvKey)
 {
     vector<_TicketType> tickets;
-    v_strings vMainKeys;
-    // get real MV key stored in DB: "@M@" + key
-    auto realMVKey = RealMVKey(mvKey);
-    // get DB for the given ticket type
-    const auto itDB = dbs.find(_TicketType::GetID());
-    if (itDB != dbs.cend())
-    {
-        // find primary keys of the tickets with mvKey
-        itDB->second->Read(realMVKey, vMainKeys);
-        // read all tickets
-        for (const auto& key : vMainKeys)
+    ProcessTicketsByMVKey<_TicketType>(mvKey, [&](const _TicketType& ticket) -> bool
         {
-            _TicketType ticket;
-            if (itDB->second->Read(key, ticket))
-                tickets.emplace_back(ticket);
-        }
-    }
+            tickets.push_back(ticket);
+            return true;
+        });
     return tickets;
 }
 
@@ -829,62 +1200,194 @@ v_strings CPastelTicketProcessor::GetAllKeys(const TicketID id) const
     return vResults;
 }
 
+/**
+ * Process fixed-length index keys "<prefix><height:10><txid>" starting from sSeekKey.
+ * Enumeration stops at the first key that has different length or prefix.
+ * 
+ * \param id - ticket type
+ * \param sSeekKey - key to seek to, defines key length and prefix
+ * \param nPrefixSize - size of the key prefix (position of the block height in the key)
+ * \param fnKey - functor to call for each index value (primary key, ticket txid, ticket height)
+ */
+void CPastelTicketProcessor::ProcessKeysByPrefix(const TicketID id, const string& sSeekKey, const size_t nPrefixSize,
+    const function<bool(string&&, const string&, const uint32_t)>& fnKey) const
+{
+    const auto itDB = dbs.find(id);
+    if (itDB == dbs.cend())
+        return;
+    const size_t nKeySize = sSeekKey.size();
+    const size_t nTxIdPos = nPrefixSize + 10;
+    unique_ptr<CDBIterator> pcursor(itDB->second->NewIterator());
+    string sKey, sKeyOne, sTxId;
+    for (pcursor->Seek(sSeekKey); pcursor->Valid(); pcursor->Next())
+    {
+        sKey.clear();
+        if (!pcursor->GetKey(sKey) || (sKey.size() != nKeySize) ||
+            (sKey.compare(0, nPrefixSize, sSeekKey, 0, nPrefixSize) != 0))
+            break; // end of the index range
+        sKeyOne.clear();
+        if (!pcursor->GetValue(sKeyOne))
+            continue;
+        const auto nHeight = static_cast<uint32_t>(strtoul(sKey.c_str() + nPrefixSize, nullptr, 10));
+        sTxId = sKey.substr(nTxIdPos);
+        if (!fnKey(move(sKeyOne), sTxId, nHeight))
+            break;
+    }
+}
+
+void CPastelTicketProcessor::ProcessKeysByMVKey(const TicketID id, const string& mvKey,
+    const function<bool(string&&, const string&, const uint32_t)>& fnKey) const
+{
+    // all rows for the MV key have the same length, seek to the first row
+    ProcessKeysByPrefix(id, RealMVKeyRow(mvKey, 0, string(uint256::SIZE * 2, '0')),
+        RealMVKey(mvKey).size() + 1, fnKey);
+}
+
+void CPastelTicketProcessor::ProcessKeysByHeight(const TicketID id, const uint32_t nMinHeight,
+    const function<bool(string&&, const string&, const uint32_t)>& fnKey) const
+{
+    // all height index keys have the same length, seek to the first key with height >= nMinHeight
+    ProcessKeysByPrefix(id, RealHeightKey(nMinHeight, string(uint256::SIZE * 2, '0')),
+        char_traits<char>::length(TICKET_HEIGHT_INDEX_PREFIX), fnKey);
+}
+
 /**
  * Apply functor F for all tickets with type _TicketType.
+ * Tickets are enumerated in block height order starting from nMinHeight.
  * 
  * \param f - functor to apply
  *      if functor returns false - enumerations will be stopped
+ * \param nMinHeight - minimum ticket block height
  */
 template <class _TicketType, typename F>
 void CPastelTicketProcessor::listTickets(F f, const uint32_t nMinHeight) const
 {
-    auto vKeys = GetAllKeys(_TicketType::GetID());
-    for (auto& key : vKeys)
+    ProcessKeysByHeight(_TicketType::GetID(), nMinHeight,
+        [&](string&& sKeyOne, const string& sTxId, const uint32_t nHeight) -> bool
+        {
+            _TicketType ticket;
+            ticket.SetKeyOne(move(sKeyOne));
+            if (!FindTicket(ticket))
+                return true;
+            // skip stale index records
+            if (!ticket.IsBlock(nHeight) || !ticket.IsTxId(sTxId))
+                return true;
+            return f(ticket);
+        });
+}
+
+/**
+ * Convert nlohmann json value to UniValue.
+ * Object keys are added in the same (sorted) order as json::dump() writes them.
+ * 
+ * \param j - json value to convert
+ * \return UniValue
+ */
+UniValue JSONToUniValue(const json& j)
+{
+    UniValue v;
+    switch (j.type())
     {
-        if (key.front() == '@')
-            continue;
-        _TicketType ticket;
-        ticket.SetKeyOne(move(key));
-        if (!FindTicket(ticket))
-            continue;
-        if (ticket.GetBlock() < nMinHeight)
-            continue;
-        if (!f(ticket))
+        case json::value_t::object:
+            v.setObject();
+            v.reserve(j.size());
+            for (const auto& [key, value] : j.items())
+                v.__pushKV(key, JSONToUniValue(value));
+            break;
+
+        case json::value_t::array:
+            v.setArray();
+            v.reserve(j.size());
+            for (const auto& value : j)
+                v.push_back(JSONToUniValue(value));
+            break;
+
+        case json::value_t::string:
+            v.setStr(j.get_ref<const string&>());
+            break;
+
+        case json::value_t::boolean:
+            v.setBool(j.get<bool>());
+            break;
+
+        case json::value_t::number_integer:
+            v.setInt(j.get<int64_t>());
+            break;
+
+        case json::value_t::number_unsigned:
+            v.setInt(j.get<uint64_t>());
+            break;
+
+        case json::value_t::number_float:
+            // keep json number formatting
+            v.setNumStr(j.dump());
+            break;
+
+        default:
             break;
     }
+    return v;
+}
+
+CTicketsJSONArrayWriter::CTicketsJSONArrayWriter(const tickets_list_page_t& page) noexcept :
+    m_page(page),
+    m_result(UniValue::VARR)
+{}
+
+/**
+ * Add ticket to the json array.
+ * 
+ * \param ticket - ticket to add
+ * \return false if page limit was reached and enumeration should be stopped
+ */
+bool CTicketsJSONArrayWriter::Add(const CPastelTicket& ticket)
+{
+    if (m_nSkipped < m_page.nOffset)
+    {
+        ++m_nSkipped;
+        return true;
+    }
+    m_result.push_back(JSONToUniValue(ticket.getJSON()));
+    ++m_nCount;
+    return !m_page.nLimit || (m_nCount < m_page.nLimit);
+}
+
+UniValue CTicketsJSONArrayWriter::Finish()
+{
+    return move(m_result);
 }
 
 template <class _TicketType>
-string CPastelTicketProcessor::ListTickets(const uint32_t nMinHeight) const
+UniValue CPastelTicketProcessor::ListTickets(const uint32_t nMinHeight, const tickets_list_page_t &page) const
 {
-    json jArray = json::array();
+    CTicketsJSONArrayWriter writer(page);
     listTickets<_TicketType>([&](const _TicketType& ticket) -> bool
     {
-        jArray.push_back(json::parse(ticket.ToJSON()));
-        return true;
+        return writer.Add(ticket);
     }, nMinHeight);
-    return jArray.dump();
-}
-template string CPastelTicketProcessor::ListTickets<CPastelIDRegTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CNFTRegTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CNFTCollectionRegTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CNFTCollectionActivateTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CNFTActivateTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<COfferTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CAcceptTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CTransferTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CNFTRoyaltyTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CChangeUsernameTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CChangeEthereumAddressTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CActionRegTicket>(const uint32_t nMinHeight) const;
-template string CPastelTicketProcessor::ListTickets<CActionActivateTicket>(const uint32_t nMinHeight) const;
+    return writer.Finish();
+}
+template UniValue CPastelTicketProcessor::ListTickets<CPastelIDRegTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CNFTRegTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CNFTCollectionRegTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CNFTCollectionActivateTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CNFTActivateTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<COfferTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CAcceptTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CTransferTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CNFTRoyaltyTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CChangeUsernameTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CChangeEthereumAddressTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CActionRegTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
+template UniValue CPastelTicketProcessor::ListTickets<CActionActivateTicket>(const uint32_t nMinHeight, const tickets_list_page_t &page) const;
 
 template <class _TicketType, typename F>
-string CPastelTicketProcessor::filterTickets(F f, const uint32_t nMinHeight, const bool bCheckConfirmation) const
+UniValue CPastelTicketProcessor::filterTickets(F f, const uint32_t nMinHeight, const bool bCheckConfirmation, 
+    const tickets_list_page_t &page) const
 {
-    json jArray = json::array();
+    CTicketsJSONArrayWriter writer(page);
     const auto nChainHeight = GetActiveChainHeight();
-    // list tickets with the specific type (_TicketType) and add to json array if functor f applies
+    // list tickets with the specific type (_TicketType) and add to json array if functor f does not skip it
     listTickets<_TicketType>([&](const _TicketType& ticket) -> bool
     {
         //check if the ticket is confirmed
@@ -893,10 +1396,9 @@ string CPastelTicketProcessor::filterTickets(F f, const uint32_t nMinHeight, con
         // apply functor to the current ticket
         if (f(ticket, nChainHeight))
             return true;
-        jArray.push_back(json::parse(ticket.ToJSON()));
-        return true;
+        return writer.Add(ticket);
     }, nMinHeight);
-    return jArray.dump();
+    return writer.Finish();
 }
 
 /**
@@ -909,7 +1411,8 @@ string CPastelTicketProcessor::filterTickets(F f, const uint32_t nMinHeight, con
  * \param pmapIDs - map of locally stored Pastel IDs -> LegRoast public key
  * \return json with filtered tickets
  */
-string CPastelTicketProcessor::ListFilterPastelIDTickets(const uint32_t nMinHeight, const short filter, const pastelid_store_t* pmapIDs) const
+UniValue CPastelTicketProcessor::ListFilterPastelIDTickets(const uint32_t nMinHeight, const short filter, const pastelid_store_t* pmapIDs, 
+    const tickets_list_page_t &page) const
 {
     return filterTickets<CPastelIDRegTicket>(
         [&](const CPastelIDRegTicket& t, const unsigned int chainHeight) -> bool
@@ -922,11 +1425,11 @@ string CPastelTicketProcessor::ListFilterPastelIDTickets(const uint32_t nMinHeig
                     pmapIDs && pmapIDs->find(t.pastelID) != pmapIDs->cend()))
                 return false;
             return true;
-        }, nMinHeight);
+        }, nMinHeight, true, page);
 }
 
 // 1 - active;    2 - inactive;     3 - transferred
-string CPastelTicketProcessor::ListFilterNFTTickets(const uint32_t nMinHeight, const short filter) const
+UniValue CPastelTicketProcessor::ListFilterNFTTickets(const uint32_t nMinHeight, const short filter, const tickets_list_page_t &page) const
 {
     return filterTickets<CNFTRegTicket>(
         [&](const CNFTRegTicket& t, const unsigned int nChainHeight) -> bool
@@ -952,11 +1455,11 @@ string CPastelTicketProcessor::ListFilterNFTTickets(const uint32_t nMinHeight, c
             } else if (filter == 2)
                 return false; //don't skip inactive
             return true;
-        }, nMinHeight);
+        }, nMinHeight, true, page);
 }
 
 // 1 - active;    2 - inactive;
-string CPastelTicketProcessor::ListFilterNFTCollectionTickets(const uint32_t nMinHeight, const short filter) const
+UniValue CPastelTicketProcessor::ListFilterNFTCollectionTickets(const uint32_t nMinHeight, const short filter, const tickets_list_page_t &page) const
 {
     return filterTickets<CNFTCollectionRegTicket>(
         [&](const CNFTCollectionRegTicket& t, const unsigned int nChainHeight) -> bool
@@ -970,11 +1473,11 @@ string CPastelTicketProcessor::ListFilterNFTCollectionTickets(const uint32_t nMi
             if (filter == 2)
                 return false; //don't skip inactive
             return true;
-        }, nMinHeight);
+        }, nMinHeight, true, page);
 }
 
 // 1 - active; 2 - inactive; 3 - transferred
-string CPastelTicketProcessor::ListFilterActionTickets(const uint32_t nMinHeight, const short filter) const
+UniValue CPastelTicketProcessor::ListFilterActionTickets(const uint32_t nMinHeight, const short filter, const tickets_list_page_t &page) const
 {
     return filterTickets<CActionRegTicket>(
         [&](const CActionRegTicket& t, const unsigned int nChainHeight) -> bool
@@ -999,11 +1502,11 @@ string CPastelTicketProcessor::ListFilterActionTickets(const uint32_t nMinHeight
             } else if (filter == 2)
                 return false; //don't skip inactive
             return true;
-        }, nMinHeight);
+        }, nMinHeight, true, page);
 }
 
 // 1 - available;      2 - transferred|sold
-string CPastelTicketProcessor::ListFilterActTickets(const uint32_t nMinHeight, const short filter) const
+UniValue CPastelTicketProcessor::ListFilterActTickets(const uint32_t nMinHeight, const short filter, const tickets_list_page_t &page) const
 {
     return filterTickets<CNFTActivateTicket>(
         [&](const CNFTActivateTicket& t, const unsigned int chainHeight) -> bool
@@ -1021,15 +1524,16 @@ string CPastelTicketProcessor::ListFilterActTickets(const uint32_t nMinHeight, c
             } else if (filter == 2)
                 return false; //don't skip transferred|sold
             return true;
-        }, nMinHeight);
+        }, nMinHeight, true, page);
 }
 
 // 0 - all, 1 - available; 2 - unavailable; 3 - expired; 4 - transferred|sold
-string CPastelTicketProcessor::ListFilterOfferTickets(const uint32_t nMinHeight, const short filter, const string& pastelID) const
+UniValue CPastelTicketProcessor::ListFilterOfferTickets(const uint32_t nMinHeight, const short filter, const string& pastelID, 
+    const tickets_list_page_t &page) const
 {
     const bool checkConfirmation{filter > 0};
     if (filter == 0 && pastelID.empty()) {
-            return ListTickets<COfferTicket>(nMinHeight); // get all
+            return ListTickets<COfferTicket>(nMinHeight, page); // get all
     }
     return filterTickets<COfferTicket>(
         [&](const COfferTicket& t, const unsigned int chainHeight) -> bool
@@ -1068,15 +1572,16 @@ string CPastelTicketProcessor::ListFilterOfferTickets(const uint32_t nMinHeight,
                     return true;
             }
             return false;
-        }, checkConfirmation);
+        }, nMinHeight, checkConfirmation, page);
 }
 
 // 0 - all, 1 - expired;    2 - transferred|sold
-string CPastelTicketProcessor::ListFilterAcceptTickets(const uint32_t nMinHeight, const short filter, const string& pastelID) const
+UniValue CPastelTicketProcessor::ListFilterAcceptTickets(const uint32_t nMinHeight, const short filter, const string& pastelID, 
+    const tickets_list_page_t &page) const
 {
     const bool checkConfirmation{filter > 0};
     if (filter == 0 && pastelID.empty()) {
-            return ListTickets<CAcceptTicket>(nMinHeight); // get all
+            return ListTickets<CAcceptTicket>(nMinHeight, page); // get all
     }
     return filterTickets<CAcceptTicket>(
         [&](const CAcceptTicket& t, const unsigned int chainHeight) -> bool
@@ -1091,15 +1596,16 @@ string CPastelTicketProcessor::ListFilterAcceptTickets(const uint32_t nMinHeight
             } else if (filter == 1 && t.GetBlock() + masterNodeCtrl.MaxAcceptTicketAge < chainHeight)
                 return false; //don't skip non transferred|sold, and expired
             return true;
-        }, checkConfirmation);
+        }, nMinHeight, checkConfirmation, page);
 }
 
 // 0 - all, 1 - available; 2 - transferred|sold
-string CPastelTicketProcessor::ListFilterTransferTickets(const uint32_t nMinHeight, const short filter, const string& pastelID) const
+UniValue CPastelTicketProcessor::ListFilterTransferTickets(const uint32_t nMinHeight, const short filter, const string& pastelID, 
+    const tickets_list_page_t &page) const
 {
     const bool checkConfirmation{filter > 0};
     if (filter == 0 && pastelID.empty())
-        return ListTickets<CTransferTicket>(nMinHeight); // get all
+        return ListTickets<CTransferTicket>(nMinHeight, page); // get all
     return filterTickets<CTransferTicket>(
         [&](const CTransferTicket& t, const unsigned int chainHeight) -> bool
         {
@@ -1116,7 +1622,7 @@ string CPastelTicketProcessor::ListFilterTransferTickets(const uint32_t nMinHeig
             } else if (filter == 2)
                 return false; //don't skip transferred|sold
             return true;
-        }, checkConfirmation);
+        }, nMinHeight, checkConfirmation, page);
 }
 
 bool CPastelTicketProcessor::WalkBackTradingChain(
@@ -1324,6 +1830,232 @@ tuple<string, string> CPastelTicketProcessor::SendTicket(const CPastelTicket& ti
     return make_tuple(tx.GetHash().GetHex(), ticket.KeyOne());
 }
 
+/**
+ * Calculate 64-bit trigram signature of the lowercased string.
+ * Each trigram sets one bit in the mask, so if string A contains string B
+ * then all bits of B's mask are set in A's mask.
+ * 
+ * \param sValue - lowercased string
+ * \return trigram mask, 0 for strings shorter than 3 characters
+ */
+uint64_t CNFTSearchAttributes::GetTrigramMask(const string& sValue) noexcept
+{
+    uint64_t nMask = 0;
+    for (size_t i = 0; i + 2 < sValue.size(); ++i)
+    {
+        const uint32_t nTrigram = (static_cast<uint8_t>(sValue[i]) << 16) |
+                                  (static_cast<uint8_t>(sValue[i + 1]) << 8) |
+                                   static_cast<uint8_t>(sValue[i + 2]);
+        nMask |= uint64_t(1) << ((nTrigram * 0x9E3779B1u) >> 26);
+    }
+    return nMask;
+}
+
+/**
+ * Decode NFT app ticket json (base64-encoded "app_ticket" property of the NFT ticket).
+ * 
+ * \param ticket - NFT registration ticket
+ * \param jApp - returns app ticket json (empty if NFT ticket has no app ticket)
+ * \param error - returns error message if any
+ * \return true if NFT ticket was successfully decoded
+ */
+bool CNFTSearchAttributes::DecodeAppTicket(const CNFTRegTicket& ticket, json& jApp, string& error)
+{
+    // NFT ticket data are base64 encoded
+    bool bInvalid = false;
+    string sData = DecodeBase64(ticket.ToStr(), &bInvalid);
+    if (bInvalid)
+    {
+        error = "failed to decode base64 encoded NFT ticket";
+        return false;
+    }
+    json j;
+    try
+    {
+        // parse NFT ticket json
+        j = json::parse(sData);
+    } catch (const json::exception& ex)
+    {
+        error = strprintf("failed to parse NFT ticket json. %s", SAFE_SZ(ex.what()));
+        return false;
+    }
+    jApp.clear();
+    if (!j.contains("app_ticket"))
+        return true;
+    const json& jAppTicketBase64 = j["app_ticket"];
+    if (!jAppTicketBase64.is_string())
+        return true;
+    sData = DecodeBase64(jAppTicketBase64.get<string>(), &bInvalid);
+    if (bInvalid)
+    {
+        error = "failed to decode base64 encoded NFT app ticket";
+        return false;
+    }
+    try
+    {
+        // parse app ticket json
+        jApp = json::parse(sData);
+    } catch (const json::exception& ex)
+    {
+        error = strprintf("failed to parse NFT app ticket json. %s", SAFE_SZ(ex.what()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parse NFT registration ticket attributes used by NFT search.
+ * Indexes all scalar app ticket properties, other properties are added to setNotIndexedProps.
+ * 
+ * \param ticket - NFT registration ticket
+ * \param error - returns error message if any
+ * \return true if attributes were successfully parsed
+ */
+bool CNFTSearchAttributes::Parse(const CNFTRegTicket& ticket, string& error)
+{
+    json jApp;
+    if (!DecodeAppTicket(ticket, jApp, error))
+        return false;
+    nTotalCopies = ticket.getTotalCopies();
+    if (!jApp.is_object())
+        return true;
+    try
+    {
+        if (jApp.contains("rareness_score") && jApp["rareness_score"].is_number())
+            nRarenessScore = jApp["rareness_score"].get<int32_t>();
+        if (jApp.contains("nsfw_score") && jApp["nsfw_score"].is_number())
+            nNSFWScore = jApp["nsfw_score"].get<int32_t>();
+        if (jApp.contains("thumbnail_hash") && jApp["thumbnail_hash"].is_string())
+            sThumbnailHash = jApp["thumbnail_hash"].get<string>();
+        for (const auto& [sPropName, jProp] : jApp.items())
+        {
+            nft_search_prop_t prop;
+            if (jProp.is_string())
+            {
+                prop.nType = to_integral_type(NFT_SEARCH_PROP_TYPE::string);
+                jProp.get_to(prop.sValue);
+                if (prop.sValue.size() > MAX_INDEXED_PROP_SIZE)
+                {
+                    setNotIndexedProps.insert(sPropName);
+                    continue;
+                }
+                lowercase(prop.sValue);
+                prop.nTrigramMask = GetTrigramMask(prop.sValue);
+            } else if (jProp.is_boolean()) {
+                prop.nType = to_integral_type(NFT_SEARCH_PROP_TYPE::boolean);
+                prop.sValue = jProp.get<bool>() ? "1" : "0";
+            } else if (jProp.is_number()) {
+                prop.nType = to_integral_type(NFT_SEARCH_PROP_TYPE::number);
+                prop.sValue = to_string(jProp);
+            } else {
+                // arrays, objects and nulls are not indexed - fuzzy filter is checked using app ticket json
+                setNotIndexedProps.insert(sPropName);
+                continue;
+            }
+            mapProps.emplace(sPropName, move(prop));
+        }
+    } catch (const json::exception& ex)
+    {
+        error = strprintf("failed to parse NFT app ticket properties. %s", SAFE_SZ(ex.what()));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check if indexed app ticket property passes fuzzy search filter.
+ * Same rules as in isValuePassFuzzyFilter.
+ * 
+ * \param sPropName - app ticket property name
+ * \param sPropFilterValue - filter value
+ * \return std::nullopt if property was not indexed and app ticket json should be checked,
+ *         true if property is missing in app ticket (filter is skipped) or passes the filter
+ */
+optional<bool> CNFTSearchAttributes::PassFuzzyFilter(const string& sPropName, const string& sPropFilterValue) const noexcept
+{
+    const auto it = mapProps.find(sPropName);
+    if (it == mapProps.cend())
+    {
+        if (setNotIndexedProps.count(sPropName))
+            return nullopt;
+        return true; // just skip unknown properties
+    }
+    const auto& prop = it->second;
+    switch (static_cast<NFT_SEARCH_PROP_TYPE>(prop.nType))
+    {
+        case NFT_SEARCH_PROP_TYPE::string:
+        {
+            const string sFilter = lowercase(sPropFilterValue);
+            const uint64_t nFilterMask = GetTrigramMask(sFilter);
+            // fast check: all filter trigrams should be present in the value
+            if ((prop.nTrigramMask & nFilterMask) != nFilterMask)
+                return false;
+            return prop.sValue.find(sFilter) != string::npos;
+        }
+
+        case NFT_SEARCH_PROP_TYPE::boolean:
+        {
+            bool bValue = false;
+            if (!str_tobool(sPropFilterValue, bValue))
+                return false;
+            return (prop.sValue == "1") == bValue;
+        }
+
+        case NFT_SEARCH_PROP_TYPE::number:
+            return prop.sValue == sPropFilterValue;
+
+        default:
+            break;
+    }
+    return nullopt;
+}
+
+/**
+ * Get json with indexed app ticket properties.
+ */
+json CNFTSearchAttributes::ToAppJSON() const noexcept
+{
+    json j = json::object();
+    if (!sThumbnailHash.empty())
+        j["thumbnail_hash"] = sThumbnailHash;
+    if (nRarenessScore >= 0)
+        j["rareness_score"] = nRarenessScore;
+    if (nNSFWScore >= 0)
+        j["nsfw_score"] = nNSFWScore;
+    return j;
+}
+
+/**
+ * Get pre-parsed NFT registration ticket search attributes.
+ * If attributes are missing in the DB (ticket was added by the older version) -
+ * parse NFT ticket and store attributes in the DB.
+ * 
+ * \param sRegTxId - NFT registration ticket txid
+ * \param attrs - returns NFT search attributes
+ * \return true if attributes were found or created
+ */
+bool CPastelTicketProcessor::GetNFTSearchAttributes(const string& sRegTxId, CNFTSearchAttributes& attrs) const
+{
+    const auto itDB = dbs.find(TicketID::NFT);
+    if (itDB == dbs.cend())
+        return false;
+    const auto sAttrKey = RealNFTAttrKey(sRegTxId);
+    if (itDB->second->Read(sAttrKey, attrs))
+        return true;
+    auto pTicket = GetTicket(sRegTxId, TicketID::NFT);
+    const auto pNFTTicket = dynamic_cast<const CNFTRegTicket*>(pTicket.get());
+    if (!pNFTTicket)
+        return false;
+    string error;
+    if (!attrs.Parse(*pNFTTicket, error))
+    {
+        LogPrintf("ERROR: failed to parse NFT ticket (%s). %s\n", sRegTxId, error);
+        return false;
+    }
+    itDB->second->Write(sAttrKey, attrs);
+    return true;
+}
+
 #ifdef ENABLE_WALLET
 bool CPastelTicketProcessor::CreateP2FMSTransaction(const string& input_string, CMutableTransaction& tx_out, 
     const CAmount pricePSL, const opt_string_t& sFundingAddress, string& error_ret)
@@ -1407,7 +2139,6 @@ void CPastelTicketProcessor::SearchForNFTs(const search_thumbids_t& p, function<
     } else
         vPastelIDs.push_back(p.sCreatorPastelId);
     size_t nResultCount = 0;
-    string sDataBase64, sData;
     // process NFT activation tickets by PastelID (mvkey #1)
     for (const auto &sPastelID : vPastelIDs)
     {
@@ -1424,76 +2155,25 @@ void CPastelTicketProcessor::SearchForNFTs(const search_thumbids_t& p, function<
                     break;
 
                 const auto& regTxId = actTicket.getRegTxId();
-                // find NFT registration ticket by txid
-                auto pNftTicketPtr = CPastelTicketProcessor::GetTicket(regTxId, TicketID::NFT);
-                if (!pNftTicketPtr)
-                    break;
-                auto pNftTicket = dynamic_cast<const CNFTRegTicket*>(pNftTicketPtr.get());
-                if (!pNftTicket)
+                // get pre-parsed NFT registration ticket attributes
+                CNFTSearchAttributes attrs;
+                if (!GetNFTSearchAttributes(regTxId, attrs))
                     break;
                 // filter by number of copies
-                if (p.copyCount.has_value() && !p.copyCount.value().contains(pNftTicket->getTotalCopies()))
+                if (p.copyCount.has_value() && !p.copyCount.value().contains(attrs.nTotalCopies))
                     break;
-                // NFT ticket data are base64 encoded
-                bool bInvalid = false;
-                sData = DecodeBase64(pNftTicket->ToStr(), &bInvalid);
-                if (bInvalid)
-                {
-                    LogPrintf("ERROR: failed to decode base64 encoded NFT ticket (%s)", regTxId);
-                    break;
-                }
-                json j;
-                try
-                {
-                    // parse NFT ticket json
-                    j = json::parse(sData);
-                } catch (const json::exception& ex)
-                {
-                    LogPrintf("ERROR: failed to parse NFT ticket json (%s). %s", regTxId, SAFE_SZ(ex.what()));
-                    break;
-                }
-                json jApp; // app ticket json
-                if (j.contains("app_ticket"))
-                {
-                    const json &jAppTicketBase64 = j["app_ticket"];
-                    if (jAppTicketBase64.is_string())
-                    {
-                        bInvalid = false;
-                        jAppTicketBase64.get_to(sDataBase64);
-                        sData = DecodeBase64(sDataBase64, &bInvalid);
-                        if (bInvalid)
-                        {
-                            LogPrintf("ERROR: failed to decode base64 encoded NFT app ticket (%s)", regTxId);
-                            break;
-                        }
-                        try
-                        {
-                            // parse app ticket json
-                            jApp = json::parse(sData);
-                        } catch (const json::exception& ex)
-                        {
-                            LogPrintf("ERROR: failed to parse NFT app ticket json (%s). %s", regTxId, SAFE_SZ(ex.what()));
-                            break;
-                        }
-                    }
-                }
-                uint32_t nScore;
                 // filter by rareness score
-                if (p.rarenessScore.has_value() && jApp.contains("rareness_score"))
-                {
-                    jApp["rareness_score"].get_to(nScore);
-                    if (!p.rarenessScore.value().contains(nScore))
-                        break;
-                }
+                if (p.rarenessScore.has_value() && (attrs.nRarenessScore >= 0) &&
+                    !p.rarenessScore.value().contains(static_cast<uint32_t>(attrs.nRarenessScore)))
+                    break;
                 // filter by nsfw score
-                if (p.nsfwScore.has_value() && jApp.contains("nsfw_score"))
-                {
-                    jApp["nsfw_score"].get_to(nScore);
-                    if (!p.nsfwScore.value().contains(nScore))
-                        break;
-                }
-                // nft reg app ticket properties (name: value)
-                string sPropName, sPropValue;
+                if (p.nsfwScore.has_value() && (attrs.nNSFWScore >= 0) &&
+                    !p.nsfwScore.value().contains(static_cast<uint32_t>(attrs.nNSFWScore)))
+                    break;
+                // nft reg app ticket json, decoded only for the properties that were not indexed
+                optional<json> jApp;
+                unique_ptr<CPastelTicket> pNftTicketPtr;
+                string sPropName, error;
                 // fuzzy search (key is lowercased in the fuzzySearchMap)
                 bool bPassedFilter = true;
                 for (const auto &[sSearchProp, sPropFilterValue] : p.fuzzySearchMap)
@@ -1504,14 +2184,41 @@ void CPastelTicketProcessor::SearchForNFTs(const search_thumbids_t& p, function<
                         sPropName = itMapping->second; // found property name in the map -> use it
                     else
                         sPropName = sSearchProp; // try to use search property and nft ticket property name as is
-                    if (!jApp.contains(sPropName))
-                        continue; // just skip unknown properties
-                    bPassedFilter = isValuePassFuzzyFilter(jApp[sPropName], sPropFilterValue);
+                    auto passed = attrs.PassFuzzyFilter(sPropName, sPropFilterValue);
+                    if (!passed.has_value())
+                    {
+                        // property was not indexed - check app ticket json
+                        if (!jApp.has_value())
+                        {
+                            pNftTicketPtr = CPastelTicketProcessor::GetTicket(regTxId, TicketID::NFT);
+                            const auto pNftTicket = dynamic_cast<const CNFTRegTicket*>(pNftTicketPtr.get());
+                            jApp = json();
+                            if (!pNftTicket || !CNFTSearchAttributes::DecodeAppTicket(*pNftTicket, jApp.value(), error))
+                            {
+                                LogPrintf("ERROR: failed to decode NFT ticket (%s). %s\n", regTxId, error);
+                                bPassedFilter = false;
+                                break;
+                            }
+                        }
+                        passed = !jApp.value().contains(sPropName) || 
+                            isValuePassFuzzyFilter(jApp.value()[sPropName], sPropFilterValue);
+                    }
+                    if (!passed.value())
+                    {
+                        bPassedFilter = false;
+                        break;
+                    }
                 }
                 if (!bPassedFilter)
                     break;
+                // find NFT registration ticket by txid
+                if (!pNftTicketPtr)
+                    pNftTicketPtr = CPastelTicketProcessor::GetTicket(regTxId, TicketID::NFT);
+                const auto pNftTicket = dynamic_cast<const CNFTRegTicket*>(pNftTicketPtr.get());
+                if (!pNftTicket)
+                    break;
                 // add NFT reg ticket info to the json array
-                nResultCount = fnMatchFound(pNftTicket, jApp);
+                nResultCount = fnMatchFound(pNftTicket, attrs.ToAppJSON());
             } while (false);
             return true;
         });
@@ -2043,6 +2750,11 @@ string CPastelTicketProcessor::CreateFakeTransaction(CPastelTicket& ticket, cons
 }
 #endif // FAKE_TICKET
 
+CTicketCache& CPastelTicketProcessor::GetTicketCache() noexcept
+{
+    return TicketCache;
+}
+
 shared_ptr<ITxMemPoolTracker> CPastelTicketProcessor::GetTxMemPoolTracker()
 {
     if (!TicketTxMemPoolTracker)
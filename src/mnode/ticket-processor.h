@@ -3,9 +3,13 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 #include <memory>
+#include <functional>
 #include <tuple>
 #include <optional>
+#include <map>
+#include <set>
 #include <json/json.hpp>
+#include <univalue.h>
 
 #include <dbwrapper.h>
 #include <chain.h>
@@ -18,6 +22,7 @@
 #include <mnode/mnode-consts.h>
 #include <mnode/tickets/ticket-types.h>
 #include <mnode/tickets/ticket.h>
+#include <mnode/ticket-cache.h>
 #include <datacompressor.h>
 
 constexpr int DATASTREAM_VERSION = 1;
@@ -59,9 +64,116 @@ typedef struct _search_thumbids_t
     mu_strings fuzzySearchMap;
 } search_thumbids_t;
 
+// pagination parameters for the ticket list/filter functions
+typedef struct _tickets_list_page_t
+{
+    size_t nOffset{0};  // number of matching tickets to skip
+    size_t nLimit{0};   // max number of tickets to return, 0 - no limit
+} tickets_list_page_t;
+
+class CPastelTicket;
+
+/**
+ * Builds json array of the tickets page.
+ * Each ticket json is converted directly to UniValue, without serializing it to string
+ * and parsing it back.
+ */
+class CTicketsJSONArrayWriter
+{
+public:
+    CTicketsJSONArrayWriter(const tickets_list_page_t& page) noexcept;
+
+    // add ticket to the json array, returns false if page limit was reached
+    bool Add(const CPastelTicket& ticket);
+    // return result json array
+    UniValue Finish();
+
+private:
+    const tickets_list_page_t &m_page;
+    UniValue m_result;
+    size_t m_nSkipped = 0;
+    size_t m_nCount = 0;
+};
+
 // Check if json value passes fuzzy search filter
+// convert nlohmann json value to UniValue
+UniValue JSONToUniValue(const nlohmann::json& j);
 bool isValuePassFuzzyFilter(const nlohmann::json& jProp, const std::string& sPropFilterValue) noexcept;
 
+class CNFTRegTicket;
+
+// type of the indexed NFT app ticket property
+enum class NFT_SEARCH_PROP_TYPE : uint8_t
+{
+    string = 0,
+    boolean = 1,
+    number = 2
+};
+
+// NFT app ticket property value indexed for fuzzy search
+typedef struct _nft_search_prop_t
+{
+    uint8_t nType{0};           // property type (NFT_SEARCH_PROP_TYPE)
+    std::string sValue;         // lowercased string value or json representation of the boolean/number
+    uint64_t nTrigramMask{0};   // trigram signature of the string value
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream>
+    inline void SerializationOp(Stream& s, const SERIALIZE_ACTION ser_action)
+    {
+        READWRITE(nType);
+        READWRITE(sValue);
+        READWRITE(nTrigramMask);
+    }
+} nft_search_prop_t;
+
+/**
+ * Pre-parsed NFT registration ticket attributes used by 'tickets tools searchthumbids'.
+ * Stored in NFT ticket DB by NFT registration ticket txid ("@A@" + txid) 
+ * when the ticket is added to the DB, so search does not need to decode NFT ticket json.
+ */
+class CNFTSearchAttributes
+{
+public:
+    // max size of the string property value to index
+    static constexpr size_t MAX_INDEXED_PROP_SIZE = 4096;
+
+    uint32_t nTotalCopies{0};
+    int32_t nRarenessScore{-1};     // -1 if not defined in app ticket
+    int32_t nNSFWScore{-1};         // -1 if not defined in app ticket
+    std::string sThumbnailHash;
+    // app ticket property name -> indexed value
+    std::map<std::string, nft_search_prop_t> mapProps;
+    // app ticket properties that were not indexed (too big values, arrays, objects, nulls)
+    std::set<std::string> setNotIndexedProps;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream>
+    inline void SerializationOp(Stream& s, const SERIALIZE_ACTION ser_action)
+    {
+        READWRITE(nTotalCopies);
+        READWRITE(nRarenessScore);
+        READWRITE(nNSFWScore);
+        READWRITE(sThumbnailHash);
+        READWRITE(mapProps);
+        READWRITE(setNotIndexedProps);
+    }
+
+    // parse NFT registration ticket attributes
+    bool Parse(const CNFTRegTicket& ticket, std::string& error);
+    // check fuzzy filter for the given property, returns std::nullopt if the property was not indexed
+    std::optional<bool> PassFuzzyFilter(const std::string& sPropName, const std::string& sPropFilterValue) const noexcept;
+    // get json with indexed app ticket properties
+    nlohmann::json ToAppJSON() const noexcept;
+
+    // calculate 64-bit trigram signature of the lowercased string
+    static uint64_t GetTrigramMask(const std::string& sValue) noexcept;
+    // decode NFT app ticket json
+    static bool DecodeAppTicket(const CNFTRegTicket& ticket, nlohmann::json& jApp, std::string& error);
+};
+
 // Ticket  Processor ////////////////////////////////////////////////////////////////////////////////////////////////////
 class CPastelTicketProcessor
 {
@@ -73,7 +185,8 @@ class CPastelTicketProcessor
 
     // filter tickets of the specific type using functor f
     template <class _TicketType, typename F>
-    std::string filterTickets(F f, const uint32_t nMinHeight, const bool bCheckConfirmation = true) const;
+    UniValue filterTickets(F f, const uint32_t nMinHeight, const bool bCheckConfirmation = true, 
+        const tickets_list_page_t &page = {}) const;
 
 public:
     CPastelTicketProcessor() = default;
@@ -82,14 +195,26 @@ public:
     static std::unique_ptr<CPastelTicket> CreateTicket(const TicketID ticketId);
 
     void InitTicketDB();
-    void UpdatedBlockTip(const CBlockIndex* cBlockIndex, bool fInitialDownload);
-    bool ParseTicketAndUpdateDB(CMutableTransaction& tx, const unsigned int nBlockHeight);
+    // block was connected to the active chain - add block tickets to the ticket DBs
+    void ConnectedBlock(const CBlockIndex* pindex, const CBlock& block);
+    // block was disconnected from the active chain
+    void DisconnectedBlock(const CBlockIndex* pindex, const CBlock* pblock);
 
     static std::string RealKeyTwo(const std::string& key) noexcept { return "@2@" + key; }
     static std::string RealMVKey(const std::string& key) noexcept { return "@M@" + key; }
+    // MV key row: "@M@" + key + '\0' + zero-padded block height + ticket txid (fixed length for the given MV key)
+    static std::string RealMVKeyRow(const std::string& key, const uint32_t nHeight, const std::string& txid) noexcept;
+    // height index key: "@H@" + zero-padded block height + ticket txid (fixed length)
+    static std::string RealHeightKey(const uint32_t nHeight, const std::string& txid) noexcept;
+    // NFT search attributes key: "@A@" + NFT registration ticket txid
+    static std::string RealNFTAttrKey(const std::string& txid) noexcept { return "@A@" + txid; }
 
     bool UpdateDB(CPastelTicket& ticket, std::string& txid, const unsigned int nBlockHeight);
-    void UpdateDB_MVK(const CPastelTicket& ticket, const std::string& mvKey);
+    // primary key -> ticket written to the DB batch
+    using pending_tickets_t = std::unordered_map<std::string, const CPastelTicket*>;
+    // add ticket records (ticket, height index, secondary & MV keys) to the DB batch
+    void UpdateDBBatch(CDBBatch& batch, const CPastelTicket& ticket, pending_tickets_t* pPending = nullptr) const;
+    void UpdateDB_MVK(CDBBatch& batch, const CPastelTicket& ticket, const bool bErase = false) const;
 
     // check whether ticket exists (use keyOne as a key)
     bool CheckTicketExist(const CPastelTicket& ticket);
@@ -110,49 +235,75 @@ public:
     template <class _TicketType, typename _TicketFunctor>
     void ProcessTicketsByMVKey(const std::string& mvKey, _TicketFunctor f) const
     {
-        v_strings vMainKeys;
-        // get real MV key: "@M@" + key
-        const auto realMVKey = RealMVKey(mvKey);
         // get DB for the given ticket type
         const auto itDB = dbs.find(_TicketType::GetID());
         if (itDB == dbs.cend())
             return;
-        // read primary keys for the given MV key
-        itDB->second->Read(realMVKey, vMainKeys);
-        for (const auto& key : vMainKeys)
-        {
-            // read ticket & call the functor
-            _TicketType ticket;
-            if (itDB->second->Read(key, ticket))
+        // enumerate primary keys for the given MV key
+        ProcessKeysByMVKey(_TicketType::GetID(), mvKey, 
+            [&](std::string&& sKeyOne, const std::string& txid, const uint32_t nHeight) -> bool
             {
-                if (!f(ticket))
-                    break; // stop processing tickets if functor returned false
-            }
-        }
+                // read ticket & call the functor
+                _TicketType ticket;
+                if (!itDB->second->Read(sKeyOne, ticket))
+                    return true;
+                // skip stale MV key records
+                if (!ticket.IsBlock(nHeight) || !ticket.IsTxId(txid))
+                    return true;
+                // stop processing tickets if functor returned false
+                return f(ticket);
+            });
     }
 
+    /**
+    * Process primary keys of the tickets with the given MV key.
+    * MV key rows have the same size for the given MV key - uses DB prefix scan,
+    * keys are enumerated in ticket height order.
+    *
+    * \param id - ticket type
+    * \param mvKey - MV key to use for tickets enumeration
+    * \param fnKey - functor to call for each ticket key (primary key, ticket txid, ticket height).
+    *       Functor fnKey should return false to stop enumeration.
+    */
+    void ProcessKeysByMVKey(const TicketID id, const std::string& mvKey,
+        const std::function<bool(std::string&&, const std::string&, const uint32_t)>& fnKey) const;
+
     // find all tickets by mvKey
     template <class _TicketType>
     std::vector<_TicketType> FindTicketsByMVKey(const std::string& mvKey);
 
+    /**
+    * Process primary keys of the tickets registered at height >= nMinHeight.
+    * Uses block height index - seeks directly to nMinHeight, keys are enumerated in height order.
+    *
+    * \param id - ticket type
+    * \param nMinHeight - minimum ticket block height
+    * \param fnKey - functor to call for each ticket key (primary key, ticket txid, ticket height).
+    *       Functor fnKey should return false to stop enumeration.
+    */
+    void ProcessKeysByHeight(const TicketID id, const uint32_t nMinHeight,
+        const std::function<bool(std::string &&, const std::string &, const uint32_t)>& fnKey) const;
+
     v_strings GetAllKeys(const TicketID id) const;
 
     std::string getValueBySecondaryKey(const CPastelTicket& ticket) const;
 
     template <class _TicketType>
-    std::string ListTickets(const uint32_t nMinHeight) const;
+    UniValue ListTickets(const uint32_t nMinHeight, const tickets_list_page_t &page = {}) const;
 
     // list NFT registration tickets using filter
-    std::string ListFilterPastelIDTickets(const uint32_t nMinHeight, const short filter = 0, // 1 - mn;        2 - personal;     3 - mine
-                                          const pastelid_store_t* pmapIDs = nullptr) const;
-    std::string ListFilterNFTTickets(const uint32_t nMinHeight, const short filter = 0) const;   // 1 - active;    2 - inactive;     3 - transferred
-    std::string ListFilterNFTCollectionTickets(const uint32_t nMinHeight, const short filter = 0) const;   // 1 - active;    2 - inactive;
-    std::string ListFilterActTickets(const uint32_t nMinHeight, const short filter = 0) const;   // 1 - available; 2 - transferred
-    std::string ListFilterOfferTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "") const;  // 0 - all, 1 - available; 2 - unavailable;  3 - expired; 4 - transferred
-    std::string ListFilterAcceptTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "") const;   // 0 - all, 1 - transferred; 2 - expired
-    std::string ListFilterTransferTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "") const; // 0 - all, 1 - available; 2 - transferred
-    std::string ListFilterActionTickets(const uint32_t nMinHeight, const short filter = 0) const; // 1 - active;    2 - inactive
+    UniValue ListFilterPastelIDTickets(const uint32_t nMinHeight, const short filter = 0, // 1 - mn;        2 - personal;     3 - mine
+                                          const pastelid_store_t* pmapIDs = nullptr, const tickets_list_page_t &page = {}) const;
+    UniValue ListFilterNFTTickets(const uint32_t nMinHeight, const short filter = 0, const tickets_list_page_t &page = {}) const;   // 1 - active;    2 - inactive;     3 - transferred
+    UniValue ListFilterNFTCollectionTickets(const uint32_t nMinHeight, const short filter = 0, const tickets_list_page_t &page = {}) const;   // 1 - active;    2 - inactive;
+    UniValue ListFilterActTickets(const uint32_t nMinHeight, const short filter = 0, const tickets_list_page_t &page = {}) const;   // 1 - available; 2 - transferred
+    UniValue ListFilterOfferTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "", const tickets_list_page_t &page = {}) const;  // 0 - all, 1 - available; 2 - unavailable;  3 - expired; 4 - transferred
+    UniValue ListFilterAcceptTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "", const tickets_list_page_t &page = {}) const;   // 0 - all, 1 - transferred; 2 - expired
+    UniValue ListFilterTransferTickets(const uint32_t nMinHeight, const short filter = 0, const std::string& pastelID = "", const tickets_list_page_t &page = {}) const; // 0 - all, 1 - available; 2 - transferred
+    UniValue ListFilterActionTickets(const uint32_t nMinHeight, const short filter = 0, const tickets_list_page_t &page = {}) const; // 1 - active;    2 - inactive
 
+    // get pre-parsed NFT registration ticket search attributes, builds them if missing
+    bool GetNFTSearchAttributes(const std::string& sRegTxId, CNFTSearchAttributes& attrs) const;
     // search for NFT registration tickets, calls functor for each matching ticket
     void SearchForNFTs(const search_thumbids_t &p, std::function<size_t(const CPastelTicket *, const nlohmann::json &)> &fnMatchFound) const;
 
@@ -198,7 +349,16 @@ public:
 
     // Get mempool tracker for ticket transactions
     static std::shared_ptr<ITxMemPoolTracker> GetTxMemPoolTracker();
+    // Get cache of the decoded tickets
+    static CTicketCache& GetTicketCache() noexcept;
 
 private:
     static ticket_validation_t ValidateTicketFees(const uint32_t nHeight, const CTransaction& tx, std::unique_ptr<CPastelTicket>&& ticket) noexcept;
+    // build block height index for the existing ticket DB
+    void BuildHeightIndex(const TicketID id);
+    // convert MV keys stored as vectors of primary keys to MV key rows
+    void BuildMVKeyIndex(const TicketID id);
+    // process fixed-length "<prefix><height><txid>" index keys starting from sSeekKey
+    void ProcessKeysByPrefix(const TicketID id, const std::string& sSeekKey, const size_t nPrefixSize,
+        const std::function<bool(std::string&&, const std::string&, const uint32_t)>& fnKey) const;
 };
@@ -9,6 +9,7 @@ using namespace std;
 /**
  * Handle notification: transaction was added to the local memory pool.
  * Add txid to a local map if it is recognized as a ticket P2FMS transaction.
+ * Ticket is parsed here once and indexed by its keys.
  * 
  * \param entry - transaction memory pool entry
  */
@@ -18,13 +19,100 @@ void CTicketTxMemPoolTracker::processTransaction(const CTxMemPoolEntry& entry, [
     TicketID ticket_id;
     string error;
     const auto& tx = entry.GetTx();
+    const uint256& txid = tx.GetHash();
     if (!CPastelTicketProcessor::preParseTicket(tx, data_stream, ticket_id, error))
         return;
+
+    mempool_ticket_t mpTicket;
+    mpTicket.id = ticket_id;
+    auto ticket = CPastelTicketProcessor::CreateTicket(ticket_id);
+    if (ticket)
+    {
+        try
+        {
+            // deserialize ticket
+            data_stream >> *ticket;
+            // set additional ticket transaction data
+            ticket->SetTxId(txid.ToString());
+            ticket->SetBlock(entry.GetHeight());
+
+            auto& vKeys = mpTicket.vKeys;
+            vKeys[to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::KEY_ONE)] = ticket->KeyOne();
+            if (ticket->HasKeyTwo())
+                vKeys[to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::KEY_TWO)] = ticket->KeyTwo();
+            if (ticket->HasMVKeyOne())
+                vKeys[to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::MVKEY_ONE)] = ticket->MVKeyOne();
+            if (ticket->HasMVKeyTwo())
+                vKeys[to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::MVKEY_TWO)] = ticket->MVKeyTwo();
+            if (ticket->HasMVKeyThree())
+                vKeys[to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::MVKEY_THREE)] = ticket->MVKeyThree();
+            mpTicket.ticket = move(ticket);
+        } catch (const exception& e) {
+            LogPrint("mempool", "Failed to deserialize '%s' ticket from P2FMS transaction '%s'. %s\n",
+                GetTicketDescription(ticket_id), txid.ToString(), e.what());
+        }
+    } else
+        LogPrint("mempool", "P2FMS transaction '%s': unknown ticket id %hhu\n",
+            txid.ToString(), to_integral_type<TicketID>(ticket_id));
     {
         unique_lock lock(m_rwlock);
-        m_mapTicket.emplace(ticket_id, tx.GetHash());
-        m_mapTxid.emplace(tx.GetHash(), ticket_id);
+        m_mapTicket.emplace(ticket_id, txid);
+        m_mapTxid.emplace(txid, ticket_id);
+        if (mpTicket.ticket)
+            indexTicket(txid, move(mpTicket));
+    }
+}
+
+/**
+ * Add parsed ticket to the key indexes.
+ * Should be called with m_rwlock held.
+ * 
+ * \param txid - ticket transaction hash
+ * \param mpTicket - parsed ticket and its keys
+ */
+void CTicketTxMemPoolTracker::indexTicket(const uint256& txid, mempool_ticket_t&& mpTicket)
+{
+    auto& keyIndexes = m_mapKeyIndex[mpTicket.id];
+    for (size_t i = 0; i < TICKET_KEY_TYPE_COUNT; ++i)
+    {
+        if (!mpTicket.vKeys[i].empty())
+            keyIndexes[i].emplace(mpTicket.vKeys[i], txid);
     }
+    m_mapParsedTicket[txid] = move(mpTicket);
+}
+
+/**
+ * Remove parsed ticket from the key indexes.
+ * Should be called with m_rwlock held.
+ * 
+ * \param txid - ticket transaction hash
+ */
+void CTicketTxMemPoolTracker::unindexTicket(const uint256& txid)
+{
+    const auto itParsed = m_mapParsedTicket.find(txid);
+    if (itParsed == m_mapParsedTicket.end())
+        return;
+    const auto& mpTicket = itParsed->second;
+    auto itIndex = m_mapKeyIndex.find(mpTicket.id);
+    if (itIndex != m_mapKeyIndex.end())
+    {
+        for (size_t i = 0; i < TICKET_KEY_TYPE_COUNT; ++i)
+        {
+            if (mpTicket.vKeys[i].empty())
+                continue;
+            auto& keyIndex = itIndex->second[i];
+            const auto range = keyIndex.equal_range(mpTicket.vKeys[i]);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == txid)
+                {
+                    keyIndex.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+    m_mapParsedTicket.erase(itParsed);
 }
 
 /**
@@ -46,6 +134,7 @@ void CTicketTxMemPoolTracker::removeTx(const uint256& txid)
         if (toEraseIt != m_mapTicket.end())
             m_mapTicket.erase(toEraseIt);
         m_mapTxid.erase(itTx);
+        unindexTicket(txid);
     }
 }
 
@@ -81,3 +170,72 @@ size_t CTicketTxMemPoolTracker::count(const TicketID ticket_id) const noexcept
     shared_lock rlock(m_rwlock);
     return m_mapTicket.count(ticket_id);
 }
+
+/**
+ * Check if ticket with the given key exists in the mempool.
+ * 
+ * \param ticket_id - Pastel ticket id
+ * \param keyType - ticket key type
+ * \param sKey - ticket key value
+ * \return true if the ticket was found
+ */
+bool CTicketTxMemPoolTracker::ticketExists(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const string& sKey) const noexcept
+{
+    shared_lock rlock(m_rwlock);
+    const auto it = m_mapKeyIndex.find(ticket_id);
+    if (it == m_mapKeyIndex.cend())
+        return false;
+    return it->second[to_integral_type<TICKET_KEY_TYPE>(keyType)].count(sKey) > 0;
+}
+
+/**
+ * Find first ticket in the mempool by the given key.
+ * 
+ * \param ticket_id - Pastel ticket id
+ * \param keyType - ticket key type
+ * \param sKey - ticket key value
+ * \return parsed ticket or nullptr if not found
+ */
+mempool_ticket_ptr_t CTicketTxMemPoolTracker::findTicket(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const string& sKey) const noexcept
+{
+    shared_lock rlock(m_rwlock);
+    const auto it = m_mapKeyIndex.find(ticket_id);
+    if (it == m_mapKeyIndex.cend())
+        return nullptr;
+    const auto& keyIndex = it->second[to_integral_type<TICKET_KEY_TYPE>(keyType)];
+    const auto itKey = keyIndex.find(sKey);
+    if (itKey == keyIndex.cend())
+        return nullptr;
+    const auto itParsed = m_mapParsedTicket.find(itKey->second);
+    if (itParsed == m_mapParsedTicket.cend())
+        return nullptr;
+    return itParsed->second.ticket;
+}
+
+/**
+ * Find all tickets in the mempool by the given key.
+ * 
+ * \param ticket_id - Pastel ticket id
+ * \param keyType - ticket key type
+ * \param sKey - ticket key value
+ * \param vTickets - found tickets are added to this vector
+ * \return number of tickets found
+ */
+size_t CTicketTxMemPoolTracker::findTickets(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const string& sKey, mempool_tickets_t& vTickets) const noexcept
+{
+    size_t nCount = 0;
+    shared_lock rlock(m_rwlock);
+    const auto it = m_mapKeyIndex.find(ticket_id);
+    if (it == m_mapKeyIndex.cend())
+        return 0;
+    const auto range = it->second[to_integral_type<TICKET_KEY_TYPE>(keyType)].equal_range(sKey);
+    for (auto itKey = range.first; itKey != range.second; ++itKey)
+    {
+        const auto itParsed = m_mapParsedTicket.find(itKey->second);
+        if (itParsed == m_mapParsedTicket.cend())
+            continue;
+        vTickets.push_back(itParsed->second.ticket);
+        ++nCount;
+    }
+    return nCount;
+}
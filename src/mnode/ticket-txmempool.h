@@ -2,17 +2,39 @@
 // Copyright (c) 2021 The Pastel Core developers
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <array>
+#include <memory>
 #include <shared_mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "txmempool_entry.h"
 #include <mnode/tickets/ticket.h>
 #include <mnode/tickets/ticket-types.h>
 
+// ticket keys indexed by the mempool tracker
+typedef enum class _TICKET_KEY_TYPE : uint8_t
+{
+    KEY_ONE = 0,   // primary key
+    KEY_TWO,       // secondary key
+    MVKEY_ONE,     // multi-value keys
+    MVKEY_TWO,
+    MVKEY_THREE,
+    COUNT
+} TICKET_KEY_TYPE;
+
+constexpr size_t TICKET_KEY_TYPE_COUNT = to_integral_type<TICKET_KEY_TYPE>(TICKET_KEY_TYPE::COUNT);
+
+// parsed tickets from the memory pool
+using mempool_ticket_ptr_t = std::shared_ptr<const CPastelTicket>;
+using mempool_tickets_t = std::vector<mempool_ticket_ptr_t>;
+
 /**
  * Track P2FMS transactions with Pastel Tickets accepted to the local memory pool.
- * 
+ * Each ticket is parsed only once - when the transaction is added to the mempool,
+ * parsed tickets are indexed by ticket type and ticket keys.
  */
 class CTicketTxMemPoolTracker : public ITxMemPoolTracker
 {
@@ -30,13 +52,39 @@ public:
     // get number of ticket transactions in mempool by ticket id
     virtual size_t count(const TicketID ticket_id) const noexcept;
 
+    // check if ticket with the given key exists in the mempool
+    bool ticketExists(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const std::string& sKey) const noexcept;
+    // find first ticket by the given key
+    mempool_ticket_ptr_t findTicket(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const std::string& sKey) const noexcept;
+    // find all tickets by the given key
+    size_t findTickets(const TicketID ticket_id, const TICKET_KEY_TYPE keyType, const std::string& sKey, mempool_tickets_t& vTickets) const noexcept;
+
 protected:
     using mempool_txidmap_t = std::unordered_map<uint256, TicketID>;
     using mempool_ticketidmap_t = std::unordered_multimap<TicketID, uint256>;
+    // ticket key -> txid
+    using mempool_keyindex_t = std::unordered_multimap<std::string, uint256>;
+    using mempool_keyindexes_t = std::array<mempool_keyindex_t, TICKET_KEY_TYPE_COUNT>;
+
+    // parsed ticket and its indexed keys
+    typedef struct _mempool_ticket_t
+    {
+        TicketID id;
+        mempool_ticket_ptr_t ticket;
+        std::array<std::string, TICKET_KEY_TYPE_COUNT> vKeys;
+    } mempool_ticket_t;
+
+    // add/remove parsed ticket to/from the key indexes, should be called with m_rwlock held
+    void indexTicket(const uint256& txid, mempool_ticket_t&& ticket);
+    void unindexTicket(const uint256& txid);
     // read-write lock to protect access to maps
     mutable std::shared_mutex m_rwlock;
     // map of ticket transactions accepted into the local mempool: ticket id -> txid
     mempool_ticketidmap_t m_mapTicket;
     // map of txid -> ticketm_mapTicket id
     mempool_txidmap_t m_mapTxid;
+    // map of txid -> parsed ticket
+    std::unordered_map<uint256, mempool_ticket_t> m_mapParsedTicket;
+    // ticket key indexes by ticket id
+    std::unordered_map<TicketID, mempool_keyindexes_t> m_mapKeyIndex;
 };
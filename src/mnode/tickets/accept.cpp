@@ -174,7 +174,7 @@ ticket_validation_t CAcceptTicket::IsValid(const bool bPreReg, const uint32_t nC
     return tv;
 }
 
-string CAcceptTicket::ToJSON() const noexcept
+json CAcceptTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -191,7 +191,7 @@ string CAcceptTicket::ToJSON() const noexcept
             }
         }
     };
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CAcceptTicket::FindTicketInDb(const string& key, CAcceptTicket& ticket)
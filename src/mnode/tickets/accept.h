@@ -65,7 +65,7 @@ public:
     // get ticket price in PSL (1% from price)
     CAmount TicketPricePSL(const uint32_t nHeight) const noexcept override { return std::max<CAmount>(10, price / 100); }
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override;
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
     bool IsSameSignature(const v_uint8& signature) const noexcept { return m_signature == signature; }
@@ -41,7 +41,7 @@ void CActionActivateTicket::Clear() noexcept
     m_signature.clear();
 }
 
-string CActionActivateTicket::ToJSON() const noexcept
+json CActionActivateTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -59,7 +59,7 @@ string CActionActivateTicket::ToJSON() const noexcept
             }
         }
     };
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 string CActionActivateTicket::ToStr() const noexcept
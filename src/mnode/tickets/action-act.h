@@ -57,7 +57,7 @@ public:
     bool HasMVKeyTwo() const noexcept override { return true; }
     void SetKeyOne(std::string && sValue) override { m_regTicketTxId = std::move(sValue); }
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override;
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
     CAmount GetStorageFee() const noexcept override { return m_storageFee; }
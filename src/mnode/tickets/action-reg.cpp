@@ -147,7 +147,7 @@ bool CActionRegTicket::SetActionType(const string& sActionType)
  * 
  * \return json string
  */
-string CActionRegTicket::ToJSON() const noexcept
+json CActionRegTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -168,7 +168,7 @@ string CActionRegTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 /**
@@ -102,7 +102,7 @@ public:
     void SetKeyOne(std::string &&sValue) override { m_keyOne = std::move(sValue); }
     void GenerateKeyOne() override;
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override { return m_sActionTicket; }
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
     // check if sPastelID belongs to the action caller
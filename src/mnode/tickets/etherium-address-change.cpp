@@ -17,7 +17,7 @@ using json = nlohmann::json;
 using namespace std;
 
 // CChangeEthereumAddressTicket ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-string CChangeEthereumAddressTicket::ToJSON() const noexcept
+json CChangeEthereumAddressTicket::getJSON() const noexcept
 {
     const json jsonObj = 
     {
@@ -34,7 +34,7 @@ string CChangeEthereumAddressTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 string CChangeEthereumAddressTicket::ToStr() const noexcept
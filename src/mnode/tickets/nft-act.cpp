@@ -179,7 +179,7 @@ CAmount CNFTActivateTicket::GetExtraOutputs(vector<CTxOut>& outputs) const
     return nAllAmount;
 }
 
-string CNFTActivateTicket::ToJSON() const noexcept
+json CNFTActivateTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -198,7 +198,7 @@ string CNFTActivateTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CNFTActivateTicket::FindTicketInDb(const string& key, CNFTActivateTicket& ticket)
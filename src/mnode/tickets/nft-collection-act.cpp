@@ -180,7 +180,7 @@ CAmount CNFTCollectionActivateTicket::GetExtraOutputs(vector<CTxOut>& outputs) c
     return nAllAmount;
 }
 
-string CNFTCollectionActivateTicket::ToJSON() const noexcept
+json CNFTCollectionActivateTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -199,7 +199,7 @@ string CNFTCollectionActivateTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CNFTCollectionActivateTicket::FindTicketInDb(const string& key, CNFTCollectionActivateTicket& ticket)
@@ -331,7 +331,7 @@ void CNFTCollectionRegTicket::Clear() noexcept
 * 
 * \return json string
 */
-string CNFTCollectionRegTicket::ToJSON() const noexcept
+json CNFTCollectionRegTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -358,7 +358,7 @@ string CNFTCollectionRegTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 /**
@@ -94,7 +94,7 @@ public:
     std::string MVKeyOne() const noexcept override { return getCreatorPastelId(); }
     std::string MVKeyTwo() const noexcept override { return m_label; }
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override { return m_sNFTCollectionTicket; }
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
     // check if this user is in the permitted list
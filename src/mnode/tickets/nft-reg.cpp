@@ -449,7 +449,7 @@ void CNFTRegTicket::Clear() noexcept
  * 
  * \return json string
  */
-string CNFTRegTicket::ToJSON() const noexcept
+json CNFTRegTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -473,7 +473,7 @@ string CNFTRegTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 /**
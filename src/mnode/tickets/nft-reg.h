@@ -110,7 +110,7 @@ public:
     std::string MVKeyTwo() const noexcept override { return m_sNFTCollectionTxid; }
     std::string MVKeyThree() const noexcept override { return m_label; }
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override { return m_sNFTTicket; }
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
 
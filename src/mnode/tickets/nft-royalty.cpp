@@ -198,7 +198,7 @@ ticket_validation_t CNFTRoyaltyTicket::IsValid(const bool bPreReg, const uint32_
     return tv;
 }
 
-string CNFTRoyaltyTicket::ToJSON() const noexcept
+json CNFTRoyaltyTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -215,7 +215,7 @@ string CNFTRoyaltyTicket::ToJSON() const noexcept
             }
         }
     };
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CNFTRoyaltyTicket::FindTicketInDb(const string& key, CNFTRoyaltyTicket& ticket)
@@ -24,7 +24,7 @@ public:
         return TICKET_INFO[to_integral_type<TicketID>(TicketID::Down)].szDescription;
     }
 
-    std::string ToJSON() const noexcept override { return "{}"; }
+    nlohmann::json getJSON() const noexcept override { return nlohmann::json::object(); }
     std::string ToStr() const noexcept override { return ""; }
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override
     {
@@ -414,7 +414,7 @@ ticket_validation_t COfferTicket::IsValid(const bool bPreReg, const uint32_t nCa
     return tv;
 }
 
-string COfferTicket::ToJSON() const noexcept
+json COfferTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -435,7 +435,7 @@ string COfferTicket::ToJSON() const noexcept
             }
         }
     };
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool COfferTicket::FindTicketInDb(const string& key, COfferTicket& ticket)
@@ -1,6 +1,11 @@
 // Copyright (c) 2018-2022 The Pastel Core Developers
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include <json/json.hpp>
 
 #include <key_io.h>
@@ -15,6 +20,65 @@
 using json = nlohmann::json;
 using namespace std;
 
+namespace
+{
+
+// max number of entries in the Pastel ID registration ticket validity cache
+constexpr size_t PASTELID_VALIDITY_CACHE_MAX_ENTRIES = 50'000;
+
+/**
+ * Cache of the valid fully confirmed Pastel ID registration tickets.
+ * Validity of the Pastel ID registration ticket stored in the ticket DB
+ * (older than MinTicketConfirmations blocks) does not change - MN checks are skipped
+ * for such tickets and the Pastel ID signature is deterministic.
+ * Entries: ticket txid -> ticket block height.
+ * The key is safe across reorgs: the cached checks depend only on the ticket transaction
+ * data (identified by txid); if the ticket is disconnected and mined again at another height,
+ * the height does not match and the ticket is validated again.
+ * When the cache is full - the oldest entries are evicted (FIFO).
+ */
+class CPastelIDValidityCache
+{
+public:
+    bool IsValid(const string& sTxId, const uint32_t nBlock) const
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        const auto it = m_mapValid.find(sTxId);
+        return (it != m_mapValid.cend()) && (it->second == nBlock);
+    }
+
+    void SetValid(const string& sTxId, const uint32_t nBlock)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        const auto [it, bInserted] = m_mapValid.try_emplace(sTxId, nBlock);
+        if (!bInserted)
+        {
+            it->second = nBlock;
+            return;
+        }
+        m_InsertOrder.push_back(sTxId);
+        while (m_mapValid.size() > PASTELID_VALIDITY_CACHE_MAX_ENTRIES)
+        {
+            m_mapValid.erase(m_InsertOrder.front());
+            m_InsertOrder.pop_front();
+        }
+    }
+
+private:
+    mutable shared_mutex m_mutex;
+    unordered_map<string, uint32_t> m_mapValid;
+    // txids in insertion order, used to evict the oldest entries
+    deque<string> m_InsertOrder;
+};
+
+CPastelIDValidityCache& GetPastelIDValidityCache()
+{
+    static CPastelIDValidityCache validityCache;
+    return validityCache;
+}
+
+} // namespace
+
 // CPastelIDRegTicket ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Create Pastel ID registration ticket.
@@ -122,6 +186,25 @@ string CPastelIDRegTicket::ToStr() const noexcept
 ticket_validation_t CPastelIDRegTicket::IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept
 {
     ticket_validation_t tv;
+    // validity of the fully confirmed registration ticket does not change
+    bool bConfirmed = false;
+    if (!bPreReg && !m_txid.empty() && !IsBlock(0))
+    {
+        int nCurrentHeight;
+        {
+            LOCK(cs_main);
+            nCurrentHeight = chainActive.Height();
+        }
+        bConfirmed = (nCurrentHeight >= 0) && (static_cast<uint32_t>(nCurrentHeight) >= m_nBlock) &&
+            (static_cast<uint32_t>(nCurrentHeight) - m_nBlock >= masterNodeCtrl.MinTicketConfirmations);
+        if (bConfirmed && GetPastelIDValidityCache().IsValid(m_txid, m_nBlock))
+        {
+            tv.setValid();
+            return tv;
+        }
+    }
+    // MN Pastel ID ticket can be cached only if MN checks were done (blockchain and MNs are synced)
+    bool bCanCache = outpoint.IsNull();
     do
     {
         // Something to check ONLY before ticket made into transaction
@@ -206,6 +289,7 @@ ticket_validation_t CPastelIDRegTicket::IsValid(const bool bPreReg, const uint32
                     }
                 }
             }
+            bCanCache = true;
         }
 
         // Something to validate always
@@ -221,11 +305,13 @@ ticket_validation_t CPastelIDRegTicket::IsValid(const bool bPreReg, const uint32
         // 2. Ticket pay correct registration fee - is validated in ValidateIfTicketTransaction
 
         tv.setValid();
+        if (bConfirmed && bCanCache)
+            GetPastelIDValidityCache().SetValid(m_txid, m_nBlock);
     } while (false);
     return tv;
 }
 
-string CPastelIDRegTicket::ToJSON() const noexcept
+json CPastelIDRegTicket::getJSON() const noexcept
 {
     json jsonObj 
     {
@@ -248,7 +334,7 @@ string CPastelIDRegTicket::ToJSON() const noexcept
     if (!outpoint.IsNull())
         jsonObj["ticket"]["outpoint"] = outpoint.ToStringShort();
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CPastelIDRegTicket::FindTicketInDb(const string& key, CPastelIDRegTicket& ticket)
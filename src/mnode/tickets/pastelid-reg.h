@@ -71,7 +71,7 @@ public:
     bool HasKeyTwo() const noexcept override { return true; }
     void SetKeyOne(std::string&& sValue) override { pastelID = std::move(sValue); }
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override;
     void ToStrStream(std::stringstream& ss, const bool bIncludeMNsignature = true) const noexcept;
     ticket_validation_t IsValid(const bool bPreReg, const uint32_t nCallDepth) const noexcept override;
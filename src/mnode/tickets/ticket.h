@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include <json/json.hpp>
+
 #include <amount.h>
 #include <primitives/transaction.h>
 #include <mnode/tickets/ticket-types.h>
@@ -46,7 +48,9 @@ public:
     // get ticket type
     virtual TicketID ID() const noexcept = 0;
     // get json representation
-    virtual std::string ToJSON() const noexcept = 0;
+    virtual nlohmann::json getJSON() const noexcept = 0;
+    // get json representation as a formatted string
+    std::string ToJSON() const noexcept { return getJSON().dump(4); }
     virtual std::string ToStr() const noexcept = 0;
     /**
      * if preReg = true - validate pre-registration conditions.
@@ -2,10 +2,12 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 #include <unordered_map>
+#include <set>
 
 #include <str_utils.h>
 #include <serialize.h>
 #include <streams.h>
+#include <script_check.h>
 #include <pastelid/common.h>
 #include <mnode/tickets/pastelid-reg.h>
 #include <mnode/tickets/ticket_signing.h>
@@ -14,6 +16,25 @@
 using json = nlohmann::json;
 using namespace std;
 
+/**
+ * Verify one ticket signature.
+ * 
+ * \param sText - signed ticket text
+ * \param vSignature - signature to verify
+ * \param sPastelID - Pastel ID of the signer
+ * \return true if the signature is valid
+ */
+static bool VerifyTicketSignature(const string& sText, const v_uint8& vSignature, const string& sPastelID) noexcept
+{
+    try
+    {
+        return CPastelID::Verify(sText, vector_to_string(vSignature), sPastelID);
+    } catch (const exception& e) {
+        LogPrintf("Pastel ID [%s] signature verification failed. %s\n", sPastelID, e.what());
+    }
+    return false;
+}
+
 void CTicketSigning::clear_signatures() noexcept
 {
     for (size_t i = 0; i < SIGN_COUNT; ++i)
@@ -148,6 +169,9 @@ ticket_validation_t CTicketSigning::validate_signatures(const uint32_t nCallDept
     uint32_t nCurrentCallDepth = nCallDepth;
     unordered_map<string, int> pidCountMap;
     map<COutPoint, int> outCountMap{};
+    // outpoints of the top MNs for the block nCreatorHeight
+    set<COutPoint> setTopMNOutpoints;
+    bool bTopMNsLoaded = false;
     ticket_validation_t tv;
     tv.setValid();
 
@@ -209,13 +233,15 @@ ticket_validation_t CTicketSigning::validate_signatures(const uint32_t nCallDept
             // 4. Masternodes beyond these Pastel IDs, were in the top 10 at the block when the registration happened
             if (masterNodeCtrl.masternodeSync.IsSynced()) // ticket needs synced MNs
             {
-                auto topBlockMNs = masterNodeCtrl.masternodeManager.GetTopMNsForBlock(nCreatorHeight, true);
-                const auto foundIt = find_if(topBlockMNs.cbegin(), topBlockMNs.cend(), [&pastelIdRegTicket](CMasternode const& mn)
-                    {
-                        return mn.vin.prevout == pastelIdRegTicket.outpoint;
-                    });
-
-                if (foundIt == topBlockMNs.cend()) //not found
+                // top MNs list is calculated only once for all MN signers
+                if (!bTopMNsLoaded)
+                {
+                    const auto topBlockMNs = masterNodeCtrl.masternodeManager.GetTopMNsForBlock(nCreatorHeight, true);
+                    for (const auto& mn : topBlockMNs)
+                        setTopMNOutpoints.insert(mn.vin.prevout);
+                    bTopMNsLoaded = true;
+                }
+                if (!setTopMNOutpoints.count(pastelIdRegTicket.outpoint)) //not found
                 {
                     tv.state = TICKET_VALIDATION_STATE::INVALID;
                     tv.errorMsg = strprintf(
@@ -230,9 +256,23 @@ ticket_validation_t CTicketSigning::validate_signatures(const uint32_t nCallDept
         return tv;
 
     // 5. Signatures matches included Pastel IDs (signature verification is slower - hence separate loop)
+    // all signatures are verified in parallel on the shared validation check queue,
+    // invalid signature does not fail the whole batch - result is reported for each signer
+    array<bool, SIGN_COUNT> vIsValid {};
+    vector<CValidationCheck::check_func_t> vChecks;
+    vChecks.reserve(SIGN_COUNT);
+    for (auto mnIndex = SIGN_PRINCIPAL; mnIndex < SIGN_COUNT; ++mnIndex)
+    {
+        vChecks.emplace_back([&, mnIndex]()
+        {
+            vIsValid[mnIndex] = VerifyTicketSignature(sTicketToValidate, m_vTicketSignature[mnIndex], m_vPastelID[mnIndex]);
+            return true;
+        });
+    }
+    gl_ScriptCheckManager.RunChecks(vChecks);
     for (auto mnIndex = SIGN_PRINCIPAL; mnIndex < SIGN_COUNT; ++mnIndex)
     {
-        if (!CPastelID::Verify(sTicketToValidate, vector_to_string(m_vTicketSignature[mnIndex]), m_vPastelID[mnIndex]))
+        if (!vIsValid[mnIndex])
         {
             tv.state = TICKET_VALIDATION_STATE::INVALID;
             tv.errorMsg = strprintf(
@@ -479,7 +479,7 @@ CAmount CTransferTicket::GetExtraOutputs(vector<CTxOut>& outputs) const
     return nPriceAmount + nRoyaltyAmount + nGreenNFTAmount;
 }
 
-string CTransferTicket::ToJSON() const noexcept
+json CTransferTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -499,7 +499,7 @@ string CTransferTicket::ToJSON() const noexcept
             }
         }
     };
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 bool CTransferTicket::FindTicketInDb(const string& key, CTransferTicket& ticket)
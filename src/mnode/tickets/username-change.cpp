@@ -27,7 +27,7 @@ void CChangeUsernameTicket::set_signature(const std::string& sSignature)
 }
 
 // CChangeUsernameTicket ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-string CChangeUsernameTicket::ToJSON() const noexcept
+json CChangeUsernameTicket::getJSON() const noexcept
 {
     const json jsonObj
     {
@@ -44,7 +44,7 @@ string CChangeUsernameTicket::ToJSON() const noexcept
         }
     };
 
-    return jsonObj.dump(4);
+    return jsonObj;
 }
 
 string CChangeUsernameTicket::ToStr() const noexcept
@@ -80,7 +80,7 @@ ticket_validation_t CChangeUsernameTicket::IsValid(const bool bPreReg, const uin
     const auto chainHeight = GetActiveChainHeight();
 
     // initialize Pastel Ticket mempool processor for username-change tickets
-    // retrieve mempool transactions with TicketID::Username tickets
+    // (uses indexes of the parsed TicketID::Username tickets in the mempool)
     CPastelTicketMemPoolProcessor TktMemPool(ID());
     TktMemPool.Initialize(mempool);
 
@@ -64,7 +64,7 @@ public:
     void SetKeyOne(std::string&& sValue) override { username = std::move(sValue); }
     void set_signature(const std::string& signature);
 
-    std::string ToJSON() const noexcept override;
+    nlohmann::json getJSON() const noexcept override;
     std::string ToStr() const noexcept override;
     // get ticket price in PSL
     CAmount TicketPricePSL(const uint32_t nHeight) const noexcept override { return fee; }
@@ -86,6 +86,7 @@ map<CInv, CDataStream> mapRelay;
 deque<pair<int64_t, CInv> > vRelayExpiration;
 CCriticalSection cs_mapRelay;
 limitedmap<CInv, int64_t> mapAlreadyAskedFor(MAX_INV_SZ);
+CCriticalSection cs_mapAlreadyAskedFor;
 
 static deque<string> vOneShots;
 static CCriticalSection cs_vOneShots;
@@ -101,6 +102,7 @@ CCriticalSection cs_nLastNodeId;
 
 static CSemaphore* semOutbound = nullptr;
 static condition_variable messageHandlerCondition;
+static mutex messageHandlerMutex;
 
 // Signals for message handling
 static CNodeSignals g_signals;
@@ -670,7 +672,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes)
         if (msg.complete())
         {
             msg.nTime = GetTimeMicros();
-            messageHandlerCondition.notify_one();
+            messageHandlerCondition.notify_all();
         }
     }
 
@@ -769,6 +771,9 @@ void SocketSendData(CNode *pnode)
         assert(pnode->nSendSize == 0);
     }
     pnode->vSendMsg.erase(pnode->vSendMsg.begin(), it);
+    // send queue drained - socket should wait for receiving data again
+    if (pnode->vSendMsg.empty())
+        pnode->fSocketEventsChanged = true;
 }
 
 static list<CNode*> vNodesDisconnected;
@@ -967,7 +972,7 @@ static bool AttemptToEvictConnection(bool fPreferNewConnection) {
     return true;
 }
 
-static void AcceptConnection(const ListenSocket& hListenSocket)
+static void AcceptConnection(const ListenSocket& hListenSocket, const CSocketEventWaiter& socketWaiter)
 {
     struct sockaddr_storage sockaddr;
     socklen_t len = sizeof(sockaddr);
@@ -998,7 +1003,7 @@ static void AcceptConnection(const ListenSocket& hListenSocket)
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (!socketWaiter.IsSupportedSocket(hSocket))
     {
         LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
         CloseSocket(hSocket);
@@ -1051,8 +1056,103 @@ static void AcceptConnection(const ListenSocket& hListenSocket)
     }
 }
 
+/**
+ * Check if any of the given events occurred on the socket during the last wait.
+ *
+ * \param hSocket - socket handle
+ * \param nEvents - socket events to check (SOCKET_EVENT_xxx)
+ * \return true if any of the events occurred
+ */
+bool CSocketHandlerThread::HasSocketEvent(const SOCKET hSocket, const uint8_t nEvents) const noexcept
+{
+    const auto it = mapSocketEvents.find(hSocket);
+    if (it == mapSocketEvents.cend())
+        return false;
+    return (it->second & nEvents) != 0;
+}
+
+/**
+ * Update socket events registered for the node.
+ * Called only when the events may have changed: new node, send queue became
+ * empty or non-empty, receive buffer is full.
+ *
+ * \param pnode - node to update socket events for
+ */
+void CSocketHandlerThread::UpdateNodeSocketEvents(CNode* pnode)
+{
+    // Implement the following logic:
+    // * If there is data to send, wait for sending data. As this only
+    //   happens when optimistic write failed, we choose to first drain the
+    //   write buffer in this case before receiving more. This avoids
+    //   needlessly queueing received data, if the remote peer is not themselves
+    //   receiving data. This means properly utilizing TCP flow control signaling.
+    // * Otherwise, if there is no (complete) message in the receive buffer,
+    //   or there is space left in the buffer, wait for receiving data.
+    // * (if neither of the above applies, there is certainly one message
+    //   in the receiver buffer ready to be processed).
+    // Together, that means that at least one of the following is always possible,
+    // so we don't deadlock:
+    // * We send some data.
+    // * We wait for data to be received (and disconnect after timeout).
+    // * We process a message in the buffer (message handler thread).
+    // errors are always reported for the registered socket
+    uint8_t nEvents = 0;
+    bool bSend = false;
+    {
+        TRY_LOCK(pnode->cs_vSend, lockSend);
+        if (!lockSend)
+        {
+            // retry on the next iteration
+            pnode->fSocketEventsChanged = true;
+            return;
+        }
+        bSend = !pnode->vSendMsg.empty();
+    }
+    if (bSend)
+        nEvents = SOCKET_EVENT_SEND;
+    else
+    {
+        TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
+        if (!lockRecv)
+        {
+            pnode->fSocketEventsChanged = true;
+            return;
+        }
+        if (pnode->vRecvMsg.empty() || !pnode->vRecvMsg.front().complete() ||
+            pnode->GetTotalRecvSize() <= ReceiveFloodSize())
+            nEvents = SOCKET_EVENT_RECV;
+    }
+    if (!m_socketWaiter.SetSocketEvents(pnode->hSocket, pnode->id, nEvents))
+    {
+        pnode->fSocketEventsChanged = true;
+        return;
+    }
+    pnode->hRegisteredSocket = pnode->hSocket;
+    pnode->nSocketEvents = nEvents;
+}
+
+/**
+ * Remove node socket registration from the socket event waiter.
+ * Node socket can be already closed.
+ *
+ * \param pnode - node to remove socket registration for
+ */
+void CSocketHandlerThread::RemoveNodeSocket(CNode* pnode)
+{
+    if (pnode->hRegisteredSocket == INVALID_SOCKET)
+        return;
+    m_socketWaiter.RemoveSocket(pnode->hRegisteredSocket, pnode->id);
+    pnode->hRegisteredSocket = INVALID_SOCKET;
+    pnode->nSocketEvents = 0;
+}
+
 void CSocketHandlerThread::execute()
 {
+    // listen sockets are registered with negative owner ids to distinguish them from nodes
+    int64_t nListenSocketId = 0;
+    for (const auto& hListenSocket : vhListenSocket)
+        m_socketWaiter.SetSocketEvents(hListenSocket.socket, --nListenSocketId, SOCKET_EVENT_RECV);
+
     size_t nPrevNodeCount = 0;
     while (!shouldStop())
     {
@@ -1078,6 +1178,7 @@ void CSocketHandlerThread::execute()
                     pnode->grantOutbound.Release();
 
                     // close socket and cleanup
+                    RemoveNodeSocket(pnode);
                     pnode->CloseSocketDisconnect();
 
                     // hold in disconnected pool until all refs are released
@@ -1136,92 +1237,26 @@ void CSocketHandlerThread::execute()
         }
 
         //
-        // Find which sockets have data to receive
+        // Wait for events on the registered sockets
         //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        for (const auto& hListenSocket : vhListenSocket)
-        {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
-
-        {
-            LOCK(cs_vNodes);
-            for (auto pnode : vNodes)
-            {
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = max(hSocketMax, pnode->hSocket);
-                have_fds = true;
-
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signaling.
-                // * Otherwise, if there is no (complete) message in the receive buffer,
-                //   or there is space left in the buffer, select() for receiving data.
-                // * (if neither of the above applies, there is certainly one message
-                //   in the receiver buffer ready to be processed).
-                // Together, that means that at least one of the following is always possible,
-                // so we don't deadlock:
-                // * We send some data.
-                // * We wait for data to be received (and disconnect after timeout).
-                // * We process a message in the buffer (message handler thread).
-                {
-                    TRY_LOCK(pnode->cs_vSend, lockSend);
-                    if (lockSend && !pnode->vSendMsg.empty()) {
-                        FD_SET(pnode->hSocket, &fdsetSend);
-                        continue;
-                    }
-                }
-                {
-                    TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
-                    if (lockRecv && (
-                        pnode->vRecvMsg.empty() || !pnode->vRecvMsg.front().complete() ||
-                        pnode->GetTotalRecvSize() <= ReceiveFloodSize()))
-                        FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-                if (shouldStop())
-                    break;
-            }
-            if (shouldStop())
-                break;
-        }
+        constexpr uint32_t SOCKET_WAIT_TIMEOUT_MS = 50; // frequency to check registered socket events
 
-        int nSelect = select(have_fds ? static_cast<int>(hSocketMax + 1) : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+        string error;
+        const bool bWaitResult = m_socketWaiter.Wait(mapSocketEvents, SOCKET_WAIT_TIMEOUT_MS, error);
         if (shouldStop())
             break;
 
-        if (nSelect == SOCKET_ERROR)
+        if (!bWaitResult)
         {
-            if (have_fds)
+            if (!error.empty())
             {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
+                LogPrintf("%s\n", error);
+                // try to receive from all sockets
+                for (const auto& [hSocket, request] : m_socketWaiter.GetSockets())
+                    mapSocketEvents[hSocket] = SOCKET_EVENT_RECV;
             }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
             unique_lock<mutex> lck(m_mutex);
-            if (m_condVar.wait_for(lck, chrono::milliseconds(timeout.tv_usec / 1000)) == cv_status::no_timeout)
+            if (m_condVar.wait_for(lck, chrono::milliseconds(SOCKET_WAIT_TIMEOUT_MS)) == cv_status::no_timeout)
             {
                 if (shouldStop())
                     break;
@@ -1233,10 +1268,8 @@ void CSocketHandlerThread::execute()
         //
         for (const auto& hListenSocket : vhListenSocket)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
+            if (hListenSocket.socket != INVALID_SOCKET && HasSocketEvent(hListenSocket.socket, SOCKET_EVENT_RECV))
+                AcceptConnection(hListenSocket, m_socketWaiter);
             if (shouldStop())
                 break;
         }
@@ -1260,8 +1293,14 @@ void CSocketHandlerThread::execute()
             // Receive
             //
             if (pnode->hSocket == INVALID_SOCKET)
+            {
+                RemoveNodeSocket(pnode);
                 continue;
-            if (FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError))
+            }
+            // registered socket events should be updated (new node or send queue state changed)
+            bool bUpdateSocketEvents = pnode->fSocketEventsChanged.exchange(false) ||
+                !(pnode->nSocketEvents & (SOCKET_EVENT_RECV | SOCKET_EVENT_SEND));
+            if (HasSocketEvent(pnode->hSocket, SOCKET_EVENT_RECV | SOCKET_EVENT_ERROR))
             {
                 TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
                 if (lockRecv)
@@ -1274,6 +1313,9 @@ void CSocketHandlerThread::execute()
                         {
                             if (!pnode->ReceiveMsgBytes(pchBuf, nBytes))
                                 pnode->CloseSocketDisconnect();
+                            // receive buffer is full - stop waiting for receiving data
+                            else if (pnode->GetTotalRecvSize() > ReceiveFloodSize())
+                                bUpdateSocketEvents = true;
                             pnode->nLastRecv = GetTime();
                             pnode->nRecvBytes += nBytes;
                             pnode->RecordBytesRecv(nBytes);
@@ -1304,14 +1346,25 @@ void CSocketHandlerThread::execute()
             // Send
             //
             if (pnode->hSocket == INVALID_SOCKET)
+            {
+                RemoveNodeSocket(pnode);
                 continue;
-            if (FD_ISSET(pnode->hSocket, &fdsetSend))
+            }
+            if (HasSocketEvent(pnode->hSocket, SOCKET_EVENT_SEND))
             {
                 TRY_LOCK(pnode->cs_vSend, lockSend);
                 if (lockSend)
                     SocketSendData(pnode);
             }
 
+            //
+            // Update registered socket events
+            //
+            if (pnode->hSocket == INVALID_SOCKET)
+                RemoveNodeSocket(pnode);
+            else if (bUpdateSocketEvents || pnode->fSocketEventsChanged.exchange(false))
+                UpdateNodeSocketEvents(pnode);
+
             //
             // Inactivity checking
             //
@@ -1715,11 +1768,19 @@ bool OpenNetworkConnection(const CAddress& addrConnect, CSemaphoreGrant *grantOu
     return true;
 }
 
+/**
+ * Message handler thread.
+ * Several message handler threads can run in parallel (-msghandlerthreads).
+ * Each peer is owned by exactly one thread at a time, so messages from one peer
+ * are always processed in order, while independent peers are processed in parallel.
+ */
 class CMessageHandlerThread : public CStoppableServiceThread
 {
 public:
-    CMessageHandlerThread() : 
-        CStoppableServiceThread("msghand")
+    CMessageHandlerThread(const size_t nWorkerId, const size_t nWorkerCount) : 
+        CStoppableServiceThread(nWorkerId ? strprintf("msghand%zu", nWorkerId).c_str() : "msghand"),
+        m_nWorkerId(nWorkerId),
+        m_nWorkerCount(nWorkerCount)
     {}
 
     void execute() override
@@ -1729,8 +1790,6 @@ public:
         SetThreadPriority(THREAD_PRIORITY_BELOW_NORMAL);
         while (!shouldStop())
         {
-            unique_lock<mutex> lock(m_mutex);
-
             vector<CNode*> vNodesCopy;
             {
                 LOCK(cs_vNodes);
@@ -1741,16 +1800,25 @@ public:
 
             // Poll the connected nodes for messages
             CNode* pnodeTrickle = nullptr;
-            if (!vNodesCopy.empty())
-                pnodeTrickle = vNodesCopy[GetRand(vNodesCopy.size())];
+            const size_t nNodeCount = vNodesCopy.size();
+            if (nNodeCount)
+                pnodeTrickle = vNodesCopy[GetRand(nNodeCount)];
 
             bool fSleep = true;
 
-            for (auto pnode : vNodesCopy)
+            // each worker starts from its own offset to reduce contention between workers
+            const size_t nStartPos = nNodeCount ? (m_nWorkerId * nNodeCount / m_nWorkerCount) : 0;
+            for (size_t i = 0; i < nNodeCount; ++i)
             {
+                CNode* pnode = vNodesCopy[(nStartPos + i) % nNodeCount];
                 if (pnode->fDisconnect)
                     continue;
 
+                // take ownership of the node, skip it if it is processed by another worker
+                bool bOwned = false;
+                if (!pnode->fMsgHandlerOwned.compare_exchange_strong(bOwned, true))
+                    continue;
+
                 // Receive messages
                 {
                     TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
@@ -1767,14 +1835,14 @@ public:
                         }
                     }
                 }
-                if (shouldStop())
-                    break;
-                // Send messages
+                if (!shouldStop())
                 {
+                    // Send messages
                     TRY_LOCK(pnode->cs_vSend, lockSend);
                     if (lockSend)
                         g_signals.SendMessages(chainparams, pnode, pnode == pnodeTrickle || pnode->fWhitelisted);
                 }
+                pnode->fMsgHandlerOwned = false;
                 if (shouldStop())
                     break;
             }
@@ -1788,9 +1856,16 @@ public:
                 break;
 
             if (fSleep)
+            {
+                unique_lock<mutex> lock(messageHandlerMutex);
                 messageHandlerCondition.wait_for(lock, 100ms);
+            }
         }
     }
+
+private:
+    size_t m_nWorkerId;     // message handler worker id (0-based)
+    size_t m_nWorkerCount;  // total number of message handler workers
 };
 
 bool BindListenPort(const CService &addrBind, string& strError, bool fWhitelisted)
@@ -1991,7 +2066,11 @@ void StartNode(CServiceThreadGroup& threadGroup, CScheduler &scheduler)
     threadGroup.add_thread(make_shared<COpenConnectionsThread>());
 
     // Process messages
-    threadGroup.add_thread(make_shared<CMessageHandlerThread>());
+    const size_t nMsgHandlerThreads = static_cast<size_t>(max(1, min(static_cast<int>(GetArg("-msghandlerthreads", DEFAULT_MSGHANDLER_THREADS)), MAX_MSGHANDLER_THREADS)));
+    if (nMsgHandlerThreads > 1)
+        LogPrintf("Using %zu message handler threads\n", nMsgHandlerThreads);
+    for (size_t i = 0; i < nMsgHandlerThreads; ++i)
+        threadGroup.add_thread(make_shared<CMessageHandlerThread>(i, nMsgHandlerThreads));
 
     //MasterNode
     masterNodeCtrl.StartMasterNode(threadGroup);
@@ -2304,9 +2383,13 @@ CNode::CNode(SOCKET hSocketIn, const CAddress& addrIn, const std::string& addrNa
     fNetworkNode = fNetworkNodeIn;
     fSuccessfullyConnected = false;
     fDisconnect = false;
+    fMsgHandlerOwned = false;
     nRefCount = 0;
     nSendSize = 0;
     nSendOffset = 0;
+    fSocketEventsChanged = true;
+    hRegisteredSocket = INVALID_SOCKET;
+    nSocketEvents = 0;
     hashContinue = uint256();
     nStartingHeight = -1;
     fGetAddr = false;
@@ -2362,6 +2445,8 @@ void CNode::AskFor(const CInv& inv)
     // We're using mapAskFor as a priority queue,
     // the key is the earliest time the request can be sent
     int64_t nRequestTime;
+    // mapAlreadyAskedFor is shared by all message handler threads
+    LOCK(cs_mapAlreadyAskedFor);
     limitedmap<CInv, int64_t>::const_iterator it = mapAlreadyAskedFor.find(inv);
     if (it != mapAlreadyAskedFor.end())
         nRequestTime = it->second;
@@ -2434,13 +2519,19 @@ void CNode::EndMessage() UNLOCK_FUNCTION(cs_vSend)
 
     LogPrint("net", "sent: (%u bytes) peer=%d\n", nSize, id);
 
+    const bool bSendQueueWasEmpty = vSendMsg.empty();
     auto &msgData = vSendMsg.emplace_back();
     ssSend.GetAndClear(msgData);
     nSendSize += msgData.size();
 
     // If write queue empty, attempt "optimistic write"
-    if (msgData == vSendMsg.front())
+    if (bSendQueueWasEmpty)
+    {
         SocketSendData(this);
+        // optimistic write failed - socket should wait for sending data
+        if (!vSendMsg.empty())
+            fSocketEventsChanged = true;
+    }
 
     LEAVE_CRITICAL_SECTION(cs_vSend);
 }
@@ -5,6 +5,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
+#include <atomic>
 #include <deque>
 #include <stdint.h>
 
@@ -28,6 +29,7 @@
 #include <utilstrencodings.h>
 #include <chainparams.h>
 #include <svc_thread.h>
+#include <socket_events.h>
 
 class CAddrMan;
 class CBlockIndex;
@@ -54,6 +56,10 @@ static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
 static const size_t SETASKFOR_MAX_SZ = 2 * MAX_INV_SZ;
 /** The maximum number of peer connections to maintain. */
 static constexpr unsigned int DEFAULT_MAX_PEER_CONNECTIONS = 125;
+/** Default number of message handler threads (1 = single message handler thread). */
+constexpr int DEFAULT_MSGHANDLER_THREADS = 1;
+/** Maximum number of message handler threads. */
+constexpr int MAX_MSGHANDLER_THREADS = 16;
 // The period before a network upgrade activates, where connections to upgrading peers are preferred (in blocks).
 constexpr uint32_t MAINNET_NETWORK_UPGRADE_PEER_PREFERENCE_BLOCK_PERIOD = 24 * 24 * 3;
 constexpr uint32_t TESTNET_NETWORK_UPGRADE_PEER_PREFERENCE_BLOCK_PERIOD = 100;
@@ -152,6 +158,7 @@ extern std::map<CInv, CDataStream> mapRelay;
 extern std::deque<std::pair<int64_t, CInv> > vRelayExpiration;
 extern CCriticalSection cs_mapRelay;
 extern limitedmap<CInv, int64_t> mapAlreadyAskedFor;
+extern CCriticalSection cs_mapAlreadyAskedFor;
 
 extern std::vector<std::string> vAddedNodes;
 extern CCriticalSection cs_vAddedNodes;
@@ -245,6 +252,11 @@ public:
     uint64_t nSendBytes;
     std::deque<CSerializeData> vSendMsg;
     CCriticalSection cs_vSend;
+    // send queue became empty or non-empty - registered socket events should be updated
+    std::atomic_bool fSocketEventsChanged;
+    // socket and events registered in the socket event waiter (accessed only by the socket handler thread)
+    SOCKET hRegisteredSocket;
+    uint8_t nSocketEvents;
 
     std::deque<CInv> vRecvGetData;
     std::deque<CNetMessage> vRecvMsg;
@@ -272,6 +284,8 @@ public:
     bool fNetworkNode;
     bool fSuccessfullyConnected;
     bool fDisconnect;
+    // true if node is currently owned by one of the message handler threads
+    std::atomic_bool fMsgHandlerOwned;
     // We use fRelayTxes for two purposes -
     // a) it allows us to not relay tx invs before receiving the peer's version message
     // b) the peer may tell us in its version message that we should not relay tx invs
@@ -306,16 +320,18 @@ public:
     uint256 hashContinue;
     int nStartingHeight;
 
-    // flood relay
+    // flood relay, vAddrToSend and addrKnown are protected by cs_vAddr
+    CCriticalSection cs_vAddr;
     std::vector<CAddress> vAddrToSend;
     CRollingBloomFilter addrKnown;
     bool fGetAddr;
     std::set<uint256> setKnown;
 
-    // inventory based relay
+    // inventory based relay, setInventoryKnown and vInventoryToSend are protected by cs_inventory
     mruset<CInv> setInventoryKnown;
     std::vector<CInv> vInventoryToSend;
     CCriticalSection cs_inventory;
+    // accessed only by the message handler thread that owns the node (fMsgHandlerOwned)
     std::set<uint256> setAskFor;
     std::multimap<int64_t, CInv> mapAskFor;
 
@@ -391,6 +407,7 @@ public:
 
     void AddAddressKnown(const CAddress& addr)
     {
+        LOCK(cs_vAddr);
         addrKnown.insert(addr.GetKey());
     }
 
@@ -399,6 +416,7 @@ public:
         // Known checking here is only to save space from duplicates.
         // SendMessages will filter it again for knowns that were added
         // after addresses were pushed.
+        LOCK(cs_vAddr);
         if (addr.IsValid() && !addrKnown.contains(addr.GetKey())) {
             if (vAddrToSend.size() >= MAX_ADDR_TO_SEND) {
                 vAddrToSend[insecure_rand() % vAddrToSend.size()] = addr;
@@ -644,6 +662,16 @@ public:
     {}
 
     void execute() override;
+
+private:
+    // waits for socket events (epoll or select), keeps socket registrations between the waits
+    CSocketEventWaiter m_socketWaiter;
+    // socket events occurred in the current loop iteration
+    socket_events_t mapSocketEvents;
+
+    bool HasSocketEvent(const SOCKET hSocket, const uint8_t nEvents) const noexcept;
+    void UpdateNodeSocketEvents(CNode* pnode);
+    void RemoveNodeSocket(CNode* pnode);
 };
 
 
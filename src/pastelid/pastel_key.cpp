@@ -1,7 +1,15 @@
 // Copyright (c) 2018-2022 The Pastel Core developers
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#include <memory>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_set>
+
 #include <base58.h>
+#include <random.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
 #include <key_io.h>
 #include <str_utils.h>
 #include <pastelid/ed.h>
@@ -15,6 +23,222 @@ using namespace legroast;
 using namespace ed_crypto;
 using namespace secure_container;
 
+namespace
+{
+
+// max number of entries in the Pastel ID verified signature cache
+constexpr size_t PASTELID_SIG_CACHE_MAX_ENTRIES = 100'000;
+// max number of decoded Pastel ID public keys in the cache
+constexpr size_t PASTELID_PUBKEY_CACHE_MAX_ENTRIES = 10'000;
+
+class CPastelIDSigCacheHasher
+{
+public:
+    size_t operator()(const uint256& key) const noexcept
+    {
+        return key.GetCheapHash();
+    }
+};
+
+/**
+ * Valid Pastel ID signature cache, to avoid doing expensive EdDSA448 signature
+ * verification for the same ticket several times (mempool accept, block connect, reindex,
+ * trading chain walkback).
+ * Entries are SHA256(nonce || Pastel ID || text || signature) with a secret random nonce.
+ */
+class CPastelIDSignatureCache
+{
+public:
+    CPastelIDSignatureCache() :
+        m_nMaxEntries(PASTELID_SIG_CACHE_MAX_ENTRIES),
+        m_nHits(0),
+        m_nEvictions(0)
+    {
+        GetRandBytes(m_nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const string& sText, const string& sSignature, const string& sPastelID, const bool fBase64) const
+    {
+        unsigned char buf[8];
+        CSHA256 hasher;
+        hasher.Write(m_nonce.begin(), 32);
+        // length-prefixed fields to avoid ambiguity
+        for (const auto psField : { &sPastelID, &sText, &sSignature })
+        {
+            WriteLE64(buf, psField->size());
+            hasher.Write(buf, sizeof(buf)).Write(reinterpret_cast<const unsigned char*>(psField->data()), psField->size());
+        }
+        const unsigned char nFlags = fBase64 ? 1 : 0;
+        hasher.Write(&nFlags, 1).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry) const
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        if (m_setValid.count(entry) == 0)
+            return false;
+        ++m_nHits;
+        return true;
+    }
+
+    void Set(const uint256& entry)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        // evict entry from the bucket selected by the new entry hash if the cache is full
+        while (!m_setValid.empty() && (m_setValid.size() >= m_nMaxEntries))
+        {
+            const size_t nBucketCount = m_setValid.bucket_count();
+            const size_t nStartBucket = static_cast<size_t>(ReadLE64(entry.begin() + 16) % nBucketCount);
+            bool bEvicted = false;
+            for (size_t i = 0; i < nBucketCount; ++i)
+            {
+                const size_t nBucket = (nStartBucket + i) % nBucketCount;
+                auto it = m_setValid.begin(nBucket);
+                if (it != m_setValid.end(nBucket))
+                {
+                    m_setValid.erase(*it);
+                    ++m_nEvictions;
+                    bEvicted = true;
+                    break;
+                }
+            }
+            if (!bEvicted)
+                break;
+        }
+        m_setValid.insert(entry);
+    }
+
+    void GetStats(size_t& nEntries, uint64_t& nHits, uint64_t& nEvictions) const
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        nEntries = m_setValid.size();
+        nHits = m_nHits;
+        nEvictions = m_nEvictions;
+    }
+
+    void Reset(const size_t nMaxEntries)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        m_setValid.clear();
+        m_nMaxEntries = nMaxEntries ? nMaxEntries : PASTELID_SIG_CACHE_MAX_ENTRIES;
+        m_nHits = 0;
+        m_nEvictions = 0;
+    }
+
+private:
+    uint256 m_nonce;
+    mutable shared_mutex m_mutex;
+    unordered_set<uint256, CPastelIDSigCacheHasher> m_setValid;
+    size_t m_nMaxEntries;
+    // Get is called under the shared lock
+    mutable atomic_uint64_t m_nHits;
+    uint64_t m_nEvictions;
+};
+
+/**
+ * Cache of the decoded Pastel ID EdDSA448 public keys.
+ * Decoding Pastel ID and creating OpenSSL key object is done only once per Pastel ID.
+ */
+class CPastelIDPubKeyCache
+{
+public:
+    using key_ptr_t = shared_ptr<const key_dsa448>;
+
+    CPastelIDPubKeyCache() :
+        m_nMaxEntries(PASTELID_PUBKEY_CACHE_MAX_ENTRIES),
+        m_nHits(0),
+        m_nEvictions(0)
+    {}
+
+    key_ptr_t Get(const string& sPastelID) const
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        const auto it = m_mapKeys.find(sPastelID);
+        if (it == m_mapKeys.cend())
+            return nullptr;
+        ++m_nHits;
+        return it->second;
+    }
+
+    void Set(const string& sPastelID, const key_ptr_t& pKey)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        if (m_mapKeys.count(sPastelID))
+            return;
+        if (!m_mapKeys.empty() && (m_mapKeys.size() >= m_nMaxEntries))
+        {
+            m_mapKeys.erase(m_mapKeys.begin());
+            ++m_nEvictions;
+        }
+        m_mapKeys.emplace(sPastelID, pKey);
+    }
+
+    void GetStats(size_t& nEntries, uint64_t& nHits, uint64_t& nEvictions) const
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        nEntries = m_mapKeys.size();
+        nHits = m_nHits;
+        nEvictions = m_nEvictions;
+    }
+
+    void Reset(const size_t nMaxEntries)
+    {
+        unique_lock<shared_mutex> lock(m_mutex);
+        m_mapKeys.clear();
+        m_nMaxEntries = nMaxEntries ? nMaxEntries : PASTELID_PUBKEY_CACHE_MAX_ENTRIES;
+        m_nHits = 0;
+        m_nEvictions = 0;
+    }
+
+private:
+    mutable shared_mutex m_mutex;
+    unordered_map<string, key_ptr_t> m_mapKeys;
+    size_t m_nMaxEntries;
+    // Get is called under the shared lock
+    mutable atomic_uint64_t m_nHits;
+    uint64_t m_nEvictions;
+};
+
+CPastelIDSignatureCache& GetPastelIDSignatureCache()
+{
+    static CPastelIDSignatureCache sigCache;
+    return sigCache;
+}
+
+CPastelIDPubKeyCache& GetPastelIDPubKeyCache()
+{
+    static CPastelIDPubKeyCache pubKeyCache;
+    return pubKeyCache;
+}
+
+} // namespace
+
+/**
+* Get Pastel ID signature and public key cache statistics.
+* 
+* \return pastelid_cache_stats_t structure
+*/
+pastelid_cache_stats_t CPastelID::GetCacheStats()
+{
+    pastelid_cache_stats_t stats;
+    GetPastelIDSignatureCache().GetStats(stats.nSigEntries, stats.nSigHits, stats.nSigEvictions);
+    GetPastelIDPubKeyCache().GetStats(stats.nPubKeyEntries, stats.nPubKeyHits, stats.nPubKeyEvictions);
+    return stats;
+}
+
+/**
+* Clear Pastel ID signature and public key caches, reset statistics
+* and set max number of entries for both caches.
+* 
+* \param nMaxSigEntries - max number of cached verified signatures (0 - use default)
+* \param nMaxPubKeyEntries - max number of cached public keys (0 - use default)
+*/
+void CPastelID::ResetCaches(const size_t nMaxSigEntries, const size_t nMaxPubKeyEntries)
+{
+    GetPastelIDSignatureCache().Reset(nMaxSigEntries);
+    GetPastelIDPubKeyCache().Reset(nMaxPubKeyEntries);
+}
+
 /**
 * Generate new Pastel ID (EdDSA448) and LegRoast public/private key pairs.
 * Create new secure container to store all items associated with Pastel ID.
@@ -171,6 +395,7 @@ string CPastelID::Sign(const string& sText, const string& sPastelID, SecureStrin
 
 /**
 * Verify signature with the public key associated with Pastel ID.
+* Successfully verified EdDSA448 signatures and decoded public keys are cached.
 * 
 * \param sText - text to verify signature for
 * \param sSignature - signature in base64 format
@@ -189,15 +414,30 @@ bool CPastelID::Verify(const string& sText, const string& sSignature, const stri
         {
             case SIGN_ALGORITHM::ed448:
             {
-                v_uint8 vRawPubKey;
-                if (!DecodePastelID(sPastelID, vRawPubKey))
-                    return false;
+                // check if this signature was already verified
+                auto& sigCache = GetPastelIDSignatureCache();
+                uint256 entry;
+                sigCache.ComputeEntry(entry, sText, sSignature, sPastelID, fBase64);
+                if (sigCache.Get(entry))
+                    return true;
+
+                auto& pubKeyCache = GetPastelIDPubKeyCache();
+                auto pKey = pubKeyCache.Get(sPastelID);
+                if (!pKey)
+                {
+                    v_uint8 vRawPubKey;
+                    if (!DecodePastelID(sPastelID, vRawPubKey))
+                        return false;
+                    pKey = make_shared<const key_dsa448>(key_dsa448::create_from_raw_public(vRawPubKey.data(), vRawPubKey.size()));
+                    pubKeyCache.Set(sPastelID, pKey);
+                }
                 // use EdDSA448 public key to verify signature
-                auto key = ed_crypto::key_dsa448::create_from_raw_public(vRawPubKey.data(), vRawPubKey.size());
                 if (fBase64)
-                    bRet = ed_crypto::crypto_sign::verify_base64(sText, sSignature, key);
+                    bRet = ed_crypto::crypto_sign::verify_base64(sText, sSignature, *pKey);
                 else
-                    bRet = ed_crypto::crypto_sign::verify(sText, sSignature, key);
+                    bRet = ed_crypto::crypto_sign::verify(sText, sSignature, *pKey);
+                if (bRet)
+                    sigCache.Set(entry);
             } break;
 
             case SIGN_ALGORITHM::legroast:
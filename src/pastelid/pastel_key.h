@@ -16,6 +16,17 @@ using pastelid_store_t = mu_strings;
 constexpr auto SIGN_ALG_ED448 = "ed448";
 constexpr auto SIGN_ALG_LEGROAST = "legroast";
 
+// Pastel ID signature and public key cache statistics
+typedef struct _pastelid_cache_stats_t
+{
+    size_t nSigEntries = 0;         // number of cached verified signatures
+    uint64_t nSigHits = 0;          // number of signature cache hits
+    uint64_t nSigEvictions = 0;     // number of evicted signatures
+    size_t nPubKeyEntries = 0;      // number of cached decoded public keys
+    uint64_t nPubKeyHits = 0;       // number of public key cache hits
+    uint64_t nPubKeyEvictions = 0;  // number of evicted public keys
+} pastelid_cache_stats_t;
+
 class CPastelID
 {
     static constexpr size_t  PASTELID_PUBKEY_SIZE = 57;
@@ -49,6 +60,10 @@ public:
     static bool ChangePassphrase(std::string &error, const std::string& sPastelId, SecureString&& sOldPassphrase, SecureString&& sNewPassphrase);
     // read ed448 private key from PKCS8 file (olf format)
     static bool ProcessEd448_PastelKeyFile(std::string& error, const std::string& sFilePath, const SecureString& sOldPassPhrase, SecureString &&sNewPassPhrase);
+    // get signature and public key cache statistics
+    static pastelid_cache_stats_t GetCacheStats();
+    // clear signature and public key caches, set max number of entries (0 - default)
+    static void ResetCaches(const size_t nMaxSigEntries = 0, const size_t nMaxPubKeyEntries = 0);
 
 protected:
     // encode/decode PastelID
@@ -14,6 +14,7 @@
 #include "uint256.h"
 #include "util.h"
 #include "main.h"
+#include "script_check.h"
 #include "sodium.h"
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
@@ -130,6 +131,35 @@ bool CheckEquihashSolution(const CBlockHeader* pblock, const Consensus::Params&
     return true;
 }
 
+/**
+ * Check Equihash solutions of the block headers.
+ * Solutions are verified in parallel on the shared validation check queue.
+ * 
+ * \param vHeaders - block headers to check
+ * \param consensusParams - consensus parameters
+ * \param vValid - in: 1 for the headers with already verified Equihash solution (skipped),
+ *                 out: 1 for the headers with valid Equihash solution, 0 - otherwise
+ */
+void CheckEquihashSolutions(const std::vector<CBlockHeader>& vHeaders, const Consensus::Params& consensusParams, std::vector<uint8_t>& vValid)
+{
+    const size_t nCount = vHeaders.size();
+    vValid.resize(nCount, 0);
+    std::vector<CValidationCheck::check_func_t> vChecks;
+    vChecks.reserve(nCount);
+    for (size_t i = 0; i < nCount; ++i)
+    {
+        if (vValid[i])
+            continue;
+        // invalid solution does not fail the whole batch - result is reported for each header
+        vChecks.emplace_back([pHeader = &vHeaders[i], &consensusParams, pValid = &vValid[i]]()
+        {
+            *pValid = CheckEquihashSolution(pHeader, consensusParams) ? 1 : 0;
+            return true;
+        });
+    }
+    gl_ScriptCheckManager.RunChecks(vChecks);
+}
+
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params& params)
 {
     bool fNegative;
@@ -9,6 +9,7 @@
 #include "consensus/params.h"
 
 #include <stdint.h>
+#include <vector>
 
 class CBlockHeader;
 class CBlockIndex;
@@ -23,6 +24,9 @@ unsigned int CalculateNextWorkRequired(arith_uint256 bnAvg,
 
 /** Check whether the Equihash solution in a block header is valid */
 bool CheckEquihashSolution(const CBlockHeader *pblock, const Consensus::Params&);
+/** Check Equihash solutions of the block headers in parallel, vValid[i] is set to 1 if the i-th solution is valid,
+    headers with vValid[i] already set to 1 are skipped */
+void CheckEquihashSolutions(const std::vector<CBlockHeader>& vHeaders, const Consensus::Params&, std::vector<uint8_t>& vValid);
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
@@ -16,6 +16,7 @@
 #include <key_io.h>
 #include <main.h>
 #include <primitives/transaction.h>
+#include <script/sigcache.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <sync.h>
@@ -994,6 +995,9 @@ UniValue mempoolInfoToJSON()
     ret.pushKV("size", (int64_t) mempool.size());
     ret.pushKV("bytes", (int64_t) mempool.GetTotalTxSize());
     ret.pushKV("usage", (int64_t) mempool.DynamicMemoryUsage());
+    const size_t nMaxMempool = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    ret.pushKV("maxmempool", (int64_t) nMaxMempool);
+    ret.pushKV("mempoolminfee", ValueFromAmount(mempool.GetMinFee(nMaxMempool).GetFeePerK()));
 
     return ret;
 }
@@ -1011,6 +1015,8 @@ Result:
   "size": xxxxx                (numeric) Current tx count
   "bytes": xxxxx               (numeric) Sum of all tx sizes
   "usage": xxxxx               (numeric) Total memory usage for the mempool
+  "maxmempool": xxxxx          (numeric) Maximum memory usage for the mempool
+  "mempoolminfee": xxxxx       (numeric) Minimum fee rate in )" + CURRENCY_UNIT + R"(/kB for tx to be accepted
 }
 
 Examples:
@@ -1022,6 +1028,47 @@ Examples:
     return mempoolInfoToJSON();
 }
 
+UniValue getsigcacheinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+R"(getsigcacheinfo
+
+Returns details on the state of the signature cache.
+
+Result:
+{
+  "entries": xxxxx             (numeric) Current number of cached signatures
+  "max_entries": xxxxx         (numeric) Max number of cached signatures (-maxsigcachesize)
+  "usage": xxxxx               (numeric) Approximate memory usage of the signature cache
+  "shards": xxxxx              (numeric) Number of cache shards
+  "lookups": xxxxx             (numeric) Number of signature cache lookups
+  "hits": xxxxx                (numeric) Number of signature cache hits
+  "hit_rate": x.xxx            (numeric) Cache hit rate (hits / lookups)
+  "inserts": xxxxx             (numeric) Number of inserted signatures
+  "evictions": xxxxx           (numeric) Number of evicted signatures
+}
+
+Examples:
+)"
+            + HelpExampleCli("getsigcacheinfo", "")
+            + HelpExampleRpc("getsigcacheinfo", "")
+        );
+
+    const auto stats = GetSignatureCacheStats();
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("entries", static_cast<uint64_t>(stats.nEntries));
+    ret.pushKV("max_entries", static_cast<uint64_t>(stats.nMaxEntries));
+    ret.pushKV("usage", static_cast<uint64_t>(stats.nMemoryUsage));
+    ret.pushKV("shards", static_cast<uint64_t>(SIG_CACHE_SHARDS));
+    ret.pushKV("lookups", stats.nLookups);
+    ret.pushKV("hits", stats.nHits);
+    ret.pushKV("hit_rate", stats.nLookups ? static_cast<double>(stats.nHits) / stats.nLookups : 0.0);
+    ret.pushKV("inserts", stats.nInserts);
+    ret.pushKV("evictions", stats.nEvictions);
+    return ret;
+}
+
 UniValue invalidateblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -1284,6 +1331,63 @@ Examples:)"
 
     return blockToDeltasJSON(block, pblockindex);
 }
+
+// insightexplorer
+UniValue getblockhashes(const UniValue& params, bool fHelp)
+{
+    const string enableArg = "insightexplorer";
+    const bool enabled = fExperimentalMode && fInsightExplorer;
+    string disabledMsg;
+    if (!enabled)
+        disabledMsg = experimentalDisabledHelpMsg("getblockhashes", enableArg);
+    if (fHelp || params.size() != 2)
+        throw runtime_error(
+R"(getblockhashes high low
+
+Returns array of hashes of the active chain blocks within the timestamp range [low, high).)"
++ disabledMsg +
+R"(
+Arguments:
+1. high         (numeric, required) The newer block timestamp (exclusive)
+2. low          (numeric, required) The older block timestamp (inclusive)
+
+Result:
+[
+  "hash"         (string) The block hash
+]
+
+Examples:
+)"
+            + HelpExampleCli("getblockhashes", "1558141697 1558141576")
+            + HelpExampleRpc("getblockhashes", "1558141697, 1558141576")
+        );
+
+    if (!enabled)
+        throw JSONRPCError(RPC_MISC_ERROR, "Error: getblockhashes is disabled. "
+            "Run './pastel-cli help getblockhashes' for instructions on how to enable this feature.");
+
+    const int64_t nHigh = params[0].get_int64();
+    const int64_t nLow = params[1].get_int64();
+    if (nLow < 0 || nHigh <= nLow || nHigh > numeric_limits<unsigned int>::max())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid timestamp range");
+
+    v_uint256 vHashes;
+    if (!GetTimestampIndex(static_cast<unsigned int>(nHigh), static_cast<unsigned int>(nLow), vHashes))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
+
+    UniValue result(UniValue::VARR);
+    LOCK(cs_main);
+    for (const auto& hash : vHashes)
+    {
+        // timestamp index is not updated on disconnect - skip blocks that are not in the active chain
+        const auto it = mapBlockIndex.find(hash);
+        if (it == mapBlockIndex.cend() || !chainActive.Contains(it->second))
+            continue;
+        result.push_back(hash.GetHex());
+    }
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafeMode
   //  --------------------- ------------------------  -----------------------  ----------
@@ -1297,12 +1401,14 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getdifficulty",          &getdifficulty,          true  },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true  },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true  },
+    { "blockchain",         "getsigcacheinfo",        &getsigcacheinfo,        true  },
     { "blockchain",         "gettxout",               &gettxout,               true  },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true  },
     { "blockchain",         "verifychain",            &verifychain,            true  },
 
     // insightexplorer
-    { "blockchain",         "getblockdeltas",         &getblockdeltas,         false },    
+    { "blockchain",         "getblockdeltas",         &getblockdeltas,         false },
+    { "blockchain",         "getblockhashes",         &getblockhashes,         true  },
     
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        true  },
@@ -101,6 +101,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setban", 2 },
     { "setban", 3 },
     { "getaddressmempool", 0},
+    { "getaddressbalance", 0},
+    { "getaddressutxos", 0},
+    { "getaddresstxids", 0},
+    { "getblockhashes", 0},
+    { "getblockhashes", 1},
     { "getblockdeltas", 0},
     { "zcrawjoinsplit", 1 },
     { "zcrawjoinsplit", 2 },
@@ -132,6 +137,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "z_sendmanywithchangetosender", 3},
     { "z_shieldcoinbase", 2},
     { "z_shieldcoinbase", 3},
+    { "z_rescanwallet", 0},
     { "z_getoperationstatus", 0},
     { "z_getoperationresult", 0},
     { "z_importkey", 2 },
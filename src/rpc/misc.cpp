@@ -4,6 +4,8 @@
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
 #include <stdint.h>
+#include <set>
+#include <unordered_set>
 #include <variant>
 
 #include <univalue.h>
@@ -24,6 +26,7 @@
 #endif
 
 #include <zcash/Address.hpp>
+#include <mnode/ticket-processor.h>
 
 using namespace std;
 
@@ -509,6 +512,19 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCTicketCacheInfo()
+{
+    const auto stats = CPastelTicketProcessor::GetTicketCache().GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.nEntries));
+    obj.pushKV("usage", uint64_t(stats.nUsage));
+    obj.pushKV("max_usage", uint64_t(stats.nMaxSize));
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("misses", stats.nMisses);
+    obj.pushKV("evictions", stats.nEvictions);
+    return obj;
+}
+
 UniValue getmemoryinfo(const UniValue& params, bool fHelp)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -529,6 +545,14 @@ Result:
     "locked": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.
     "chunks_used": xxxxx,   (numeric) Number allocated chunks
     "chunks_free": xxxxx,   (numeric) Number unused chunks
+  },
+  "tickets": {              (json object) Information about decoded tickets cache
+    "entries": xxxxx,       (numeric) Number of cached tickets
+    "usage": xxxxx,         (numeric) Approximate memory usage in bytes
+    "max_usage": xxxxx,     (numeric) Max memory usage in bytes (-maxticketcachesize)
+    "hits": xxxxx,          (numeric) Number of ticket lookups served from the cache
+    "misses": xxxxx,        (numeric) Number of ticket lookups not found in the cache
+    "evictions": xxxxx,     (numeric) Number of tickets evicted from the cache
   }
 }
 
@@ -539,6 +563,7 @@ Examples:
 );
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("locked", RPCLockedMemoryInfo());
+    obj.pushKV("tickets", RPCTicketCacheInfo());
     return obj;
 }
 
@@ -695,6 +720,251 @@ Examples:)"
     }
     return result;
 }
+// insightexplorer
+static void checkAddressIndexEnabled(const char* szMethod, const bool fEnabled)
+{
+    if (!fEnabled)
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Error: %s is disabled. "
+            "Run './pastel-cli help %s' for instructions on how to enable this feature.", szMethod, szMethod));
+}
+
+// insightexplorer
+static const char* ADDRESSES_PARAM_HELP = R"(Arguments:
+{
+  addresses:
+    [
+      address   (string) The base58check encoded address
+      ,...
+    ]
+}
+(or)
+address   (string) The base58check encoded address
+)";
+
+UniValue getaddressbalance(const UniValue& params, bool fHelp)
+{
+    const bool fEnabled = fExperimentalMode && fInsightExplorer;
+    std::string disabledMsg;
+    if (!fEnabled)
+        disabledMsg = experimentalDisabledHelpMsg("getaddressbalance", "insightexplorer");
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+R"(getaddressbalance {addresses: [taddr, ...]}
+
+Returns the balance for addresses.)"
++ disabledMsg + ADDRESSES_PARAM_HELP +
+R"(
+Result:
+{
+  "balance"      (number) The current confirmed balance in patoshis
+  "received"     (number) The total confirmed number of patoshis received (including change)
+  "unconfirmed"  (number) The balance change in patoshis from the mempool transactions
+}
+
+Examples:)"
+            + HelpExampleCli("getaddressbalance", "'{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}'")
+            + HelpExampleRpc("getaddressbalance", "{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}")
+        );
+    checkAddressIndexEnabled("getaddressbalance", fEnabled);
+
+    std::vector<std::pair<uint160, CScript::ScriptType>> addresses;
+    if (!getAddressesFromParams(params, addresses))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    CAmount nBalance = 0;
+    CAmount nReceived = 0;
+    for (const auto& [addressHash, type] : addresses)
+    {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+        if (!GetAddressIndex(addressHash, type, vAddressIndex))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        for (const auto& [key, nValue] : vAddressIndex)
+        {
+            if (nValue > 0)
+                nReceived += nValue;
+            nBalance += nValue;
+        }
+    }
+    // merge balance changes from the mempool
+    CAmount nUnconfirmed = 0;
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> vMempoolDeltas;
+    mempool.getAddressIndex(addresses, vMempoolDeltas);
+    for (const auto& [key, delta] : vMempoolDeltas)
+        nUnconfirmed += delta.amount;
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", nBalance);
+    result.pushKV("received", nReceived);
+    result.pushKV("unconfirmed", nUnconfirmed);
+    return result;
+}
+
+UniValue getaddressutxos(const UniValue& params, bool fHelp)
+{
+    const bool fEnabled = fExperimentalMode && fInsightExplorer;
+    std::string disabledMsg;
+    if (!fEnabled)
+        disabledMsg = experimentalDisabledHelpMsg("getaddressutxos", "insightexplorer");
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+R"(getaddressutxos {addresses: [taddr, ...]}
+
+Returns all unspent outputs for addresses. Outputs spent by the mempool transactions are not returned.)"
++ disabledMsg + ADDRESSES_PARAM_HELP +
+R"(
+Result:
+[
+  {
+    "address"      (string) The address base58check encoded
+    "txid"         (string) The output txid
+    "outputIndex"  (number) The output index
+    "script"       (string) The script hex encoded
+    "patoshis"     (number) The number of patoshis of the output
+    "height"       (number) The block height
+  }
+]
+
+Examples:)"
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}'")
+            + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}")
+        );
+    checkAddressIndexEnabled("getaddressutxos", fEnabled);
+
+    std::vector<std::pair<uint160, CScript::ScriptType>> addresses;
+    if (!getAddressesFromParams(params, addresses))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> vUnspentOutputs;
+    for (const auto& [addressHash, type] : addresses)
+    {
+        if (!GetAddressUnspent(addressHash, type, vUnspentOutputs))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    }
+    std::sort(vUnspentOutputs.begin(), vUnspentOutputs.end(),
+        [](const std::pair<CAddressUnspentKey, CAddressUnspentValue>& a,
+           const std::pair<CAddressUnspentKey, CAddressUnspentValue>& b) -> bool {
+               return a.second.blockHeight < b.second.blockHeight;
+           });
+
+    UniValue result(UniValue::VARR);
+    for (const auto& [key, value] : vUnspentOutputs)
+    {
+        // skip outputs spent by the mempool transactions
+        CSpentIndexValue spentInfo;
+        if (mempool.getSpentIndex(CSpentIndexKey(key.txhash, static_cast<unsigned int>(key.index)), spentInfo))
+            continue;
+        std::string address;
+        if (!getAddressFromIndex(static_cast<CScript::ScriptType>(key.type), key.hashBytes, address))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+        UniValue output(UniValue::VOBJ);
+        output.pushKV("address", std::move(address));
+        output.pushKV("txid", key.txhash.GetHex());
+        output.pushKV("outputIndex", static_cast<int>(key.index));
+        output.pushKV("script", HexStr(value.script.begin(), value.script.end()));
+        output.pushKV("patoshis", value.patoshis);
+        output.pushKV("height", value.blockHeight);
+        result.push_back(std::move(output));
+    }
+    return result;
+}
+
+UniValue getaddresstxids(const UniValue& params, bool fHelp)
+{
+    const bool fEnabled = fExperimentalMode && fInsightExplorer;
+    std::string disabledMsg;
+    if (!fEnabled)
+        disabledMsg = experimentalDisabledHelpMsg("getaddresstxids", "insightexplorer");
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+R"(getaddresstxids {addresses: [taddr, ...], (start: n, end: n)}
+
+Returns the txids for addresses.
+If start and end heights are not specified, txids of the mempool transactions are appended to the result.)"
++ disabledMsg +
+R"(Arguments:
+{
+  addresses:
+    [
+      address   (string) The base58check encoded address
+      ,...
+    ]
+  start: n      (number, optional) The start block height
+  end: n        (number, optional) The end block height
+}
+(or)
+address   (string) The base58check encoded address
+
+Result:
+[
+  "transactionid"  (string) The transaction id
+  ,...
+]
+
+Examples:)"
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}'")
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"], \"start\": 1000, \"end\": 2000}'")
+            + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"tPp3pfmLi57S8qoccfWnn2o4tXyoQ23wVSp\"]}")
+        );
+    checkAddressIndexEnabled("getaddresstxids", fEnabled);
+
+    std::vector<std::pair<uint160, CScript::ScriptType>> addresses;
+    if (!getAddressesFromParams(params, addresses))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    int nStartHeight = 0;
+    int nEndHeight = 0;
+    if (params[0].isObject())
+    {
+        const UniValue startValue = find_value(params[0].get_obj(), "start");
+        const UniValue endValue = find_value(params[0].get_obj(), "end");
+        if (startValue.isNum() && endValue.isNum())
+        {
+            nStartHeight = startValue.get_int();
+            nEndHeight = endValue.get_int();
+            if (nStartHeight <= 0 || nEndHeight <= 0)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Start and end heights are expected to be greater than zero");
+            if (nEndHeight < nStartHeight)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "End height is expected to be greater than or equal to start height");
+        }
+    }
+
+    // txids sorted by height and index in the block
+    std::set<std::pair<std::pair<int, unsigned int>, uint256>> setTxids;
+    for (const auto& [addressHash, type] : addresses)
+    {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> vAddressIndex;
+        if (!GetAddressIndex(addressHash, type, vAddressIndex, nStartHeight, nEndHeight))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        for (const auto& [key, nValue] : vAddressIndex)
+            setTxids.emplace(std::make_pair(key.blockHeight, key.txindex), key.txhash);
+    }
+
+    UniValue result(UniValue::VARR);
+    std::unordered_set<uint256> setAdded;
+    for (const auto& [pos, txid] : setTxids)
+    {
+        if (setAdded.insert(txid).second)
+            result.push_back(txid.GetHex());
+    }
+    if (nStartHeight == 0 && nEndHeight == 0)
+    {
+        // merge mempool transactions, sorted by the time they entered the mempool
+        std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> vMempoolDeltas;
+        mempool.getAddressIndex(addresses, vMempoolDeltas);
+        std::sort(vMempoolDeltas.begin(), vMempoolDeltas.end(),
+            [](const std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>& a,
+               const std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>& b) -> bool {
+                   return a.second.time < b.second.time;
+               });
+        for (const auto& [key, delta] : vMempoolDeltas)
+        {
+            if (setAdded.insert(key.txhash).second)
+                result.push_back(key.txhash.GetHex());
+        }
+    }
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafeMode
   //  --------------------- ------------------------  -----------------------  ----------
@@ -707,6 +977,9 @@ static const CRPCCommand commands[] =
 
     /* Address index */
     { "addressindex",       "getaddressmempool",      &getaddressmempool,      true  }, /* insight explorer */
+    { "addressindex",       "getaddressbalance",      &getaddressbalance,      true  }, /* insight explorer */
+    { "addressindex",       "getaddressutxos",        &getaddressutxos,        true  }, /* insight explorer */
+    { "addressindex",       "getaddresstxids",        &getaddresstxids,        true  }, /* insight explorer */
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            true  },
@@ -0,0 +1,85 @@
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <sapling_check.h>
+#include <librustzcash.h>
+
+using namespace std;
+
+bool CSaplingProofCheck::SetError(const int nDoS, const char* szError, const char* szRejectReason)
+{
+    if (m_pResult)
+    {
+        m_pResult->bValid = false;
+        m_pResult->nDoS = nDoS;
+        m_pResult->sError = szError;
+        m_pResult->sRejectReason = szRejectReason;
+    }
+    return false;
+}
+
+/**
+ * Verify Sapling spend and output proofs and the binding signature of the transaction.
+ * 
+ * \return true if all proofs and the binding signature are valid
+ */
+bool CSaplingProofCheck::operator()()
+{
+    if (!m_ptx)
+        return true;
+    const auto& tx = *m_ptx;
+    auto ctx = librustzcash_sapling_verification_ctx_init();
+    bool bRet = true;
+    do
+    {
+        for (const auto &spend : tx.vShieldedSpend)
+        {
+            if (!librustzcash_sapling_check_spend(
+                ctx,
+                spend.cv.begin(),
+                spend.anchor.begin(),
+                spend.nullifier.begin(),
+                spend.rk.begin(),
+                spend.zkproof.data(),
+                spend.spendAuthSig.data(),
+                m_dataToBeSigned.begin()
+            ))
+            {
+                bRet = SetError(m_nDoSLevelRelaxing, "Sapling spend description invalid", "bad-txns-sapling-spend-description-invalid");
+                break;
+            }
+        }
+        if (!bRet)
+            break;
+
+        for (const auto &output : tx.vShieldedOutput)
+        {
+            if (!librustzcash_sapling_check_output(
+                ctx,
+                output.cv.begin(),
+                output.cm.begin(),
+                output.ephemeralKey.begin(),
+                output.zkproof.data()
+            ))
+            {
+                // This should be a non-contextual check, but we check it here
+                // as we need to pass over the outputs anyway in order to then
+                // call librustzcash_sapling_final_check().
+                bRet = SetError(m_nDoSLevelBlock, "Sapling output description invalid", "bad-txns-sapling-output-description-invalid");
+                break;
+            }
+        }
+        if (!bRet)
+            break;
+
+        if (!librustzcash_sapling_final_check(
+            ctx,
+            tx.valueBalance,
+            tx.bindingSig.data(),
+            m_dataToBeSigned.begin()
+        ))
+            bRet = SetError(m_nDoSLevelRelaxing, "Sapling binding signature invalid", "bad-txns-sapling-binding-signature-invalid");
+    } while (false);
+    librustzcash_sapling_verification_ctx_free(ctx);
+    return bRet;
+}
@@ -0,0 +1,47 @@
+#pragma once
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <string>
+
+#include <uint256.h>
+#include <primitives/transaction.h>
+
+// result of the Sapling proofs verification
+typedef struct _sapling_check_result_t
+{
+    bool bValid = true;        // true if all proofs and binding signature are valid
+    int nDoS = 0;              // DoS level for the invalid transaction
+    std::string sError;        // error message
+    std::string sRejectReason; // reject reason
+} sapling_check_result_t;
+
+/**
+ * Closure representing verification of the Sapling spend and output proofs 
+ * and binding signature of one transaction.
+ * Note that this stores references to the transaction and to the check result.
+ */
+class CSaplingProofCheck
+{
+public:
+    CSaplingProofCheck() = default;
+    CSaplingProofCheck(const CTransaction& tx, const uint256& dataToBeSigned, const int nDoSLevelBlock, const int nDoSLevelRelaxing) :
+        m_ptx(&tx),
+        m_dataToBeSigned(dataToBeSigned),
+        m_nDoSLevelBlock(nDoSLevelBlock),
+        m_nDoSLevelRelaxing(nDoSLevelRelaxing)
+    {}
+
+    bool operator()();
+
+    void SetResult(sapling_check_result_t* pResult) noexcept { m_pResult = pResult; }
+
+private:
+    const CTransaction* m_ptx = nullptr;
+    uint256 m_dataToBeSigned;
+    int m_nDoSLevelBlock = 0;     // DoS level for the invalid output description
+    int m_nDoSLevelRelaxing = 0;  // DoS level for the invalid spend description or binding signature
+    sapling_check_result_t* m_pResult = nullptr;
+
+    bool SetError(const int nDoS, const char* szError, const char* szRejectReason);
+};
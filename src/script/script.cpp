@@ -277,6 +277,16 @@ string CScript::ToString() const
     return str;
 }
 
+// insightexplorer
+CScript::ScriptType CScript::GetScriptType() const
+{
+    if (IsPayToPublicKeyHash())
+        return ScriptType::P2PKH;
+    if (IsPayToScriptHash())
+        return ScriptType::P2SH;
+    return ScriptType::UNKNOWN;
+}
+
 // insightexplorer
 uint160 CScript::AddressHash() const
 {
@@ -590,6 +590,7 @@ public:
     bool IsPayToScriptHash() const;
 
     uint160 AddressHash() const;
+    ScriptType GetScriptType() const;
 
     /** Called by IsStandardTx and P2SH/BIP62 VerifyScript (which makes it consensus-critical). */
     bool IsPushOnly() const;
@@ -3,10 +3,13 @@
 // Copyright (c) 2018-2022 The Pastel Core developers
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <array>
+#include <atomic>
 #include <unordered_set>
 #include <shared_mutex>
 
 #include <script/sigcache.h>
+#include <crypto/common.h>
 #include <memusage.h>
 #include <pubkey.h>
 #include <random.h>
@@ -32,21 +35,89 @@ public:
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
+ * again when accepted into the block chain).
+ * Cache is split into SIG_CACHE_SHARDS shards, each shard is protected by its own lock,
+ * so the script check workers do not serialize on one lock.
+ * Max number of entries is calculated once from -maxsigcachesize.
  */
 class CSignatureCache
 {
 private:
-     //! Entries are SHA256(nonce || signature hash || public key || signature):
-    uint256 nonce;
     typedef std::unordered_set<uint256, CSignatureCacheHasher> map_type;
-    map_type setValid;
-    shared_mutex cs_sigcache;
+
+    // shard is aligned to the cache line, so the per-shard lock and counters
+    // of the different shards do not share cache lines
+    struct alignas(64) CacheShard
+    {
+        shared_mutex cs;
+        map_type setValid;
+
+        // statistics, summed over all shards in GetStats
+        atomic_uint64_t nLookups{0};
+        atomic_uint64_t nHits{0};
+        atomic_uint64_t nInserts{0};
+        atomic_uint64_t nEvictions{0};
+    };
+
+    //! Entries are SHA256(nonce || signature hash || public key || signature):
+    uint256 nonce;
+    array<CacheShard, SIG_CACHE_SHARDS> m_shards;
+    atomic_size_t m_nMaxShardEntries;
+
+    // entries are uniformly distributed, use the last byte to select the shard
+    CacheShard& GetShard(const uint256& entry) noexcept
+    {
+        return m_shards[entry.begin()[31] % SIG_CACHE_SHARDS];
+    }
+
+    // estimated memory usage of one cache entry
+    static size_t GetEntryUsage() noexcept
+    {
+        return memusage::MallocUsage(sizeof(memusage::stl_unordered_node<uint256>)) + sizeof(void*);
+    }
+
+    /**
+     * Insert entry to the shard, shard lock should be held.
+     * Evicts entry from the bucket selected by the new entry hash if the shard is full -
+     * entries are keyed by the secret nonce, so eviction can't be targeted by an attacker.
+     */
+    void InsertToShard(CacheShard& shard, const uint256& entry, const size_t nMaxShardEntries)
+    {
+        auto& setValid = shard.setValid;
+        while (!setValid.empty() && (setValid.size() >= nMaxShardEntries))
+        {
+            const size_t nBucketCount = setValid.bucket_count();
+            const size_t nStartBucket = static_cast<size_t>(ReadLE64(entry.begin() + 16) % nBucketCount);
+            bool bEvicted = false;
+            for (size_t i = 0; i < nBucketCount; ++i)
+            {
+                const size_t nBucket = (nStartBucket + i) % nBucketCount;
+                auto it = setValid.begin(nBucket);
+                if (it != setValid.end(nBucket))
+                {
+                    setValid.erase(*it);
+                    bEvicted = true;
+                    break;
+                }
+            }
+            if (!bEvicted)
+                break;
+            shard.nEvictions.fetch_add(1, memory_order_relaxed);
+        }
+        if (setValid.insert(entry).second)
+            shard.nInserts.fetch_add(1, memory_order_relaxed);
+    }
 
 public:
     CSignatureCache()
     {
         GetRandBytes(nonce.begin(), 32);
+        SetMaxSize(static_cast<size_t>(DEFAULT_MAX_SIG_CACHE_SIZE) << 20);
+    }
+
+    void SetMaxSize(const size_t nMaxCacheSize) noexcept
+    {
+        m_nMaxShardEntries = nMaxCacheSize / GetEntryUsage() / SIG_CACHE_SHARDS;
     }
 
     void
@@ -58,40 +129,111 @@ public:
     bool
     Get(const uint256& entry)
     {
-        shared_lock<shared_mutex> lock(cs_sigcache);
-        return setValid.count(entry);
+        auto& shard = GetShard(entry);
+        shard.nLookups.fetch_add(1, memory_order_relaxed);
+        shared_lock<shared_mutex> lock(shard.cs);
+        if (!shard.setValid.count(entry))
+            return false;
+        shard.nHits.fetch_add(1, memory_order_relaxed);
+        return true;
     }
 
     void Erase(const uint256& entry)
     {
-        unique_lock<shared_mutex> lock(cs_sigcache);
-        setValid.erase(entry);
+        auto& shard = GetShard(entry);
+        unique_lock<shared_mutex> lock(shard.cs);
+        shard.setValid.erase(entry);
     }
 
     void Set(const uint256& entry)
     {
-        size_t nMaxCacheSize = GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
-        if (nMaxCacheSize <= 0) return;
+        const size_t nMaxShardEntries = m_nMaxShardEntries;
+        if (!nMaxShardEntries)
+            return;
 
-        unique_lock<shared_mutex> lock(cs_sigcache);
-        while (memusage::DynamicUsage(setValid) > nMaxCacheSize)
+        auto& shard = GetShard(entry);
+        unique_lock<shared_mutex> lock(shard.cs);
+        InsertToShard(shard, entry, nMaxShardEntries);
+    }
+
+    /**
+     * Insert batch of entries, each shard lock is taken only once.
+     * 
+     * \param vEntries - signature cache entries to insert
+     */
+    void SetBatch(const v_uint256& vEntries)
+    {
+        const size_t nMaxShardEntries = m_nMaxShardEntries;
+        if (!nMaxShardEntries || vEntries.empty())
+            return;
+        if (vEntries.size() == 1)
         {
-            map_type::size_type s = GetRand(setValid.bucket_count());
-            map_type::local_iterator it = setValid.begin(s);
-            if (it != setValid.end(s)) {
-                setValid.erase(*it);
-            }
+            Set(vEntries.front());
+            return;
+        }
+        array<v_uint256, SIG_CACHE_SHARDS> vShardEntries;
+        for (const auto& entry : vEntries)
+            vShardEntries[entry.begin()[31] % SIG_CACHE_SHARDS].push_back(entry);
+        for (size_t i = 0; i < SIG_CACHE_SHARDS; ++i)
+        {
+            if (vShardEntries[i].empty())
+                continue;
+            auto& shard = m_shards[i];
+            unique_lock<shared_mutex> lock(shard.cs);
+            for (const auto& entry : vShardEntries[i])
+                InsertToShard(shard, entry, nMaxShardEntries);
         }
+    }
 
-        setValid.insert(entry);
+    sigcache_stats_t GetStats()
+    {
+        sigcache_stats_t stats = {};
+        for (auto& shard : m_shards)
+        {
+            shared_lock<shared_mutex> lock(shard.cs);
+            stats.nEntries += shard.setValid.size();
+            stats.nMemoryUsage += memusage::DynamicUsage(shard.setValid);
+            stats.nLookups += shard.nLookups.load(memory_order_relaxed);
+            stats.nHits += shard.nHits.load(memory_order_relaxed);
+            stats.nInserts += shard.nInserts.load(memory_order_relaxed);
+            stats.nEvictions += shard.nEvictions.load(memory_order_relaxed);
+        }
+        stats.nMaxEntries = m_nMaxShardEntries * SIG_CACHE_SHARDS;
+        return stats;
     }
 };
 
+CSignatureCache& GetSignatureCache()
+{
+    static CSignatureCache signatureCache;
+    return signatureCache;
+}
+
+}
+
+/**
+ * Initialize signature cache size.
+ * -maxsigcachesize is read only once here instead of on every insert.
+ */
+void InitSignatureCache()
+{
+    const int64_t nMaxCacheSizeMB = max<int64_t>(GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE), 0);
+    GetSignatureCache().SetMaxSize(static_cast<size_t>(nMaxCacheSizeMB) << 20);
+}
+
+void SignatureCacheInsertBatch(const v_uint256 &vEntries)
+{
+    GetSignatureCache().SetBatch(vEntries);
+}
+
+sigcache_stats_t GetSignatureCacheStats()
+{
+    return GetSignatureCache().GetStats();
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-    static CSignatureCache signatureCache;
+    auto& signatureCache = GetSignatureCache();
 
     uint256 entry;
     signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
@@ -106,8 +248,12 @@ bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsig
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
         return false;
 
-    if (m_bStore) {
-        signatureCache.Set(entry);
+    if (m_bStore)
+    {
+        if (m_pvCacheEntries)
+            m_pvCacheEntries->push_back(entry);
+        else
+            signatureCache.Set(entry);
     }
     return true;
 }
@@ -6,23 +6,49 @@
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
 #include <vector_types.h>
+#include <uint256.h>
 #include <script/interpreter.h>
 
 // DoS prevention: limit cache size to less than 40MB (over 500000
 // entries on 64-bit systems).
 static constexpr unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 40;
+// number of signature cache shards (each shard has its own lock)
+constexpr size_t SIG_CACHE_SHARDS = 32;
 
 class CPubKey;
 
+// signature cache statistics
+typedef struct _sigcache_stats_t
+{
+    size_t nEntries;      // current number of entries in the cache
+    size_t nMaxEntries;   // max number of entries in the cache
+    size_t nMemoryUsage;  // approximate memory usage in bytes
+    uint64_t nLookups;    // number of cache lookups
+    uint64_t nHits;       // number of cache hits
+    uint64_t nInserts;    // number of inserted entries
+    uint64_t nEvictions;  // number of evicted entries
+} sigcache_stats_t;
+
+// initialize signature cache size (-maxsigcachesize)
+void InitSignatureCache();
+// insert batch of the signature cache entries
+void SignatureCacheInsertBatch(const v_uint256 &vEntries);
+// get signature cache statistics
+sigcache_stats_t GetSignatureCacheStats();
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool m_bStore;
+    // if defined - new cache entries are collected here instead of inserting them to the cache
+    v_uint256 *m_pvCacheEntries;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amount, bool storeIn, PrecomputedTransactionData& txdataIn) :
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amount, bool storeIn, PrecomputedTransactionData& txdataIn,
+        v_uint256 *pvCacheEntries = nullptr) :
         TransactionSignatureChecker(txToIn, nInIn, amount, txdataIn),
-        m_bStore(storeIn)
+        m_bStore(storeIn),
+        m_pvCacheEntries(pvCacheEntries)
     {}
 
     bool VerifySignature(const v_uint8 & vchSig, const CPubKey& vchPubKey, const uint256& sighash) const;
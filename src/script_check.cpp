@@ -19,7 +19,8 @@ CScriptCheck::CScriptCheck() :
     cacheStore(false),
     consensusBranchId(0),
     error(SCRIPT_ERR_UNKNOWN_ERROR),
-    txdata(nullptr)
+    txdata(nullptr),
+    pvSigCacheEntries(nullptr)
 {}
 
 CScriptCheck::CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn, 
@@ -33,7 +34,8 @@ CScriptCheck::CScriptCheck(const CCoins& txFromIn, const CTransaction& txToIn,
     cacheStore(cacheIn),
     consensusBranchId(consensusBranchIdIn),
     error(SCRIPT_ERR_UNKNOWN_ERROR),
-    txdata(txdataIn)
+    txdata(txdataIn),
+    pvSigCacheEntries(nullptr)
 {}
 
 void CScriptCheck::swap(CScriptCheck& check) noexcept
@@ -47,13 +49,32 @@ void CScriptCheck::swap(CScriptCheck& check) noexcept
     std::swap(consensusBranchId, check.consensusBranchId);
     std::swap(error, check.error);
     std::swap(txdata, check.txdata);
+    std::swap(pvSigCacheEntries, check.pvSigCacheEntries);
 }
 
 bool CScriptCheck::operator()()
 {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, amount, cacheStore, *txdata), consensusBranchId, &error))
+    // valid signatures are collected and added to the signature cache
+    // only if the whole script (or the whole block for the caller's collector) is valid
+    v_uint256 vSigCacheEntries;
+    v_uint256* pvEntries = nullptr;
+    if (cacheStore)
+        pvEntries = pvSigCacheEntries ? pvSigCacheEntries : &vSigCacheEntries;
+    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, 
+            CachingTransactionSignatureChecker(ptxTo, nIn, amount, cacheStore, *txdata, pvEntries), consensusBranchId, &error))
         return ::error("CScriptCheck(): %s:%d VerifySignature failed: %s", ptxTo->GetHash().ToString(), nIn, ScriptErrorString(error));
+    if (!vSigCacheEntries.empty())
+        SignatureCacheInsertBatch(vSigCacheEntries);
+    return true;
+}
+
+bool CValidationCheck::operator()()
+{
+    if (auto pScriptCheck = std::get_if<CScriptCheck>(&m_check))
+        return (*pScriptCheck)();
+    if (auto pfnCheck = std::get_if<check_func_t>(&m_check))
+        return (*pfnCheck)();
     return true;
 }
 
@@ -2,7 +2,13 @@
 // Copyright (c) 2018-2022 The Pastel Core developers
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <functional>
+#include <memory>
+#include <variant>
+#include <vector>
+
 #include <amount.h>
+#include <uint256.h>
 #include <script/script.h>
 #include <script/script_error.h>
 #include <script/interpreter.h>
@@ -32,6 +38,9 @@ private:
     uint32_t consensusBranchId;
     ScriptError error;
     PrecomputedTransactionData* txdata;
+    // if defined - valid signature cache entries are collected here to be inserted
+    // by the caller in one batch, otherwise they are inserted after the script check
+    v_uint256* pvSigCacheEntries;
 
 public:
     CScriptCheck();
@@ -44,9 +53,36 @@ public:
 
     void swap(CScriptCheck& check) noexcept;
     ScriptError GetScriptError() const noexcept { return error; }
+    void SetSigCacheEntries(v_uint256* pvEntries) noexcept { pvSigCacheEntries = pvEntries; }
 };
 
-using CScriptCheckWorker = CCheckQueueWorkerThread<CScriptCheck>;
+/**
+ * Closure representing one check executed by the shared validation check queue.
+ * This is either the script verification or any other independent check
+ * (Sapling proofs, Equihash solution, ticket signature, ...) wrapped into a function.
+ */
+class CValidationCheck
+{
+public:
+    using check_func_t = std::function<bool()>;
+
+    CValidationCheck() = default;
+    CValidationCheck(CScriptCheck&& check) : 
+        m_check(std::move(check))
+    {}
+    CValidationCheck(check_func_t&& fnCheck) :
+        m_check(std::move(fnCheck))
+    {}
+
+    bool operator()();
+
+    void swap(CValidationCheck& check) noexcept { m_check.swap(check.m_check); }
+
+private:
+    std::variant<std::monostate, CScriptCheck, check_func_t> m_check;
+};
+
+using CScriptCheckWorker = CCheckQueueWorkerThread<CValidationCheck>;
 
 class CScriptCheckManager
 {
@@ -61,11 +97,37 @@ public:
 
     std::unique_ptr<CScriptCheckWorker> create_master(const bool bEnabled);
 
+    /**
+     * Run checks on the shared check queue and wait for all of them to complete.
+     * Checks are executed in the calling thread if there are no check workers
+     * or there is only one check to run.
+     * Should not be called while the calling thread already controls the queue.
+     * 
+     * \param vChecks - checks to run, moved to the queue in the parallel mode
+     * \return true if all checks passed
+     */
+    template <typename T>
+    bool RunChecks(std::vector<T>& vChecks)
+    {
+        if ((m_nScriptCheckThreads > 1) && (vChecks.size() > 1))
+        {
+            auto control = create_master(true);
+            control->Add(vChecks);
+            return control->Wait();
+        }
+        for (auto& check : vChecks)
+        {
+            if (!check())
+                return false;
+        }
+        return true;
+    }
+
 private:
     size_t m_nScriptCheckThreads; // number of script check worker threads
 
-    // script check queue
-    CCheckQueue<CScriptCheck> m_ScriptCheckQueue;
+    // shared queue for script verification and other validation checks
+    CCheckQueue<CValidationCheck> m_ScriptCheckQueue;
 };
 
 extern CScriptCheckManager gl_ScriptCheckManager;
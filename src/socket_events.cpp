@@ -0,0 +1,227 @@
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <algorithm>
+
+#include <socket_events.h>
+#include <netbase.h>
+#include <util.h>
+
+using namespace std;
+
+#ifdef USE_EPOLL
+// max number of events returned by one epoll_wait call
+constexpr size_t MAX_EPOLL_EVENTS = 1024;
+
+static uint32_t ToEpollEvents(const uint8_t nEvents) noexcept
+{
+    // EPOLLERR and EPOLLHUP are always reported
+    uint32_t nEpollEvents = 0;
+    if (nEvents & SOCKET_EVENT_RECV)
+        nEpollEvents |= EPOLLIN;
+    if (nEvents & SOCKET_EVENT_SEND)
+        nEpollEvents |= EPOLLOUT;
+    return nEpollEvents;
+}
+#endif
+
+CSocketEventWaiter::CSocketEventWaiter() noexcept
+#ifdef USE_EPOLL
+    : m_epollFd(-1)
+#endif
+{
+#ifdef USE_EPOLL
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == -1)
+        LogPrintf("epoll_create1 failed (%s), using select() for socket events\n", NetworkErrorString(errno));
+    else
+        m_vEvents.resize(MAX_EPOLL_EVENTS);
+#endif
+}
+
+CSocketEventWaiter::~CSocketEventWaiter()
+{
+#ifdef USE_EPOLL
+    if (m_epollFd != -1)
+        close(m_epollFd);
+#endif
+}
+
+bool CSocketEventWaiter::IsEpoll() const noexcept
+{
+#ifdef USE_EPOLL
+    return m_epollFd != -1;
+#else
+    return false;
+#endif
+}
+
+bool CSocketEventWaiter::IsSupportedSocket(const SOCKET s) const noexcept
+{
+    if (IsEpoll())
+        return true;
+    return IsSelectableSocket(s);
+}
+
+/**
+ * Register socket or update requested events.
+ * Socket is re-registered if the owner has changed - socket handle can be reused
+ * after the socket was closed (closed sockets are removed from epoll by the kernel).
+ *
+ * \param hSocket - socket handle
+ * \param nOwnerId - unique id of the socket owner
+ * \param nEvents - requested events (SOCKET_EVENT_RECV, SOCKET_EVENT_SEND), errors are always reported
+ * \return false if socket could not be registered
+ */
+bool CSocketEventWaiter::SetSocketEvents(const SOCKET hSocket, const int64_t nOwnerId, const uint8_t nEvents)
+{
+    auto it = m_mapRegistered.find(hSocket);
+    if ((it != m_mapRegistered.end()) && (it->second.nOwnerId == nOwnerId) && (it->second.nEvents == nEvents))
+        return true;
+#ifdef USE_EPOLL
+    if (IsEpoll())
+    {
+        struct epoll_event ev = {};
+        ev.events = ToEpollEvents(nEvents);
+        ev.data.fd = hSocket;
+        // new socket or the handle was reused by another owner
+        const bool bAdd = (it == m_mapRegistered.end()) || (it->second.nOwnerId != nOwnerId);
+        if (epoll_ctl(m_epollFd, bAdd ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, hSocket, &ev) == -1)
+        {
+            // fallback to the opposite operation if epoll registration is out of sync
+            if (((bAdd && errno != EEXIST) || (!bAdd && errno != ENOENT)) ||
+                (epoll_ctl(m_epollFd, bAdd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, hSocket, &ev) == -1))
+            {
+                LogPrint("net", "epoll_ctl failed to register socket %d: %s\n", hSocket, NetworkErrorString(errno));
+                if (it != m_mapRegistered.end())
+                    m_mapRegistered.erase(it);
+                return false;
+            }
+        }
+    }
+#endif
+    m_mapRegistered[hSocket] = socket_request_t{nEvents, nOwnerId};
+    return true;
+}
+
+/**
+ * Remove socket registration.
+ * Registration is not removed if the socket handle was already reused by another owner.
+ *
+ * \param hSocket - socket handle
+ * \param nOwnerId - unique id of the socket owner
+ */
+void CSocketEventWaiter::RemoveSocket(const SOCKET hSocket, const int64_t nOwnerId)
+{
+    const auto it = m_mapRegistered.find(hSocket);
+    if ((it == m_mapRegistered.end()) || (it->second.nOwnerId != nOwnerId))
+        return;
+#ifdef USE_EPOLL
+    if (IsEpoll())
+    {
+        struct epoll_event ev = {};
+        // socket may be already closed, ignore errors
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, hSocket, &ev);
+    }
+#endif
+    m_mapRegistered.erase(it);
+}
+
+/**
+ * Wait for the events on the registered sockets.
+ *
+ * \param mapEvents - returns occurred events
+ * \param nTimeoutMs - wait timeout in milliseconds
+ * \param error - returns error message
+ * \return false if wait failed
+ */
+bool CSocketEventWaiter::Wait(socket_events_t& mapEvents, const uint32_t nTimeoutMs, string &error)
+{
+    mapEvents.clear();
+#ifdef USE_EPOLL
+    if (IsEpoll())
+        return WaitEpoll(mapEvents, nTimeoutMs, error);
+#endif
+    return WaitSelect(mapEvents, nTimeoutMs, error);
+}
+
+bool CSocketEventWaiter::WaitSelect(socket_events_t& mapEvents, const uint32_t nTimeoutMs, string &error)
+{
+    struct timeval timeout;
+    timeout.tv_sec = nTimeoutMs / 1000;
+    timeout.tv_usec = (nTimeoutMs % 1000) * 1000;
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+    for (const auto& [hSocket, request] : m_mapRegistered)
+    {
+        if (!IsSelectableSocket(hSocket))
+            continue;
+        FD_SET(hSocket, &fdsetError);
+        if (request.nEvents & SOCKET_EVENT_RECV)
+            FD_SET(hSocket, &fdsetRecv);
+        if (request.nEvents & SOCKET_EVENT_SEND)
+            FD_SET(hSocket, &fdsetSend);
+        hSocketMax = max(hSocketMax, hSocket);
+        have_fds = true;
+    }
+    const int nSelect = select(have_fds ? static_cast<int>(hSocketMax + 1) : 0,
+                               &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+            error = strprintf("socket select error %s", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    if (nSelect == 0)
+        return true;
+    for (const auto& [hSocket, request] : m_mapRegistered)
+    {
+        if (!IsSelectableSocket(hSocket))
+            continue;
+        uint8_t nEvents = 0;
+        if (FD_ISSET(hSocket, &fdsetRecv))
+            nEvents |= SOCKET_EVENT_RECV;
+        if (FD_ISSET(hSocket, &fdsetSend))
+            nEvents |= SOCKET_EVENT_SEND;
+        if (FD_ISSET(hSocket, &fdsetError))
+            nEvents |= SOCKET_EVENT_ERROR;
+        if (nEvents)
+            mapEvents.emplace(hSocket, nEvents);
+    }
+    return true;
+}
+
+#ifdef USE_EPOLL
+bool CSocketEventWaiter::WaitEpoll(socket_events_t& mapEvents, const uint32_t nTimeoutMs, string &error)
+{
+    const int nEvents = epoll_wait(m_epollFd, m_vEvents.data(), static_cast<int>(m_vEvents.size()), static_cast<int>(nTimeoutMs));
+    if (nEvents == -1)
+    {
+        if (errno == EINTR)
+            return true;
+        error = strprintf("socket epoll_wait error %s", NetworkErrorString(errno));
+        return false;
+    }
+    for (int i = 0; i < nEvents; ++i)
+    {
+        const auto& ev = m_vEvents[i];
+        uint8_t nSocketEvents = 0;
+        if (ev.events & EPOLLIN)
+            nSocketEvents |= SOCKET_EVENT_RECV;
+        if (ev.events & EPOLLOUT)
+            nSocketEvents |= SOCKET_EVENT_SEND;
+        if (ev.events & (EPOLLERR | EPOLLHUP))
+            nSocketEvents |= SOCKET_EVENT_ERROR;
+        if (nSocketEvents)
+            mapEvents.emplace(static_cast<SOCKET>(ev.data.fd), nSocketEvents);
+    }
+    return true;
+}
+#endif // USE_EPOLL
@@ -0,0 +1,74 @@
+#pragma once
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <compat.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WIN32)
+#define USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+// socket events
+constexpr uint8_t SOCKET_EVENT_RECV = 0x01;   // socket has data to receive (or incoming connection)
+constexpr uint8_t SOCKET_EVENT_SEND = 0x02;   // socket is ready to send data
+constexpr uint8_t SOCKET_EVENT_ERROR = 0x04;  // error or hang-up on socket
+
+// registered socket
+typedef struct _socket_request_t
+{
+    uint8_t nEvents;   // requested events (SOCKET_EVENT_RECV, SOCKET_EVENT_SEND)
+    int64_t nOwnerId;  // unique id of the socket owner (node id), used to detect socket handle reuse
+} socket_request_t;
+
+using socket_requests_t = std::unordered_map<SOCKET, socket_request_t>;
+// socket -> occurred events (SOCKET_EVENT_xxx)
+using socket_events_t = std::unordered_map<SOCKET, uint8_t>;
+
+/**
+ * Waits for the socket events.
+ * Uses level-triggered epoll on Linux, select() is used as a fallback.
+ * Sockets are registered once and kept between the waits, the caller updates
+ * registrations only when requested events change (connect, disconnect, send queue state).
+ * With epoll number of sockets is not limited by FD_SETSIZE.
+ * Not thread-safe - all methods should be called from the same thread.
+ */
+class CSocketEventWaiter
+{
+public:
+    CSocketEventWaiter() noexcept;
+    ~CSocketEventWaiter();
+
+    CSocketEventWaiter(const CSocketEventWaiter&) = delete;
+    CSocketEventWaiter& operator=(const CSocketEventWaiter&) = delete;
+
+    // returns true if epoll backend is used
+    bool IsEpoll() const noexcept;
+    // returns true if the socket can be used with this waiter
+    bool IsSupportedSocket(const SOCKET s) const noexcept;
+    // register socket or update requested events
+    bool SetSocketEvents(const SOCKET hSocket, const int64_t nOwnerId, const uint8_t nEvents);
+    // remove socket registration
+    void RemoveSocket(const SOCKET hSocket, const int64_t nOwnerId);
+    // get registered sockets
+    const socket_requests_t& GetSockets() const noexcept { return m_mapRegistered; }
+    // wait for the events on the registered sockets
+    bool Wait(socket_events_t& mapEvents, const uint32_t nTimeoutMs, std::string &error);
+
+private:
+    // registered sockets
+    socket_requests_t m_mapRegistered;
+
+    bool WaitSelect(socket_events_t& mapEvents, const uint32_t nTimeoutMs, std::string &error);
+#ifdef USE_EPOLL
+    bool WaitEpoll(socket_events_t& mapEvents, const uint32_t nTimeoutMs, std::string &error);
+
+    int m_epollFd;
+    std::vector<struct epoll_event> m_vEvents;
+#endif
+};
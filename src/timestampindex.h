@@ -0,0 +1,83 @@
+#pragma once
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <uint256.h>
+#include <serialize.h>
+
+// insightexplorer
+// timestamp index key used to seek to the first block with time >= timestamp
+struct CTimestampIndexIteratorKey
+{
+    unsigned int timestamp;
+
+    size_t GetSerializeSize(int nType, int nVersion) const noexcept
+    {
+        return 4;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        // timestamps are stored big-endian for key sorting in LevelDB
+        ser_writedata32be(s, timestamp);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        timestamp = ser_readdata32be(s);
+    }
+
+    CTimestampIndexIteratorKey(const unsigned int time) noexcept :
+        timestamp(time)
+    {}
+
+    CTimestampIndexIteratorKey() noexcept
+    {
+        SetNull();
+    }
+
+    void SetNull() noexcept
+    {
+        timestamp = 0;
+    }
+};
+
+// timestamp index key: block time -> block hash
+struct CTimestampIndexKey
+{
+    unsigned int timestamp;
+    uint256 blockHash;
+
+    size_t GetSerializeSize(int nType, int nVersion) const noexcept
+    {
+        return 36;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata32be(s, timestamp);
+        blockHash.Serialize(s);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        timestamp = ser_readdata32be(s);
+        blockHash.Unserialize(s);
+    }
+
+    CTimestampIndexKey(const unsigned int time, const uint256& hash) noexcept :
+        timestamp(time),
+        blockHash(hash)
+    {}
+
+    CTimestampIndexKey() noexcept
+    {
+        SetNull();
+    }
+
+    void SetNull() noexcept
+    {
+        timestamp = 0;
+        blockHash.SetNull();
+    }
+};
@@ -33,6 +33,9 @@ static constexpr char DB_REINDEX_FLAG = 'R';
 static constexpr char DB_LAST_BLOCK = 'l';
 
 static constexpr char DB_SPENTINDEX = 'p';
+static constexpr char DB_ADDRESSINDEX = 'd';
+static constexpr char DB_ADDRESSUNSPENTINDEX = 'u';
+static constexpr char DB_TIMESTAMPINDEX = 'T';
 
 
 CCoinsViewDB::CCoinsViewDB(std::string dbName, size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / dbName, nCacheSize, fMemory, fWipe) {
@@ -199,6 +202,150 @@ bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     return Read(make_pair(DB_SPENTINDEX, key), value);
 }
 
+/**
+ * Update spent index in one batch (insightexplorer).
+ * Null values are erased from the index.
+ */
+bool CBlockTreeDB::UpdateSpentIndex(const vector<pair<CSpentIndexKey, CSpentIndexValue>> &vect)
+{
+    CDBBatch batch(*this);
+    for (const auto &[key, value] : vect)
+    {
+        if (value.IsNull())
+            batch.Erase(make_pair(DB_SPENTINDEX, key));
+        else
+            batch.Write(make_pair(DB_SPENTINDEX, key), value);
+    }
+    return WriteBatch(batch);
+}
+
+/**
+ * Update address unspent index in one batch (insightexplorer).
+ * Null values are erased from the index.
+ */
+bool CBlockTreeDB::UpdateAddressUnspentIndex(const vector<pair<CAddressUnspentKey, CAddressUnspentValue>> &vect)
+{
+    CDBBatch batch(*this);
+    for (const auto &[key, value] : vect)
+    {
+        if (value.IsNull())
+            batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, key));
+        else
+            batch.Write(make_pair(DB_ADDRESSUNSPENTINDEX, key), value);
+    }
+    return WriteBatch(batch);
+}
+
+/**
+ * Read all unspent outputs for the address - single prefix scan.
+ * 
+ * \param addressHash - address hash
+ * \param type - address type
+ * \param vUnspentOutputs - returns unspent outputs
+ * \return false if failed to read the index value
+ */
+bool CBlockTreeDB::ReadAddressUnspentIndex(const uint160& addressHash, const CScript::ScriptType type,
+    vector<pair<CAddressUnspentKey, CAddressUnspentValue>> &vUnspentOutputs)
+{
+    const auto nType = to_integral_type(type);
+    auto pcursor = NewIterator();
+    pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(nType, addressHash)));
+    while (pcursor->Valid())
+    {
+        func_thread_interrupt_point();
+        pair<char, CAddressUnspentKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSUNSPENTINDEX ||
+            key.second.type != nType || key.second.hashBytes != addressHash)
+            break;
+        CAddressUnspentValue value;
+        if (!pcursor->GetValue(value))
+            return error("failed to get address unspent value");
+        vUnspentOutputs.emplace_back(key.second, value);
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::WriteAddressIndex(const vector<pair<CAddressIndexKey, CAmount>> &vect)
+{
+    CDBBatch batch(*this);
+    for (const auto &[key, nValue] : vect)
+        batch.Write(make_pair(DB_ADDRESSINDEX, key), nValue);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseAddressIndex(const vector<pair<CAddressIndexKey, CAmount>> &vect)
+{
+    CDBBatch batch(*this);
+    for (const auto &[key, nValue] : vect)
+        batch.Erase(make_pair(DB_ADDRESSINDEX, key));
+    return WriteBatch(batch);
+}
+
+/**
+ * Read address index entries (balance changes) for the address.
+ * Keys are sorted by height, so the height range query is a single prefix scan.
+ * 
+ * \param addressHash - address hash
+ * \param type - address type
+ * \param vAddressIndex - returns address index entries
+ * \param nStartHeight - start block height (inclusive), 0 - no range
+ * \param nEndHeight - end block height (inclusive), 0 - no range
+ * \return false if failed to read the index value
+ */
+bool CBlockTreeDB::ReadAddressIndex(const uint160& addressHash, const CScript::ScriptType type,
+    vector<pair<CAddressIndexKey, CAmount>> &vAddressIndex, const int nStartHeight, const int nEndHeight)
+{
+    const auto nType = to_integral_type(type);
+    auto pcursor = NewIterator();
+    if (nStartHeight > 0 && nEndHeight > 0)
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(nType, addressHash, nStartHeight)));
+    else
+        pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(nType, addressHash)));
+    while (pcursor->Valid())
+    {
+        func_thread_interrupt_point();
+        pair<char, CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX ||
+            key.second.type != nType || key.second.hashBytes != addressHash)
+            break;
+        if (nEndHeight > 0 && key.second.blockHeight > nEndHeight)
+            break;
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("failed to get address index value");
+        vAddressIndex.emplace_back(key.second, nValue);
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex)
+{
+    CDBBatch batch(*this);
+    batch.Write(make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
+    return WriteBatch(batch);
+}
+
+/**
+ * Read hashes of the blocks with timestamps in range [nLow, nHigh).
+ */
+bool CBlockTreeDB::ReadTimestampIndex(const unsigned int nHigh, const unsigned int nLow, v_uint256 &vHashes)
+{
+    auto pcursor = NewIterator();
+    pcursor->Seek(make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(nLow)));
+    while (pcursor->Valid())
+    {
+        func_thread_interrupt_point();
+        pair<char, CTimestampIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_TIMESTAMPINDEX || key.second.timestamp >= nHigh)
+            break;
+        vHashes.push_back(key.second.blockHash);
+        pcursor->Next();
+    }
+    return true;
+}
+
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
     return Read(make_pair(DB_BLOCK_FILES, nFile), info);
 }
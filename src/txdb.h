@@ -7,6 +7,8 @@
 #include "coins.h"
 #include "dbwrapper.h"
 #include "spentindex.h"
+#include "addressindex.h"
+#include "timestampindex.h"
 #include "chainparams.h"
 
 #include <map>
@@ -68,7 +70,19 @@ public:
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindex);
     bool ReadReindexing(bool &fReindex);
+    // insightexplorer
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
+    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue>> &vect);
+    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> &vect);
+    bool ReadAddressUnspentIndex(const uint160& addressHash, const CScript::ScriptType type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> &vUnspentOutputs);
+    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount>> &vect);
+    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount>> &vect);
+    bool ReadAddressIndex(const uint160& addressHash, const CScript::ScriptType type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount>> &vAddressIndex,
+                          const int nStartHeight = 0, const int nEndHeight = 0);
+    bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
+    bool ReadTimestampIndex(const unsigned int nHigh, const unsigned int nLow, v_uint256 &vHashes);
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
     bool WriteFlag(const std::string &name, bool fValue);
@@ -4,6 +4,8 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <cmath>
+
 #include <txmempool.h>
 #include <clientversion.h>
 #include <consensus/consensus.h>
@@ -73,10 +75,23 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     // Used by main.cpp AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     LOCK(cs);
-    mapTx.insert(entry);
-    const auto& tx = mapTx.find(hash)->GetTx();
+    const auto itTx = mapTx.insert(entry).first;
+    // apply prioritisetransaction fee delta and calculate ancestor state
+    double dPriorityDelta = 0;
+    CAmount nFeeDelta = 0;
+    ApplyDeltas(hash, dPriorityDelta, nFeeDelta);
+    if (nFeeDelta)
+        mapTx.modify(itTx, [nFeeDelta](CTxMemPoolEntry& e) { e.UpdateFeeDelta(nFeeDelta); });
+    UpdateAncestorState(itTx);
+    const auto& tx = itTx->GetTx();
     for (unsigned int i = 0; i < tx.vin.size(); i++)
         mapNextTx[tx.vin[i].prevout] = CInPoint(&tx, i);
+    // transactions spending this one can be already in the mempool
+    // if it is re-added after the block disconnect
+    const auto itNext = mapNextTx.lower_bound(COutPoint(hash, 0));
+    if ((itNext != mapNextTx.cend()) && (itNext->first.hash == hash))
+        UpdateDescendantsAncestorState(hash, HasMemPoolParents(tx),
+            1, static_cast<int64_t>(itTx->GetTxSize()), itTx->GetModifiedFee());
     for (const auto &spendDescription : tx.vShieldedSpend)
         mapSaplingNullifiers[spendDescription.nullifier] = &tx;
     nTransactionsUpdated++;
@@ -88,6 +103,130 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     return true;
 }
 
+/**
+ * Calculate all in-mempool ancestors of the transaction (cs should be locked).
+ * 
+ * \param tx - transaction to calculate ancestors for (does not have to be in the mempool)
+ * \param setAncestors - returns txids of the in-mempool ancestors
+ */
+void CTxMemPool::CalculateMemPoolAncestors(const CTransaction& tx, set<uint256>& setAncestors) const
+{
+    AssertLockHeld(cs);
+    deque<const CTransaction*> vToProcess;
+    vToProcess.push_back(&tx);
+    while (!vToProcess.empty())
+    {
+        const CTransaction* ptx = vToProcess.front();
+        vToProcess.pop_front();
+        for (const auto& txin : ptx->vin)
+        {
+            const auto it = mapTx.find(txin.prevout.hash);
+            if (it == mapTx.cend())
+                continue;
+            if (setAncestors.insert(txin.prevout.hash).second)
+                vToProcess.push_back(&it->GetTx());
+        }
+    }
+}
+
+/**
+ * Calculate all in-mempool descendants of the transaction (cs should be locked).
+ * 
+ * \param txid - transaction hash
+ * \param setDescendants - returns txids of the in-mempool descendants
+ */
+void CTxMemPool::CalculateDescendants(const uint256& txid, set<uint256>& setDescendants) const
+{
+    AssertLockHeld(cs);
+    deque<uint256> vToProcess;
+    vToProcess.push_back(txid);
+    while (!vToProcess.empty())
+    {
+        const uint256 hash = vToProcess.front();
+        vToProcess.pop_front();
+        for (auto it = mapNextTx.lower_bound(COutPoint(hash, 0)); (it != mapNextTx.cend()) && (it->first.hash == hash); ++it)
+        {
+            const uint256& childTxid = it->second.ptx->GetHash();
+            if (setDescendants.insert(childTxid).second)
+                vToProcess.push_back(childTxid);
+        }
+    }
+}
+
+/**
+ * Recalculate ancestor state (count, size and modified fees) of the mempool entry.
+ * 
+ * \param it - mempool entry iterator
+ */
+void CTxMemPool::UpdateAncestorState(txiter it)
+{
+    AssertLockHeld(cs);
+    set<uint256> setAncestors;
+    CalculateMemPoolAncestors(it->GetTx(), setAncestors);
+    uint64_t nCount = 1;
+    uint64_t nSize = it->GetTxSize();
+    CAmount nModFees = it->GetModifiedFee();
+    for (const auto& ancestorTxid : setAncestors)
+    {
+        const auto itAncestor = mapTx.find(ancestorTxid);
+        if (itAncestor == mapTx.cend())
+            continue;
+        ++nCount;
+        nSize += itAncestor->GetTxSize();
+        nModFees += itAncestor->GetModifiedFee();
+    }
+    mapTx.modify(it, [&](CTxMemPoolEntry& e) { e.SetAncestorState(nCount, nSize, nModFees); });
+}
+
+/**
+ * Check if the transaction spends outputs of other mempool transactions.
+ * 
+ * \param tx - transaction to check
+ * \return true if any of the transaction inputs is in the mempool
+ */
+bool CTxMemPool::HasMemPoolParents(const CTransaction& tx) const
+{
+    AssertLockHeld(cs);
+    for (const auto& txin : tx.vin)
+    {
+        if (mapTx.count(txin.prevout.hash))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Update ancestor state of all in-mempool descendants of the transaction.
+ * Called when the transaction is added to or removed from the mempool
+ * while its descendants stay in the mempool.
+ * If the transaction has no in-mempool parents, it is the only ancestor its descendants gain (or lose),
+ * so they are updated by the transaction's own count, size and modified fee.
+ * Otherwise descendants may gain (or lose) the transaction ancestors as well and their state is recalculated.
+ * 
+ * \param txid - transaction hash
+ * \param bHasMemPoolParents - true if the transaction spends outputs of other mempool transactions
+ * \param nCountDiff - 1 if the transaction was added, -1 if removed
+ * \param nSizeDiff - transaction size (negative if removed)
+ * \param nModFeeDiff - transaction modified fee (negative if removed)
+ */
+void CTxMemPool::UpdateDescendantsAncestorState(const uint256& txid, const bool bHasMemPoolParents,
+    const int64_t nCountDiff, const int64_t nSizeDiff, const CAmount nModFeeDiff)
+{
+    AssertLockHeld(cs);
+    set<uint256> setDescendants;
+    CalculateDescendants(txid, setDescendants);
+    for (const auto& descendantTxid : setDescendants)
+    {
+        const auto it = mapTx.find(descendantTxid);
+        if (it == mapTx.cend())
+            continue;
+        if (bHasMemPoolParents)
+            UpdateAncestorState(it);
+        else
+            mapTx.modify(it, [&](CTxMemPoolEntry& e) { e.UpdateAncestorState(nCountDiff, nSizeDiff, nModFeeDiff); });
+    }
+}
+
 void CTxMemPool::getAddressIndex(
     const vector<pair<uint160, CScript::ScriptType>>& vAddresses,
     vector<pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>>& results)
@@ -116,6 +255,91 @@ bool CTxMemPool::getSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &valu
     return false;
 }
 
+/**
+ * Add address deltas of the mempool transaction (insightexplorer).
+ * 
+ * \param entry - mempool entry
+ * \param view - coins view with the transaction inputs
+ */
+void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view)
+{
+    LOCK(cs);
+    const auto& tx = entry.GetTx();
+    const uint256& txid = tx.GetHash();
+    vector<CMempoolAddressDeltaKey> vInserted;
+    for (uint32_t j = 0; j < tx.vin.size(); ++j)
+    {
+        const auto& input = tx.vin[j];
+        const CTxOut& prevout = view.GetOutputFor(input);
+        const auto type = prevout.scriptPubKey.GetScriptType();
+        if (type == CScript::ScriptType::UNKNOWN)
+            continue;
+        CMempoolAddressDeltaKey key(type, prevout.scriptPubKey.AddressHash(), txid, j, 1);
+        mapAddress.emplace(key, CMempoolAddressDelta(entry.GetTime(), -prevout.nValue, input.prevout.hash, input.prevout.n));
+        vInserted.push_back(move(key));
+    }
+    for (uint32_t k = 0; k < tx.vout.size(); ++k)
+    {
+        const auto& out = tx.vout[k];
+        const auto type = out.scriptPubKey.GetScriptType();
+        if (type == CScript::ScriptType::UNKNOWN)
+            continue;
+        CMempoolAddressDeltaKey key(type, out.scriptPubKey.AddressHash(), txid, k, 0);
+        mapAddress.emplace(key, CMempoolAddressDelta(entry.GetTime(), out.nValue));
+        vInserted.push_back(move(key));
+    }
+    if (!vInserted.empty())
+        mapAddressInserted.emplace(txid, move(vInserted));
+}
+
+/**
+ * Add spent index entries for the inputs of the mempool transaction (insightexplorer).
+ * 
+ * \param entry - mempool entry
+ * \param view - coins view with the transaction inputs
+ */
+void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view)
+{
+    LOCK(cs);
+    const auto& tx = entry.GetTx();
+    const uint256& txid = tx.GetHash();
+    vector<CSpentIndexKey> vInserted;
+    vInserted.reserve(tx.vin.size());
+    for (uint32_t j = 0; j < tx.vin.size(); ++j)
+    {
+        const auto& input = tx.vin[j];
+        const CTxOut& prevout = view.GetOutputFor(input);
+        const auto type = prevout.scriptPubKey.GetScriptType();
+        const uint160 addressHash = type == CScript::ScriptType::UNKNOWN ? uint160() : prevout.scriptPubKey.AddressHash();
+        CSpentIndexKey key(input.prevout.hash, input.prevout.n);
+        // mempool transactions have block height -1
+        mapSpent.emplace(key, CSpentIndexValue(txid, j, -1, prevout.nValue, type, addressHash));
+        vInserted.push_back(move(key));
+    }
+    if (!vInserted.empty())
+        mapSpentInserted.emplace(txid, move(vInserted));
+}
+
+void CTxMemPool::removeAddressIndex(const uint256& txid)
+{
+    const auto it = mapAddressInserted.find(txid);
+    if (it == mapAddressInserted.cend())
+        return;
+    for (const auto& key : it->second)
+        mapAddress.erase(key);
+    mapAddressInserted.erase(it);
+}
+
+void CTxMemPool::removeSpentIndex(const uint256& txid)
+{
+    const auto it = mapSpentInserted.find(txid);
+    if (it == mapSpentInserted.cend())
+        return;
+    for (const auto& key : it->second)
+        mapSpent.erase(key);
+    mapSpentInserted.erase(it);
+}
+
 /**
  * Remove the transaction from the memory pool.
  * 
@@ -128,6 +352,12 @@ void CTxMemPool::remove(const CTransaction& origTx, const bool fRecursive, list<
     {
         LOCK(cs);
         deque<uint256> txToRemove;
+        // non-recursive removal: ancestor state of the in-mempool descendants is updated
+        // by the removed transaction size and modified fee
+        bool bUpdateDescendants = false;
+        bool bHasMemPoolParents = false;
+        int64_t nSizeDiff = 0;
+        CAmount nModFeeDiff = 0;
         const auto& txid = origTx.GetHash();
         txToRemove.emplace_back(txid);
         if (fRecursive && !mapTx.count(txid))
@@ -152,21 +382,29 @@ void CTxMemPool::remove(const CTransaction& origTx, const bool fRecursive, list<
             if (itTx == mapTx.cend())
                 continue;
             const auto& tx = itTx->GetTx();
-            if (fRecursive)
+            for (unsigned int i = 0; i < tx.vout.size(); i++)
             {
-                for (unsigned int i = 0; i < tx.vout.size(); i++)
-                {
-                    const auto it = mapNextTx.find(COutPoint(hash, i));
-                    if (it == mapNextTx.cend())
-                        continue;
+                const auto it = mapNextTx.find(COutPoint(hash, i));
+                if (it == mapNextTx.cend())
+                    continue;
+                if (fRecursive)
                     txToRemove.emplace_back(it->second.ptx->GetHash());
-                }
+                else
+                    bUpdateDescendants = true;
+            }
+            if (bUpdateDescendants)
+            {
+                bHasMemPoolParents = HasMemPoolParents(tx);
+                nSizeDiff = -static_cast<int64_t>(itTx->GetTxSize());
+                nModFeeDiff = -itTx->GetModifiedFee();
             }
 
             for (const auto& txin : tx.vin)
                 mapNextTx.erase(txin.prevout);
             for (const auto &spendDescription : tx.vShieldedSpend)
                 mapSaplingNullifiers.erase(spendDescription.nullifier);
+            removeAddressIndex(hash);
+            removeSpentIndex(hash);
 
             if (pRemovedTxList)
                 pRemovedTxList->emplace_back(tx);
@@ -180,6 +418,9 @@ void CTxMemPool::remove(const CTransaction& origTx, const bool fRecursive, list<
             for (auto pTracker : m_vTxMemPoolTracker)
                 pTracker->removeTx(hash);
         }
+        // removed transaction is not an ancestor of its descendants anymore
+        if (bUpdateDescendants)
+            UpdateDescendantsAncestorState(txid, bHasMemPoolParents, -1, nSizeDiff, nModFeeDiff);
     }
 }
 
@@ -318,10 +559,91 @@ void CTxMemPool::removeForBlock(const vector<CTransaction>& vtx, unsigned int nB
         removeConflicts(tx, conflicts);
         ClearPrioritisation(tx.GetHash());
     }
+    // decay of the rolling minimum fee starts from the block connection time
+    lastRollingFeeUpdate = GetTime();
+    blockSinceLastRollingFeeBump = true;
     // After the txs in the new block have been removed from the mempool, update policy estimates
     minerPolicyEstimator->processBlock(nBlockHeight, entries, fCurrentEstimate);
 }
 
+/**
+ * Raise rolling minimum fee rate to the fee rate of the evicted transaction.
+ * 
+ * \param rate - fee rate of the removed transaction (including incremental relay fee)
+ */
+void CTxMemPool::trackPackageRemoved(const CFeeRate& rate)
+{
+    AssertLockHeld(cs);
+    if (rate.GetFeePerK() > rollingMinimumFeeRate)
+    {
+        rollingMinimumFeeRate = static_cast<double>(rate.GetFeePerK());
+        blockSinceLastRollingFeeBump = false;
+    }
+}
+
+CFeeRate CTxMemPool::GetMinFee(const size_t nSizeLimit) const
+{
+    LOCK(cs);
+    if (!blockSinceLastRollingFeeBump || rollingMinimumFeeRate == 0)
+        return CFeeRate(llround(rollingMinimumFeeRate));
+
+    const int64_t nTime = GetTime();
+    if (nTime > lastRollingFeeUpdate + 10)
+    {
+        // decay faster if the mempool is much smaller than the limit
+        double halflife = ROLLING_FEE_HALFLIFE;
+        const size_t nUsage = DynamicMemoryUsage();
+        if (nUsage < nSizeLimit / 4)
+            halflife /= 4;
+        else if (nUsage < nSizeLimit / 2)
+            halflife /= 2;
+
+        rollingMinimumFeeRate = rollingMinimumFeeRate / pow(2.0, (nTime - lastRollingFeeUpdate) / halflife);
+        lastRollingFeeUpdate = nTime;
+
+        if (rollingMinimumFeeRate < static_cast<double>(::minRelayTxFee.GetFeePerK()) / 2)
+        {
+            rollingMinimumFeeRate = 0;
+            return CFeeRate(0);
+        }
+    }
+    return max(CFeeRate(llround(rollingMinimumFeeRate)), ::minRelayTxFee);
+}
+
+/**
+ * Evict transactions with the lowest fee rate until mempool memory usage is below the limit.
+ * Descendants of the evicted transactions are removed as well, all trackers are notified
+ * about removed transactions.
+ * 
+ * \param nSizeLimit - mempool memory usage limit in bytes
+ * \return number of removed transactions
+ */
+size_t CTxMemPool::TrimToSize(const size_t nSizeLimit)
+{
+    LOCK(cs);
+    size_t nTxRemoved = 0;
+    CFeeRate maxFeeRateRemoved(0);
+    while (!mapTx.empty() && DynamicMemoryUsage() > nSizeLimit)
+    {
+        // fee rate index is sorted by fee rate in descending order
+        auto it = mapTx.get<1>().end();
+        --it;
+        // the new rolling minimum fee must be higher than the fee rate of the evicted transaction
+        const CFeeRate removedFeeRate(it->GetFeeRate().GetFeePerK() + ::minRelayTxFee.GetFeePerK());
+        trackPackageRemoved(removedFeeRate);
+        maxFeeRateRemoved = max(maxFeeRateRemoved, removedFeeRate);
+
+        // copy transaction - entry is destroyed by remove
+        const CTransaction tx = it->GetTx();
+        list<CTransaction> removedTxList;
+        remove(tx, true, &removedTxList);
+        nTxRemoved += removedTxList.size();
+    }
+    if (nTxRemoved)
+        LogPrint("mempool", "Removed %zu txn, rolling minimum fee bumped to %s\n", nTxRemoved, maxFeeRateRemoved.ToString());
+    return nTxRemoved;
+}
+
 /**
  * Called whenever the tip changes. Removes transactions which don't commit to
  * the given branch ID from the mempool.
@@ -347,6 +669,10 @@ void CTxMemPool::clear()
     LOCK(cs);
     mapTx.clear();
     mapNextTx.clear();
+    mapAddress.clear();
+    mapAddressInserted.clear();
+    mapSpent.clear();
+    mapSpentInserted.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     ++nTransactionsUpdated;
@@ -405,6 +731,21 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             assert(pcoins->GetSaplingAnchorAt(spendDescription.anchor, tree));
             assert(!pcoins->GetNullifier(spendDescription.nullifier, SAPLING));
         }
+        // check ancestor state
+        set<uint256> setAncestors;
+        CalculateMemPoolAncestors(tx, setAncestors);
+        uint64_t nSizeWithAncestors = it->GetTxSize();
+        CAmount nModFeesWithAncestors = it->GetModifiedFee();
+        for (const auto& ancestorTxid : setAncestors)
+        {
+            const auto itAncestor = mapTx.find(ancestorTxid);
+            nSizeWithAncestors += itAncestor->GetTxSize();
+            nModFeesWithAncestors += itAncestor->GetModifiedFee();
+        }
+        assert(it->GetCountWithAncestors() == setAncestors.size() + 1);
+        assert(it->GetSizeWithAncestors() == nSizeWithAncestors);
+        assert(it->GetModFeesWithAncestors() == nModFeesWithAncestors);
+
         if (fDependsWait)
             waitingOnDependants.push_back(&(*it));
         else {
@@ -580,6 +921,21 @@ void CTxMemPool::PrioritiseTransaction(const uint256 hash, const string strHash,
         auto &deltas = mapDeltas[hash];
         deltas.first += dPriorityDelta;
         deltas.second += nFeeDelta;
+        // update modified fees of the transaction and ancestor fees of its descendants
+        const auto it = mapTx.find(hash);
+        if ((it != mapTx.cend()) && nFeeDelta)
+        {
+            const CAmount nNewFeeDelta = deltas.second;
+            mapTx.modify(it, [nNewFeeDelta](CTxMemPoolEntry& e) { e.UpdateFeeDelta(nNewFeeDelta); });
+            set<uint256> setDescendants;
+            CalculateDescendants(hash, setDescendants);
+            for (const auto& descendantTxid : setDescendants)
+            {
+                const auto itDescendant = mapTx.find(descendantTxid);
+                if (itDescendant != mapTx.cend())
+                    mapTx.modify(itDescendant, [nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModFeesWithAncestors(nFeeDelta); });
+            }
+        }
     }
     LogPrintf("PrioritiseTransaction: %s priority += %f, fee += %d\n", strHash, dPriorityDelta, FormatMoney(nFeeDelta));
 }
@@ -6,6 +6,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 #include <list>
 #include <limits>
+#include <set>
 #include <unordered_map>
 
 #include "vector_types.h"
@@ -22,6 +23,9 @@
 
 class CAutoFile;
 
+// half-life of the rolling minimum fee rate, in seconds
+static constexpr int64_t ROLLING_FEE_HALFLIFE = 60 * 60 * 12;
+
 static constexpr double ALLOW_FREE_THRESHOLD = COIN * 144 / 250;
 
 inline bool AllowFree(double dPriority)
@@ -44,7 +48,7 @@ struct mempoolentry_txid
 class CompareTxMemPoolEntryByFee
 {
 public:
-    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) noexcept
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const noexcept
     {
         if (a.GetFeeRate() == b.GetFeeRate())
             return a.GetTime() < b.GetTime();
@@ -52,6 +56,24 @@ public:
     }
 };
 
+/**
+ * Sort by ancestor fee rate - fee rate of the package formed by the transaction
+ * and all its in-mempool ancestors (modified fees are used).
+ * Ties are broken by txid to make the order deterministic.
+ */
+class CompareTxMemPoolEntryByAncestorFee
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const noexcept
+    {
+        const double f1 = static_cast<double>(a.GetModFeesWithAncestors()) * b.GetSizeWithAncestors();
+        const double f2 = static_cast<double>(b.GetModFeesWithAncestors()) * a.GetSizeWithAncestors();
+        if (f1 == f2)
+            return a.GetTx().GetHash() < b.GetTx().GetHash();
+        return f1 > f2;
+    }
+};
+
 /** An inpoint - a combination of a transaction and an index n into its vin */
 class CInPoint
 {
@@ -100,13 +122,26 @@ private:
     uint64_t totalTxSize = 0; //! sum of all mempool tx' byte sizes
     uint64_t cachedInnerUsage; //! sum of dynamic memory usage of all the map elements (NOT the maps themselves)
 
+    // rolling minimum fee rate (patoshis per 1000 bytes) required to get into the mempool,
+    // raised when transactions are evicted by TrimToSize and decays with time
+    mutable double rollingMinimumFeeRate = 0;
+    mutable int64_t lastRollingFeeUpdate = 0;
+    mutable bool blockSinceLastRollingFeeBump = false;
+
+    void trackPackageRemoved(const CFeeRate& rate);
+
     std::unordered_map<uint256, const CTransaction*> mapSaplingNullifiers;
     std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpent;
     std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> mapAddress;
+    // insightexplorer: txid -> keys inserted into mapAddress and mapSpent
+    std::unordered_map<uint256, std::vector<CMempoolAddressDeltaKey>> mapAddressInserted;
+    std::unordered_map<uint256, std::vector<CSpentIndexKey>> mapSpentInserted;
     // array of objects to notify for transactions add/remove events
     std::vector<std::shared_ptr<ITxMemPoolTracker>> m_vTxMemPoolTracker;
 
     void checkNullifiers(ShieldedType type) const;
+    void removeAddressIndex(const uint256& txid);
+    void removeSpentIndex(const uint256& txid);
     
 public:
     typedef boost::multi_index_container<
@@ -115,9 +150,20 @@ public:
             // sorted by txid
             boost::multi_index::ordered_unique<mempoolentry_txid>,
             // sorted by fee rate
-            boost::multi_index::ordered_non_unique<boost::multi_index::identity<CTxMemPoolEntry>, CompareTxMemPoolEntryByFee>
+            boost::multi_index::ordered_non_unique<boost::multi_index::identity<CTxMemPoolEntry>, CompareTxMemPoolEntryByFee>,
+            // sorted by ancestor fee rate (used to assemble block templates)
+            boost::multi_index::ordered_non_unique<boost::multi_index::identity<CTxMemPoolEntry>, CompareTxMemPoolEntryByAncestorFee>
         >
     > indexed_transaction_set;
+    using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
+
+private:
+    void UpdateAncestorState(txiter it);
+    void UpdateDescendantsAncestorState(const uint256& txid, const bool bHasMemPoolParents,
+        const int64_t nCountDiff, const int64_t nSizeDiff, const CAmount nModFeeDiff);
+    bool HasMemPoolParents(const CTransaction& tx) const;
+
+public:
 
     mutable CCriticalSection cs;
     indexed_transaction_set mapTx;
@@ -140,6 +186,9 @@ public:
                          std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>>& results);
 
     bool getSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value);
+    // insightexplorer: add address deltas and spent index entries for the mempool transaction
+    void addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
+    void addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
 
 	bool addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry, bool fCurrentEstimate = true);
     void remove(const CTransaction& tx, const bool fRecursive = true, std::list<CTransaction>* pRemovedTxList = nullptr);
@@ -150,6 +199,16 @@ public:
     void removeForBlock(const std::vector<CTransaction>& vtx, unsigned int nBlockHeight,
                         std::list<CTransaction>& conflicts, bool fCurrentEstimate = true);
     void removeWithoutBranchId(uint32_t nMemPoolBranchId);
+    /**
+     * Remove transactions with the lowest fee rate (and their descendants)
+     * until the mempool memory usage is below the size limit.
+     */
+    size_t TrimToSize(const size_t nSizeLimit);
+    /**
+     * The minimum fee rate to get into the mempool.
+     * Rolling minimum fee is raised by evictions and decays exponentially with time.
+     */
+    CFeeRate GetMinFee(const size_t nSizeLimit) const;
     void clear();
     void queryHashes(v_uint256& vtxid);
     void pruneSpent(const uint256& hash, CCoins &coins);
@@ -160,6 +219,13 @@ public:
      * the tx is not dependent on other mempool transactions to be included in a block.
      */
     bool HasNoInputsOf(const CTransaction& tx) const;
+    /**
+     * Calculate all in-mempool ancestors of the transaction (cs should be locked).
+     * Transaction itself does not have to be in the mempool.
+     */
+    void CalculateMemPoolAncestors(const CTransaction& tx, std::set<uint256>& setAncestors) const;
+    // calculate all in-mempool descendants of the transaction (cs should be locked)
+    void CalculateDescendants(const uint256& txid, std::set<uint256>& setDescendants) const;
 
     /** Affect CreateNewBlock prioritisation of transactions */
     void PrioritiseTransaction(const uint256 hash, const std::string strHash, double dPriorityDelta, const CAmount& nFeeDelta);
@@ -30,6 +30,13 @@ private:
     bool hadNoDependencies; //! Not dependent on any other txs when it entered the mempool
     bool spendsCoinbase;    //! keep track of transactions that spend a coinbase
     uint32_t nBranchId;     //! Branch ID this transaction is known to commit to, cached for efficiency
+    CAmount nFeeDelta;      //! Fee delta set by prioritisetransaction
+
+    // Ancestor state: this transaction with all its in-mempool ancestors,
+    // maintained by CTxMemPool on add/remove of the related transactions
+    uint64_t nCountWithAncestors;
+    uint64_t nSizeWithAncestors;
+    CAmount nModFeesWithAncestors; //! modified fees (with fee deltas)
 
 public:
     CTxMemPoolEntry(
@@ -48,12 +55,16 @@ public:
         nHeight(nHeight),
         hadNoDependencies(poolHasNoInputsOf),
         spendsCoinbase(spendsCoinbase),
-        nBranchId(nBranchId)
+        nBranchId(nBranchId),
+        nFeeDelta(0)
     {
         nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
         nModSize = tx.CalculateModifiedSize(nTxSize);
         nUsageSize = RecursiveDynamicUsage(tx);
         feeRate = CFeeRate(nFee, nTxSize);
+        nCountWithAncestors = 1;
+        nSizeWithAncestors = nTxSize;
+        nModFeesWithAncestors = nFee;
     }
 
     CTxMemPoolEntry() : 
@@ -65,7 +76,11 @@ public:
         dPriority(0.0),
         hadNoDependencies(false),
         spendsCoinbase(false),
-        nBranchId(0)
+        nBranchId(0),
+        nFeeDelta(0),
+        nCountWithAncestors(1),
+        nSizeWithAncestors(0),
+        nModFeesWithAncestors(0)
     {
         nHeight = MEMPOOL_HEIGHT;
     }
@@ -91,6 +106,33 @@ public:
 
     bool GetSpendsCoinbase() const noexcept { return spendsCoinbase; }
     uint32_t GetValidatedBranchId() const noexcept { return nBranchId; }
+
+    // fee including prioritisetransaction delta
+    CAmount GetModifiedFee() const noexcept { return nFee + nFeeDelta; }
+    uint64_t GetCountWithAncestors() const noexcept { return nCountWithAncestors; }
+    uint64_t GetSizeWithAncestors() const noexcept { return nSizeWithAncestors; }
+    CAmount GetModFeesWithAncestors() const noexcept { return nModFeesWithAncestors; }
+
+    // set new fee delta, ancestor fees are adjusted by the difference
+    void UpdateFeeDelta(const CAmount nNewFeeDelta) noexcept
+    {
+        nModFeesWithAncestors += nNewFeeDelta - nFeeDelta;
+        nFeeDelta = nNewFeeDelta;
+    }
+    void UpdateModFeesWithAncestors(const CAmount nModFeeDiff) noexcept { nModFeesWithAncestors += nModFeeDiff; }
+    // ancestor was added to (nCountDiff=1) or removed from (nCountDiff=-1) the mempool
+    void UpdateAncestorState(const int64_t nCountDiff, const int64_t nSizeDiff, const CAmount nModFeeDiff) noexcept
+    {
+        nCountWithAncestors += nCountDiff;
+        nSizeWithAncestors += nSizeDiff;
+        nModFeesWithAncestors += nModFeeDiff;
+    }
+    void SetAncestorState(const uint64_t nCount, const uint64_t nSize, const CAmount nModFees) noexcept
+    {
+        nCountWithAncestors = nCount;
+        nSizeWithAncestors = nSize;
+        nModFeesWithAncestors = nModFees;
+    }
 };
 
 /**
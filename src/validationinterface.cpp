@@ -3,7 +3,17 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
 #include "validationinterface.h"
+#include "primitives/block.h"
+#include "consensus/validation.h"
+#include "svc_thread.h"
+#include "crypto/common.h"
 #include <boost/bind/bind.hpp>
 using namespace boost::placeholders;
 using namespace std;
@@ -15,7 +25,240 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterValidationInterface(CValidationInterface* pwalletIn) {
+/**
+ * Ordered queue of notifications for the asynchronous validation interface listeners.
+ * Notifications are delivered one by one on a single background thread.
+ * When the thread is not running, notifications are delivered synchronously.
+ */
+class CValidationInterfaceQueue : public CServiceThread
+{
+public:
+    CValidationInterfaceQueue() :
+        CServiceThread("valqueue"),
+        m_bAccepting(false)
+    {}
+
+    ~CValidationInterfaceQueue() override
+    {
+        Stop();
+    }
+
+    bool Start()
+    {
+        {
+            unique_lock<mutex> lck(m_mutex);
+            if (m_bAccepting)
+                return true;
+            m_bAccepting = true;
+        }
+        if (start())
+            return true;
+        unique_lock<mutex> lck(m_mutex);
+        m_bAccepting = false;
+        return false;
+    }
+
+    // stop accepting new notifications, the thread delivers the backlog and exits
+    void stop() override
+    {
+        {
+            unique_lock<mutex> lck(m_mutex);
+            m_bAccepting = false;
+        }
+        CServiceThread::stop();
+        m_condNotify.notify_one();
+        m_condProcessed.notify_all();
+    }
+
+    void Stop()
+    {
+        stop();
+        waitForStop();
+    }
+
+    void AddCallback(function<void()> &&callback)
+    {
+        {
+            unique_lock<mutex> lck(m_mutex);
+            if (m_bAccepting)
+            {
+                m_queue.emplace_back(move(callback));
+                lck.unlock();
+                m_condNotify.notify_one();
+                return;
+            }
+        }
+        callback();
+    }
+
+    // wait until all callbacks queued so far are executed
+    void Flush()
+    {
+        promise<void> done;
+        auto future = done.get_future();
+        AddCallback([&done]() { done.set_value(); });
+        future.wait();
+    }
+
+    // wait until the backlog is below nMaxSize
+    void WaitForSpace(const size_t nMaxSize)
+    {
+        unique_lock<mutex> lck(m_mutex);
+        m_condProcessed.wait(lck, [&]() { return !m_bAccepting || (m_queue.size() < nMaxSize); });
+    }
+
+    size_t size() const
+    {
+        unique_lock<mutex> lck(m_mutex);
+        return m_queue.size();
+    }
+
+    void execute() override
+    {
+        while (true)
+        {
+            function<void()> callback;
+            {
+                unique_lock<mutex> lck(m_mutex);
+                m_condNotify.wait(lck, [&]() { return !m_bAccepting || !m_queue.empty(); });
+                // deliver the backlog before exit
+                if (m_queue.empty())
+                    break;
+                callback = move(m_queue.front());
+                m_queue.pop_front();
+            }
+            try
+            {
+                callback();
+            } catch (const exception& e) {
+                PrintExceptionContinue(&e, m_sThreadName.c_str());
+            }
+            m_condProcessed.notify_all();
+        }
+        m_condProcessed.notify_all();
+    }
+
+private:
+    mutable mutex m_mutex;
+    condition_variable m_condNotify;    // signalled when callback is added or queue is stopped
+    condition_variable m_condProcessed; // signalled when callback is processed
+    deque<function<void()>> m_queue;
+    bool m_bAccepting; // true if the thread accepts new callbacks
+};
+
+static CValidationInterfaceQueue gl_ValidationQueue;
+
+// signal connections of the asynchronous listeners
+static mutex gl_AsyncConnectionsMutex;
+static unordered_map<CValidationInterface*, vector<boost::signals2::connection>> gl_mapAsyncConnections;
+
+/**
+ * Get block copy that can be safely passed to the asynchronous listeners.
+ * SyncTransaction is called for every transaction of the connected block -
+ * the last copied block is reused to avoid copying it for every transaction.
+ * 
+ * \param pblock - block pointer (can be nullptr)
+ * \return shared block copy or nullptr
+ */
+static shared_ptr<const CBlock> GetSharedBlockCopy(const CBlock *pblock)
+{
+    static mutex cacheMutex;
+    static shared_ptr<const CBlock> lastBlock;
+
+    if (!pblock)
+        return nullptr;
+    const uint256 hash = pblock->GetHash();
+    unique_lock<mutex> lck(cacheMutex);
+    if (!lastBlock || (lastBlock->GetHash() != hash) || (lastBlock->vtx.size() != pblock->vtx.size()))
+        lastBlock = make_shared<const CBlock>(*pblock);
+    return lastBlock;
+}
+
+/**
+ * Disconnect asynchronous listener from the main signals.
+ * Waits for the queued notifications, so the listener can be safely destroyed.
+ * 
+ * \return false if pwalletIn is not registered as asynchronous listener
+ */
+static bool UnregisterAsyncValidationInterface(CValidationInterface* pwalletIn)
+{
+    {
+        unique_lock<mutex> lck(gl_AsyncConnectionsMutex);
+        auto it = gl_mapAsyncConnections.find(pwalletIn);
+        if (it == gl_mapAsyncConnections.end())
+            return false;
+        for (auto &connection : it->second)
+            connection.disconnect();
+        gl_mapAsyncConnections.erase(it);
+    }
+    gl_ValidationQueue.Flush();
+    return true;
+}
+
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const bool bAsync) {
+    if (bAsync)
+    {
+        // notification parameters are copied and the listener is called on the validation interface queue thread,
+        // block index pointers are never freed while the node is running
+        vector<boost::signals2::connection> vConnections;
+        vConnections.push_back(g_signals.AcceptedBlockHeader.connect([pwalletIn](const CBlockIndex *pindexNew)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->AcceptedBlockHeader(pindexNew); });
+        }));
+        vConnections.push_back(g_signals.NotifyHeaderTip.connect([pwalletIn](const CBlockIndex *pindexNew, bool fInitialDownload)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->NotifyHeaderTip(pindexNew, fInitialDownload); });
+        }));
+        vConnections.push_back(g_signals.UpdatedBlockTip.connect([pwalletIn](const CBlockIndex *pindex, bool fInitialDownload)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->UpdatedBlockTip(pindex, fInitialDownload); });
+        }));
+        vConnections.push_back(g_signals.SyncTransaction.connect([pwalletIn](const CTransaction &tx, const CBlock *pblock)
+        {
+            auto block = GetSharedBlockCopy(pblock);
+            gl_ValidationQueue.AddCallback([pwalletIn, tx, block]() { pwalletIn->SyncTransaction(tx, block.get()); });
+        }));
+        vConnections.push_back(g_signals.EraseTransaction.connect([pwalletIn](const uint256 &hash)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->EraseFromWallet(hash); });
+        }));
+        vConnections.push_back(g_signals.UpdatedTransaction.connect([pwalletIn](const uint256 &hash)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->UpdatedTransaction(hash); });
+        }));
+        vConnections.push_back(g_signals.ChainTip.connect([pwalletIn](const CBlockIndex *pindex, const CBlock *pblock, SaplingMerkleTree saplingTree, bool added)
+        {
+            auto block = GetSharedBlockCopy(pblock);
+            gl_ValidationQueue.AddCallback([pwalletIn, pindex, block, saplingTree, added]()
+                { pwalletIn->ChainTip(pindex, block.get(), saplingTree, added); });
+        }));
+        vConnections.push_back(g_signals.SetBestChain.connect([pwalletIn](const CBlockLocator &locator)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->SetBestChain(locator); });
+        }));
+        vConnections.push_back(g_signals.Inventory.connect([pwalletIn](const uint256 &hash)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->Inventory(hash); });
+        }));
+        vConnections.push_back(g_signals.Broadcast.connect([pwalletIn](int64_t nBestBlockTime)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->ResendWalletTransactions(nBestBlockTime); });
+        }));
+        vConnections.push_back(g_signals.BlockChecked.connect([pwalletIn](const CBlock &block, const CValidationState &state)
+        {
+            auto pblock = GetSharedBlockCopy(&block);
+            gl_ValidationQueue.AddCallback([pwalletIn, pblock, state]() { pwalletIn->BlockChecked(*pblock, state); });
+        }));
+        vConnections.push_back(g_signals.TicketNotification.connect([pwalletIn](const ticket_notification_t &ticket)
+        {
+            gl_ValidationQueue.AddCallback([=]() { pwalletIn->TicketNotification(ticket); });
+        }));
+
+        unique_lock<mutex> lck(gl_AsyncConnectionsMutex);
+        auto &vListenerConnections = gl_mapAsyncConnections[pwalletIn];
+        vListenerConnections.insert(vListenerConnections.end(), vConnections.cbegin(), vConnections.cend());
+        return;
+    }
     g_signals.AcceptedBlockHeader.connect(boost::bind(&CValidationInterface::AcceptedBlockHeader, pwalletIn, _1));
     g_signals.NotifyHeaderTip.connect(boost::bind(&CValidationInterface::NotifyHeaderTip, pwalletIn, _1, _2));
     g_signals.UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2));
@@ -27,9 +270,13 @@ void RegisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.Inventory.connect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
     g_signals.Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1));
     g_signals.BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
+    g_signals.TicketNotification.connect(boost::bind(&CValidationInterface::TicketNotification, pwalletIn, _1));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
+    if (UnregisterAsyncValidationInterface(pwalletIn))
+        return;
+    g_signals.TicketNotification.disconnect(boost::bind(&CValidationInterface::TicketNotification, pwalletIn, _1));
     g_signals.BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
     g_signals.Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1));
     g_signals.Inventory.disconnect(boost::bind(&CValidationInterface::Inventory, pwalletIn, _1));
@@ -44,6 +291,11 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
 }
 
 void UnregisterAllValidationInterfaces() {
+    {
+        unique_lock<mutex> lck(gl_AsyncConnectionsMutex);
+        gl_mapAsyncConnections.clear();
+    }
+    g_signals.TicketNotification.disconnect_all_slots();
     g_signals.BlockChecked.disconnect_all_slots();
     g_signals.Broadcast.disconnect_all_slots();
     g_signals.Inventory.disconnect_all_slots();
@@ -55,8 +307,48 @@ void UnregisterAllValidationInterfaces() {
     g_signals.UpdatedBlockTip.disconnect_all_slots();
     g_signals.NotifyHeaderTip.disconnect_all_slots();
     g_signals.AcceptedBlockHeader.disconnect_all_slots();
+    gl_ValidationQueue.Flush();
 }
 
 void SyncWithWallets(const CTransaction &tx, const CBlock *pblock) {
     g_signals.SyncTransaction(tx, pblock);
 }
+
+void StartValidationInterfaceQueue()
+{
+    if (!gl_ValidationQueue.Start())
+        LogPrintf("Failed to start validation interface queue thread, notifications are delivered synchronously\n");
+}
+
+void StopValidationInterfaceQueue()
+{
+    gl_ValidationQueue.Stop();
+}
+
+void SyncWithValidationInterfaceQueue()
+{
+    gl_ValidationQueue.Flush();
+}
+
+void LimitValidationInterfaceQueue()
+{
+    gl_ValidationQueue.WaitForSpace(MAX_VALIDATION_INTERFACE_QUEUE_SIZE);
+}
+
+size_t GetValidationInterfaceQueueSize()
+{
+    return gl_ValidationQueue.size();
+}
+
+vector<unsigned char> GetTicketNotificationMessage(const ticket_notification_t &ticket, const bool bRaw)
+{
+    vector<unsigned char> vData(TICKET_NOTIFICATION_HEADER_SIZE);
+    for (unsigned int i = 0; i < 32; i++)
+        vData[31 - i] = ticket.txid.begin()[i];
+    vData[32] = ticket.nTicketID;
+    WriteLE32(&vData[33], ticket.nBlockHeight);
+    vData[37] = ticket.bConnected ? 1 : 0;
+    if (bRaw)
+        vData.insert(vData.end(), ticket.vTicketData.cbegin(), ticket.vTicketData.cend());
+    return vData;
+}
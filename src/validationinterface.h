@@ -8,6 +8,9 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <vector>
+
+#include "uint256.h"
 #include "zcash/IncrementalMerkleTree.hpp"
 
 class CBlock;
@@ -18,10 +21,41 @@ class CValidationInterface;
 class CValidationState;
 class uint256;
 
+// ticket notification - ticket was stored in the ticket DB on block connect
+// or removed from the active chain on block disconnect
+typedef struct _ticket_notification_t
+{
+    uint8_t nTicketID;       // ticket type (TicketID)
+    uint256 txid;            // ticket transaction hash
+    uint32_t nBlockHeight;   // height of the block with the ticket
+    bool bConnected;         // true - ticket block connected, false - disconnected on reorg
+    std::vector<unsigned char> vTicketData; // serialized ticket (ticket DB format)
+} ticket_notification_t;
+
+// size of the ticket notification message header: txid | ticket type | block height | event
+constexpr size_t TICKET_NOTIFICATION_HEADER_SIZE = 32 + 1 + 4 + 1;
+
+/** Get ticket notification message body (ZMQ and AMQP hashticket/rawticket):
+ *   txid (32 bytes, same byte order as in hashtx) | ticket type (1 byte) |
+ *   block height (4 bytes, little-endian) | event (1 byte: 1 - connected, 0 - disconnected)
+ * rawticket message has the serialized ticket appended to the header.
+ */
+std::vector<unsigned char> GetTicketNotificationMessage(const ticket_notification_t &ticket, const bool bRaw);
+
+// max number of notifications waiting in the validation interface queue,
+// block connection is throttled by LimitValidationInterfaceQueue() when the backlog reaches this size
+constexpr size_t MAX_VALIDATION_INTERFACE_QUEUE_SIZE = 1000;
+
 // These functions dispatch to one or all registered wallets
 
-/** Register a wallet to receive updates from core */
-void RegisterValidationInterface(CValidationInterface* pwalletIn);
+/** Register a wallet to receive updates from core.
+ * Asynchronous listeners receive all notifications in order on the validation interface queue thread.
+ * They may lock cs_main (ZMQ/AMQP rawblock notifiers do it to read the block from disk): notifications are
+ * queued with cs_main held, but the queue is never waited on with cs_main held.
+ * Listeners must not call SyncWithValidationInterfaceQueue() or UnregisterValidationInterface()
+ * from a notification handler.
+ */
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const bool bAsync = false);
 /** Unregister a wallet from core */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
@@ -29,6 +63,21 @@ void UnregisterAllValidationInterfaces();
 /** Push an updated transaction to all registered wallets */
 void SyncWithWallets(const CTransaction& tx, const CBlock* pblock = NULL);
 
+/** Start the thread that delivers notifications to asynchronous listeners */
+void StartValidationInterfaceQueue();
+/** Deliver all queued notifications and stop the validation interface queue thread */
+void StopValidationInterfaceQueue();
+/** Wait until all notifications queued so far are delivered to asynchronous listeners.
+ * Should not be called with cs_main held.
+ */
+void SyncWithValidationInterfaceQueue();
+/** Wait until the backlog of the validation interface queue is below MAX_VALIDATION_INTERFACE_QUEUE_SIZE.
+ * Should not be called with cs_main held.
+ */
+void LimitValidationInterfaceQueue();
+/** Get number of notifications waiting in the validation interface queue */
+size_t GetValidationInterfaceQueueSize();
+
 class CValidationInterface {
 protected:
     virtual void ChainTip(const CBlockIndex *pindex, const CBlock *pblock, SaplingMerkleTree saplingTree, bool added) {}
@@ -44,7 +93,8 @@ protected:
     virtual void Inventory(const uint256 &hash) {}
     virtual void ResendWalletTransactions(int64_t nBestBlockTime) {}
     virtual void BlockChecked(const CBlock&, const CValidationState&) {}
-    friend void ::RegisterValidationInterface(CValidationInterface*);
+    virtual void TicketNotification(const ticket_notification_t &ticket) {}
+    friend void ::RegisterValidationInterface(CValidationInterface*, const bool);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
@@ -72,6 +122,8 @@ struct CMainSignals {
     boost::signals2::signal<void (int64_t nBestBlockTime)> Broadcast;
     /** Notifies listeners of a block validation result */
     boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
+    /** Notifies listeners of a ticket connected to (or disconnected from) the active chain */
+    boost::signals2::signal<void (const ticket_notification_t &)> TicketNotification;
 };
 
 CMainSignals& GetMainSignals();
@@ -0,0 +1,106 @@
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <init.h>
+#include <main.h>
+#include <rpc/protocol.h>
+#include <rpc/server.h>
+#include <util.h>
+#include <wallet/asyncrpcoperation_rescan.h>
+
+using namespace std;
+
+AsyncRPCOperation_rescan::AsyncRPCOperation_rescan(const int nStartHeight, UniValue contextInfo) :
+    m_nStartHeight(nStartHeight),
+    m_contextInfo(contextInfo)
+{}
+
+void AsyncRPCOperation_rescan::main()
+{
+    if (isCancelled())
+        return;
+
+    set_state(OperationStatus::EXECUTING);
+    start_execution_clock();
+
+    bool success = false;
+    try {
+        success = main_impl();
+    } catch (const UniValue& objError) {
+        int code = find_value(objError, "code").get_int();
+        string message = find_value(objError, "message").get_str();
+        set_error_code(code);
+        set_error_message(message);
+    } catch (const runtime_error& e) {
+        set_error_code(-1);
+        set_error_message("runtime error: " + string(e.what()));
+    } catch (const exception& e) {
+        set_error_code(-1);
+        set_error_message("general exception: " + string(e.what()));
+    } catch (...) {
+        set_error_code(-2);
+        set_error_message("unknown error");
+    }
+
+    stop_execution_clock();
+
+    set_state(success ? OperationStatus::SUCCESS : OperationStatus::FAILED);
+
+    string s = strprintf("%s: z_rescanwallet finished (status=%s", getId(), getStateAsString());
+    if (success)
+        s += strprintf(", found=%d)\n", m_progress.nFoundTxCount.load());
+    else
+        s += strprintf(", error=%s)\n", getErrorMessage());
+    LogPrintf("%s", s);
+}
+
+bool AsyncRPCOperation_rescan::main_impl()
+{
+    if (!pwalletMain)
+        throw JSONRPCError(RPC_WALLET_ERROR, "Wallet is not available");
+    CBlockIndex* pindexStart = nullptr;
+    {
+        LOCK(cs_main);
+        if (m_nStartHeight < 0 || m_nStartHeight > chainActive.Height())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+        pindexStart = chainActive[m_nStartHeight];
+    }
+    const int nFound = pwalletMain->ScanForWalletTransactions(pindexStart, true, &m_progress);
+    if (ShutdownRequested())
+        throw JSONRPCError(RPC_WALLET_ERROR, "Rescan interrupted by shutdown");
+    if (nFound < 0)
+        throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("start_height", m_progress.nStartHeight.load());
+    ret.pushKV("stop_height", m_progress.nCurrentHeight.load());
+    ret.pushKV("found", nFound);
+    set_result(move(ret));
+    return true;
+}
+
+UniValue AsyncRPCOperation_rescan::getStatus() const
+{
+    UniValue v = AsyncRPCOperation::getStatus();
+    UniValue obj = v.get_obj();
+    obj.pushKV("method", "z_rescanwallet");
+    if (!m_contextInfo.isNull())
+        obj.pushKV("params", m_contextInfo);
+    if (isExecuting())
+    {
+        const int nStartHeight = m_progress.nStartHeight;
+        const int nCurrentHeight = m_progress.nCurrentHeight;
+        const int nTipHeight = m_progress.nTipHeight;
+        UniValue progress(UniValue::VOBJ);
+        progress.pushKV("start_height", nStartHeight);
+        progress.pushKV("current_height", nCurrentHeight);
+        progress.pushKV("tip_height", nTipHeight);
+        progress.pushKV("found", m_progress.nFoundTxCount.load());
+        double dProgress = 0;
+        if ((nTipHeight > nStartHeight) && (nCurrentHeight >= nStartHeight))
+            dProgress = 100.0 * (nCurrentHeight - nStartHeight) / (nTipHeight - nStartHeight);
+        progress.pushKV("percent", dProgress);
+        obj.pushKV("progress", progress);
+    }
+    return obj;
+}
@@ -0,0 +1,36 @@
+#pragma once
+// Copyright (c) 2022 The Pastel Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+#include <univalue.h>
+
+#include <asyncrpcoperation.h>
+#include <wallet/wallet.h>
+
+/**
+ * Asynchronous wallet rescan.
+ * Rescan progress is reported in the operation status.
+ */
+class AsyncRPCOperation_rescan : public AsyncRPCOperation
+{
+public:
+    AsyncRPCOperation_rescan(const int nStartHeight, UniValue contextInfo = NullUniValue);
+    ~AsyncRPCOperation_rescan() override = default;
+
+    // We don't want to be copied or moved around
+    AsyncRPCOperation_rescan(AsyncRPCOperation_rescan const&) = delete;             // Copy construct
+    AsyncRPCOperation_rescan(AsyncRPCOperation_rescan&&) = delete;                  // Move construct
+    AsyncRPCOperation_rescan& operator=(AsyncRPCOperation_rescan const&) = delete;  // Copy assign
+    AsyncRPCOperation_rescan& operator=(AsyncRPCOperation_rescan &&) = delete;      // Move assign
+
+    void main() override;
+
+    UniValue getStatus() const override;
+
+private:
+    int m_nStartHeight;         // height to start rescan from
+    UniValue m_contextInfo;     // optional data to include in return value from getStatus()
+    wallet_rescan_progress_t m_progress;
+
+    bool main_impl();
+};
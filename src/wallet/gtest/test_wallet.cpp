@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
+#include <deque>
 #include <set>
 #include <gmock/gmock.h>
 #include <sodium.h>
@@ -10,10 +11,12 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <fs.h>
+#include <gtest/test_mempool_entryhelper.h>
 #include <key_io.h>
 #include <main.h>
 #include <primitives/block.h>
 #include <random.h>
+#include <svc_thread.h>
 #include <transaction_builder.h>
 #include <utiltest.h>
 #include <wallet/wallet.h>
@@ -72,12 +75,25 @@ public:
 
     void IncrementNoteWitnesses(const CBlockIndex* pindex,
                                 const CBlock* pblock,
-                                SaplingMerkleTree& saplingTree) {
-        CWallet::IncrementNoteWitnesses(pindex, pblock, saplingTree);
+                                SaplingMerkleTree& saplingTree,
+                                const bool bRebuild = false) {
+        CWallet::IncrementNoteWitnesses(pindex, pblock, saplingTree, bRebuild);
     }
     void DecrementNoteWitnesses(const CBlockIndex* pindex) {
         CWallet::DecrementNoteWitnesses(pindex);
     }
+    CBlockIndex* BeginSaplingWitnessRebuild(const v_uint256& vTxHashes) {
+        return CWallet::BeginSaplingWitnessRebuild(vTxHashes);
+    }
+    CBlockIndex* RestartSaplingWitnessRebuild() {
+        return CWallet::RestartSaplingWitnessRebuild();
+    }
+    void ReplaySaplingWitnesses(const CBlockIndex* pindex, const CBlock& block, SaplingMerkleTree& saplingTree) {
+        CWallet::ReplaySaplingWitnesses(pindex, block, saplingTree);
+    }
+    void EndSaplingWitnessRebuild() {
+        CWallet::EndSaplingWitnessRebuild();
+    }
     void SetBestChain(MockWalletDB& walletdb, const CBlockLocator& loc) {
         CWallet::SetBestChainINTERNAL(walletdb, loc);
     }
@@ -228,6 +244,221 @@ TEST(WalletTests, FindMySaplingNotes) {
     UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex::UPGRADE_OVERWINTER, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
 }
 
+static OutputDescription CreateTestSaplingOutput(const libzcash::SaplingPaymentAddress& pa, const uint64_t nValue)
+{
+    libzcash::SaplingNote note(pa, nValue);
+    libzcash::SaplingNotePlaintext pt(note, {});
+    auto encResult = pt.encrypt(note.pk_d);
+    EXPECT_TRUE(encResult.has_value());
+    OutputDescription output;
+    output.cm = note.cm().value();
+    output.ephemeralKey = encResult->second.get_epk();
+    output.encCiphertext = encResult->first;
+    return output;
+}
+
+TEST(WalletTests, SaplingTrialDecryptParallel)
+{
+    // viewing keys of the wallet, key #5 is duplicated at #30 - the first one should be found
+    auto sk = GetTestMasterSaplingSpendingKey();
+    vector<libzcash::SaplingExtendedSpendingKey> vSpendingKeys;
+    vector<libzcash::SaplingIncomingViewingKey> vIvk;
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        vSpendingKeys.push_back(sk.Derive(i | ZIP32_HARDENED_KEY_LIMIT));
+        vIvk.push_back(vSpendingKeys.back().expsk.full_viewing_key().in_viewing_key());
+    }
+    vIvk[30] = vIvk[5];
+    // key that does not belong to the wallet
+    const auto skUnknown = sk.Derive(1000 | ZIP32_HARDENED_KEY_LIMIT);
+
+    vector<OutputDescription> vOutputs;
+    for (const size_t nKeyIndex : { 0, 17, 39, 5, 17 })
+        vOutputs.push_back(CreateTestSaplingOutput(vSpendingKeys[nKeyIndex].DefaultAddress(), 1000 + nKeyIndex));
+    vOutputs.push_back(CreateTestSaplingOutput(skUnknown.DefaultAddress(), 5000));
+    const vector<size_t> vExpected = { 0, 17, 39, 5, 17, vIvk.size() };
+
+    // serial trial decryption in the calling thread
+    vector<atomic_size_t> vFoundSerial(vOutputs.size());
+    SaplingTrialDecrypt(vOutputs, vIvk, vFoundSerial, false);
+
+    // parallel trial decryption by the sapling decryption workers
+    CServiceThreadGroup threadGroup;
+    CreateSaplingDecryptWorkers(threadGroup, 4);
+    vector<atomic_size_t> vFoundParallel(vOutputs.size());
+    SaplingTrialDecrypt(vOutputs, vIvk, vFoundParallel);
+    threadGroup.stop_all();
+    threadGroup.join_all();
+    // switch back to the decryption in the calling thread
+    CreateSaplingDecryptWorkers(threadGroup, 1);
+
+    for (size_t i = 0; i < vOutputs.size(); ++i)
+    {
+        EXPECT_EQ(vFoundSerial[i].load(), vExpected[i]) << "output " << i;
+        EXPECT_EQ(vFoundParallel[i].load(), vFoundSerial[i].load()) << "output " << i;
+    }
+}
+
+static CTransaction CreateTestSaplingTx(const libzcash::SaplingPaymentAddress& pa, const uint64_t nValue)
+{
+    CMutableTransaction mtx;
+    mtx.fOverwintered = true;
+    mtx.nVersion = SAPLING_TX_VERSION;
+    mtx.nVersionGroupId = SAPLING_VERSION_GROUP_ID;
+    mtx.vShieldedOutput.push_back(CreateTestSaplingOutput(pa, nValue));
+    return mtx;
+}
+
+// Rescan rebuilds the witness cache of the new note B in chunks, chain tip updates and reorg
+// happen between the chunks while the wallet locks are released.
+TEST(WalletTests, SaplingWitnessRebuildChunked)
+{
+    SelectParams(ChainNetwork::REGTEST);
+    UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex::UPGRADE_OVERWINTER, Consensus::NetworkUpgrade::ALWAYS_ACTIVE);
+    UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex::UPGRADE_SAPLING, Consensus::NetworkUpgrade::ALWAYS_ACTIVE);
+
+    TestWallet wallet;
+    LOCK2(cs_main, wallet.cs_wallet);
+
+    auto sk = GetTestMasterSaplingSpendingKey();
+    const auto pa = sk.DefaultAddress();
+    const auto paUnknown = sk.Derive(1000 | ZIP32_HARDENED_KEY_LIMIT).DefaultAddress();
+    ASSERT_TRUE(wallet.AddSaplingZKey(sk));
+
+    // blocks 0-4: note A in block 0, note B in block 1; blocks 3' and 4' - alternative chain
+    vector<CBlock> vBlocks;
+    deque<CBlockIndex> vIndex;
+    vector<SaplingMerkleTree> vTreeBefore;
+    SaplingMerkleTree saplingTree;
+    const auto AddBlock = [&](const CTransaction& tx, CBlockIndex* pindexPrev, const SaplingMerkleTree& treeBefore) -> size_t
+    {
+        CBlock block;
+        block.vtx.push_back(tx);
+        block.hashMerkleRoot = block.BuildMerkleTree();
+        vBlocks.push_back(block);
+        vIndex.emplace_back(block);
+        auto& index = vIndex.back();
+        index.pprev = pindexPrev;
+        index.nHeight = pindexPrev ? pindexPrev->nHeight + 1 : 0;
+        mapBlockIndex.emplace(block.GetHash(), &index);
+        vTreeBefore.push_back(treeBefore);
+        return vBlocks.size() - 1;
+    };
+    const auto ConnectTip = [&](const size_t nBlock)
+    {
+        chainActive.SetTip(&vIndex[nBlock]);
+        SaplingMerkleTree tree = vTreeBefore[nBlock];
+        wallet.IncrementNoteWitnesses(&vIndex[nBlock], &vBlocks[nBlock], tree);
+    };
+    const auto Replay = [&](const size_t nBlock)
+    {
+        SaplingMerkleTree tree = vTreeBefore[nBlock];
+        wallet.ReplaySaplingWitnesses(&vIndex[nBlock], vBlocks[nBlock], tree);
+    };
+
+    const auto txA = CreateTestSaplingTx(pa, 10000);
+    const auto txB = CreateTestSaplingTx(pa, 20000);
+    for (size_t i = 0; i < 5; ++i)
+    {
+        const auto& tx = (i == 0) ? txA : ((i == 1) ? txB : CreateTestSaplingTx(paUnknown, 1000 + i));
+        AddBlock(tx, i ? &vIndex[i - 1] : nullptr, saplingTree);
+        saplingTree.append(tx.vShieldedOutput[0].cm);
+    }
+    SaplingMerkleTree saplingTreeAlt = vTreeBefore[3];
+    CBlockIndex* pindexPrev = &vIndex[2];
+    for (size_t i = 3; i < 5; ++i)
+    {
+        const auto tx = CreateTestSaplingTx(paUnknown, 2000 + i);
+        pindexPrev = &vIndex[AddBlock(tx, pindexPrev, saplingTreeAlt)];
+        saplingTreeAlt.append(tx.vShieldedOutput[0].cm);
+    }
+    EXPECT_EQ(vIndex[6].pprev, &vIndex[5]);
+    EXPECT_EQ(vIndex[6].nHeight, 4);
+
+    // note A is witnessed by the chain tip updates
+    CWalletTx wtxA {&wallet, txA};
+    auto saplingNoteDataA = wallet.FindMySaplingNotes(wtxA).first;
+    wtxA.SetSaplingNoteData(saplingNoteDataA);
+    wtxA.SetMerkleBranch(vBlocks[0]);
+    wallet.AddToWallet(wtxA, true, nullptr);
+    for (size_t i = 0; i < 4; ++i)
+        ConnectTip(i);
+
+    // rescan finds note B
+    CWalletTx wtxB {&wallet, txB};
+    auto saplingNoteDataB = wallet.FindMySaplingNotes(wtxB).first;
+    wtxB.SetSaplingNoteData(saplingNoteDataB);
+    ASSERT_EQ(wtxB.mapSaplingNoteData.size(), 1u);
+    wtxB.SetMerkleBranch(vBlocks[1]);
+    wallet.AddToWallet(wtxB, true, nullptr);
+    const SaplingOutPoint opA(txA.GetHash(), 0);
+    const SaplingOutPoint opB(txB.GetHash(), 0);
+    auto& ndA = wallet.mapWallet[opA.hash].mapSaplingNoteData[opA];
+    auto& ndB = wallet.mapWallet[opB.hash].mapSaplingNoteData[opB];
+
+    EXPECT_EQ(wallet.BeginSaplingWitnessRebuild({ opB.hash }), &vIndex[1]);
+    // chunk #1
+    Replay(1);
+    Replay(2);
+    EXPECT_EQ(ndB.witnessHeight, 2);
+    EXPECT_EQ(ndB.witnesses.size(), 2u);
+    EXPECT_TRUE(ndB.nullifier.has_value());
+
+    // new chain tip is connected while the locks are released - note B is skipped
+    ConnectTip(4);
+    EXPECT_EQ(ndA.witnessHeight, 4);
+    EXPECT_EQ(ndB.witnessHeight, 2);
+    EXPECT_EQ(ndB.witnesses.size(), 2u);
+
+    // chunk #2
+    Replay(3);
+    EXPECT_EQ(ndB.witnessHeight, 3);
+
+    // reorg to blocks 3' and 4' while the locks are released
+    wallet.DecrementNoteWitnesses(&vIndex[4]);
+    wallet.DecrementNoteWitnesses(&vIndex[3]);
+    EXPECT_EQ(ndA.witnessHeight, 2);
+    EXPECT_EQ(ndB.witnessHeight, 3);
+    ConnectTip(5);
+    ConnectTip(6);
+    EXPECT_FALSE(chainActive.Contains(&vIndex[3]));
+
+    // replayed block 3 was disconnected - rebuild starts over
+    EXPECT_EQ(wallet.RestartSaplingWitnessRebuild(), &vIndex[1]);
+    EXPECT_TRUE(ndB.witnesses.empty());
+    EXPECT_EQ(ndB.witnessHeight, -1);
+    EXPECT_FALSE(ndB.nullifier.has_value());
+    for (const size_t nBlock : { 1, 2, 5, 6 })
+        Replay(nBlock);
+    wallet.EndSaplingWitnessRebuild();
+
+    // both witnesses are valid for the new chain tip
+    EXPECT_EQ(ndA.witnessHeight, 4);
+    EXPECT_EQ(ndB.witnessHeight, 4);
+    ASSERT_FALSE(ndA.witnesses.empty());
+    ASSERT_FALSE(ndB.witnesses.empty());
+    EXPECT_EQ(ndA.witnesses.front().root(), saplingTreeAlt.root());
+    EXPECT_EQ(ndB.witnesses.front().root(), saplingTreeAlt.root());
+    EXPECT_EQ(ndA.witnesses.front().position(), 0u);
+    EXPECT_EQ(ndB.witnesses.front().position(), 1u);
+    ASSERT_TRUE(ndB.nullifier.has_value());
+    EXPECT_EQ(wallet.mapSaplingNullifiersToNotes[ndB.nullifier.value()], opB);
+
+    // chain tip updates process note B again
+    wallet.DecrementNoteWitnesses(&vIndex[6]);
+    EXPECT_EQ(ndB.witnessHeight, 3);
+    EXPECT_EQ(ndB.witnesses.front().root(), vTreeBefore[6].root());
+
+    // Tear down
+    chainActive.SetTip(nullptr);
+    for (const auto& block : vBlocks)
+        mapBlockIndex.erase(block.GetHash());
+
+    // Revert to default
+    UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex::UPGRADE_SAPLING, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
+    UpdateNetworkUpgradeParameters(Consensus::UpgradeIndex::UPGRADE_OVERWINTER, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
+}
+
 // Generate note A and spend to create note B, from which we spend to create two conflicting transactions
 TEST(WalletTests, GetConflictedSaplingNotes) {
     SelectParams(ChainNetwork::REGTEST);
@@ -935,6 +1166,317 @@ TEST(WalletTests, SaplingNoteLocking)
     EXPECT_FALSE(wallet.IsLockedNote(sop2));
 }
 
+/**
+ * Wallet with the transparent key on the fake active chain.
+ * Wallet notifications are simulated the same way SyncTransaction and ChainTip do it,
+ * wallet is not file-backed.
+ */
+class TestWalletChain : public ::testing::Test
+{
+protected:
+    TestWallet wallet;
+    CScript m_scriptMine;
+    CScript m_scriptOther;
+    deque<CBlockIndex> m_vIndex;
+    map<const CBlockIndex*, CBlock> m_mapBlocks;
+
+    void SetUp() override
+    {
+        SelectParams(ChainNetwork::REGTEST);
+        CKey key;
+        key.MakeNewKey(true);
+        ASSERT_TRUE(wallet.AddKeyPubKey(key, key.GetPubKey()));
+        m_scriptMine = GetScriptForDestination(key.GetPubKey().GetID());
+        CKey keyOther;
+        keyOther.MakeNewKey(true);
+        m_scriptOther = GetScriptForDestination(keyOther.GetPubKey().GetID());
+        mempool.clear();
+    }
+
+    void TearDown() override
+    {
+        mempool.clear();
+        chainActive.SetTip(nullptr);
+        for (const auto& index : m_vIndex)
+            mapBlockIndex.erase(index.GetBlockHash());
+    }
+
+    CTransaction CreateCoinbase(const CAmount nValue) const
+    {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout.SetNull();
+        mtx.vin[0].scriptSig = CScript() << static_cast<int64_t>(m_vIndex.size()) << OP_0;
+        mtx.vout.emplace_back(nValue, m_scriptMine);
+        return mtx;
+    }
+
+    CTransaction CreateTx(const vector<COutPoint>& vInputs, const vector<pair<CAmount, CScript>>& vOutputs) const
+    {
+        CMutableTransaction mtx;
+        for (const auto& outpoint : vInputs)
+            mtx.vin.emplace_back(outpoint);
+        for (const auto& [nValue, script] : vOutputs)
+            mtx.vout.emplace_back(nValue, script);
+        return mtx;
+    }
+
+    // add transaction to the wallet and mark affected balances dirty as SyncTransaction does
+    void SyncTransaction(const CTransaction& tx, const CBlock* pblock = nullptr)
+    {
+        const auto it = wallet.mapWallet.find(tx.GetHash());
+        if (it == wallet.mapWallet.end())
+        {
+            if (!wallet.IsMine(tx) && !wallet.IsFromMe(tx))
+                return;
+            CWalletTx wtx(&wallet, tx);
+            if (pblock)
+                wtx.SetMerkleBranch(*pblock);
+            wallet.AddToWallet(wtx, true, nullptr);
+        } else if (pblock)
+            it->second.SetMerkleBranch(*pblock);
+        wallet.MarkAffectedTransactionsDirty(tx);
+        wallet.MarkBalanceDirty(tx.GetHash());
+    }
+
+    void AddToMempool(const CTransaction& tx)
+    {
+        TestMemPoolEntryHelper entry;
+        mempool.addUnchecked(tx.GetHash(), entry.FromTx(CMutableTransaction(tx)));
+        SyncTransaction(tx);
+    }
+
+    // connect block, conflicted transactions are removed from the mempool as removeForBlock does
+    void ConnectBlock(const vector<CTransaction>& vtx, const vector<CTransaction>& vConflicted = {})
+    {
+        for (const auto& tx : vConflicted)
+        {
+            mempool.remove(tx, true);
+            SyncTransaction(tx);
+        }
+        CBlock block;
+        if (chainActive.Tip())
+            block.hashPrevBlock = chainActive.Tip()->GetBlockHash();
+        // blocks with the same transactions on different branches get different hashes
+        block.nTime = static_cast<uint32_t>(m_vIndex.size());
+        block.vtx = vtx;
+        block.hashMerkleRoot = block.BuildMerkleTree();
+        m_vIndex.emplace_back(block);
+        auto& index = m_vIndex.back();
+        index.pprev = chainActive.Tip();
+        index.nHeight = chainActive.Height() + 1;
+        index.phashBlock = &mapBlockIndex.emplace(block.GetHash(), &index).first->first;
+        chainActive.SetTip(&index);
+        const auto& blockConnected = m_mapBlocks.emplace(&index, block).first->second;
+        for (const auto& tx : blockConnected.vtx)
+        {
+            mempool.remove(tx, false);
+            SyncTransaction(tx, &blockConnected);
+        }
+        wallet.ChainTip(&index, &blockConnected, SaplingMerkleTree(), true);
+    }
+
+    // disconnect the chain tip, non-coinbase transactions are returned to the mempool
+    void DisconnectTip()
+    {
+        CBlockIndex* pindex = chainActive.Tip();
+        const auto& block = m_mapBlocks.at(pindex);
+        chainActive.SetTip(pindex->pprev);
+        TestMemPoolEntryHelper entry;
+        for (const auto& tx : block.vtx)
+        {
+            if (!tx.IsCoinBase())
+                mempool.addUnchecked(tx.GetHash(), entry.FromTx(CMutableTransaction(tx)));
+            SyncTransaction(tx);
+        }
+        wallet.ChainTip(pindex, &block, SaplingMerkleTree(), false);
+    }
+
+    // check cached wallet balances against the expected values and the full recalculation
+    void CheckBalances(const CAmount nTrusted, const CAmount nUnconfirmed, const CAmount nImmature)
+    {
+        // cached balances are read first - full recalculation refreshes credits cached in the transactions
+        const CAmount nCachedTrusted = wallet.GetBalance();
+        const CAmount nCachedUnconfirmed = wallet.GetUnconfirmedBalance();
+        const CAmount nCachedImmature = wallet.GetImmatureBalance();
+        EXPECT_EQ(nCachedTrusted, nTrusted);
+        EXPECT_EQ(nCachedUnconfirmed, nUnconfirmed);
+        EXPECT_EQ(nCachedImmature, nImmature);
+
+        CAmount nFullTrusted = 0, nFullUnconfirmed = 0, nFullImmature = 0;
+        for (const auto& [txid, wtx] : wallet.mapWallet)
+        {
+            const bool bTrusted = wtx.IsTrusted();
+            const CAmount nAvailable = wtx.GetAvailableCredit(false);
+            if (bTrusted)
+                nFullTrusted += nAvailable;
+            if (!CheckFinalTx(wtx) || (!bTrusted && wtx.GetDepthInMainChain() == 0))
+                nFullUnconfirmed += nAvailable;
+            nFullImmature += wtx.GetImmatureCredit(false);
+        }
+        EXPECT_EQ(nCachedTrusted, nFullTrusted);
+        EXPECT_EQ(nCachedUnconfirmed, nFullUnconfirmed);
+        EXPECT_EQ(nCachedImmature, nFullImmature);
+    }
+
+    using coin_t = tuple<uint256, int, int, bool>;
+
+    // available coins calculated by the full scan of the wallet transactions
+    set<coin_t> AvailableCoinsFullScan(const bool fOnlyConfirmed, const bool fIncludeCoinBase) const
+    {
+        set<coin_t> setCoins;
+        for (const auto& [txid, wtx] : wallet.mapWallet)
+        {
+            if (!CheckFinalTx(wtx))
+                continue;
+            if (fOnlyConfirmed && !wtx.IsTrusted())
+                continue;
+            if (wtx.IsCoinBase() && (!fIncludeCoinBase || (wtx.GetBlocksToMaturity() > 0)))
+                continue;
+            const int nDepth = wtx.GetDepthInMainChain();
+            if (nDepth < 0)
+                continue;
+            for (unsigned int i = 0; i < wtx.vout.size(); i++)
+            {
+                const auto& txOut = wtx.vout[i];
+                const isminetype mine = wallet.GetIsMine(txOut);
+                if (mine == isminetype::NO)
+                    continue;
+                if (wallet.IsSpent(txid, i) || wallet.IsLockedCoin(txid, i))
+                    continue;
+                if (txOut.nValue <= 0)
+                    continue;
+                setCoins.emplace(txid, i, nDepth, IsMineSpendable(mine));
+            }
+        }
+        return setCoins;
+    }
+
+    // check available coins from the wallet unspent output index against the full scan
+    void CheckAvailableCoins(const size_t nConfirmed, const size_t nAll)
+    {
+        for (const bool fOnlyConfirmed : { true, false })
+        {
+            for (const bool fIncludeCoinBase : { true, false })
+            {
+                vector<COutput> vCoins;
+                wallet.AvailableCoins(vCoins, fOnlyConfirmed, nullptr, false, fIncludeCoinBase);
+                set<coin_t> setCoins;
+                for (const auto& out : vCoins)
+                    setCoins.emplace(out.tx->GetHash(), out.i, out.nDepth, out.fSpendable);
+                EXPECT_EQ(setCoins.size(), vCoins.size());
+                EXPECT_EQ(setCoins, AvailableCoinsFullScan(fOnlyConfirmed, fIncludeCoinBase))
+                    << "fOnlyConfirmed=" << fOnlyConfirmed << ", fIncludeCoinBase=" << fIncludeCoinBase;
+                if (fIncludeCoinBase)
+                    EXPECT_EQ(vCoins.size(), fOnlyConfirmed ? nConfirmed : nAll);
+            }
+        }
+    }
+};
+
+TEST_F(TestWalletChain, balance_cache)
+{
+    LOCK2(cs_main, wallet.cs_wallet);
+    ConnectBlock({});
+    CheckBalances(0, 0, 0);
+
+    // coinbase is immature until COINBASE_MATURITY blocks are mined on top of it
+    const auto txCoinbase = CreateCoinbase(50 * COIN);
+    ConnectBlock({ txCoinbase });
+    CheckBalances(0, 0, 50 * COIN);
+    for (int i = 0; i < COINBASE_MATURITY - 1; ++i)
+        ConnectBlock({});
+    CheckBalances(0, 0, 50 * COIN);
+    ConnectBlock({});
+    CheckBalances(50 * COIN, 0, 0);
+
+    // receive unconfirmed transaction
+    const auto txReceive = CreateTx({ COutPoint(GetRandHash(), 0) }, { { 5 * COIN, m_scriptMine } });
+    AddToMempool(txReceive);
+    CheckBalances(50 * COIN, 5 * COIN, 0);
+
+    // spend the coinbase, the change is trusted
+    const auto txSpend = CreateTx({ COutPoint(txCoinbase.GetHash(), 0) }, { { 10 * COIN, m_scriptOther }, { 39 * COIN, m_scriptMine } });
+    AddToMempool(txSpend);
+    CheckBalances(39 * COIN, 5 * COIN, 0);
+
+    ConnectBlock({ txReceive, txSpend });
+    CheckBalances(44 * COIN, 0, 0);
+
+    // tip change: transactions are returned to the mempool
+    DisconnectTip();
+    CheckBalances(39 * COIN, 5 * COIN, 0);
+    ConnectBlock({});
+    ConnectBlock({ txSpend });
+    CheckBalances(39 * COIN, 5 * COIN, 0);
+
+    // abandoned transaction is dropped from the mempool and is re-evaluated on the next tip
+    mempool.remove(txReceive, false);
+    ConnectBlock({});
+    CheckBalances(39 * COIN, 0, 0);
+
+    // tip change makes the coinbase immature again
+    const auto txCoinbase2 = CreateCoinbase(25 * COIN);
+    ConnectBlock({ txCoinbase2 });
+    for (int i = 0; i < COINBASE_MATURITY; ++i)
+        ConnectBlock({});
+    CheckBalances(64 * COIN, 0, 0);
+    DisconnectTip();
+    CheckBalances(39 * COIN, 0, 25 * COIN);
+
+    // whole wallet is marked dirty - cache is rebuilt from scratch
+    wallet.MarkDirty();
+    CheckBalances(39 * COIN, 0, 25 * COIN);
+}
+
+TEST_F(TestWalletChain, available_coins_index)
+{
+    LOCK2(cs_main, wallet.cs_wallet);
+    ConnectBlock({});
+    const auto txCoinbase = CreateCoinbase(50 * COIN);
+    ConnectBlock({ txCoinbase });
+    CheckAvailableCoins(0, 0);
+    for (int i = 0; i < COINBASE_MATURITY; ++i)
+        ConnectBlock({});
+    CheckAvailableCoins(1, 1);
+
+    // receive unconfirmed transaction with two own outputs
+    const auto txReceive = CreateTx({ COutPoint(GetRandHash(), 0) },
+        { { 5 * COIN, m_scriptMine }, { 1 * COIN, m_scriptOther }, { 2 * COIN, m_scriptMine } });
+    AddToMempool(txReceive);
+    CheckAvailableCoins(1, 3);
+
+    // spend the coinbase in the mempool - only the change is available
+    const auto txSpend = CreateTx({ COutPoint(txCoinbase.GetHash(), 0) }, { { 10 * COIN, m_scriptOther }, { 39 * COIN, m_scriptMine } });
+    AddToMempool(txSpend);
+    CheckAvailableCoins(1, 3);
+
+    // conflicting transaction spends the same coinbase output and is mined
+    const auto txConflict = CreateTx({ COutPoint(txCoinbase.GetHash(), 0) }, { { 20 * COIN, m_scriptOther }, { 29 * COIN, m_scriptMine } });
+    ConnectBlock({ txConflict }, { txSpend });
+    CheckAvailableCoins(1, 3);
+
+    // reorg: conflicting transaction is returned to the mempool, received transaction is mined on the new branch
+    DisconnectTip();
+    CheckAvailableCoins(1, 3);
+    ConnectBlock({ txReceive });
+    CheckAvailableCoins(3, 3);
+
+    // conflicting transaction is dropped from the mempool - coinbase is available again on the next tip
+    mempool.remove(txConflict, false);
+    ConnectBlock({});
+    CheckAvailableCoins(3, 3);
+    vector<COutput> vCoins;
+    wallet.AvailableCoins(vCoins, true, nullptr, false, true);
+    EXPECT_TRUE(any_of(vCoins.cbegin(), vCoins.cend(), [&](const COutput& out) { return out.tx->GetHash() == txCoinbase.GetHash(); }));
+
+    // locked coin is skipped
+    wallet.LockCoin(COutPoint(txReceive.GetHash(), 0));
+    CheckAvailableCoins(2, 2);
+    wallet.UnlockCoin(COutPoint(txReceive.GetHash(), 0));
+    CheckAvailableCoins(3, 3);
+}
+
 static void add_coin(const CAmount& nValue, int nAge = 6*24, bool fIsFromMe = false, int nInput=0)
 {
     static int nextLockTime = 0;
@@ -150,7 +150,8 @@ As a JSON-RPC call
         pwalletMain->nTimeFirstKey = 1; // 0 would be considered 'no value'
 
         if (fRescan) {
-            pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true);
+            if (pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true) < 0)
+                throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
         }
     }
 
@@ -227,7 +228,8 @@ As a JSON-RPC call
 
         if (fRescan)
         {
-            pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true);
+            if (pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true) < 0)
+                throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
             pwalletMain->ReacceptWalletTransactions();
         }
     }
@@ -393,7 +395,8 @@ UniValue importwallet_impl(const UniValue& params, bool fHelp, bool fImportZKeys
         pwalletMain->nTimeFirstKey = nTimeBegin;
 
     LogPrintf("Rescanning last %i blocks\n", chainActive.Height() - pindex->nHeight + 1);
-    pwalletMain->ScanForWalletTransactions(pindex);
+    if (pwalletMain->ScanForWalletTransactions(pindex) < 0)
+        throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
     pwalletMain->MarkDirty();
 
     if (!fGood)
@@ -712,7 +715,8 @@ As a JSON-RPC call
     
     // We want to scan for transactions and notes
     if (fRescan) {
-        pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true);
+        if (pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true) < 0)
+            throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
     }
 
     return result;
@@ -814,7 +818,10 @@ As a JSON-RPC call
 
     // We want to scan for transactions and notes
     if (fRescan)
-        pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true);
+    {
+        if (pwalletMain->ScanForWalletTransactions(chainActive[nRescanHeight], true) < 0)
+            throw JSONRPCError(RPC_WALLET_ERROR, "Rescan aborted, failed to read blocks from disk");
+    }
 
     return result;
 }
@@ -35,6 +35,7 @@
 #include <wallet/wallet.h>
 #include <wallet/walletdb.h>
 #include <wallet/asyncrpcoperation_mergetoaddress.h>
+#include <wallet/asyncrpcoperation_rescan.h>
 #include <wallet/asyncrpcoperation_sendmany.h>
 #include <wallet/asyncrpcoperation_shieldcoinbase.h>
 
@@ -4525,6 +4526,55 @@ Examples:
     return ret;
 }
 
+UniValue z_rescanwallet(const UniValue& params, bool fHelp)
+{
+    if (!EnsureWalletIsAvailable(fHelp))
+        return NullUniValue;
+
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+R"(z_rescanwallet ( startHeight )
+
+Rescan the blockchain for the wallet transactions and notes. This is an asynchronous operation,
+the node stays responsive during the rescan. Keys can be imported with rescan disabled and the wallet
+rescanned with this call afterwards.
+Use z_getoperationstatus to monitor the rescan progress.
+
+Arguments:
+1. startHeight        (numeric, optional, default=0) Block height to start rescan from
+
+Result:
+"operationid"          (string) An operationid to pass to z_getoperationstatus to get the result of the operation.
+
+Examples:
+)"
++ HelpExampleCli("z_rescanwallet", "")
++ HelpExampleCli("z_rescanwallet", "30000")
++ HelpExampleRpc("z_rescanwallet", "30000")
+);
+
+    if (fPruneMode)
+        throw JSONRPCError(RPC_WALLET_ERROR, "Rescan is disabled in pruned mode");
+
+    int nStartHeight = 0;
+    if (params.size() > 0)
+        nStartHeight = params[0].get_int();
+    {
+        LOCK(cs_main);
+        if (nStartHeight < 0 || nStartHeight > chainActive.Height())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+    }
+
+    UniValue contextInfo(UniValue::VOBJ);
+    contextInfo.pushKV("startHeight", nStartHeight);
+
+    // Create operation and add to global queue
+    auto q = getAsyncRPCQueue();
+    auto operation = make_shared<AsyncRPCOperation_rescan>(nStartHeight, contextInfo);
+    q->addOperation(operation);
+    return operation->getId();
+}
+
 
 UniValue z_getnotescount(const UniValue& params, bool fHelp)
 {
@@ -4635,6 +4685,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "z_getoperationstatus",     &z_getoperationstatus,     true  },
     { "wallet",             "z_getoperationresult",     &z_getoperationresult,     true  },
     { "wallet",             "z_listoperationids",       &z_listoperationids,       true  },
+    { "wallet",             "z_rescanwallet",           &z_rescanwallet,           true  },
     { "wallet",             "z_getnewaddress",          &z_getnewaddress,          true  },
     { "wallet",             "z_listaddresses",          &z_listaddresses,          true  },
     { "wallet",             "z_exportkey",              &z_exportkey,              true  },
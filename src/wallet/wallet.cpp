@@ -8,6 +8,7 @@
 
 #include <asyncrpcqueue.h>
 #include <checkpoints.h>
+#include <checkqueue.h>
 #include <coincontrol.h>
 #include <core_io.h>
 #include <consensus/upgrades.h>
@@ -22,6 +23,7 @@
 #include <rpc/server.h>
 #include <script/script.h>
 #include <script/sign.h>
+#include <script_check.h>
 #include <timedata.h>
 #include <utilmoneystr.h>
 #include <zcash/Note.hpp>
@@ -30,6 +32,8 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <future>
 #include <random>
 #include <variant>
 #include <thread>
@@ -473,6 +477,23 @@ void CWallet::ChainTip(const CBlockIndex *pindex,
         DecrementNoteWitnesses(pindex);
     }
     UpdateSaplingNullifierNoteMapForBlock(pblock);
+
+    // re-evaluate balance of the transactions that depend on the chain tip
+    LOCK(cs_wallet);
+    if (m_bBalanceCacheValid)
+    {
+        m_setBalanceDirty.insert(m_setBalanceTipDependent.cbegin(), m_setBalanceTipDependent.cend());
+        // coinbase transactions matured at the disconnected tip are immature again
+        if (!added)
+        {
+            for (const auto& [txid, wtx] : mapWallet)
+            {
+                if (wtx.IsCoinBase() && !m_setBalanceTipDependent.count(txid) && (wtx.GetBlocksToMaturity() > 0))
+                    m_setBalanceDirty.insert(txid);
+            }
+        }
+    }
+    UpdateBalanceCache();
 }
 
 void CWallet::SetBestChain(const CBlockLocator& loc)
@@ -774,11 +795,38 @@ void CWallet::ClearNoteWitnessCache()
     nWitnessCacheSize = 0;
 }
 
+/**
+ * Check whether the witness cache of the note should be updated.
+ * Witness caches rebuilt by the wallet rescan are updated only by the rescan replay,
+ * all other witness caches - only by the chain tip updates.
+ *
+ * \param setRebuild - notes with the witness caches being rebuilt
+ * \param op - note outpoint
+ * \param bRebuild - true if called from the rescan replay
+ * \return true if the note witness cache should be updated
+ */
+template<typename OutPoint>
+static inline bool IsNoteWitnessUpdated(const set<OutPoint>& setRebuild, const OutPoint& op, const bool bRebuild)
+{
+    if (setRebuild.empty())
+        return !bRebuild;
+    return (setRebuild.count(op) > 0) == bRebuild;
+}
+
 template<typename NoteDataMap>
-void CopyPreviousWitnesses(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize)
+void CopyPreviousWitnesses(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize,
+    const set<typename NoteDataMap::key_type>& setRebuild, const bool bRebuild)
 {
     for (auto& item : noteDataMap) {
+        if (!IsNoteWitnessUpdated(setRebuild, item.first, bRebuild))
+            continue;
         auto* nd = &(item.second);
+        // chain tip updates could shrink the witness cache while the rebuilt notes were skipped
+        if (bRebuild)
+        {
+            while (nd->witnesses.size() > nWitnessCacheSize)
+                nd->witnesses.pop_back();
+        }
         // Only increment witnesses that are behind the current height
         if (nd->witnessHeight < indexHeight) {
             // Check the validity of the cache
@@ -800,10 +848,13 @@ void CopyPreviousWitnesses(NoteDataMap& noteDataMap, int indexHeight, const uint
 }
 
 template<typename NoteDataMap>
-void AppendNoteCommitment(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize, const uint256& note_commitment)
+void AppendNoteCommitment(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize, const uint256& note_commitment,
+    const set<typename NoteDataMap::key_type>& setRebuild, const bool bRebuild)
 {
     for (auto& item : noteDataMap)
     {
+        if (!IsNoteWitnessUpdated(setRebuild, item.first, bRebuild))
+            continue;
         auto* nd = &(item.second);
         if (nd->witnessHeight < indexHeight && !nd->witnesses.empty())
         {
@@ -849,10 +900,13 @@ void WitnessNoteIfMine(map<OutPoint, NoteData>& noteDataMap, int indexHeight, co
 
 
 template<typename NoteDataMap>
-void UpdateWitnessHeights(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize)
+void UpdateWitnessHeights(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize,
+    const set<typename NoteDataMap::key_type>& setRebuild, const bool bRebuild)
 {
     for (auto& item : noteDataMap)
     {
+        if (!IsNoteWitnessUpdated(setRebuild, item.first, bRebuild))
+            continue;
         auto* nd = &(item.second);
         if (nd->witnessHeight < indexHeight)
         {
@@ -866,11 +920,12 @@ void UpdateWitnessHeights(NoteDataMap& noteDataMap, int indexHeight, const uint6
 
 void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
                                      const CBlock* pblockIn,
-                                      SaplingMerkleTree& saplingTree)
+                                      SaplingMerkleTree& saplingTree,
+                                     const bool bRebuild)
 {
     LOCK(cs_wallet);
     for (auto& wtxItem : mapWallet)
-       ::CopyPreviousWitnesses(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize);
+       ::CopyPreviousWitnesses(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize, m_setSaplingWitnessRebuild, bRebuild);
 
     if (nWitnessCacheSize < WITNESS_CACHE_SIZE)
         ++nWitnessCacheSize;
@@ -893,11 +948,12 @@ void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
 
             // Increment existing witnesses
             for (auto& wtxItem : mapWallet)
-                ::AppendNoteCommitment(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize, note_commitment);
+                ::AppendNoteCommitment(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize, note_commitment,
+                    m_setSaplingWitnessRebuild, bRebuild);
 
             // If this is our note, witness it
-            if (txIsOurs) {
-                SaplingOutPoint outPoint {hash, i};
+            SaplingOutPoint outPoint {hash, i};
+            if (txIsOurs && IsNoteWitnessUpdated(m_setSaplingWitnessRebuild, outPoint, bRebuild)) {
                 ::WitnessNoteIfMine(mapWallet[hash].mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize, outPoint, saplingTree.witness());
             }
         }
@@ -905,7 +961,8 @@ void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
 
     // Update witness heights
     for (auto& wtxItem : mapWallet)
-        ::UpdateWitnessHeights(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize);
+        ::UpdateWitnessHeights(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize,
+            m_setSaplingWitnessRebuild, bRebuild);
 
     // For performance reasons, we write out the witness cache in
     // CWallet::SetBestChain() (which also ensures that overall consistency
@@ -913,10 +970,14 @@ void CWallet::IncrementNoteWitnesses(const CBlockIndex* pindex,
 }
 
 template<typename NoteDataMap>
-void DecrementNoteWitnesses(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize)
+void DecrementNoteWitnesses(NoteDataMap& noteDataMap, int indexHeight, const uint64_t nWitnessCacheSize,
+    const set<typename NoteDataMap::key_type>& setRebuild)
 {
     for (auto& item : noteDataMap)
     {
+        // rescan replay restarts if the replayed blocks are disconnected
+        if (!IsNoteWitnessUpdated(setRebuild, item.first, false))
+            continue;
         auto* nd = &(item.second);
         // Only decrement witnesses that are not above the current height
         if (nd->witnessHeight <= indexHeight)
@@ -958,7 +1019,7 @@ void CWallet::DecrementNoteWitnesses(const CBlockIndex* pindex)
 {
     LOCK(cs_wallet);
     for (auto& wtxItem : mapWallet)
-        ::DecrementNoteWitnesses(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize);
+        ::DecrementNoteWitnesses(wtxItem.second.mapSaplingNoteData, pindex->nHeight, nWitnessCacheSize, m_setSaplingWitnessRebuild);
     --nWitnessCacheSize;
     // TODO: If nWitnessCache is zero, we need to regenerate the caches (#1302)
     assert(nWitnessCacheSize > 0);
@@ -1095,6 +1156,16 @@ void CWallet::MarkDirty()
     LOCK(cs_wallet);
     for (auto &item : mapWallet)
         item.second.MarkDirty();
+    // all cached credits are invalidated - rebuild balance cache from scratch
+    m_bBalanceCacheValid = false;
+}
+
+void CWallet::MarkBalanceDirty(const uint256& txid) const
+{
+    LOCK(cs_wallet);
+    // if the cache is not valid - it will be rebuilt anyway
+    if (m_bBalanceCacheValid)
+        m_setBalanceDirty.insert(txid);
 }
 
 /**
@@ -1400,6 +1471,9 @@ void CWallet::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
         return; // Not one of ours
 
     MarkAffectedTransactionsDirty(tx);
+    // depth of the transaction may have changed (connected or disconnected block)
+    MarkBalanceDirty(tx.GetHash());
+    UpdateBalanceCache();
 }
 
 void CWallet::MarkAffectedTransactionsDirty(const CTransaction& tx)
@@ -1429,11 +1503,144 @@ void CWallet::EraseFromWallet(const uint256 &hash)
     {
         LOCK(cs_wallet);
         if (mapWallet.erase(hash))
+        {
             CWalletDB(strWalletFile).EraseTx(hash);
+            // contribution of the erased transaction will be subtracted on the next refresh
+            MarkBalanceDirty(hash);
+        }
     }
     return;
 }
 
+// min number of trial decryptions (outputs x viewing keys) in transaction to use parallel decryption
+constexpr size_t SAPLING_PARALLEL_DECRYPT_MIN_TRIALS = 64;
+// number of viewing keys tried by one sapling trial decryption check
+constexpr size_t SAPLING_DECRYPT_IVK_CHUNK_SIZE = 16;
+// max number of checks processed in one batch by the sapling decryption worker
+constexpr size_t SAPLING_DECRYPT_QUEUE_BATCH_SIZE = 4;
+
+/**
+ * Closure to try to decrypt one sapling output with a range of incoming viewing keys.
+ * Stores the index of the first viewing key that decrypts the output,
+ * several checks for the same output can run in parallel - the smallest index wins.
+ */
+class CSaplingTrialDecryptCheck
+{
+public:
+    CSaplingTrialDecryptCheck() = default;
+    CSaplingTrialDecryptCheck(const OutputDescription* pOutput, const vector<SaplingIncomingViewingKey>* pvIvk,
+        const size_t nFirst, const size_t nLast, atomic_size_t* pnFoundIvk) :
+        m_pOutput(pOutput),
+        m_pvIvk(pvIvk),
+        m_nFirst(nFirst),
+        m_nLast(nLast),
+        m_pnFoundIvk(pnFoundIvk)
+    {}
+
+    bool operator()()
+    {
+        if (!m_pOutput || !m_pvIvk || !m_pnFoundIvk)
+            return true;
+        for (size_t i = m_nFirst; i < m_nLast; ++i)
+        {
+            // output was already decrypted with the key that goes before this range
+            if (*m_pnFoundIvk < i)
+                return true;
+            if (!SaplingNotePlaintext::decrypt(m_pOutput->encCiphertext, (*m_pvIvk)[i], m_pOutput->ephemeralKey, m_pOutput->cm))
+                continue;
+            size_t nFound = *m_pnFoundIvk;
+            while ((i < nFound) && !m_pnFoundIvk->compare_exchange_weak(nFound, i))
+                ;
+            return true;
+        }
+        return true;
+    }
+
+    void swap(CSaplingTrialDecryptCheck& check) noexcept
+    {
+        std::swap(m_pOutput, check.m_pOutput);
+        std::swap(m_pvIvk, check.m_pvIvk);
+        std::swap(m_nFirst, check.m_nFirst);
+        std::swap(m_nLast, check.m_nLast);
+        std::swap(m_pnFoundIvk, check.m_pnFoundIvk);
+    }
+
+private:
+    const OutputDescription* m_pOutput = nullptr;
+    const vector<SaplingIncomingViewingKey>* m_pvIvk = nullptr;
+    size_t m_nFirst = 0;
+    size_t m_nLast = 0;
+    atomic_size_t* m_pnFoundIvk = nullptr;
+};
+
+using CSaplingDecryptWorker = CCheckQueueWorkerThread<CSaplingTrialDecryptCheck>;
+// queue to try sapling outputs decryption in parallel
+static CCheckQueue<CSaplingTrialDecryptCheck> SaplingDecryptQueue(SAPLING_DECRYPT_QUEUE_BATCH_SIZE);
+// number of sapling decryption threads (including master), 0 - decrypt in the calling thread
+static size_t nSaplingDecryptThreads = 0;
+
+/**
+ * Create sapling trial decryption worker threads.
+ * By default uses the same number of threads as script verification (-par).
+ * 
+ * \param threadGroup - add workers to this thread group
+ * \param nThreads - number of decryption threads (including master), 0 - use -par
+ */
+void CreateSaplingDecryptWorkers(CServiceThreadGroup &threadGroup, const size_t nThreads)
+{
+    nSaplingDecryptThreads = nThreads ? nThreads : gl_ScriptCheckManager.GetThreadCount();
+    if (nSaplingDecryptThreads <= 1)
+    {
+        nSaplingDecryptThreads = 0;
+        return;
+    }
+    LogPrintf("Using %zu threads for sapling note decryption\n", nSaplingDecryptThreads);
+    string sThreadName;
+    for (size_t i = 0; i < nSaplingDecryptThreads - 1; ++i)
+    {
+        sThreadName = strprintf("zdec-%zu", i + 1);
+        threadGroup.add_thread(make_shared<CSaplingDecryptWorker>(&SaplingDecryptQueue, false, sThreadName.c_str()), true);
+    }
+}
+
+/**
+ * Try to decrypt sapling outputs with all incoming viewing keys.
+ * Outputs x viewing keys are split into checks and processed by the sapling decryption workers.
+ * 
+ * \param vOutputs - sapling outputs
+ * \param vIvk - incoming viewing keys
+ * \param vFoundIvk - returns for each output index of the first viewing key that decrypts it,
+ *                    or vIvk.size() if output can't be decrypted with any key
+ * \param bAllowParallel - if false - decrypt in the calling thread
+ */
+void SaplingTrialDecrypt(const vector<OutputDescription>& vOutputs, const vector<SaplingIncomingViewingKey>& vIvk,
+    vector<atomic_size_t>& vFoundIvk, const bool bAllowParallel)
+{
+    const size_t nIvkCount = vIvk.size();
+    for (auto& nFound : vFoundIvk)
+        nFound = nIvkCount;
+
+    vector<CSaplingTrialDecryptCheck> vChecks;
+    const bool bParallel = bAllowParallel && nSaplingDecryptThreads &&
+        (vOutputs.size() * nIvkCount >= SAPLING_PARALLEL_DECRYPT_MIN_TRIALS);
+    const size_t nChunkSize = bParallel ? SAPLING_DECRYPT_IVK_CHUNK_SIZE : nIvkCount;
+    vChecks.reserve(vOutputs.size() * ((nIvkCount + nChunkSize - 1) / nChunkSize));
+    for (size_t i = 0; i < vOutputs.size(); ++i)
+    {
+        for (size_t nFirst = 0; nFirst < nIvkCount; nFirst += nChunkSize)
+            vChecks.emplace_back(&vOutputs[i], &vIvk, nFirst, min(nFirst + nChunkSize, nIvkCount), &vFoundIvk[i]);
+    }
+    if (bParallel)
+    {
+        CSaplingDecryptWorker control(&SaplingDecryptQueue, true, "zdec-m");
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        for (auto& check : vChecks)
+            check();
+    }
+}
+
 /**
  * Finds all output notes in the given transaction that have been sent to
  * SaplingPaymentAddresses in this wallet.
@@ -1444,33 +1651,52 @@ void CWallet::EraseFromWallet(const uint256 &hash)
  */
 pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> CWallet::FindMySaplingNotes(const CTransaction &tx) const
 {
-    LOCK(cs_KeyStore);
-    uint256 hash = tx.GetHash();
+    const uint256 hash = tx.GetHash();
 
     mapSaplingNoteData_t noteData;
     SaplingIncomingViewingKeyMap viewingKeysToAdd;
 
+    if (tx.vShieldedOutput.empty())
+        return make_pair(noteData, viewingKeysToAdd);
+
+    // take a snapshot of the incoming viewing keys, trial decryption is done without holding cs_KeyStore
+    vector<SaplingIncomingViewingKey> vIvk;
+    {
+        LOCK(cs_KeyStore);
+        vIvk.reserve(mapSaplingFullViewingKeys.size());
+        for (const auto& [ivk, fvk] : mapSaplingFullViewingKeys)
+            vIvk.push_back(ivk);
+    }
+    if (vIvk.empty())
+        return make_pair(noteData, viewingKeysToAdd);
+
     // Protocol Spec: 4.19 Block Chain Scanning (Sapling)
-    for (uint32_t i = 0; i < tx.vShieldedOutput.size(); ++i) {
-        const OutputDescription output = tx.vShieldedOutput[i];
-        for (auto it = mapSaplingFullViewingKeys.begin(); it != mapSaplingFullViewingKeys.end(); ++it) {
-            SaplingIncomingViewingKey ivk = it->first;
-            auto result = SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cm);
-            if (!result) {
-                continue;
-            }
-            auto address = ivk.address(result.value().d);
-            if (address && mapSaplingIncomingViewingKeys.count(address.value()) == 0) {
-                viewingKeysToAdd[address.value()] = ivk;
-            }
-            // We don't cache the nullifier here as computing it requires knowledge of the note position
-            // in the commitment tree, which can only be determined when the transaction has been mined.
-            SaplingOutPoint op {hash, i};
-            SaplingNoteData nd;
-            nd.ivk = ivk;
-            noteData.insert(make_pair(op, nd));
-            break;
+    // index of the first viewing key that decrypts the output
+    vector<atomic_size_t> vFoundIvk(tx.vShieldedOutput.size());
+    SaplingTrialDecrypt(tx.vShieldedOutput, vIvk, vFoundIvk);
+
+    LOCK(cs_KeyStore);
+    for (uint32_t i = 0; i < tx.vShieldedOutput.size(); ++i)
+    {
+        const size_t nIvkIndex = vFoundIvk[i];
+        if (nIvkIndex >= vIvk.size())
+            continue;
+        const auto& output = tx.vShieldedOutput[i];
+        const auto& ivk = vIvk[nIvkIndex];
+        // decrypt once again to get the diversifier of the recipient address
+        auto result = SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cm);
+        if (!result)
+            continue;
+        auto address = ivk.address(result.value().d);
+        if (address && mapSaplingIncomingViewingKeys.count(address.value()) == 0) {
+            viewingKeysToAdd[address.value()] = ivk;
         }
+        // We don't cache the nullifier here as computing it requires knowledge of the note position
+        // in the commitment tree, which can only be determined when the transaction has been mined.
+        SaplingOutPoint op {hash, i};
+        SaplingNoteData nd;
+        nd.ivk = ivk;
+        noteData.insert(make_pair(op, nd));
     }
 
     return make_pair(noteData, viewingKeysToAdd);
@@ -2046,12 +2272,212 @@ bool CWalletTx::WriteToDisk(CWalletDB *pwalletdb)
     return pwalletdb->WriteTx(GetHash(), *this);
 }
 
+// block read ahead by the wallet rescan
+typedef struct _rescan_block_t
+{
+    CBlockIndex* pindex = nullptr;
+    CBlock block;
+    // for each block transaction: true if transaction may involve the wallet (has own outputs or shielded outputs)
+    v_bools vMaybeMine;
+} rescan_block_t;
+using rescan_chunk_t = vector<rescan_block_t>;
+
+/**
+ * Collect the next chunk of active chain blocks to rescan.
+ * Requires cs_main.
+ * 
+ * \param pindexStart - first block of the chunk (can be not in the active chain after reorg)
+ * \return block indexes of the chunk
+ */
+static vector<CBlockIndex*> GetRescanChunk(CBlockIndex* pindexStart)
+{
+    AssertLockHeld(cs_main);
+    vector<CBlockIndex*> vChunk;
+    CBlockIndex* pindex = pindexStart;
+    // chain was reorganized - continue from the fork point
+    if (pindex && !chainActive.Contains(pindex))
+        pindex = chainActive.Next(chainActive.FindFork(pindex));
+    while (pindex && (vChunk.size() < WALLET_RESCAN_CHUNK_SIZE))
+    {
+        vChunk.push_back(pindex);
+        pindex = chainActive.Next(pindex);
+    }
+    return vChunk;
+}
+
+/**
+ * Read chunk of blocks from disk and prescreen transactions for the wallet outputs.
+ * Runs without cs_main and cs_wallet (keystore uses its own lock).
+ * 
+ * \param pwallet - wallet
+ * \param vChunk - block indexes to read
+ * \return blocks read from disk, chunk is truncated at the block that failed to read
+ */
+static rescan_chunk_t ReadRescanChunk(const CWallet* pwallet, const vector<CBlockIndex*> &vChunk)
+{
+    const auto& consensusParams = Params().GetConsensus();
+    rescan_chunk_t chunk(vChunk.size());
+    for (size_t i = 0; i < vChunk.size(); ++i)
+    {
+        auto& item = chunk[i];
+        item.pindex = vChunk[i];
+        if (!ReadBlockFromDisk(item.block, item.pindex, consensusParams))
+        {
+            LogPrintf("Rescanning... failed to read block %d (%s) from disk\n",
+                item.pindex->nHeight, item.pindex->GetBlockHash().ToString());
+            chunk.resize(i);
+            break;
+        }
+        item.vMaybeMine.reserve(item.block.vtx.size());
+        for (const auto& tx : item.block.vtx)
+            item.vMaybeMine.push_back(!tx.vShieldedOutput.empty() || pwallet->IsMine(tx));
+        if (ShutdownRequested())
+            break;
+    }
+    return chunk;
+}
+
+/**
+ * Get the first active chain block with the transactions of the notes being rebuilt.
+ * Requires cs_main and cs_wallet.
+ *
+ * \param setRebuild - notes with the witness caches being rebuilt
+ * \param mapWallet - wallet transactions
+ * \return first block to replay or nullptr if none of the transactions is in the active chain
+ */
+static CBlockIndex* GetWitnessRebuildStart(const set<SaplingOutPoint>& setRebuild, const wallet_txmap_t& mapWallet)
+{
+    CBlockIndex* pindexStart = nullptr;
+    uint256 hashPrevTx;
+    for (const auto& op : setRebuild)
+    {
+        if (op.hash == hashPrevTx)
+            continue;
+        hashPrevTx = op.hash;
+        const auto itTx = mapWallet.find(op.hash);
+        if (itTx == mapWallet.cend())
+            continue;
+        const auto mi = mapBlockIndex.find(itTx->second.hashBlock);
+        if ((mi == mapBlockIndex.cend()) || !chainActive.Contains(mi->second))
+            continue;
+        if (!pindexStart || (mi->second->nHeight < pindexStart->nHeight))
+            pindexStart = mi->second;
+    }
+    return pindexStart;
+}
+
+/**
+ * Start rebuilding witness caches for the new Sapling notes found by the rescan.
+ * Notes are excluded from the chain tip updates until EndSaplingWitnessRebuild is called.
+ * Requires cs_main and cs_wallet.
+ *
+ * \param vTxHashes - wallet transactions found by the rescan
+ * \return first block to replay or nullptr if there is nothing to rebuild
+ */
+CBlockIndex* CWallet::BeginSaplingWitnessRebuild(const v_uint256& vTxHashes)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    m_setSaplingWitnessRebuild.clear();
+    for (const auto &hash : vTxHashes)
+    {
+        auto &wtx = mapWallet[hash];
+        for (auto& [op, nd] : wtx.mapSaplingNoteData)
+        {
+            if (!nd.witnesses.empty())
+                continue;
+            nd.witnessHeight = -1;
+            m_setSaplingWitnessRebuild.insert(op);
+        }
+    }
+    CBlockIndex* pindexStart = GetWitnessRebuildStart(m_setSaplingWitnessRebuild, mapWallet);
+    if (!pindexStart)
+        m_setSaplingWitnessRebuild.clear();
+    return pindexStart;
+}
+
 /**
- * Scan the block chain (starting in pindexStart) for transactions
- * from or to us. If fUpdate is true, found transactions that already
- * exist in the wallet will be updated.
+ * Reset the rebuilt witness caches, called when the replayed blocks were disconnected
+ * while the locks were released.
+ * Requires cs_main and cs_wallet.
+ *
+ * \return first block to replay or nullptr if there is nothing to rebuild
  */
-int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
+CBlockIndex* CWallet::RestartSaplingWitnessRebuild()
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+    unordered_set<uint256> setTxHashes;
+    for (const auto& op : m_setSaplingWitnessRebuild)
+    {
+        auto itTx = mapWallet.find(op.hash);
+        if (itTx == mapWallet.end())
+            continue;
+        auto itNote = itTx->second.mapSaplingNoteData.find(op);
+        if (itNote == itTx->second.mapSaplingNoteData.end())
+            continue;
+        itNote->second.witnesses.clear();
+        itNote->second.witnessHeight = -1;
+        setTxHashes.insert(op.hash);
+    }
+    // erase nullifiers calculated for the disconnected note positions
+    for (const auto& hash : setTxHashes)
+        UpdateSaplingNullifierNoteMapWithTx(mapWallet[hash]);
+    CBlockIndex* pindexStart = GetWitnessRebuildStart(m_setSaplingWitnessRebuild, mapWallet);
+    if (!pindexStart)
+        EndSaplingWitnessRebuild();
+    return pindexStart;
+}
+
+/**
+ * Replay active chain block for the notes with the witness caches being rebuilt.
+ * Requires cs_main and cs_wallet.
+ *
+ * \param pindex - replayed block index
+ * \param block - replayed block
+ * \param saplingTree - Sapling commitment tree state before the block
+ */
+void CWallet::ReplaySaplingWitnesses(const CBlockIndex* pindex, const CBlock& block, SaplingMerkleTree& saplingTree)
+{
+    AssertLockHeld(cs_wallet);
+    IncrementNoteWitnesses(pindex, &block, saplingTree, true);
+    // nullifiers of the rebuilt notes are needed to detect their spends in the next blocks
+    UpdateSaplingNullifierNoteMapForBlock(&block);
+}
+
+/**
+ * Hand over the rebuilt witness caches to the chain tip updates.
+ * Should be called under the same cs_main lock as the replay of the active chain tip.
+ */
+void CWallet::EndSaplingWitnessRebuild()
+{
+    AssertLockHeld(cs_wallet);
+    m_setSaplingWitnessRebuild.clear();
+    // re-evaluate balance of the transactions that depend on the chain tip
+    if (m_bBalanceCacheValid)
+        m_setBalanceDirty.insert(m_setBalanceTipDependent.cbegin(), m_setBalanceTipDependent.cend());
+    UpdateBalanceCache();
+}
+
+/**
+ * Scan the active chain for the wallet transactions.
+ * 
+ * Rescan runs in two phases:
+ *  1) blocks are read and prescreened ahead by the I/O thread, transactions are added to the wallet
+ *     chunk by chunk, cs_main and cs_wallet are released between chunks,
+ *     Sapling trial decryption runs in parallel in FindMySaplingNotes.
+ *  2) if new Sapling notes were found - witness caches are rebuilt in block order starting from the
+ *     first block with the new notes, spends of the new notes are detected on the way.
+ *     Chain tip updates skip the rebuilt notes, so cs_main and cs_wallet are released between chunks as well.
+ *     If the replayed blocks are disconnected meanwhile - replay starts over,
+ *     when it reaches the chain tip - the notes are handed over to the chain tip updates.
+ * 
+ * \param pindexStart - block to start rescan from
+ * \param fUpdate - if true - existing wallet transactions are updated
+ * \param pProgress - optional rescan progress
+ * \return number of found wallet transactions, -1 if rescan was aborted because block could not be read from disk
+ */
+int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate, wallet_rescan_progress_t *pProgress)
 {
     int ret = 0;
     int64_t nNow = GetTime();
@@ -2060,52 +2486,207 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
     CBlockIndex* pindex = pindexStart;
 
     v_uint256 myTxHashes;
-
+    double dProgressStart = 0;
+    double dProgressTip = 0;
+    vector<CBlockIndex*> vChunk;
     {
-        LOCK2(cs_main, cs_wallet);
-
+        LOCK(cs_main);
         // no need to read and scan block, if block was created before
         // our wallet birthday (as adjusted for block time variability)
         while (pindex && nTimeFirstKey && (pindex->GetBlockTime() < (nTimeFirstKey - 7200)))
             pindex = chainActive.Next(pindex);
 
         ShowProgress(_("Rescanning..."), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
-        double dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
-        double dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.Tip(), false);
-        while (pindex)
+        dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
+        dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.Tip(), false);
+        if (pProgress)
         {
-            if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
-                ShowProgress(_("Rescanning..."), max(1, min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
+            pProgress->nStartHeight = pindex ? pindex->nHeight : -1;
+            pProgress->nTipHeight = chainActive.Height();
+        }
+        vChunk = GetRescanChunk(pindex);
+    }
+
+    // phase 1: find wallet transactions
+    bool bReadFailed = false;
+    future<rescan_chunk_t> futureChunk;
+    if (!vChunk.empty())
+        futureChunk = async(launch::async, ReadRescanChunk, this, vChunk);
+    while (!vChunk.empty())
+    {
+        rescan_chunk_t chunk = futureChunk.get();
+        if (ShutdownRequested())
+            break;
+        if (chunk.size() < vChunk.size())
+        {
+            bReadFailed = true;
+            break;
+        }
+        // read the next chunk while processing this one
+        vector<CBlockIndex*> vNextChunk;
+        {
+            LOCK(cs_main);
+            CBlockIndex* pindexLast = vChunk.back();
+            vNextChunk = GetRescanChunk(chainActive.Contains(pindexLast) ? chainActive.Next(pindexLast) : pindexLast);
+            if (pProgress)
+                pProgress->nTipHeight = chainActive.Height();
+        }
+        if (!vNextChunk.empty())
+            futureChunk = async(launch::async, ReadRescanChunk, this, vNextChunk);
 
-            CBlock block;
-            ReadBlockFromDisk(block, pindex, Params().GetConsensus());
-            for (auto& tx : block.vtx)
+        {
+            LOCK2(cs_main, cs_wallet);
+            for (const auto& item : chunk)
             {
-                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate)) {
-                    myTxHashes.push_back(tx.GetHash());
-                    ret++;
+                // skip blocks disconnected while the locks were released
+                if (!chainActive.Contains(item.pindex))
+                    continue;
+                const auto& block = item.block;
+                for (size_t i = 0; i < block.vtx.size(); ++i)
+                {
+                    const auto& tx = block.vtx[i];
+                    // same condition as in AddToWalletIfInvolvingMe without the expensive own outputs checks
+                    if (!item.vMaybeMine[i] && !mapWallet.count(tx.GetHash()) && !IsFromMe(tx))
+                        continue;
+                    if (AddToWalletIfInvolvingMe(tx, &block, fUpdate)) {
+                        myTxHashes.push_back(tx.GetHash());
+                        ret++;
+                    }
                 }
             }
+        }
+        pindex = chunk.back().pindex;
+        if (pProgress)
+        {
+            pProgress->nCurrentHeight = pindex->nHeight;
+            pProgress->nFoundTxCount = ret;
+        }
+        if (dProgressTip - dProgressStart > 0.0)
+            ShowProgress(_("Rescanning..."), max(1, min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
+        if (GetTime() >= nNow + 60) {
+            nNow = GetTime();
+            LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
+        }
+        vChunk = move(vNextChunk);
+    }
+    if (futureChunk.valid())
+        futureChunk.wait();
 
-            SproutMerkleTree sproutTree;
-            SaplingMerkleTree saplingTree;
-            // This should never fail: we should always be able to get the tree
-            // state on the path to the tip of our chain
-            assert(pcoinsTip->GetSproutAnchorAt(pindex->hashSproutAnchor, sproutTree));
-            if (pindex->pprev)
+    // phase 2: build witnesses for the new Sapling notes
+    CBlockIndex* pindexWitnessStart = nullptr;
+    if (!bReadFailed)
+    {
+        LOCK2(cs_main, cs_wallet);
+        pindexWitnessStart = BeginSaplingWitnessRebuild(myTxHashes);
+        if (pindexWitnessStart)
+            vChunk = GetRescanChunk(pindexWitnessStart);
+        else
+            vChunk.clear();
+    }
+    if (pindexWitnessStart && !ShutdownRequested())
+    {
+        LogPrintf("Rescanning... building witnesses for new Sapling notes from block %d\n", pindexWitnessStart->nHeight);
+        if (!vChunk.empty())
+            futureChunk = async(launch::async, ReadRescanChunk, this, vChunk);
+        // last replayed block
+        CBlockIndex* pindexReplayed = nullptr;
+        while (!vChunk.empty())
+        {
+            rescan_chunk_t chunk = futureChunk.get();
+            if (ShutdownRequested())
+                break;
+            if (chunk.size() < vChunk.size())
             {
-                if (NetworkUpgradeActive(pindex->pprev->nHeight, Params().GetConsensus(), Consensus::UpgradeIndex::UPGRADE_SAPLING)) {
-                    assert(pcoinsTip->GetSaplingAnchorAt(pindex->pprev->hashFinalSaplingRoot, saplingTree));
-                }
+                bReadFailed = true;
+                break;
+            }
+            // read the next chunk while replaying this one
+            vector<CBlockIndex*> vNextChunk;
+            {
+                LOCK(cs_main);
+                vNextChunk = GetRescanChunk(chainActive.Next(vChunk.back()));
             }
-            // Increment note witness caches
-            ChainTip(pindex, &block, saplingTree, true);
+            if (!vNextChunk.empty())
+                futureChunk = async(launch::async, ReadRescanChunk, this, vNextChunk);
 
-            pindex = chainActive.Next(pindex);
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight, Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
+            CBlockIndex* pindexNext = nullptr;
+            {
+                LOCK2(cs_main, cs_wallet);
+                if (pindexReplayed && !chainActive.Contains(pindexReplayed))
+                {
+                    // replayed blocks were disconnected while the locks were released
+                    LogPrintf("Rescanning... chain reorganized at block %d, rebuilding witnesses again\n", pindexReplayed->nHeight);
+                    pindexReplayed = nullptr;
+                    pindexWitnessStart = RestartSaplingWitnessRebuild();
+                    pindexNext = pindexWitnessStart;
+                } else {
+                    for (const auto& item : chunk)
+                    {
+                        // stop at the blocks disconnected while the locks were released
+                        if (!chainActive.Contains(item.pindex) || (pindexReplayed && (item.pindex->pprev != pindexReplayed)))
+                            break;
+                        const auto& block = item.block;
+                        // spends of the new notes can be detected only after their nullifiers are known
+                        for (const auto& tx : block.vtx)
+                        {
+                            if (tx.vShieldedSpend.empty() || mapWallet.count(tx.GetHash()))
+                                continue;
+                            if (AddToWalletIfInvolvingMe(tx, &block, fUpdate)) {
+                                myTxHashes.push_back(tx.GetHash());
+                                ret++;
+                            }
+                        }
+
+                        SproutMerkleTree sproutTree;
+                        SaplingMerkleTree saplingTree;
+                        // This should never fail: we should always be able to get the tree
+                        // state on the path to the tip of our chain
+                        assert(pcoinsTip->GetSproutAnchorAt(item.pindex->hashSproutAnchor, sproutTree));
+                        if (item.pindex->pprev)
+                        {
+                            if (NetworkUpgradeActive(item.pindex->pprev->nHeight, Params().GetConsensus(), Consensus::UpgradeIndex::UPGRADE_SAPLING)) {
+                                assert(pcoinsTip->GetSaplingAnchorAt(item.pindex->pprev->hashFinalSaplingRoot, saplingTree));
+                            }
+                        }
+                        // Increment witness caches of the new notes
+                        ReplaySaplingWitnesses(item.pindex, block, saplingTree);
+                        pindexReplayed = item.pindex;
+                    }
+                    pindexNext = pindexReplayed ? chainActive.Next(pindexReplayed) : pindexWitnessStart;
+                    // replay has reached the chain tip
+                    if (!pindexNext)
+                        EndSaplingWitnessRebuild();
+                }
+            }
+            if (pProgress)
+                pProgress->nFoundTxCount = ret;
+            if (!pindexNext)
+                break;
+            if (vNextChunk.empty() || (vNextChunk.front() != pindexNext))
+            {
+                // the chain has changed while the next chunk was selected - read it again
+                if (futureChunk.valid())
+                    futureChunk.wait();
+                {
+                    LOCK(cs_main);
+                    vNextChunk = GetRescanChunk(pindexNext);
+                }
+                if (!vNextChunk.empty())
+                    futureChunk = async(launch::async, ReadRescanChunk, this, vNextChunk);
             }
+            vChunk = move(vNextChunk);
+        }
+        if (futureChunk.valid())
+            futureChunk.wait();
+    }
+
+    {
+        LOCK2(cs_main, cs_wallet);
+        // rebuild was interrupted - reset partially rebuilt witness caches
+        if (!m_setSaplingWitnessRebuild.empty())
+        {
+            RestartSaplingWitnessRebuild();
+            EndSaplingWitnessRebuild();
         }
 
         // After rescanning, persist Sapling note data that might have changed, e.g. nullifiers.
@@ -2124,6 +2705,11 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
 
         ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     }
+    if (bReadFailed)
+    {
+        LogPrintf("Rescanning... aborted, failed to read blocks from disk\n");
+        return -1;
+    }
     return ret;
 }
 
@@ -2339,6 +2925,20 @@ CAmount CWalletTx::GetChange() const
     return nChangeCached;
 }
 
+void CWalletTx::MarkDirty()
+{
+    fCreditCached = false;
+    fAvailableCreditCached = false;
+    fWatchDebitCached = false;
+    fWatchCreditCached = false;
+    fAvailableWatchCreditCached = false;
+    fImmatureWatchCreditCached = false;
+    fDebitCached = false;
+    fChangeCached = false;
+    if (pwallet)
+        pwallet->MarkBalanceDirty(GetHash());
+}
+
 bool CWalletTx::IsTrusted() const
 {
     // Quick answer in most cases
@@ -2422,70 +3022,202 @@ void CWallet::ResendWalletTransactions(int64_t nBestBlockTime)
  */
 
 
-CAmount CWallet::GetBalance() const
+/**
+ * Calculate contribution of the wallet transaction to the wallet balances.
+ * 
+ * \param wtx - wallet transaction
+ * \param bTipDependent - returns true if the contribution can change with the chain tip
+ * \return balance contribution of the transaction
+ */
+wallet_balance_t CWallet::GetTxBalanceContribution(const CWalletTx& wtx, bool &bTipDependent) const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto &[txid, coin] : mapWallet)
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    wallet_balance_t balance;
+    const bool bFinal = CheckFinalTx(wtx);
+    const int nDepth = wtx.GetDepthInMainChain();
+    const bool bTrusted = wtx.IsTrusted();
+    if (bTrusted)
     {
-        if (coin.IsTrusted())
-            nTotal += coin.GetAvailableCredit();
+        balance.nTrusted = wtx.GetAvailableCredit();
+        balance.nWatchOnlyTrusted = wtx.GetAvailableWatchOnlyCredit();
     }
-    return nTotal;
+    if (!bFinal || (!bTrusted && nDepth == 0))
+    {
+        balance.nUnconfirmed = wtx.GetAvailableCredit();
+        balance.nWatchOnlyUnconfirmed = wtx.GetAvailableWatchOnlyCredit();
+    }
+    balance.nImmature = wtx.GetImmatureCredit();
+    balance.nWatchOnlyImmature = wtx.GetImmatureWatchOnlyCredit();
+    bTipDependent = !bFinal || (nDepth <= 0) || (wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0);
+    return balance;
 }
 
-CAmount CWallet::GetUnconfirmedBalance() const
+/**
+ * Check if the output is spent by the wallet transaction in the main chain.
+ * 
+ * \param hash - transaction hash
+ * \param n - output index
+ * \return true if the output is spent by the confirmed transaction
+ */
+bool CWallet::IsSpentInMainChain(const uint256& hash, const unsigned int n) const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& [txid, coin] : mapWallet)
+    const COutPoint outpoint(hash, n);
+    const auto range = mapTxSpends.equal_range(outpoint);
+    for (auto it = range.first; it != range.second; ++it)
     {
-        if (!CheckFinalTx(coin) || (!coin.IsTrusted() && coin.GetDepthInMainChain() == 0))
-            nTotal += coin.GetAvailableCredit();
+        const auto mit = mapWallet.find(it->second);
+        if (mit != mapWallet.cend() && mit->second.GetDepthInMainChain() >= 1)
+            return true;
     }
-    return nTotal;
+    return false;
 }
 
-CAmount CWallet::GetImmatureBalance() const
+/**
+ * Update unspent output index entries for the wallet transaction.
+ * 
+ * \param txid - wallet transaction hash
+ * \param pwtx - wallet transaction, nullptr if the transaction was erased from wallet
+ */
+void CWallet::UpdateTxUnspentOutputs(const uint256& txid, const CWalletTx* pwtx) const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& [txid, coin] : mapWallet)
-        nTotal += coin.GetImmatureCredit();
-    return nTotal;
+    auto it = m_mapUnspent.lower_bound(COutPoint(txid, 0));
+    while (it != m_mapUnspent.end() && it->first.hash == txid)
+        it = m_mapUnspent.erase(it);
+    if (!pwtx)
+        return;
+    const bool bCoinBase = pwtx->IsCoinBase();
+    for (uint32_t i = 0; i < pwtx->vout.size(); ++i)
+    {
+        const auto& txOut = pwtx->vout[i];
+        const isminetype mine = GetIsMine(txOut);
+        if (mine == isminetype::NO)
+            continue;
+        if (IsSpentInMainChain(txid, i))
+            continue;
+        m_mapUnspent.emplace_hint(m_mapUnspent.end(), COutPoint(txid, i), wallet_utxo_t{txOut.nValue, mine, bCoinBase});
+    }
 }
 
-CAmount CWallet::GetWatchOnlyBalance() const
+/**
+ * Refresh wallet balance cache and unspent output index.
+ * Full rebuild if the cache is not valid, otherwise only dirty transactions are recalculated.
+ */
+void CWallet::UpdateBalanceCache() const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& [txid, coin] : mapWallet)
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    bool bTipDependent = false;
+    if (!m_bBalanceCacheValid)
     {
-        if (coin.IsTrusted())
-            nTotal += coin.GetAvailableWatchOnlyCredit();
+        m_balanceCache = wallet_balance_t();
+        m_mapTxBalance.clear();
+        m_setBalanceTipDependent.clear();
+        m_mapUnspent.clear();
+        for (const auto& [txid, wtx] : mapWallet)
+        {
+            UpdateTxUnspentOutputs(txid, &wtx);
+            const auto balance = GetTxBalanceContribution(wtx, bTipDependent);
+            if (bTipDependent)
+                m_setBalanceTipDependent.insert(txid);
+            if (balance.IsZero())
+                continue;
+            m_balanceCache.Add(balance);
+            m_mapTxBalance.emplace(txid, balance);
+        }
+        m_setBalanceDirty.clear();
+        m_bBalanceCacheValid = true;
+        return;
+    }
+    // wallet transactions whose outputs were spent by the newly confirmed transactions
+    unordered_set<uint256> setSpentTxids;
+    for (const auto& txid : m_setBalanceDirty)
+    {
+        // subtract old contribution
+        auto itBalance = m_mapTxBalance.find(txid);
+        if (itBalance != m_mapTxBalance.end())
+        {
+            m_balanceCache.Subtract(itBalance->second);
+            m_mapTxBalance.erase(itBalance);
+        }
+        const bool bWasTipDependent = m_setBalanceTipDependent.erase(txid) > 0;
+        const auto it = mapWallet.find(txid);
+        if (it == mapWallet.cend())
+        {
+            UpdateTxUnspentOutputs(txid, nullptr);
+            continue; // erased from wallet
+        }
+        const auto& wtx = it->second;
+        UpdateTxUnspentOutputs(txid, &wtx);
+        const auto balance = GetTxBalanceContribution(wtx, bTipDependent);
+        if (bTipDependent)
+            m_setBalanceTipDependent.insert(txid);
+        else if (bWasTipDependent)
+        {
+            for (const auto& txin : wtx.vin)
+                setSpentTxids.insert(txin.prevout.hash);
+        }
+        if (balance.IsZero())
+            continue;
+        m_balanceCache.Add(balance);
+        m_mapTxBalance.emplace(txid, balance);
+    }
+    m_setBalanceDirty.clear();
+    // drop outputs spent by the transactions confirmed since the last refresh
+    for (const auto& txid : setSpentTxids)
+    {
+        const auto it = mapWallet.find(txid);
+        if (it != mapWallet.cend())
+            UpdateTxUnspentOutputs(txid, &it->second);
     }
-    return nTotal;
 }
 
-CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
+/**
+ * Get cached wallet balances.
+ * Takes cs_main only if the balance cache has to be refreshed.
+ */
+wallet_balance_t CWallet::GetCachedBalance() const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& [txid, coin] : mapWallet)
     {
-        if (!CheckFinalTx(coin) || (!coin.IsTrusted() && coin.GetDepthInMainChain() == 0))
-            nTotal += coin.GetAvailableWatchOnlyCredit();
+        LOCK(cs_wallet);
+        if (m_bBalanceCacheValid && m_setBalanceDirty.empty())
+            return m_balanceCache;
     }
-    return nTotal;
+    LOCK2(cs_main, cs_wallet);
+    UpdateBalanceCache();
+    return m_balanceCache;
+}
+
+CAmount CWallet::GetBalance() const
+{
+    return GetCachedBalance().nTrusted;
+}
+
+CAmount CWallet::GetUnconfirmedBalance() const
+{
+    return GetCachedBalance().nUnconfirmed;
+}
+
+CAmount CWallet::GetImmatureBalance() const
+{
+    return GetCachedBalance().nImmature;
+}
+
+CAmount CWallet::GetWatchOnlyBalance() const
+{
+    return GetCachedBalance().nWatchOnlyTrusted;
+}
+
+CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
+{
+    return GetCachedBalance().nWatchOnlyUnconfirmed;
 }
 
 CAmount CWallet::GetImmatureWatchOnlyBalance() const
 {
-    CAmount nTotal = 0;
-    LOCK2(cs_main, cs_wallet);
-    for (const auto& [txid, coin] : mapWallet)
-        nTotal += coin.GetImmatureWatchOnlyCredit();
-    return nTotal;
+    return GetCachedBalance().nWatchOnlyImmature;
 }
 
 /**
@@ -2497,52 +3229,53 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
 
     {
         LOCK2(cs_main, cs_wallet);
-        for (const auto& [txid, wtx] : mapWallet)
+        // make sure unspent output index is up-to-date
+        UpdateBalanceCache();
+
+        const CWalletTx* pwtx = nullptr;
+        bool bSkipTx = true;
+        int nDepth = 0;
+        for (const auto& [outpoint, utxo] : m_mapUnspent)
         {
-            if (!CheckFinalTx(wtx))
+            const uint256& txid = outpoint.hash;
+            // index is ordered by txid - transaction checks are done once per transaction
+            if (!pwtx || (pwtx->GetHash() != txid))
+            {
+                const auto it = mapWallet.find(txid);
+                if (it == mapWallet.cend())
+                {
+                    pwtx = nullptr;
+                    continue;
+                }
+                pwtx = &it->second;
+                nDepth = pwtx->GetDepthInMainChain();
+                bSkipTx = !CheckFinalTx(*pwtx) ||
+                    (fOnlyConfirmed && !pwtx->IsTrusted()) ||
+                    (utxo.bCoinBase && (!fIncludeCoinBase || pwtx->GetBlocksToMaturity() > 0)) ||
+                    (nDepth < 0);
+            }
+            if (bSkipTx)
                 continue;
 
-            if (fOnlyConfirmed && !wtx.IsTrusted())
+            // exact coins check
+            if (exactCoins != 0 && utxo.nValue != exactCoins * COIN)
                 continue;
-
-            if (wtx.IsCoinBase() && !fIncludeCoinBase)
+            // check if output already spent (by the mempool transaction)
+            if (IsSpent(txid, outpoint.n))
                 continue;
-
-            if (wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0)
+            // check if coin is locked and skip flag is not specified
+            if (IsLockedCoin(txid, outpoint.n) && !fIncludeLocked)
                 continue;
-
-            const int nDepth = wtx.GetDepthInMainChain();
-            if (nDepth < 0)
+            // check if tx value is not positive and skip flag is not specified
+            if (utxo.nValue <= 0 && !fIncludeZeroValue)
                 continue;
-
-            for (unsigned int i = 0; i < wtx.vout.size(); i++)
+            // coin control object is used and has some tx outputs to use as a filter
+            if (pCoinControl && pCoinControl->HasSelected())
             {
-                const auto& txOut = wtx.vout[i];
-                // exact coins check
-                if (exactCoins != 0 && txOut.nValue != exactCoins * COIN)
-                    continue;
-
-                // check if mine transaction (none, spendable or watch-only)
-                const isminetype mine = GetIsMine(txOut);
-                if (mine == isminetype::NO)
-                    continue;
-                // check if output already spent
-                if (IsSpent(txid, i))
-                    continue;
-                // check if coin is locked and skip flag is not specified
-                if (IsLockedCoin(txid, i) && !fIncludeLocked)
+                if (!pCoinControl->fAllowOtherInputs && !pCoinControl->IsSelected(txid, outpoint.n))
                     continue;
-                // check if tx value is not positive and skip flag is not specified
-                if (txOut.nValue <= 0 && !fIncludeZeroValue)
-                    continue;
-                // coin control object is used and has some tx outputs to use as a filter
-                if (pCoinControl && pCoinControl->HasSelected())
-                {
-                    if (!pCoinControl->fAllowOtherInputs && !pCoinControl->IsSelected(txid, i))
-                        continue;
-                }
-                vCoins.emplace_back(&wtx, i, nDepth, IsMineSpendable(mine));
             }
+            vCoins.emplace_back(pwtx, outpoint.n, nDepth, IsMineSpendable(utxo.mine));
         }
     }
 }
@@ -5,12 +5,15 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <optional>
 #include <set>
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -44,6 +47,68 @@ extern bool bSpendZeroConfChange;
 extern bool fSendFreeTransactions;
 extern bool fPayAtLeastCustomFee;
 
+class CServiceThreadGroup;
+// create sapling trial decryption worker threads (nThreads = 0 - use -par)
+void CreateSaplingDecryptWorkers(CServiceThreadGroup &threadGroup, const size_t nThreads = 0);
+// find the first incoming viewing key that decrypts each sapling output
+void SaplingTrialDecrypt(const std::vector<OutputDescription>& vOutputs, const std::vector<libzcash::SaplingIncomingViewingKey>& vIvk,
+    std::vector<std::atomic_size_t>& vFoundIvk, const bool bAllowParallel = true);
+
+// number of blocks read ahead and processed by the wallet rescan with one lock acquisition
+constexpr size_t WALLET_RESCAN_CHUNK_SIZE = 100;
+
+// wallet rescan progress, can be monitored from another thread
+typedef struct _wallet_rescan_progress_t
+{
+    std::atomic_int nStartHeight = -1;   // rescan start height
+    std::atomic_int nCurrentHeight = -1; // height of the last scanned block
+    std::atomic_int nTipHeight = -1;     // height of the active chain tip
+    std::atomic_int nFoundTxCount = 0;   // number of found wallet transactions
+} wallet_rescan_progress_t;
+
+// wallet balances (cached totals or contribution of one wallet transaction)
+typedef struct _wallet_balance_t
+{
+    CAmount nTrusted = 0;            // trusted available credit
+    CAmount nUnconfirmed = 0;        // unconfirmed or non-final available credit
+    CAmount nImmature = 0;           // immature coinbase credit
+    CAmount nWatchOnlyTrusted = 0;
+    CAmount nWatchOnlyUnconfirmed = 0;
+    CAmount nWatchOnlyImmature = 0;
+
+    bool IsZero() const noexcept
+    {
+        return !nTrusted && !nUnconfirmed && !nImmature &&
+               !nWatchOnlyTrusted && !nWatchOnlyUnconfirmed && !nWatchOnlyImmature;
+    }
+    void Add(const struct _wallet_balance_t& b) noexcept
+    {
+        nTrusted += b.nTrusted;
+        nUnconfirmed += b.nUnconfirmed;
+        nImmature += b.nImmature;
+        nWatchOnlyTrusted += b.nWatchOnlyTrusted;
+        nWatchOnlyUnconfirmed += b.nWatchOnlyUnconfirmed;
+        nWatchOnlyImmature += b.nWatchOnlyImmature;
+    }
+    void Subtract(const struct _wallet_balance_t& b) noexcept
+    {
+        nTrusted -= b.nTrusted;
+        nUnconfirmed -= b.nUnconfirmed;
+        nImmature -= b.nImmature;
+        nWatchOnlyTrusted -= b.nWatchOnlyTrusted;
+        nWatchOnlyUnconfirmed -= b.nWatchOnlyUnconfirmed;
+        nWatchOnlyImmature -= b.nWatchOnlyImmature;
+    }
+} wallet_balance_t;
+
+// wallet unspent output index entry
+typedef struct _wallet_utxo_t
+{
+    CAmount nValue;   // output value
+    isminetype mine;  // spendable or watch-only
+    bool bCoinBase;   // output of the coinbase transaction
+} wallet_utxo_t;
+
 //! -paytxfee default
 static constexpr CAmount DEFAULT_TRANSACTION_FEE = 0;
 //! -paytxfee will warn if called with a higher fee than this amount (in patoshis) per KB
@@ -416,17 +481,7 @@ public:
     }
 
     //! make sure balances are recalculated
-    void MarkDirty()
-    {
-        fCreditCached = false;
-        fAvailableCreditCached = false;
-        fWatchDebitCached = false;
-        fWatchCreditCached = false;
-        fAvailableWatchCreditCached = false;
-        fImmatureWatchCreditCached = false;
-        fDebitCached = false;
-        fChangeCached = false;
-    }
+    void MarkDirty();
 
     void BindWallet(CWallet *pwalletIn)
     {
@@ -656,6 +711,35 @@ private:
     typedef TxSpendMap<uint256> TxNullifiers;
     TxNullifiers mapTxSaplingNullifiers;
 
+    /**
+     * Wallet balance cache.
+     * Totals are maintained incrementally: contribution of each transaction is kept
+     * in m_mapTxBalance, only dirty transactions are recalculated on refresh.
+     * Transactions whose contribution depends on the chain tip (immature coinbase,
+     * unconfirmed, conflicted or non-final) are re-evaluated on every tip change.
+     * The same dirty tracking is used to maintain the wallet unspent output index.
+     * Protected by cs_wallet.
+     */
+    mutable wallet_balance_t m_balanceCache;
+    mutable std::unordered_map<uint256, wallet_balance_t> m_mapTxBalance;
+    mutable std::unordered_set<uint256> m_setBalanceDirty;
+    mutable std::unordered_set<uint256> m_setBalanceTipDependent;
+    mutable bool m_bBalanceCacheValid = false;
+    /**
+     * Wallet unspent output index: outpoint -> output info.
+     * Contains all outputs that are mine and are not spent by the transaction
+     * in the main chain. Outputs spent by unconfirmed transactions are kept in the index
+     * and filtered out by AvailableCoins, so they become available again if the spending
+     * transaction is dropped from the mempool.
+     */
+    mutable std::map<COutPoint, wallet_utxo_t> m_mapUnspent;
+
+    wallet_balance_t GetTxBalanceContribution(const CWalletTx& wtx, bool &bTipDependent) const;
+    wallet_balance_t GetCachedBalance() const;
+    void UpdateBalanceCache() const;
+    void UpdateTxUnspentOutputs(const uint256& txid, const CWalletTx* pwtx) const;
+    bool IsSpentInMainChain(const uint256& hash, const unsigned int n) const;
+
     void AddToTransparentSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSaplingSpends(const uint256& nullifier, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
@@ -676,12 +760,35 @@ protected:
      */
     void IncrementNoteWitnesses(const CBlockIndex* pindex,
                                 const CBlock* pblock,
-                                SaplingMerkleTree& saplingTree);
+                                SaplingMerkleTree& saplingTree,
+                                const bool bRebuild = false);
     /**
      * pindex is the old tip being disconnected.
      */
     void DecrementNoteWitnesses(const CBlockIndex* pindex);
 
+    /**
+     * Sapling notes found by the wallet rescan which witness caches are being rebuilt.
+     * Chain tip updates skip these notes, rescan replays the blocks only for them.
+     * Protected by cs_wallet.
+     */
+    std::set<SaplingOutPoint> m_setSaplingWitnessRebuild;
+
+    // start rebuilding witness caches for the new Sapling notes of the given transactions
+    CBlockIndex* BeginSaplingWitnessRebuild(const v_uint256& vTxHashes);
+    // reset the rebuilt witness caches after the replayed blocks were disconnected
+    CBlockIndex* RestartSaplingWitnessRebuild();
+    // replay one active chain block for the rebuilt witness caches
+    void ReplaySaplingWitnesses(const CBlockIndex* pindex, const CBlock& block, SaplingMerkleTree& saplingTree);
+    // hand over the rebuilt witness caches to the chain tip updates
+    void EndSaplingWitnessRebuild();
+    // check whether the witness caches of the transaction notes are being rebuilt
+    bool IsSaplingWitnessRebuilt(const uint256& txid) const noexcept
+    {
+        const auto it = m_setSaplingWitnessRebuild.lower_bound(SaplingOutPoint(txid, 0));
+        return (it != m_setSaplingWitnessRebuild.cend()) && (it->hash == txid);
+    }
+
     template <typename WalletDB>
     void SetBestChainINTERNAL(WalletDB& walletdb, const CBlockLocator& loc) {
         if (!walletdb.TxnBegin()) {
@@ -696,7 +803,10 @@ protected:
                 // are empty. This covers transactions that have no Sapling data
                 // (i.e. are purely transparent), as well as shielding and unshielding
                 // transactions in which we only have transparent addresses involved.
-                if (!wtx.mapSaplingNoteData.empty() && !walletdb.WriteTx(txid, wtx))
+                // Notes with the witness caches being rebuilt are written by the rescan when the rebuild is finished.
+                if (wtx.mapSaplingNoteData.empty() || IsSaplingWitnessRebuilt(txid))
+                    continue;
+                if (!walletdb.WriteTx(txid, wtx))
                 {
                     LogPrintf("SetBestChain(): Failed to write CWalletTx, aborting atomic write\n");
                     walletdb.TxnAbort();
@@ -989,6 +1099,8 @@ public:
     TxItems OrderedTxItems(std::list<CAccountingEntry>& acentries, std::string strAccount = "");
 
     void MarkDirty();
+    // mark wallet transaction balance contribution for recalculation
+    void MarkBalanceDirty(const uint256& txid) const;
     bool UpdateNullifierNoteMap();
     void UpdateNullifierNoteMapWithTx(const CWalletTx& wtx);
     void UpdateSaplingNullifierNoteMapWithTx(CWalletTx& wtx);
@@ -997,7 +1109,7 @@ public:
     void SyncTransaction(const CTransaction& tx, const CBlock* pblock);
     bool AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate);
     void EraseFromWallet(const uint256 &hash);
-    int ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false);
+    int ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false, wallet_rescan_progress_t *pProgress = nullptr);
     void ReacceptWalletTransactions();
     void ResendWalletTransactions(int64_t nBestBlockTime);
     v_uint256 ResendWalletTransactionsBefore(int64_t nTime);
@@ -25,3 +25,8 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyTicket(const ticket_notification_t &/*ticket*/)
+{
+    return true;
+}
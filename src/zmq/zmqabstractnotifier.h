@@ -6,6 +6,7 @@
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
 #include "zmqconfig.h"
+#include "validationinterface.h"
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -35,6 +36,7 @@ public:
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyBlock(const CBlock& pblock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyTicket(const ticket_notification_t &ticket);
 
 protected:
     void *psocket;
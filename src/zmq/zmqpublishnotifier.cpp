@@ -15,6 +15,8 @@ constexpr auto MSG_HASHTX       = "hashtx";
 constexpr auto MSG_RAWBLOCK     = "rawblock";
 constexpr auto MSG_RAWTX        = "rawtx";
 constexpr auto MSG_CHECKEDBLOCK = "checkedblock";
+constexpr auto MSG_HASHTICKET   = "hashticket";
+constexpr auto MSG_RAWTICKET    = "rawticket";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -166,18 +168,18 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     LogPrint("zmq", "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
     const auto& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
     {
+        // cs_main is held only to read the block, serialization is done without it
         LOCK(cs_main);
-        CBlock block;
         if(!ReadBlockFromDisk(block, pindex, consensusParams))
         {
             zmqError("Can't read block from disk");
             return false;
         }
-
-        ss << block;
     }
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
 
     return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
 }
@@ -186,11 +188,9 @@ bool CZMQPublishCheckedBlockNotifier::NotifyBlock(const CBlock& block)
 {
     LogPrint("zmq", "zmq: Publish checkedblock %s\n", block.GetHash().GetHex());
 
+    // called on the validation interface queue thread with a copy of the block, cs_main is not required
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        ss << block;
-    }
+    ss << block;
 
     return SendMessage(MSG_CHECKEDBLOCK, &(*ss.begin()), ss.size());
 }
@@ -203,3 +203,17 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishHashTicketNotifier::NotifyTicket(const ticket_notification_t &ticket)
+{
+    LogPrint("zmq", "zmq: Publish hashticket %s (%s)\n", ticket.txid.GetHex(), ticket.bConnected ? "connected" : "disconnected");
+    const auto vData = GetTicketNotificationMessage(ticket, false);
+    return SendMessage(MSG_HASHTICKET, vData.data(), vData.size());
+}
+
+bool CZMQPublishRawTicketNotifier::NotifyTicket(const ticket_notification_t &ticket)
+{
+    LogPrint("zmq", "zmq: Publish rawticket %s (%s)\n", ticket.txid.GetHex(), ticket.bConnected ? "connected" : "disconnected");
+    const auto vData = GetTicketNotificationMessage(ticket, true);
+    return SendMessage(MSG_RAWTICKET, vData.data(), vData.size());
+}
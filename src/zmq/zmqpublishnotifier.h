@@ -56,3 +56,15 @@ class CZMQPublishCheckedBlockNotifier : public CZMQAbstractPublishNotifier
 public:
     bool NotifyBlock(const CBlock &block);
 };
+
+class CZMQPublishHashTicketNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyTicket(const ticket_notification_t &ticket);
+};
+
+class CZMQPublishRawTicketNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyTicket(const ticket_notification_t &ticket);
+};